@@ -0,0 +1,328 @@
+/* emeus-constraint-group.c: A set of constraints
+ *
+ * Copyright 2016  Endless
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * SECTION:emeus-constraint-group
+ * @Title: EmeusConstraintGroup
+ * @Short_Description: A set of constraints toggled together
+ *
+ * #EmeusConstraintGroup collects multiple #EmeusConstraint instances
+ * so that they can be activated or deactivated at the same time.
+ *
+ * Toggling each #EmeusConstraint:active property separately causes
+ * the #EmeusConstraintLayout to update its solution after every
+ * change; toggling the #EmeusConstraintGroup:active property, on the
+ * other hand, updates all the constraints inside the group and then
+ * resolves the layout only once.
+ *
+ * A typical use of constraint groups is an adaptive layout, where
+ * one group contains the constraints for a narrow layout, and another
+ * group contains the constraints for a wide layout:
+ *
+ * |[<!-- language="C" -->
+ *   if (width < NARROW_THRESHOLD)
+ *     {
+ *       emeus_constraint_group_set_active (wide_group, FALSE);
+ *       emeus_constraint_group_set_active (narrow_group, TRUE);
+ *     }
+ *   else
+ *     {
+ *       emeus_constraint_group_set_active (narrow_group, FALSE);
+ *       emeus_constraint_group_set_active (wide_group, TRUE);
+ *     }
+ * ]|
+ *
+ * Each constraint inside a group must still be added to an
+ * #EmeusConstraintLayout, or to one of its children.
+ */
+
+#include "config.h"
+
+#include "emeus-constraint-group.h"
+
+#include "emeus-constraint-private.h"
+#include "emeus-solver-backend-private.h"
+
+#include <gtk/gtk.h>
+
+struct _EmeusConstraintGroup
+{
+  GObject parent_instance;
+
+  /* HashSet<EmeusConstraint>; owns a reference on the constraints */
+  GHashTable *constraints;
+
+  gboolean is_active;
+};
+
+enum {
+  PROP_ACTIVE = 1,
+
+  N_PROPERTIES
+};
+
+static GParamSpec *emeus_constraint_group_properties[N_PROPERTIES];
+
+G_DEFINE_TYPE (EmeusConstraintGroup, emeus_constraint_group, G_TYPE_OBJECT)
+
+static void
+emeus_constraint_group_finalize (GObject *gobject)
+{
+  EmeusConstraintGroup *self = EMEUS_CONSTRAINT_GROUP (gobject);
+
+  g_hash_table_unref (self->constraints);
+
+  G_OBJECT_CLASS (emeus_constraint_group_parent_class)->finalize (gobject);
+}
+
+static void
+emeus_constraint_group_set_property (GObject      *gobject,
+                                     guint         prop_id,
+                                     const GValue *value,
+                                     GParamSpec   *pspec)
+{
+  EmeusConstraintGroup *self = EMEUS_CONSTRAINT_GROUP (gobject);
+
+  switch (prop_id)
+    {
+    case PROP_ACTIVE:
+      emeus_constraint_group_set_active (self, g_value_get_boolean (value));
+      break;
+
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (gobject, prop_id, pspec);
+    }
+}
+
+static void
+emeus_constraint_group_get_property (GObject    *gobject,
+                                     guint       prop_id,
+                                     GValue     *value,
+                                     GParamSpec *pspec)
+{
+  EmeusConstraintGroup *self = EMEUS_CONSTRAINT_GROUP (gobject);
+
+  switch (prop_id)
+    {
+    case PROP_ACTIVE:
+      g_value_set_boolean (value, self->is_active);
+      break;
+
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (gobject, prop_id, pspec);
+    }
+}
+
+static void
+emeus_constraint_group_class_init (EmeusConstraintGroupClass *klass)
+{
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+
+  gobject_class->set_property = emeus_constraint_group_set_property;
+  gobject_class->get_property = emeus_constraint_group_get_property;
+  gobject_class->finalize = emeus_constraint_group_finalize;
+
+  /**
+   * EmeusConstraintGroup:active:
+   *
+   * Whether the constraints inside the group participate in the layout.
+   *
+   * Since: 1.0
+   */
+  emeus_constraint_group_properties[PROP_ACTIVE] =
+    g_param_spec_boolean ("active", "Active", NULL,
+                          TRUE,
+                          G_PARAM_READWRITE |
+                          G_PARAM_STATIC_STRINGS |
+                          G_PARAM_EXPLICIT_NOTIFY);
+
+  g_object_class_install_properties (gobject_class, N_PROPERTIES, emeus_constraint_group_properties);
+}
+
+static void
+emeus_constraint_group_init (EmeusConstraintGroup *self)
+{
+  self->constraints = g_hash_table_new_full (NULL, NULL, g_object_unref, NULL);
+  self->is_active = TRUE;
+}
+
+/**
+ * emeus_constraint_group_new: (constructor)
+ *
+ * Creates a new, empty, constraint group.
+ *
+ * Returns: (transfer full): the newly created constraint group
+ *
+ * Since: 1.0
+ */
+EmeusConstraintGroup *
+emeus_constraint_group_new (void)
+{
+  return g_object_new (EMEUS_TYPE_CONSTRAINT_GROUP, NULL);
+}
+
+/**
+ * emeus_constraint_group_add_constraint:
+ * @group: a #EmeusConstraintGroup
+ * @constraint: a #EmeusConstraint
+ *
+ * Adds @constraint to the @group.
+ *
+ * The #EmeusConstraint:active property of @constraint is updated
+ * to match the #EmeusConstraintGroup:active property of @group.
+ *
+ * Since: 1.0
+ */
+void
+emeus_constraint_group_add_constraint (EmeusConstraintGroup *group,
+                                       EmeusConstraint      *constraint)
+{
+  g_return_if_fail (EMEUS_IS_CONSTRAINT_GROUP (group));
+  g_return_if_fail (EMEUS_IS_CONSTRAINT (constraint));
+
+  if (g_hash_table_contains (group->constraints, constraint))
+    return;
+
+  g_hash_table_add (group->constraints, g_object_ref_sink (constraint));
+
+  emeus_constraint_set_active (constraint, group->is_active);
+}
+
+/**
+ * emeus_constraint_group_remove_constraint:
+ * @group: a #EmeusConstraintGroup
+ * @constraint: a #EmeusConstraint
+ *
+ * Removes @constraint from the @group.
+ *
+ * The #EmeusConstraint:active property of @constraint is not changed.
+ *
+ * Since: 1.0
+ */
+void
+emeus_constraint_group_remove_constraint (EmeusConstraintGroup *group,
+                                          EmeusConstraint      *constraint)
+{
+  g_return_if_fail (EMEUS_IS_CONSTRAINT_GROUP (group));
+  g_return_if_fail (EMEUS_IS_CONSTRAINT (constraint));
+
+  g_hash_table_remove (group->constraints, constraint);
+}
+
+/**
+ * emeus_constraint_group_get_constraints:
+ * @group: a #EmeusConstraintGroup
+ *
+ * Retrieves all the constraints inside the @group.
+ *
+ * Returns: (transfer container) (element-type EmeusConstraint): a list of
+ *   #EmeusConstraint instances, owned by the #EmeusConstraintGroup
+ *
+ * Since: 1.0
+ */
+GList *
+emeus_constraint_group_get_constraints (EmeusConstraintGroup *group)
+{
+  g_return_val_if_fail (EMEUS_IS_CONSTRAINT_GROUP (group), NULL);
+
+  return g_hash_table_get_keys (group->constraints);
+}
+
+/**
+ * emeus_constraint_group_set_active:
+ * @group: a #EmeusConstraintGroup
+ * @active: whether the constraints inside @group should be active
+ *
+ * Activates or deactivates all the constraints inside the @group.
+ *
+ * Each #EmeusConstraintLayout affected by the change resolves its
+ * constraints only once, after all the constraints have been updated.
+ *
+ * Since: 1.0
+ */
+void
+emeus_constraint_group_set_active (EmeusConstraintGroup *group,
+                                   gboolean              active)
+{
+  GHashTable *layouts;
+  GHashTableIter iter;
+  gpointer key;
+
+  g_return_if_fail (EMEUS_IS_CONSTRAINT_GROUP (group));
+
+  active = !!active;
+
+  if (group->is_active == active)
+    return;
+
+  group->is_active = active;
+
+  /* HashSet<EmeusConstraintLayout>; we freeze the solver of each
+   * layout involved, so that adding and removing the constraints
+   * does not optimize the tableau after every change
+   */
+  layouts = g_hash_table_new (NULL, NULL);
+
+  g_hash_table_iter_init (&iter, group->constraints);
+  while (g_hash_table_iter_next (&iter, &key, NULL))
+    {
+      EmeusConstraint *constraint = key;
+
+      if (constraint->layout == NULL)
+        continue;
+
+      if (g_hash_table_add (layouts, constraint->layout))
+        solver_freeze (constraint->solver);
+    }
+
+  g_hash_table_iter_init (&iter, group->constraints);
+  while (g_hash_table_iter_next (&iter, &key, NULL))
+    emeus_constraint_set_active (key, active);
+
+  g_hash_table_iter_init (&iter, layouts);
+  while (g_hash_table_iter_next (&iter, &key, NULL))
+    {
+      EmeusConstraintLayout *layout = key;
+
+      solver_thaw (emeus_constraint_layout_get_solver (layout));
+
+      gtk_widget_queue_resize (GTK_WIDGET (layout));
+    }
+
+  g_hash_table_unref (layouts);
+
+  g_object_notify_by_pspec (G_OBJECT (group), emeus_constraint_group_properties[PROP_ACTIVE]);
+}
+
+/**
+ * emeus_constraint_group_get_active:
+ * @group: a #EmeusConstraintGroup
+ *
+ * Checks whether the constraints inside the @group are active.
+ *
+ * Returns: %TRUE if the constraint group is active
+ *
+ * Since: 1.0
+ */
+gboolean
+emeus_constraint_group_get_active (EmeusConstraintGroup *group)
+{
+  g_return_val_if_fail (EMEUS_IS_CONSTRAINT_GROUP (group), FALSE);
+
+  return group->is_active;
+}
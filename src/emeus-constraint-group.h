@@ -0,0 +1,60 @@
+/* emeus-constraint-group.h: A set of constraints
+ *
+ * Copyright 2016  Endless
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <emeus-types.h>
+#include <emeus-constraint.h>
+
+G_BEGIN_DECLS
+
+#define EMEUS_TYPE_CONSTRAINT_GROUP (emeus_constraint_group_get_type())
+
+/**
+ * EmeusConstraintGroup:
+ *
+ * A set of #EmeusConstraint instances that are activated and
+ * deactivated together.
+ *
+ * The contents of the `EmeusConstraintGroup` structure are private and
+ * should never be accessed directly.
+ *
+ * Since: 1.0
+ */
+EMEUS_AVAILABLE_IN_1_0
+G_DECLARE_FINAL_TYPE (EmeusConstraintGroup, emeus_constraint_group, EMEUS, CONSTRAINT_GROUP, GObject)
+
+EMEUS_AVAILABLE_IN_1_0
+EmeusConstraintGroup *  emeus_constraint_group_new                      (void);
+
+EMEUS_AVAILABLE_IN_1_0
+void                    emeus_constraint_group_add_constraint           (EmeusConstraintGroup *group,
+                                                                         EmeusConstraint      *constraint);
+EMEUS_AVAILABLE_IN_1_0
+void                    emeus_constraint_group_remove_constraint        (EmeusConstraintGroup *group,
+                                                                         EmeusConstraint      *constraint);
+EMEUS_AVAILABLE_IN_1_0
+GList *                 emeus_constraint_group_get_constraints          (EmeusConstraintGroup *group);
+
+EMEUS_AVAILABLE_IN_1_0
+void                    emeus_constraint_group_set_active               (EmeusConstraintGroup *group,
+                                                                         gboolean              active);
+EMEUS_AVAILABLE_IN_1_0
+gboolean                emeus_constraint_group_get_active               (EmeusConstraintGroup *group);
+
+G_END_DECLS
@@ -23,6 +23,23 @@
 
 G_BEGIN_DECLS
 
+/* The number of attribute slots; the START and END attributes are
+ * resolved to LEFT or RIGHT, so their slots are never used
+ */
+#define N_ATTRIBUTES    (EMEUS_CONSTRAINT_ATTRIBUTE_BASELINE + 1)
+
+/* The attributes of the layout used as parameters of the allocation,
+ * and the attributes of the children that the allocation reads back
+ */
+enum {
+  ALLOCATION_LEFT,
+  ALLOCATION_TOP,
+  ALLOCATION_WIDTH,
+  ALLOCATION_HEIGHT,
+
+  N_ALLOCATION_PARAMS
+};
+
 struct _EmeusConstraintLayoutChild
 {
   GtkBin parent_instance;
@@ -32,18 +49,38 @@ struct _EmeusConstraintLayoutChild
    */
   char *name;
 
-  /* Position in the layout's GSequence */
-  GSequenceIter *iter;
+  /* Position in the layout's children array */
+  guint index;
 
   /* Back pointer to the solver in the layout */
   SimplexSolver *solver;
 
-  /* HashTable<static string, Variable>; a hash table of variables,
-   * one for each attribute; we use these to query and suggest the
-   * values for the solver. The string is static and does not need
-   * to be freed.
+  /* Array<Variable>, indexed by EmeusConstraintAttribute; the
+   * variables for each attribute, created on demand; we use these
+   * to query and suggest the values for the solver. Owns a reference
+   * on the variables.
+   */
+  Variable *bound_attributes[N_ATTRIBUTES];
+
+  /* The minimum size and the allocation of the child, computed
+   * by the layout when allocating; kept next to the attributes,
+   * as the allocation reads them together.
    */
-  GHashTable *bound_attributes;
+  GtkRequisition minimum;
+  GtkAllocation allocation;
+
+  /* Set when the minimum size was measured by the layout's own
+   * size request, and not yet consumed by the size allocation.
+   */
+  gboolean minimum_valid;
+
+  /* The left, top, width and height of the child at the last solved
+   * allocation, indexed by ALLOCATION_*, and their rate of change with
+   * respect to the left, top, width and height of the layout, valid
+   * while the basis of the solver does not change
+   */
+  double allocation_values[N_ALLOCATION_PARAMS];
+  double allocation_slopes[N_ALLOCATION_PARAMS][N_ALLOCATION_PARAMS];
 
   /* HashSet<EmeusConstraint>; the set of constraints on the
    * widget, using the public API objects.
@@ -68,17 +105,70 @@ struct _EmeusConstraintLayout
 {
   GtkContainer parent_instance;
 
-  GSequence *children;
+  /* Vec<EmeusConstraintLayoutChild>, in insertion order */
+  GPtrArray *children;
 
   SimplexSolver solver;
 
-  GHashTable *bound_attributes;
+  /* The backend used to initialize the solver, or NULL for the default */
+  const SolverBackend *solver_backend;
+
+  /* Array<Variable>, indexed by EmeusConstraintAttribute */
+  Variable *bound_attributes[N_ATTRIBUTES];
 
   /* HashSet<EmeusConstraint>; the set of constraints on the
    * widget, using the public API objects.
    */
   GHashTable *constraints;
 
+  /* Vec<DescriptionLine>; the VFL lines passed to the last call of
+   * emeus_constraint_layout_update_from_description(), in order
+   */
+  GPtrArray *description;
+
+  /* HashTable<string, LayoutMetric>; the VFL metrics referenced by
+   * the constraints, each bound to an edit variable
+   */
+  GHashTable *metrics;
+
+  /* Whether the solver is kept frozen between frames, so that changes
+   * are solved once, when GTK measures or allocates the layout
+   */
+  gboolean deferred_solving;
+
+  /* Set while the solver is frozen, waiting for the next measurement */
+  gboolean solve_pending;
+
+  /* The linear model of the last solved allocation; unset if the
+   * solver could not provide one
+   */
+  struct {
+    /* The generation of the solver the model was computed for */
+    guint generation;
+
+    GtkAllocation allocation;
+
+    /* Vec<double>; the allocations for which the model holds, see
+     * simplex_solver_get_feasible_region()
+     */
+    GArray *region;
+  } sensitivity;
+
+  /* The allocations of the children for the last few allocations of
+   * the layout, to avoid solving again when going back to one of them
+   */
+  struct {
+    /* Queue<AllocationCacheEntry>, most recently used first; unset if
+     * nothing has been cached yet
+     */
+    GQueue *entries;
+
+    guint max_size;
+
+    guint n_hits;
+    guint n_misses;
+  } allocation_cache;
+
   /* Internal constraints */
   struct {
     Constraint *top;
@@ -90,6 +180,9 @@ struct _EmeusConstraintLayout
 
 SimplexSolver * emeus_constraint_layout_get_solver      (EmeusConstraintLayout *layout);
 
+gboolean        emeus_constraint_layout_set_solver_backend      (EmeusConstraintLayout *layout,
+                                                                 const char            *name);
+
 gboolean        emeus_constraint_layout_has_child_data  (EmeusConstraintLayout *layout,
                                                          GtkWidget             *widget);
 
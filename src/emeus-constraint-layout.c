@@ -136,6 +136,29 @@
  * </object>
  * ]|
  *
+ * The `constraints` tag can also contain `resource` elements, whose
+ * `path` attribute points to a set of constraints compiled by the
+ * `emeus-gen-constraints` tool using the `--binary` option, and stored
+ * inside a #GResource:
+ *
+ * |[<!-- language="plain" -->
+ *   <constraints>
+ *     <resource path="/com/example/App/main-window.constraints"/>
+ *   </constraints>
+ * ]|
+ *
+ * Compiled constraints are read directly from the resource data, and
+ * refer to the widgets using their builder id, like the `constraint`
+ * element.
+ *
+ * Once the constraints of a layout defined in a UI file have been solved,
+ * the basis of the solution is kept, and used to solve the same layout
+ * faster the next time it is built. If the `EMEUS_BASIS_CACHE` environment
+ * variable is set, the bases are also stored in the `emeus` directory
+ * inside the user cache directory, so that they can be used the next time
+ * the application runs; only the most recently written bases are kept in
+ * the directory.
+ *
  * # Describing constraints using the Visual Format Language
  *
  * While it's entirely possible to describe layouts by writing constraints
@@ -178,11 +201,14 @@
 #include "emeus-types-private.h"
 #include "emeus-expression-private.h"
 #include "emeus-simplex-solver-private.h"
+#include "emeus-solver-backend-private.h"
 #include "emeus-utils-private.h"
+#include "emeus-utils.h"
 
 #include <errno.h>
 #include <math.h>
 #include <string.h>
+#include <glib/gstdio.h>
 
 enum {
   CHILD_PROP_NAME = 1,
@@ -195,9 +221,12 @@ static GParamSpec *emeus_constraint_layout_child_properties[CHILD_N_PROPS];
 static GtkBuildableIface *parent_buildable_iface;
 
 static GQuark quark_buildable_constraints;
+static GQuark quark_buildable_constraint_blobs;
 
 static void emeus_constraint_layout_buildable_iface_init (GtkBuildableIface *iface);
 
+static void layout_clear_allocation_cache (EmeusConstraintLayout *self);
+
 G_DEFINE_TYPE_WITH_CODE (EmeusConstraintLayout, emeus_constraint_layout, GTK_TYPE_CONTAINER,
                          G_IMPLEMENT_INTERFACE (GTK_TYPE_BUILDABLE, emeus_constraint_layout_buildable_iface_init))
 
@@ -210,21 +239,37 @@ G_DEFINE_TYPE (EmeusConstraintLayoutChild, emeus_constraint_layout_child, GTK_TY
 # define DEBUG(x)
 #endif
 
+static void
+clear_bound_attributes (Variable **bound_attributes)
+{
+  int i;
+
+  for (i = 0; i < N_ATTRIBUTES; i++)
+    g_clear_pointer (&bound_attributes[i], variable_unref);
+}
+
 static void
 emeus_constraint_layout_finalize (GObject *gobject)
 {
   EmeusConstraintLayout *self = EMEUS_CONSTRAINT_LAYOUT (gobject);
 
-  g_clear_pointer (&self->children, g_sequence_free);
-  g_clear_pointer (&self->bound_attributes, g_hash_table_unref);
+  g_clear_pointer (&self->children, g_ptr_array_unref);
+  clear_bound_attributes (self->bound_attributes);
   g_clear_pointer (&self->constraints, g_hash_table_unref);
+  g_clear_pointer (&self->description, g_ptr_array_unref);
+  g_clear_pointer (&self->metrics, g_hash_table_unref);
+  g_clear_pointer (&self->sensitivity.region, g_array_unref);
+  layout_clear_allocation_cache (self);
 
-  simplex_solver_remove_constraint (&self->solver, self->stays.top);
-  simplex_solver_remove_constraint (&self->solver, self->stays.left);
-  simplex_solver_remove_constraint (&self->solver, self->stays.width);
-  simplex_solver_remove_constraint (&self->solver, self->stays.height);
+  if (self->solver.initialized)
+    {
+      solver_remove_constraint (&self->solver, self->stays.top);
+      solver_remove_constraint (&self->solver, self->stays.left);
+      solver_remove_constraint (&self->solver, self->stays.width);
+      solver_remove_constraint (&self->solver, self->stays.height);
 
-  simplex_solver_clear (&self->solver);
+      solver_clear (&self->solver);
+    }
 
   G_OBJECT_CLASS (emeus_constraint_layout_parent_class)->finalize (gobject);
 }
@@ -234,11 +279,140 @@ emeus_constraint_layout_destroy (GtkWidget *widget)
 {
   EmeusConstraintLayout *self = EMEUS_CONSTRAINT_LAYOUT (widget);
 
-  simplex_solver_freeze (&self->solver);
+  if (self->solver.initialized)
+    solver_freeze (&self->solver);
 
   GTK_WIDGET_CLASS (emeus_constraint_layout_parent_class)->destroy (widget);
 }
 
+static void
+add_layout_stays (EmeusConstraintLayout *self)
+{
+  Variable *var;
+
+  /* Add two required stay constraints for the top left corner */
+  var = solver_create_variable (&self->solver, "top", 0.0);
+  variable_set_prefix (var, "super");
+  self->bound_attributes[EMEUS_CONSTRAINT_ATTRIBUTE_TOP] = var;
+  self->stays.top =
+    solver_add_stay_variable (&self->solver, var, STRENGTH_WEAK);
+
+  var = solver_create_variable (&self->solver, "left", 0.0);
+  variable_set_prefix (var, "super");
+  self->bound_attributes[EMEUS_CONSTRAINT_ATTRIBUTE_LEFT] = var;
+  self->stays.left =
+    solver_add_stay_variable (&self->solver, var, STRENGTH_WEAK);
+
+  var = solver_create_variable (&self->solver, "width", 0.0);
+  variable_set_prefix (var, "super");
+  self->bound_attributes[EMEUS_CONSTRAINT_ATTRIBUTE_WIDTH] = var;
+  self->stays.width =
+    solver_add_stay_variable (&self->solver, var, STRENGTH_WEAK);
+
+  var = solver_create_variable (&self->solver, "height", 0.0);
+  variable_set_prefix (var, "super");
+  self->bound_attributes[EMEUS_CONSTRAINT_ATTRIBUTE_HEIGHT] = var;
+  self->stays.height =
+    solver_add_stay_variable (&self->solver, var, STRENGTH_WEAK);
+}
+
+static void
+ensure_solver (EmeusConstraintLayout *self)
+{
+  if (G_LIKELY (self->solver.initialized))
+    return;
+
+  /* The solver, and the stays on the layout's own attributes, are only
+   * created the first time a child or a constraint needs them; many
+   * layouts are instantiated from templates and never used, so there is
+   * no point in paying for the tableau up front.
+   */
+  solver_init (&self->solver, self->solver_backend);
+  add_layout_stays (self);
+}
+
+/* In deferred mode, the first change to the constraints freezes the
+ * solver, so that every other change in the same frame only marks it
+ * as needing to be solved; GTK measures the layout in the layout phase
+ * of the frame clock, after the resize queued by the change, which is
+ * where we thaw it, and solve everything at once.
+ */
+static void
+layout_defer_solving (EmeusConstraintLayout *self)
+{
+  if (!self->deferred_solving || self->solve_pending)
+    return;
+
+  ensure_solver (self);
+
+  solver_freeze (&self->solver);
+  self->solve_pending = TRUE;
+
+  gtk_widget_queue_resize (GTK_WIDGET (self));
+}
+
+static void
+layout_flush_solving (EmeusConstraintLayout *self)
+{
+  if (!self->solve_pending)
+    return;
+
+  self->solve_pending = FALSE;
+  solver_thaw (&self->solver);
+}
+
+/* Values read outside of the size allocation need to be up to date */
+static void
+child_flush_solving (EmeusConstraintLayoutChild *child)
+{
+  GtkWidget *parent = gtk_widget_get_parent (GTK_WIDGET (child));
+
+  if (parent != NULL)
+    layout_flush_solving (EMEUS_CONSTRAINT_LAYOUT (parent));
+}
+
+typedef struct {
+  Variable *variable;
+
+  /* The required edit constraint driving the variable */
+  Constraint *edit;
+} LayoutMetric;
+
+static void
+layout_metric_free (gpointer data)
+{
+  LayoutMetric *metric = data;
+
+  solver_remove_constraint (metric->edit->solver, metric->edit);
+  variable_unref (metric->variable);
+
+  g_slice_free (LayoutMetric, metric);
+}
+
+static LayoutMetric *
+get_layout_metric (EmeusConstraintLayout *layout,
+                   const char            *name,
+                   double                 value)
+{
+  LayoutMetric *metric;
+
+  metric = g_hash_table_lookup (layout->metrics, name);
+  if (metric != NULL)
+    return metric;
+
+  ensure_solver (layout);
+
+  metric = g_slice_new (LayoutMetric);
+  metric->variable = solver_create_variable (&layout->solver, name, value);
+  variable_set_prefix (metric->variable, "metric");
+  metric->edit =
+    solver_add_edit_variable (&layout->solver, metric->variable, STRENGTH_REQUIRED);
+
+  g_hash_table_insert (layout->metrics, (gpointer) g_intern_string (name), metric);
+
+  return metric;
+}
+
 static Variable *
 get_layout_attribute (EmeusConstraintLayout   *layout,
                       EmeusConstraintAttribute attr)
@@ -263,15 +437,16 @@ get_layout_attribute (EmeusConstraintLayout   *layout,
         attr = EMEUS_CONSTRAINT_ATTRIBUTE_RIGHT;
     }
 
-  const char *attr_name = get_attribute_name (attr);
-  Variable *res = g_hash_table_lookup (layout->bound_attributes, attr_name);
+  ensure_solver (layout);
+
+  Variable *res = layout->bound_attributes[attr];
   if (res != NULL)
     return res;
 
-  res = simplex_solver_create_variable (&layout->solver, attr_name, 0.0);
+  res = solver_create_variable (&layout->solver, get_attribute_name (attr), 0.0);
   variable_set_prefix (res, "super");
 
-  g_hash_table_insert (layout->bound_attributes, (gpointer) attr_name, res);
+  layout->bound_attributes[attr] = res;
 
   /* Some attributes are really constraints computed from other
    * attributes, to avoid creating additional constraints from
@@ -287,9 +462,9 @@ get_layout_attribute (EmeusConstraintLayout   *layout,
         Expression *expr =
           expression_plus_variable (expression_new_from_variable (left), width);
 
-        simplex_solver_add_constraint (&layout->solver,
-                                       res, OPERATOR_TYPE_EQ, expr,
-                                       STRENGTH_MEDIUM);
+        solver_add_constraint (&layout->solver,
+                               res, OPERATOR_TYPE_EQ, expr,
+                               STRENGTH_MEDIUM);
 
         expression_unref (expr);
       }
@@ -303,9 +478,9 @@ get_layout_attribute (EmeusConstraintLayout   *layout,
         Expression *expr =
           expression_plus_variable (expression_new_from_variable (top), height);
 
-        simplex_solver_add_constraint (&layout->solver,
-                                       res, OPERATOR_TYPE_EQ, expr,
-                                       STRENGTH_MEDIUM);
+        solver_add_constraint (&layout->solver,
+                               res, OPERATOR_TYPE_EQ, expr,
+                               STRENGTH_MEDIUM);
 
         expression_unref (expr);
       }
@@ -319,9 +494,9 @@ get_layout_attribute (EmeusConstraintLayout   *layout,
         Expression *expr =
           expression_plus_variable (expression_divide (expression_new_from_variable (width), 2.0), left);
 
-        simplex_solver_add_constraint (&layout->solver,
-                                       res, OPERATOR_TYPE_EQ, expr,
-                                       STRENGTH_REQUIRED);
+        solver_add_constraint (&layout->solver,
+                               res, OPERATOR_TYPE_EQ, expr,
+                               STRENGTH_REQUIRED);
 
         expression_unref (expr);
       }
@@ -335,9 +510,9 @@ get_layout_attribute (EmeusConstraintLayout   *layout,
         Expression *expr =
           expression_plus_variable (expression_divide (expression_new_from_variable (height), 2.0), top);
 
-        simplex_solver_add_constraint (&layout->solver,
-                                       res, OPERATOR_TYPE_EQ, expr,
-                                       STRENGTH_REQUIRED);
+        solver_add_constraint (&layout->solver,
+                               res, OPERATOR_TYPE_EQ, expr,
+                               STRENGTH_REQUIRED);
 
         expression_unref (expr);
       }
@@ -347,9 +522,9 @@ get_layout_attribute (EmeusConstraintLayout   *layout,
     case EMEUS_CONSTRAINT_ATTRIBUTE_HEIGHT:
       {
         Expression *expr = expression_new_from_constant (0.0);
-        simplex_solver_add_constraint (&layout->solver,
-                                       res, OPERATOR_TYPE_GE, expr,
-                                       STRENGTH_REQUIRED);
+        solver_add_constraint (&layout->solver,
+                               res, OPERATOR_TYPE_GE, expr,
+                               STRENGTH_REQUIRED);
 
         expression_unref (expr);
       }
@@ -386,15 +561,14 @@ get_child_attribute (EmeusConstraintLayoutChild *child,
         attr = EMEUS_CONSTRAINT_ATTRIBUTE_RIGHT;
     }
 
-  const char *attr_name = get_attribute_name (attr);
-  Variable *res = g_hash_table_lookup (child->bound_attributes, attr_name);
+  Variable *res = child->bound_attributes[attr];
   if (res != NULL)
     return res;
 
-  res = simplex_solver_create_variable (child->solver, attr_name, 0.0);
+  res = solver_create_variable (child->solver, get_attribute_name (attr), 0.0);
   variable_set_prefix (res, child->name);
 
-  g_hash_table_insert (child->bound_attributes, (gpointer) attr_name, res);
+  child->bound_attributes[attr] = res;
 
   /* Some attributes are really constraints computed from other
    * attributes, to avoid creating additional constraints from
@@ -411,9 +585,9 @@ get_child_attribute (EmeusConstraintLayoutChild *child,
           expression_plus_variable (expression_new_from_variable (left), width);
 
         child->right_constraint =
-          simplex_solver_add_constraint (child->solver,
-                                         res, OPERATOR_TYPE_EQ, expr,
-                                         STRENGTH_MEDIUM);
+          solver_add_constraint (child->solver,
+                                 res, OPERATOR_TYPE_EQ, expr,
+                                 STRENGTH_MEDIUM);
 
         expression_unref (expr);
       }
@@ -428,9 +602,9 @@ get_child_attribute (EmeusConstraintLayoutChild *child,
           expression_plus_variable (expression_new_from_variable (top), height);
 
         child->bottom_constraint =
-          simplex_solver_add_constraint (child->solver,
-                                         res, OPERATOR_TYPE_EQ, expr,
-                                         STRENGTH_MEDIUM);
+          solver_add_constraint (child->solver,
+                                 res, OPERATOR_TYPE_EQ, expr,
+                                 STRENGTH_MEDIUM);
 
         expression_unref (expr);
       }
@@ -445,9 +619,9 @@ get_child_attribute (EmeusConstraintLayoutChild *child,
           expression_plus_variable (expression_divide (expression_new_from_variable (width), 2.0), left);
 
         child->center_x_constraint =
-          simplex_solver_add_constraint (child->solver,
-                                         res, OPERATOR_TYPE_EQ, expr,
-                                         STRENGTH_REQUIRED);
+          solver_add_constraint (child->solver,
+                                 res, OPERATOR_TYPE_EQ, expr,
+                                 STRENGTH_REQUIRED);
 
         expression_unref (expr);
       }
@@ -462,9 +636,9 @@ get_child_attribute (EmeusConstraintLayoutChild *child,
           expression_plus_variable (expression_divide (expression_new_from_variable (height), 2.0), top);
 
         child->center_y_constraint =
-          simplex_solver_add_constraint (child->solver,
-                                         res, OPERATOR_TYPE_EQ, expr,
-                                         STRENGTH_REQUIRED);
+          solver_add_constraint (child->solver,
+                                 res, OPERATOR_TYPE_EQ, expr,
+                                 STRENGTH_REQUIRED);
 
         expression_unref (expr);
       }
@@ -474,9 +648,9 @@ get_child_attribute (EmeusConstraintLayoutChild *child,
     case EMEUS_CONSTRAINT_ATTRIBUTE_HEIGHT:
       {
         Expression *expr = expression_new_from_constant (0.0);
-        simplex_solver_add_constraint (child->solver,
-                                       res, OPERATOR_TYPE_GE, expr,
-                                       STRENGTH_REQUIRED);
+        solver_add_constraint (child->solver,
+                               res, OPERATOR_TYPE_GE, expr,
+                               STRENGTH_REQUIRED);
 
         expression_unref (expr);
       }
@@ -490,42 +664,27 @@ get_child_attribute (EmeusConstraintLayoutChild *child,
 }
 
 static void
-add_layout_stays (EmeusConstraintLayout *self)
+measure_children (EmeusConstraintLayout *self)
 {
-  Variable *var;
-
-  /* Add two required stay constraints for the top left corner */
-  var = simplex_solver_create_variable (&self->solver, "top", 0.0);
-  variable_set_prefix (var, "super");
-  g_hash_table_insert (self->bound_attributes,
-                       (gpointer) get_attribute_name (EMEUS_CONSTRAINT_ATTRIBUTE_TOP),
-                       var);
-  self->stays.top =
-    simplex_solver_add_stay_variable (&self->solver, var, STRENGTH_WEAK);
-
-  var = simplex_solver_create_variable (&self->solver, "left", 0.0);
-  variable_set_prefix (var, "super");
-  g_hash_table_insert (self->bound_attributes,
-                       (gpointer) get_attribute_name (EMEUS_CONSTRAINT_ATTRIBUTE_LEFT),
-                       var);
-  self->stays.left =
-    simplex_solver_add_stay_variable (&self->solver, var, STRENGTH_WEAK);
-
-  var = simplex_solver_create_variable (&self->solver, "width", 0.0);
-  variable_set_prefix (var, "super");
-  g_hash_table_insert (self->bound_attributes,
-                       (gpointer) get_attribute_name (EMEUS_CONSTRAINT_ATTRIBUTE_WIDTH),
-                       var);
-  self->stays.width =
-    simplex_solver_add_stay_variable (&self->solver, var, STRENGTH_WEAK);
+  guint i;
+
+  /* GTK only asks for the layout's size after a resize has been queued
+   * on it or on one of its descendants, so this is where we measure the
+   * children; the minimum sizes are kept for the size allocation that
+   * follows, which would otherwise have to query them again. GTK caches
+   * the size of each child until a resize is queued on it, so measuring
+   * the children every time the layout is measured is cheap, and keeps
+   * the minimum sizes up to date even if the layout is measured without
+   * being allocated. Measuring a child also updates its minimum size
+   * constraints in the solver.
+   */
+  for (i = 0; i < self->children->len; i++)
+    {
+      EmeusConstraintLayoutChild *child = g_ptr_array_index (self->children, i);
 
-  var = simplex_solver_create_variable (&self->solver, "height", 0.0);
-  variable_set_prefix (var, "super");
-  g_hash_table_insert (self->bound_attributes,
-                       (gpointer) get_attribute_name (EMEUS_CONSTRAINT_ATTRIBUTE_HEIGHT),
-                       var);
-  self->stays.height =
-    simplex_solver_add_stay_variable (&self->solver, var, STRENGTH_WEAK);
+      gtk_widget_get_preferred_size (GTK_WIDGET (child), &child->minimum, NULL);
+      child->minimum_valid = TRUE;
+    }
 }
 
 static void
@@ -538,7 +697,7 @@ emeus_constraint_layout_get_preferred_size (EmeusConstraintLayout *self,
   Variable *size = NULL;
   Variable *opposite_size = NULL;
 
-  if (g_sequence_is_empty (self->children))
+  if (self->children->len == 0)
     {
       if (minimum_p != NULL)
         *minimum_p = 0;
@@ -565,6 +724,9 @@ emeus_constraint_layout_get_preferred_size (EmeusConstraintLayout *self,
   g_assert (size != NULL);
   g_assert (opposite_size != NULL);
 
+  measure_children (self);
+  layout_flush_solving (self);
+
   /* We impose new temporary stay constraints on the size and its opposite,
    * with a low priority so that the solver will revert to the preferred
    * size of the layout for the duration of this function.
@@ -574,27 +736,27 @@ emeus_constraint_layout_get_preferred_size (EmeusConstraintLayout *self,
    * function, whose job is to keep the layout origin and size greather than
    * or equal to zero. If we used the same priority, the solver would be in
    * an unstable state, and randomly fall back to a preferred size of 0.
+   *
+   * The stays are added inside a transaction, which we roll back once we
+   * have read the size; this restores the tableau without pivoting it back.
    */
-  variable_set_value (size, 0.0);
+  solver_begin_transaction (&self->solver);
 
-  Constraint *stay_s =
-    simplex_solver_add_stay_variable (&self->solver, size, STRENGTH_WEAK + 1);
+  variable_set_value (size, 0.0);
+  solver_add_stay_variable (&self->solver, size, STRENGTH_WEAK + 1);
 
   variable_set_value (opposite_size, for_size > 0 ? for_size : 0.0);
-
-  Constraint *stay_o =
-    simplex_solver_add_stay_variable (&self->solver, opposite_size, STRENGTH_WEAK + 1);
+  solver_add_stay_variable (&self->solver, opposite_size, STRENGTH_WEAK + 1);
 
   DEBUG (g_debug ("layout %p preferred %s size: %.3f (for opposite size: %d)",
                   self,
                   orientation == GTK_ORIENTATION_HORIZONTAL ? "horizontal" : "vertical",
-                  variable_get_value (size),
+                  solver_get_value (&self->solver, size),
                   for_size));
 
-  double value = variable_get_value (size);
+  double value = solver_get_value (&self->solver, size);
 
-  simplex_solver_remove_constraint (&self->solver, stay_s);
-  simplex_solver_remove_constraint (&self->solver, stay_o);
+  solver_rollback_transaction (&self->solver);
 
   if (minimum_p != NULL)
     *minimum_p = value;
@@ -648,247 +810,604 @@ emeus_constraint_layout_get_preferred_height_for_width (GtkWidget *widget,
                                               minimum_p, natural_p);
 }
 
+/* The attributes of the layout, and of its children, indexed by ALLOCATION_* */
+static const EmeusConstraintAttribute allocation_attributes[N_ALLOCATION_PARAMS] = {
+  EMEUS_CONSTRAINT_ATTRIBUTE_LEFT,
+  EMEUS_CONSTRAINT_ATTRIBUTE_TOP,
+  EMEUS_CONSTRAINT_ATTRIBUTE_WIDTH,
+  EMEUS_CONSTRAINT_ATTRIBUTE_HEIGHT,
+};
+
 static void
-emeus_constraint_layout_size_allocate (GtkWidget     *widget,
-                                       GtkAllocation *allocation)
+layout_clear_sensitivity (EmeusConstraintLayout *self)
 {
-  EmeusConstraintLayout *self = EMEUS_CONSTRAINT_LAYOUT (widget);
-  Constraint *stay_x, *stay_y;
-  Constraint *stay_w, *stay_h;
-
-  gtk_widget_set_allocation (widget, allocation);
-
-  if (g_sequence_is_empty (self->children))
-    return;
-
-  Variable *layout_top = get_layout_attribute (self, EMEUS_CONSTRAINT_ATTRIBUTE_TOP);
-  Variable *layout_left = get_layout_attribute (self, EMEUS_CONSTRAINT_ATTRIBUTE_LEFT);
-  Variable *layout_width = get_layout_attribute (self, EMEUS_CONSTRAINT_ATTRIBUTE_WIDTH);
-  Variable *layout_height = get_layout_attribute (self, EMEUS_CONSTRAINT_ATTRIBUTE_HEIGHT);
-
-  variable_set_value (layout_left, allocation->x);
-  stay_x = simplex_solver_add_stay_variable (&self->solver, layout_left, STRENGTH_REQUIRED);
-
-  variable_set_value (layout_top, allocation->y);
-  stay_y = simplex_solver_add_stay_variable (&self->solver, layout_top, STRENGTH_REQUIRED);
-
-  variable_set_value (layout_width, allocation->width);
-  stay_w = simplex_solver_add_stay_variable (&self->solver, layout_width, STRENGTH_REQUIRED);
-
-  variable_set_value (layout_height, allocation->height);
-  stay_h = simplex_solver_add_stay_variable (&self->solver, layout_height, STRENGTH_REQUIRED);
-
-#ifdef EMEUS_ENABLE_DEBUG
-  DEBUG (g_debug ("layout [%p] = { .top:%g, .left:%g, .width:%g, .height:%g }",
-                  self,
-                  variable_get_value (layout_top),
-                  variable_get_value (layout_left),
-                  variable_get_value (layout_width),
-                  variable_get_value (layout_height)));
-#endif
-
-  EmeusConstraintLayoutChild *child = NULL;
-  GSequenceIter *iter = g_sequence_get_begin_iter (self->children);
-
-  while (!g_sequence_iter_is_end (iter))
-    {
-      Variable *top, *left, *width, *height;
-      Variable *center_x, *center_y;
-      Variable *baseline;
-      GtkAllocation child_alloc;
-      GtkRequisition minimum;
-
-      child = g_sequence_get (iter);
-      iter = g_sequence_iter_next (iter);
-
-      top = get_child_attribute (child, EMEUS_CONSTRAINT_ATTRIBUTE_TOP);
-      left = get_child_attribute (child, EMEUS_CONSTRAINT_ATTRIBUTE_LEFT);
-      width = get_child_attribute (child, EMEUS_CONSTRAINT_ATTRIBUTE_WIDTH);
-      height = get_child_attribute (child, EMEUS_CONSTRAINT_ATTRIBUTE_HEIGHT);
-      center_x = get_child_attribute (child, EMEUS_CONSTRAINT_ATTRIBUTE_CENTER_X);
-      center_y = get_child_attribute (child, EMEUS_CONSTRAINT_ATTRIBUTE_CENTER_Y);
-      baseline = get_child_attribute (child, EMEUS_CONSTRAINT_ATTRIBUTE_BASELINE);
+  g_clear_pointer (&self->sensitivity.region, g_array_unref);
+}
 
-#ifdef EMEUS_ENABLE_DEBUG
-      DEBUG (g_debug ("child '%s' [%p] = { "
-                      ".top:%g, .left:%g, .width:%g, .height:%g, "
-                      ".center:(%g, %g), .baseline:%g "
-                      "}",
-                      child->name != NULL ? child->name : "<unnamed>",
-                      child,
-                      variable_get_value (top),
-                      variable_get_value (left),
-                      variable_get_value (width),
-                      variable_get_value (height),
-                      variable_get_value (center_x), variable_get_value (center_y),
-                      variable_get_value (baseline)));
-#endif
+/* The number of allocations kept by default in the allocation cache,
+ * enough to cover toggling between a few window states
+ */
+#define DEFAULT_ALLOCATION_CACHE_SIZE   4
 
-      gtk_widget_get_preferred_size (GTK_WIDGET (child), &minimum, NULL);
+typedef struct {
+  GtkRequisition minimum;
+  GtkAllocation allocation;
+} CachedChildAllocation;
 
-      child_alloc.x = floor (variable_get_value (left));
-      child_alloc.y = floor (variable_get_value (top));
-      child_alloc.width = variable_get_value (width) > minimum.width
-                        ? ceil (variable_get_value (width))
-                        : minimum.width;
-      child_alloc.height = variable_get_value (height) > minimum.height
-                         ? ceil (variable_get_value (height))
-                         : minimum.height;
+typedef struct {
+  /* The generation of the solver the allocations were computed for */
+  guint generation;
 
-      gtk_widget_size_allocate (GTK_WIDGET (child), &child_alloc);
-    }
+  GtkAllocation allocation;
 
-  simplex_solver_remove_constraint (&self->solver, stay_x);
-  simplex_solver_remove_constraint (&self->solver, stay_y);
-  simplex_solver_remove_constraint (&self->solver, stay_w);
-  simplex_solver_remove_constraint (&self->solver, stay_h);
-}
+  /* Array<CachedChildAllocation>, indexed like the children array */
+  CachedChildAllocation *children;
+  guint n_children;
+} AllocationCacheEntry;
 
-static gboolean
-emeus_constraint_layout_draw (GtkWidget *widget,
-                              cairo_t   *cr)
+static void
+allocation_cache_entry_free (gpointer data)
 {
-  GtkStyleContext *context = gtk_widget_get_style_context (widget);
-  int width = gtk_widget_get_allocated_width (widget);
-  int height = gtk_widget_get_allocated_height (widget);
+  AllocationCacheEntry *entry = data;
 
-  gtk_render_background (context, cr, 0, 0, width, height);
-  gtk_render_frame (context, cr, 0, 0, width, height);
-
-  return GTK_WIDGET_CLASS (emeus_constraint_layout_parent_class)->draw (widget, cr);
+  g_free (entry->children);
+  g_slice_free (AllocationCacheEntry, entry);
 }
 
 static void
-emeus_constraint_layout_add (GtkContainer *container,
-                             GtkWidget    *widget)
+layout_clear_allocation_cache (EmeusConstraintLayout *self)
 {
-  EmeusConstraintLayout *self = EMEUS_CONSTRAINT_LAYOUT (container);
+  if (self->allocation_cache.entries == NULL)
+    return;
 
-  emeus_constraint_layout_pack (self, widget, NULL, NULL);
+  g_queue_free_full (self->allocation_cache.entries, allocation_cache_entry_free);
+  self->allocation_cache.entries = NULL;
 }
 
 static void
-remove_constraints_from_widget (GHashTable *constraints,
-                                GtkWidget  *widget)
+layout_trim_allocation_cache (EmeusConstraintLayout *self)
 {
-  GHashTableIter iter;
-  gpointer key;
+  GQueue *entries = self->allocation_cache.entries;
 
-  if (constraints == NULL || widget == NULL)
+  if (entries == NULL)
     return;
 
-  g_hash_table_iter_init (&iter, constraints);
-  while (g_hash_table_iter_next (&iter, &key, NULL))
-    {
-      EmeusConstraint *constraint = key;
-      GtkWidget *real_target = constraint->target_object;
+  while (g_queue_get_length (entries) > self->allocation_cache.max_size)
+    allocation_cache_entry_free (g_queue_pop_tail (entries));
 
-      if (real_target == NULL)
-        continue;
+  if (g_queue_is_empty (entries))
+    layout_clear_allocation_cache (self);
+}
 
-      if (EMEUS_IS_CONSTRAINT_LAYOUT_CHILD (real_target))
-        real_target = gtk_bin_get_child (GTK_BIN (real_target));
+static gboolean
+allocation_cache_entry_matches (const AllocationCacheEntry *entry,
+                                EmeusConstraintLayout      *self,
+                                const GtkAllocation        *allocation)
+{
+  guint i;
 
-      if (constraint->source_object == widget || real_target == widget)
-        {
-          emeus_constraint_detach (constraint);
-          g_hash_table_iter_remove (&iter);
-        }
+  if (entry->n_children != self->children->len)
+    return FALSE;
+
+  if (!gdk_rectangle_equal (&entry->allocation, allocation))
+    return FALSE;
+
+  /* The minimum size of the children is not part of the solver, but
+   * it's used to clamp the allocation of each child
+   */
+  for (i = 0; i < entry->n_children; i++)
+    {
+      EmeusConstraintLayoutChild *child = g_ptr_array_index (self->children, i);
+      const GtkRequisition *minimum = &entry->children[i].minimum;
+
+      if (minimum->width != child->minimum.width ||
+          minimum->height != child->minimum.height)
+        return FALSE;
     }
+
+  return TRUE;
 }
 
-static void
-emeus_constraint_layout_remove (GtkContainer *container,
-                                GtkWidget    *widget)
+static gboolean
+layout_allocate_from_cache (EmeusConstraintLayout *self,
+                            const GtkAllocation   *allocation)
 {
-  EmeusConstraintLayout *self = EMEUS_CONSTRAINT_LAYOUT (container);
-  EmeusConstraintLayoutChild *layout_child;
-  GtkWidget *child;
-  GSequenceIter *iter;
+  GQueue *entries = self->allocation_cache.entries;
+  guint generation;
+  GList *l;
 
-  if (EMEUS_IS_CONSTRAINT_LAYOUT_CHILD (widget))
-    {
-      layout_child = EMEUS_CONSTRAINT_LAYOUT_CHILD (widget);
-      child = gtk_bin_get_child (GTK_BIN (widget));
-    }
-  else
+  if (self->allocation_cache.max_size == 0)
+    return FALSE;
+
+  generation = simplex_solver_get_generation (&self->solver);
+
+  l = entries != NULL ? entries->head : NULL;
+  while (l != NULL)
     {
-      GtkWidget *parent = gtk_widget_get_parent (widget);
+      AllocationCacheEntry *entry = l->data;
+      GList *next = l->next;
+      guint i;
+
+      /* The generation of the solver changes whenever the committed set
+       * of constraints, or the value of an edit variable, changes; the
+       * allocation transaction is rolled back, which restores the
+       * generation, before an entry is stored, so entries are always
+       * tagged with a committed generation, and one that does not match
+       * the current generation cannot be used any more
+       */
+      if (entry->generation != generation)
+        {
+          allocation_cache_entry_free (entry);
+          g_queue_delete_link (entries, l);
+          l = next;
+          continue;
+        }
 
-      if (EMEUS_IS_CONSTRAINT_LAYOUT_CHILD (parent))
+      if (!allocation_cache_entry_matches (entry, self, allocation))
         {
-          layout_child = EMEUS_CONSTRAINT_LAYOUT_CHILD (parent);
-          child = widget;
+          l = next;
+          continue;
         }
-      else
+
+      g_queue_unlink (entries, l);
+      g_queue_push_head_link (entries, l);
+
+      for (i = 0; i < entry->n_children; i++)
         {
-          g_critical ("Attempting to remove widget '%s' but "
-                      "it's not a child of the layout",
-                      G_OBJECT_TYPE_NAME (widget));
-          return;
+          EmeusConstraintLayoutChild *child = g_ptr_array_index (self->children, i);
+
+          child->allocation = entry->children[i].allocation;
         }
-    }
 
-  if (g_sequence_iter_get_sequence (layout_child->iter) != self->children)
-    {
-      g_critical ("Tried to remove non child %p", layout_child);
-      return;
-    }
+      self->allocation_cache.n_hits += 1;
 
-  /* Remove layout constraints */
-  remove_constraints_from_widget (self->constraints, child);
+#ifdef EMEUS_ENABLE_DEBUG
+      DEBUG (g_debug ("layout [%p] allocation cache hit (hit rate: %.1f%%)",
+                      self,
+                      emeus_constraint_layout_get_allocation_cache_hit_rate (self) * 100.0));
+#endif
 
-  /* Remove other children constraints */
-  iter = g_sequence_get_begin_iter (self->children);
-  while (!g_sequence_iter_is_end (iter))
-    {
-      EmeusConstraintLayoutChild *other = g_sequence_get (iter);
-      remove_constraints_from_widget (other->constraints, child);
-      iter = g_sequence_iter_next (iter);
+      return TRUE;
     }
 
-  gboolean was_visible = gtk_widget_get_visible (GTK_WIDGET (layout_child));
+  self->allocation_cache.n_misses += 1;
 
-  gtk_widget_unparent (GTK_WIDGET (layout_child));
-  g_sequence_remove (layout_child->iter);
+#ifdef EMEUS_ENABLE_DEBUG
+  DEBUG (g_debug ("layout [%p] allocation cache miss (hit rate: %.1f%%)",
+                  self,
+                  emeus_constraint_layout_get_allocation_cache_hit_rate (self) * 100.0));
+#endif
 
-  if (was_visible && gtk_widget_get_visible (GTK_WIDGET (container)))
-    gtk_widget_queue_resize (GTK_WIDGET (container));
+  return FALSE;
 }
 
 static void
-emeus_constraint_layout_forall (GtkContainer *container,
-                                gboolean      internals,
-                                GtkCallback   callback,
-                                gpointer      data)
+layout_add_to_allocation_cache (EmeusConstraintLayout *self,
+                                const GtkAllocation   *allocation)
 {
-  EmeusConstraintLayout *self = EMEUS_CONSTRAINT_LAYOUT (container);
+  AllocationCacheEntry *entry;
+  guint i;
 
-  if (g_sequence_is_empty (self->children))
+  if (self->allocation_cache.max_size == 0)
     return;
 
-  GtkWidget *child;
-  GSequenceIter *iter = g_sequence_get_begin_iter (self->children);
+  entry = g_slice_new (AllocationCacheEntry);
+  entry->generation = simplex_solver_get_generation (&self->solver);
+  entry->allocation = *allocation;
+  entry->n_children = self->children->len;
+  entry->children = g_new (CachedChildAllocation, entry->n_children);
 
-  while (!g_sequence_iter_is_end (iter))
+  for (i = 0; i < entry->n_children; i++)
     {
-      child = g_sequence_get (iter);
-      iter = g_sequence_iter_next (iter);
+      EmeusConstraintLayoutChild *child = g_ptr_array_index (self->children, i);
 
-      callback (child, data);
+      entry->children[i].minimum = child->minimum;
+      entry->children[i].allocation = child->allocation;
     }
+
+  if (self->allocation_cache.entries == NULL)
+    self->allocation_cache.entries = g_queue_new ();
+
+  g_queue_push_head (self->allocation_cache.entries, entry);
+
+  layout_trim_allocation_cache (self);
 }
 
-static GType
-emeus_constraint_layout_child_type (GtkContainer *container)
+static void
+child_set_allocation (EmeusConstraintLayoutChild *child,
+                      const double               *values)
 {
-  return EMEUS_TYPE_CONSTRAINT_LAYOUT_CHILD;
+  GtkAllocation *child_alloc = &child->allocation;
+  double width = values[ALLOCATION_WIDTH];
+  double height = values[ALLOCATION_HEIGHT];
+
+  child_alloc->x = floor (values[ALLOCATION_LEFT]);
+  child_alloc->y = floor (values[ALLOCATION_TOP]);
+  child_alloc->width = width > child->minimum.width
+                     ? ceil (width)
+                     : child->minimum.width;
+  child_alloc->height = height > child->minimum.height
+                      ? ceil (height)
+                      : child->minimum.height;
 }
 
-#define TAG_CONSTRAINTS "constraints"
-#define TAG_CONSTRAINT  "constraint"
-
-#define ATTR_SOURCE_OBJECT      "source-object"
+/* While the layout is resized, the basis of the solver usually stays
+ * the same, and only the constants of the tableau change; as long as
+ * the new allocation is inside the region in which the basis stays
+ * feasible, the allocation of each child is a linear function of the
+ * allocation of the layout, and we can skip the solver entirely
+ */
+static gboolean
+layout_allocate_from_sensitivity (EmeusConstraintLayout *self,
+                                  const GtkAllocation   *allocation)
+{
+  GArray *region = self->sensitivity.region;
+  double deltas[N_ALLOCATION_PARAMS];
+  guint i, j, k;
+
+  if (region == NULL)
+    return FALSE;
+
+  if (self->sensitivity.generation != simplex_solver_get_generation (&self->solver))
+    {
+      layout_clear_sensitivity (self);
+      return FALSE;
+    }
+
+  deltas[ALLOCATION_LEFT] = allocation->x - self->sensitivity.allocation.x;
+  deltas[ALLOCATION_TOP] = allocation->y - self->sensitivity.allocation.y;
+  deltas[ALLOCATION_WIDTH] = allocation->width - self->sensitivity.allocation.width;
+  deltas[ALLOCATION_HEIGHT] = allocation->height - self->sensitivity.allocation.height;
+
+  for (i = 0; i < region->len; i += N_ALLOCATION_PARAMS + 1)
+    {
+      const double *half_space = &g_array_index (region, double, i);
+      double value = half_space[0];
+
+      for (j = 0; j < N_ALLOCATION_PARAMS; j++)
+        value += half_space[j + 1] * deltas[j];
+
+      if (value < 0.0 && !approx_val (value, 0.0))
+        return FALSE;
+    }
+
+  for (i = 0; i < self->children->len; i++)
+    {
+      EmeusConstraintLayoutChild *child = g_ptr_array_index (self->children, i);
+      double values[N_ALLOCATION_PARAMS];
+
+      for (j = 0; j < N_ALLOCATION_PARAMS; j++)
+        {
+          values[j] = child->allocation_values[j];
+
+          for (k = 0; k < N_ALLOCATION_PARAMS; k++)
+            values[j] += child->allocation_slopes[j][k] * deltas[k];
+        }
+
+      child_set_allocation (child, values);
+    }
+
+#ifdef EMEUS_ENABLE_DEBUG
+  DEBUG (g_debug ("layout [%p] allocated from the current basis "
+                  "(delta: { .left:%g, .top:%g, .width:%g, .height:%g })",
+                  self,
+                  deltas[ALLOCATION_LEFT],
+                  deltas[ALLOCATION_TOP],
+                  deltas[ALLOCATION_WIDTH],
+                  deltas[ALLOCATION_HEIGHT]));
+#endif
+
+  return TRUE;
+}
+
+static void
+layout_allocate_from_solver (EmeusConstraintLayout *self,
+                             const GtkAllocation   *allocation)
+{
+  Constraint *params[N_ALLOCATION_PARAMS];
+  double layout_values[N_ALLOCATION_PARAMS];
+  gboolean has_sensitivity;
+  guint i, j;
+
+  layout_clear_sensitivity (self);
+
+  /* Only the Cassowary tableau can be queried for the sensitivity of
+   * the solution
+   */
+  has_sensitivity = solver_has_tableau (&self->solver);
+
+  layout_values[ALLOCATION_LEFT] = allocation->x;
+  layout_values[ALLOCATION_TOP] = allocation->y;
+  layout_values[ALLOCATION_WIDTH] = allocation->width;
+  layout_values[ALLOCATION_HEIGHT] = allocation->height;
+
+  /* The layout's own allocation is imposed using required stays, which
+   * are discarded by rolling back the transaction once we have read the
+   * allocation of each child
+   */
+  solver_begin_transaction (&self->solver);
+
+  for (i = 0; i < N_ALLOCATION_PARAMS; i++)
+    {
+      Variable *variable = get_layout_attribute (self, allocation_attributes[i]);
+
+      variable_set_value (variable, layout_values[i]);
+      params[i] = solver_add_stay_variable (&self->solver, variable, STRENGTH_REQUIRED);
+    }
+
+#ifdef EMEUS_ENABLE_DEBUG
+  DEBUG (g_debug ("layout [%p] = { .top:%g, .left:%g, .width:%g, .height:%g }",
+                  self,
+                  layout_values[ALLOCATION_TOP],
+                  layout_values[ALLOCATION_LEFT],
+                  layout_values[ALLOCATION_WIDTH],
+                  layout_values[ALLOCATION_HEIGHT]));
+#endif
+
+  for (i = 0; i < self->children->len; i++)
+    {
+      EmeusConstraintLayoutChild *child = g_ptr_array_index (self->children, i);
+      Variable **attrs = child->bound_attributes;
+
+#ifdef EMEUS_ENABLE_DEBUG
+      DEBUG (g_debug ("child '%s' [%p] = { "
+                      ".top:%g, .left:%g, .width:%g, .height:%g, "
+                      ".center:(%g, %g), .baseline:%g "
+                      "}",
+                      child->name != NULL ? child->name : "<unnamed>",
+                      child,
+                      solver_get_value (&self->solver, attrs[EMEUS_CONSTRAINT_ATTRIBUTE_TOP]),
+                      solver_get_value (&self->solver, attrs[EMEUS_CONSTRAINT_ATTRIBUTE_LEFT]),
+                      solver_get_value (&self->solver, attrs[EMEUS_CONSTRAINT_ATTRIBUTE_WIDTH]),
+                      solver_get_value (&self->solver, attrs[EMEUS_CONSTRAINT_ATTRIBUTE_HEIGHT]),
+                      solver_get_value (&self->solver, attrs[EMEUS_CONSTRAINT_ATTRIBUTE_CENTER_X]),
+                      solver_get_value (&self->solver, attrs[EMEUS_CONSTRAINT_ATTRIBUTE_CENTER_Y]),
+                      solver_get_value (&self->solver, attrs[EMEUS_CONSTRAINT_ATTRIBUTE_BASELINE])));
+#endif
+
+      for (j = 0; j < N_ALLOCATION_PARAMS; j++)
+        {
+          Variable *variable = attrs[allocation_attributes[j]];
+
+          child->allocation_values[j] = solver_get_value (&self->solver, variable);
+
+          if (has_sensitivity)
+            has_sensitivity = simplex_solver_get_sensitivity (&self->solver,
+                                                              params,
+                                                              N_ALLOCATION_PARAMS,
+                                                              variable,
+                                                              child->allocation_slopes[j]);
+        }
+
+      child_set_allocation (child, child->allocation_values);
+    }
+
+  if (has_sensitivity)
+    self->sensitivity.region = simplex_solver_get_feasible_region (&self->solver,
+                                                                   params,
+                                                                   N_ALLOCATION_PARAMS);
+
+  solver_rollback_transaction (&self->solver);
+
+  /* Rolling back restores the generation of the solver, so the model
+   * is valid until the constraints or the edit variables change
+   */
+  self->sensitivity.generation = simplex_solver_get_generation (&self->solver);
+  self->sensitivity.allocation = *allocation;
+}
+
+static void
+emeus_constraint_layout_size_allocate (GtkWidget     *widget,
+                                       GtkAllocation *allocation)
+{
+  EmeusConstraintLayout *self = EMEUS_CONSTRAINT_LAYOUT (widget);
+  guint i;
+
+  gtk_widget_set_allocation (widget, allocation);
+
+  if (self->children->len == 0)
+    return;
+
+  /* Resolving the attributes of a child, and measuring it, may add
+   * permanent constraints to the solver, so we need to do it before
+   * opening the transaction for the allocation
+   */
+  for (i = 0; i < self->children->len; i++)
+    {
+      EmeusConstraintLayoutChild *child = g_ptr_array_index (self->children, i);
+
+      get_child_attribute (child, EMEUS_CONSTRAINT_ATTRIBUTE_TOP);
+      get_child_attribute (child, EMEUS_CONSTRAINT_ATTRIBUTE_LEFT);
+      get_child_attribute (child, EMEUS_CONSTRAINT_ATTRIBUTE_WIDTH);
+      get_child_attribute (child, EMEUS_CONSTRAINT_ATTRIBUTE_HEIGHT);
+      get_child_attribute (child, EMEUS_CONSTRAINT_ATTRIBUTE_CENTER_X);
+      get_child_attribute (child, EMEUS_CONSTRAINT_ATTRIBUTE_CENTER_Y);
+      get_child_attribute (child, EMEUS_CONSTRAINT_ATTRIBUTE_BASELINE);
+
+      /* Reuse the minimum size measured while computing the size of
+       * the layout, if any; the cached value is only valid until the
+       * next allocation, after which GTK will ask for the size of the
+       * layout again if anything changed.
+       */
+      if (!child->minimum_valid)
+        gtk_widget_get_preferred_size (GTK_WIDGET (child), &child->minimum, NULL);
+
+      child->minimum_valid = FALSE;
+    }
+
+  layout_flush_solving (self);
+
+  if (!layout_allocate_from_cache (self, allocation))
+    {
+      if (!layout_allocate_from_sensitivity (self, allocation))
+        layout_allocate_from_solver (self, allocation);
+
+      layout_add_to_allocation_cache (self, allocation);
+    }
+
+  for (i = 0; i < self->children->len; i++)
+    {
+      EmeusConstraintLayoutChild *child = g_ptr_array_index (self->children, i);
+
+      gtk_widget_size_allocate (GTK_WIDGET (child), &child->allocation);
+    }
+}
+
+static gboolean
+emeus_constraint_layout_draw (GtkWidget *widget,
+                              cairo_t   *cr)
+{
+  GtkStyleContext *context = gtk_widget_get_style_context (widget);
+  int width = gtk_widget_get_allocated_width (widget);
+  int height = gtk_widget_get_allocated_height (widget);
+
+  gtk_render_background (context, cr, 0, 0, width, height);
+  gtk_render_frame (context, cr, 0, 0, width, height);
+
+  return GTK_WIDGET_CLASS (emeus_constraint_layout_parent_class)->draw (widget, cr);
+}
+
+static void
+emeus_constraint_layout_add (GtkContainer *container,
+                             GtkWidget    *widget)
+{
+  EmeusConstraintLayout *self = EMEUS_CONSTRAINT_LAYOUT (container);
+
+  emeus_constraint_layout_pack (self, widget, NULL, NULL);
+}
+
+static void
+remove_constraints_from_widget (GHashTable *constraints,
+                                GtkWidget  *widget)
+{
+  GHashTableIter iter;
+  gpointer key;
+
+  if (constraints == NULL || widget == NULL)
+    return;
+
+  g_hash_table_iter_init (&iter, constraints);
+  while (g_hash_table_iter_next (&iter, &key, NULL))
+    {
+      EmeusConstraint *constraint = key;
+      GtkWidget *real_target = constraint->target_object;
+
+      if (real_target == NULL)
+        continue;
+
+      if (EMEUS_IS_CONSTRAINT_LAYOUT_CHILD (real_target))
+        real_target = gtk_bin_get_child (GTK_BIN (real_target));
+
+      if (constraint->source_object == widget || real_target == widget)
+        {
+          emeus_constraint_detach (constraint);
+          g_hash_table_iter_remove (&iter);
+        }
+    }
+}
+
+static void
+emeus_constraint_layout_remove (GtkContainer *container,
+                                GtkWidget    *widget)
+{
+  EmeusConstraintLayout *self = EMEUS_CONSTRAINT_LAYOUT (container);
+  EmeusConstraintLayoutChild *layout_child;
+  GtkWidget *child;
+  guint i;
+
+  if (EMEUS_IS_CONSTRAINT_LAYOUT_CHILD (widget))
+    {
+      layout_child = EMEUS_CONSTRAINT_LAYOUT_CHILD (widget);
+      child = gtk_bin_get_child (GTK_BIN (widget));
+    }
+  else
+    {
+      GtkWidget *parent = gtk_widget_get_parent (widget);
+
+      if (EMEUS_IS_CONSTRAINT_LAYOUT_CHILD (parent))
+        {
+          layout_child = EMEUS_CONSTRAINT_LAYOUT_CHILD (parent);
+          child = widget;
+        }
+      else
+        {
+          g_critical ("Attempting to remove widget '%s' but "
+                      "it's not a child of the layout",
+                      G_OBJECT_TYPE_NAME (widget));
+          return;
+        }
+    }
+
+  if (layout_child->index >= self->children->len ||
+      g_ptr_array_index (self->children, layout_child->index) != layout_child)
+    {
+      g_critical ("Tried to remove non child %p", layout_child);
+      return;
+    }
+
+  /* Remove layout constraints */
+  remove_constraints_from_widget (self->constraints, child);
+
+  /* Remove other children constraints */
+  for (i = 0; i < self->children->len; i++)
+    {
+      EmeusConstraintLayoutChild *other = g_ptr_array_index (self->children, i);
+      remove_constraints_from_widget (other->constraints, child);
+    }
+
+  gboolean was_visible = gtk_widget_get_visible (GTK_WIDGET (layout_child));
+
+  gtk_widget_unparent (GTK_WIDGET (layout_child));
+
+  /* We keep the children in insertion order, as it's also the order
+   * in which they are drawn, so we need to update the position of the
+   * children following the one we removed
+   */
+  g_ptr_array_remove_index (self->children, layout_child->index);
+  for (i = layout_child->index; i < self->children->len; i++)
+    ((EmeusConstraintLayoutChild *) g_ptr_array_index (self->children, i))->index = i;
+
+  layout_clear_sensitivity (self);
+  layout_clear_allocation_cache (self);
+
+  if (was_visible && gtk_widget_get_visible (GTK_WIDGET (container)))
+    gtk_widget_queue_resize (GTK_WIDGET (container));
+}
+
+static void
+emeus_constraint_layout_forall (GtkContainer *container,
+                                gboolean      internals,
+                                GtkCallback   callback,
+                                gpointer      data)
+{
+  EmeusConstraintLayout *self = EMEUS_CONSTRAINT_LAYOUT (container);
+  guint i = 0;
+
+  /* The callback may remove the child from the layout, e.g. when
+   * destroying it, so we only advance if the child is still there
+   */
+  while (self->children != NULL && i < self->children->len)
+    {
+      GtkWidget *child = g_ptr_array_index (self->children, i);
+
+      callback (child, data);
+
+      if (i < self->children->len && g_ptr_array_index (self->children, i) == child)
+        i += 1;
+    }
+}
+
+static GType
+emeus_constraint_layout_child_type (GtkContainer *container)
+{
+  return EMEUS_TYPE_CONSTRAINT_LAYOUT_CHILD;
+}
+
+#define TAG_CONSTRAINTS "constraints"
+#define TAG_CONSTRAINT  "constraint"
+#define TAG_RESOURCE    "resource"
+
+#define ATTR_SOURCE_OBJECT      "source-object"
 #define ATTR_SOURCE_ATTR        "source-attr"
 #define ATTR_TARGET_OBJECT      "target-object"
 #define ATTR_TARGET_ATTR        "target-attr"
@@ -896,6 +1415,7 @@ emeus_constraint_layout_child_type (GtkContainer *container)
 #define ATTR_CONSTANT           "constant"
 #define ATTR_MULTIPLIER         "multiplier"
 #define ATTR_STRENGTH           "strength"
+#define ATTR_PATH               "path"
 
 typedef struct {
   char *source_name;
@@ -912,6 +1432,7 @@ typedef struct {
   GObject *object;
   GtkBuilder *builder;
   GSList *items;
+  GSList *blobs;
 } SubParserData;
 
 static void
@@ -1106,6 +1627,97 @@ constraints_free (gpointer data)
   g_slist_free_full (data, constraint_data_free);
 }
 
+static void
+blobs_free (gpointer data)
+{
+  g_slist_free_full (data, (GDestroyNotify) g_bytes_unref);
+}
+
+static gpointer
+blob_name_to_object (GtkBuilder *builder,
+                     const char *name)
+{
+  if (*name == '\0' || strcmp (name, "super") == 0)
+    return NULL;
+
+  return gtk_builder_get_object (builder, name);
+}
+
+static void
+add_constraints_from_blob (EmeusConstraintLayout *self,
+                           GtkBuilder            *builder,
+                           GBytes                *bytes)
+{
+  GVariant *blob, *items;
+  GVariantIter iter;
+  const char *target_name, *source_name;
+  guchar target_attr, source_attr, relation;
+  double multiplier, constant;
+  gint32 strength;
+  guint32 version;
+
+  blob = g_variant_new_from_bytes (G_VARIANT_TYPE (CONSTRAINTS_BLOB_TYPE), bytes, FALSE);
+  if (G_BYTE_ORDER == G_BIG_ENDIAN)
+    {
+      GVariant *tmp = g_variant_byteswap (blob);
+
+      g_variant_unref (blob);
+      blob = tmp;
+    }
+
+  g_variant_get_child (blob, 0, "u", &version);
+  if (version != CONSTRAINTS_BLOB_VERSION)
+    {
+      g_critical ("Unsupported version %u for compiled constraints", version);
+      g_variant_unref (blob);
+      return;
+    }
+
+  /* Constraints are not resolved until we're done with the whole set */
+  solver_freeze (emeus_constraint_layout_get_solver (self));
+
+  items = g_variant_get_child_value (blob, 1);
+  g_variant_iter_init (&iter, items);
+  while (g_variant_iter_next (&iter, CONSTRAINTS_BLOB_ITEM,
+                              &target_name, &target_attr,
+                              &relation,
+                              &source_name, &source_attr,
+                              &multiplier, &constant,
+                              &strength))
+    {
+      gpointer target, source;
+
+      if (target_attr >= N_ATTRIBUTES || source_attr >= N_ATTRIBUTES ||
+          relation > EMEUS_CONSTRAINT_RELATION_GE)
+        {
+          g_critical ("Invalid compiled constraint for target '%s'", target_name);
+          continue;
+        }
+
+      target = blob_name_to_object (builder, target_name);
+      if (target == NULL && strcmp (target_name, "super") != 0)
+        {
+          g_critical ("Unable to find target '%s' for constraint", target_name);
+          continue;
+        }
+
+      source = blob_name_to_object (builder, source_name);
+
+      emeus_constraint_layout_add_constraint (self,
+                                              emeus_constraint_new (target, target_attr,
+                                                                    relation,
+                                                                    source, source_attr,
+                                                                    multiplier,
+                                                                    constant,
+                                                                    strength));
+    }
+
+  g_variant_unref (items);
+  g_variant_unref (blob);
+
+  solver_thaw (emeus_constraint_layout_get_solver (self));
+}
+
 static void
 constraint_layout_start_element (GMarkupParseContext  *context,
                                  const gchar          *element_name,
@@ -1116,94 +1728,379 @@ constraint_layout_start_element (GMarkupParseContext  *context,
 {
   SubParserData *data = user_data;
 
-  if (strcmp (element_name, TAG_CONSTRAINT) == 0)
+  if (strcmp (element_name, TAG_CONSTRAINT) == 0)
+    {
+      const char *source_name, *source_attr;
+      const char *target_name, *target_attr;
+      const char *relation, *strength;
+      const char *multiplier, *constant;
+      ConstraintData *cdata;
+
+      if (!g_markup_collect_attributes (element_name, names, values, error,
+                                        G_MARKUP_COLLECT_STRING | G_MARKUP_COLLECT_OPTIONAL, ATTR_SOURCE_OBJECT, &source_name,
+                                        G_MARKUP_COLLECT_STRING | G_MARKUP_COLLECT_OPTIONAL, ATTR_SOURCE_ATTR, &source_attr,
+                                        G_MARKUP_COLLECT_STRING, ATTR_TARGET_OBJECT, &target_name,
+                                        G_MARKUP_COLLECT_STRING, ATTR_TARGET_ATTR, &target_attr,
+                                        G_MARKUP_COLLECT_STRING | G_MARKUP_COLLECT_OPTIONAL, ATTR_RELATION, &relation,
+                                        G_MARKUP_COLLECT_STRING | G_MARKUP_COLLECT_OPTIONAL, ATTR_STRENGTH, &strength,
+                                        G_MARKUP_COLLECT_STRING | G_MARKUP_COLLECT_OPTIONAL, ATTR_MULTIPLIER, &multiplier,
+                                        G_MARKUP_COLLECT_STRING | G_MARKUP_COLLECT_OPTIONAL, ATTR_CONSTANT, &constant,
+                                        G_MARKUP_COLLECT_INVALID))
+        {
+          return;
+        }
+
+      cdata = g_slice_new (ConstraintData);
+      cdata->source_name = g_strdup (source_name);
+      cdata->source_attr = g_strdup (source_attr);
+      cdata->target_name = g_strdup (target_name);
+      cdata->target_attr = g_strdup (target_attr);
+      cdata->relation = g_strdup (relation);
+      cdata->strength = g_strdup (strength);
+      parse_double (multiplier, &cdata->multiplier, 1.0);
+      parse_double (constant, &cdata->constant, 0.0);
+
+      data->items = g_slist_prepend (data->items, cdata);
+    }
+  else if (strcmp (element_name, TAG_RESOURCE) == 0)
+    {
+      const char *path;
+      GBytes *bytes;
+
+      if (!g_markup_collect_attributes (element_name, names, values, error,
+                                        G_MARKUP_COLLECT_STRING, ATTR_PATH, &path,
+                                        G_MARKUP_COLLECT_INVALID))
+        {
+          return;
+        }
+
+      /* Resources compiled into the binary are not copied */
+      bytes = g_resources_lookup_data (path, G_RESOURCE_LOOKUP_FLAGS_NONE, error);
+      if (bytes == NULL)
+        return;
+
+      data->blobs = g_slist_prepend (data->blobs, bytes);
+    }
+}
+
+static const GMarkupParser constraint_layout_parser = {
+  constraint_layout_start_element
+};
+
+static gboolean
+emeus_constraint_layout_buildable_custom_tag_start (GtkBuildable  *buildable,
+                                                    GtkBuilder    *builder,
+                                                    GObject       *child,
+                                                    const gchar   *tagname,
+                                                    GMarkupParser *parser,
+                                                    gpointer      *parser_data)
+{
+  if (parent_buildable_iface->custom_tag_start (buildable, builder, child, tagname, parser, parser_data))
+    return TRUE;
+
+  if (strcmp (tagname, TAG_CONSTRAINTS) == 0)
+    {
+      SubParserData *data;
+
+      data = g_slice_new0 (SubParserData);
+      data->items = NULL;
+      data->object = G_OBJECT (buildable);
+      data->builder = builder;
+
+      *parser = constraint_layout_parser;
+      *parser_data = data;
+
+      return TRUE;
+    }
+
+  return FALSE;
+}
+
+static void
+emeus_constraint_layout_buildable_custom_finished (GtkBuildable *buildable,
+                                                   GtkBuilder   *builder,
+                                                   GObject      *child,
+                                                   const gchar  *tagname,
+                                                   gpointer      user_data)
+{
+  parent_buildable_iface->custom_finished (buildable, builder, child, tagname, user_data);
+
+  if (strcmp (tagname, TAG_CONSTRAINTS) == 0)
+    {
+      SubParserData *data = user_data;
+
+      g_object_set_qdata_full (G_OBJECT (buildable), quark_buildable_constraints,
+                               data->items,
+                               constraints_free);
+      g_object_set_qdata_full (G_OBJECT (buildable), quark_buildable_constraint_blobs,
+                               data->blobs,
+                               blobs_free);
+
+      g_slice_free (SubParserData, data);
+    }
+}
+
+/* The maximum number of bases kept in the cache directory */
+#define BASIS_CACHE_MAX_FILES   64
+
+typedef struct {
+  /* The basis read from the cache directory, or exported from the first
+   * layout that solved the constraints; NULL if there is no usable basis
+   */
+  GArray *basis;
+
+  gboolean saved;
+} CachedBasis;
+
+/* HashTable<hash, CachedBasis>, shared by all the layouts in the process,
+ * so that each basis is read from the disk, and written to it, only once
+ */
+static GHashTable *basis_cache;
+
+static void
+cached_basis_free (gpointer data)
+{
+  CachedBasis *cached = data;
+
+  if (cached->basis != NULL)
+    g_array_unref (cached->basis);
+
+  g_slice_free (CachedBasis, cached);
+}
+
+/* The bases are only stored on disk if the EMEUS_BASIS_CACHE environment
+ * variable is set; reading them blocks the thread building the layout
+ */
+static gboolean
+basis_cache_use_disk (void)
+{
+  const char *value = g_getenv ("EMEUS_BASIS_CACHE");
+
+  return value != NULL && *value != '\0' && strcmp (value, "0") != 0;
+}
+
+static char *
+get_basis_cache_dir (void)
+{
+  return g_build_filename (g_get_user_cache_dir (), "emeus", NULL);
+}
+
+static char *
+get_basis_cache_path (guint hash)
+{
+  char *dir = get_basis_cache_dir ();
+  char *basename = g_strdup_printf ("%08x.basis", hash);
+  char *res = g_build_filename (dir, basename, NULL);
+
+  g_free (basename);
+  g_free (dir);
+
+  return res;
+}
+
+static CachedBasis *
+get_cached_basis (guint hash)
+{
+  CachedBasis *cached;
+  char *path, *contents = NULL;
+  gsize len = 0;
+
+  if (basis_cache == NULL)
+    basis_cache = g_hash_table_new_full (NULL, NULL, NULL, cached_basis_free);
+
+  cached = g_hash_table_lookup (basis_cache, GUINT_TO_POINTER (hash));
+  if (cached != NULL)
+    return cached;
+
+  cached = g_slice_new0 (CachedBasis);
+  g_hash_table_insert (basis_cache, GUINT_TO_POINTER (hash), cached);
+
+  if (!basis_cache_use_disk ())
+    return cached;
+
+  path = get_basis_cache_path (hash);
+  if (g_file_get_contents (path, &contents, &len, NULL) &&
+      len % sizeof (guint32) == 0)
+    {
+      cached->basis = g_array_sized_new (FALSE, FALSE, sizeof (guint32), len / sizeof (guint32));
+      g_array_append_vals (cached->basis, contents, len / sizeof (guint32));
+    }
+
+  DEBUG (g_debug ("Basis cache: %s '%s'",
+                  cached->basis != NULL ? "read" : "unable to read",
+                  path));
+
+  g_free (contents);
+  g_free (path);
+
+  return cached;
+}
+
+static gboolean
+load_cached_basis (EmeusConstraintLayout *self,
+                   guint                  hash)
+{
+  CachedBasis *cached = get_cached_basis (hash);
+  gboolean res;
+
+  if (cached->basis == NULL)
+    return FALSE;
+
+  res = simplex_solver_import_basis (&self->solver, hash,
+                                     (const guint32 *) cached->basis->data,
+                                     cached->basis->len);
+
+  DEBUG (g_debug ("Layout %p: %s cached basis %08x",
+                  self,
+                  res ? "imported" : "unable to import",
+                  hash));
+
+  /* Do not try again with the next layout; the basis of this one is
+   * going to replace it
+   */
+  if (!res)
+    g_clear_pointer (&cached->basis, g_array_unref);
+
+  return res;
+}
+
+typedef struct {
+  char *file;
+  gint64 mtime;
+} BasisFile;
+
+static int
+basis_file_compare (gconstpointer a,
+                    gconstpointer b)
+{
+  const BasisFile *file_a = a;
+  const BasisFile *file_b = b;
+
+  if (file_a->mtime < file_b->mtime)
+    return -1;
+
+  if (file_a->mtime > file_b->mtime)
+    return 1;
+
+  return 0;
+}
+
+/* Removes the least recently written bases from the cache directory,
+ * to keep at most BASIS_CACHE_MAX_FILES of them, including the one we
+ * are about to write
+ */
+static void
+trim_basis_cache_dir (const char *dir)
+{
+  GDir *d = g_dir_open (dir, 0, NULL);
+  GArray *files;
+  const char *name;
+  guint i;
+
+  if (d == NULL)
+    return;
+
+  files = g_array_new (FALSE, FALSE, sizeof (BasisFile));
+
+  while ((name = g_dir_read_name (d)) != NULL)
     {
-      const char *source_name, *source_attr;
-      const char *target_name, *target_attr;
-      const char *relation, *strength;
-      const char *multiplier, *constant;
-      ConstraintData *cdata;
+      BasisFile file;
+      GStatBuf buf;
 
-      if (!g_markup_collect_attributes (element_name, names, values, error,
-                                        G_MARKUP_COLLECT_STRING | G_MARKUP_COLLECT_OPTIONAL, ATTR_SOURCE_OBJECT, &source_name,
-                                        G_MARKUP_COLLECT_STRING | G_MARKUP_COLLECT_OPTIONAL, ATTR_SOURCE_ATTR, &source_attr,
-                                        G_MARKUP_COLLECT_STRING, ATTR_TARGET_OBJECT, &target_name,
-                                        G_MARKUP_COLLECT_STRING, ATTR_TARGET_ATTR, &target_attr,
-                                        G_MARKUP_COLLECT_STRING | G_MARKUP_COLLECT_OPTIONAL, ATTR_RELATION, &relation,
-                                        G_MARKUP_COLLECT_STRING | G_MARKUP_COLLECT_OPTIONAL, ATTR_STRENGTH, &strength,
-                                        G_MARKUP_COLLECT_STRING | G_MARKUP_COLLECT_OPTIONAL, ATTR_MULTIPLIER, &multiplier,
-                                        G_MARKUP_COLLECT_STRING | G_MARKUP_COLLECT_OPTIONAL, ATTR_CONSTANT, &constant,
-                                        G_MARKUP_COLLECT_INVALID))
-        {
-          return;
-        }
+      if (!g_str_has_suffix (name, ".basis"))
+        continue;
 
-      cdata = g_slice_new (ConstraintData);
-      cdata->source_name = g_strdup (source_name);
-      cdata->source_attr = g_strdup (source_attr);
-      cdata->target_name = g_strdup (target_name);
-      cdata->target_attr = g_strdup (target_attr);
-      cdata->relation = g_strdup (relation);
-      cdata->strength = g_strdup (strength);
-      parse_double (multiplier, &cdata->multiplier, 1.0);
-      parse_double (constant, &cdata->constant, 0.0);
+      file.file = g_build_filename (dir, name, NULL);
+      file.mtime = g_stat (file.file, &buf) == 0 ? (gint64) buf.st_mtime : 0;
 
-      data->items = g_slist_prepend (data->items, cdata);
+      g_array_append_val (files, file);
     }
+
+  g_dir_close (d);
+
+  if (files->len >= BASIS_CACHE_MAX_FILES)
+    {
+      g_array_sort (files, basis_file_compare);
+
+      for (i = 0; i <= files->len - BASIS_CACHE_MAX_FILES; i++)
+        g_unlink (g_array_index (files, BasisFile, i).file);
+    }
+
+  for (i = 0; i < files->len; i++)
+    g_free (g_array_index (files, BasisFile, i).file);
+
+  g_array_unref (files);
 }
 
-static const GMarkupParser constraint_layout_parser = {
-  constraint_layout_start_element
-};
+typedef struct {
+  guint hash;
+  GArray *basis;
+} BasisWrite;
 
-static gboolean
-emeus_constraint_layout_buildable_custom_tag_start (GtkBuildable  *buildable,
-                                                    GtkBuilder    *builder,
-                                                    GObject       *child,
-                                                    const gchar   *tagname,
-                                                    GMarkupParser *parser,
-                                                    gpointer      *parser_data)
+static void
+basis_write_free (gpointer data)
 {
-  if (parent_buildable_iface->custom_tag_start (buildable, builder, child, tagname, parser, parser_data))
-    return TRUE;
-
-  if (strcmp (tagname, TAG_CONSTRAINTS) == 0)
-    {
-      SubParserData *data;
+  BasisWrite *write = data;
 
-      data = g_slice_new0 (SubParserData);
-      data->items = NULL;
-      data->object = G_OBJECT (buildable);
-      data->builder = builder;
+  g_array_unref (write->basis);
+  g_slice_free (BasisWrite, write);
+}
 
-      *parser = constraint_layout_parser;
-      *parser_data = data;
+static void
+basis_write_thread (GTask        *task,
+                    gpointer      source_object,
+                    gpointer      task_data,
+                    GCancellable *cancellable)
+{
+  BasisWrite *write = task_data;
+  char *dir = get_basis_cache_dir ();
+  char *path = get_basis_cache_path (write->hash);
 
-      return TRUE;
+  /* The cache is only an optimization, so we ignore errors */
+  if (g_mkdir_with_parents (dir, 0755) == 0)
+    {
+      trim_basis_cache_dir (dir);
+      g_file_set_contents (path, write->basis->data,
+                           write->basis->len * sizeof (guint32),
+                           NULL);
     }
 
-  return FALSE;
+  g_free (path);
+  g_free (dir);
+
+  g_task_return_boolean (task, TRUE);
 }
 
 static void
-emeus_constraint_layout_buildable_custom_finished (GtkBuildable *buildable,
-                                                   GtkBuilder   *builder,
-                                                   GObject      *child,
-                                                   const gchar  *tagname,
-                                                   gpointer      user_data)
+save_cached_basis (EmeusConstraintLayout *self,
+                   guint                  hash)
 {
-  parent_buildable_iface->custom_finished (buildable, builder, child, tagname, user_data);
+  CachedBasis *cached = get_cached_basis (hash);
+  BasisWrite *write;
+  GTask *task;
 
-  if (strcmp (tagname, TAG_CONSTRAINTS) == 0)
-    {
-      SubParserData *data = user_data;
+  if (cached->saved)
+    return;
 
-      g_object_set_qdata_full (G_OBJECT (buildable), quark_buildable_constraints,
-                               data->items,
-                               constraints_free);
+  cached->saved = TRUE;
 
-      g_slice_free (SubParserData, data);
-    }
+  g_clear_pointer (&cached->basis, g_array_unref);
+  cached->basis = simplex_solver_export_basis (&self->solver);
+
+  if (!basis_cache_use_disk ())
+    return;
+
+  /* Writing the file, and trimming the directory, do not need to block
+   * the thread building the layout
+   */
+  write = g_slice_new (BasisWrite);
+  write->hash = hash;
+  write->basis = g_array_ref (cached->basis);
+
+  task = g_task_new (NULL, NULL, NULL, NULL);
+  g_task_set_task_data (task, write, basis_write_free);
+  g_task_run_in_thread (task, basis_write_thread);
+  g_object_unref (task);
 }
 
 static void
@@ -1211,13 +2108,36 @@ emeus_constraint_layout_buildable_parser_finished (GtkBuildable *buildable,
                                                    GtkBuilder   *builder)
 {
   EmeusConstraintLayout *self = EMEUS_CONSTRAINT_LAYOUT (buildable);
-  GSList *constraints, *l;
+  GSList *constraints, *blobs, *l;
   GError *error = NULL;
+  gboolean has_basis = FALSE;
+  gboolean has_constraints;
+  guint hash = 0;
 
   /* Maintain the order in which the constraints were defined */
+  blobs = g_object_get_qdata (G_OBJECT (buildable), quark_buildable_constraint_blobs);
+  blobs = g_slist_reverse (blobs);
   constraints = g_object_get_qdata (G_OBJECT (buildable), quark_buildable_constraints);
   constraints = g_slist_reverse (constraints);
 
+  has_constraints = blobs != NULL || constraints != NULL;
+
+  /* Layouts defined in UI files are usually the same every time the
+   * application runs, so we solve the constraints in one go, starting
+   * from the basis that solved them the last time, if we have it; a
+   * layout without constraints does not need a solver yet
+   */
+  if (has_constraints)
+    {
+      ensure_solver (self);
+      solver_freeze (&self->solver);
+    }
+
+  for (l = blobs; l != NULL; l = l->next)
+    add_constraints_from_blob (self, builder, l->data);
+
+  g_object_set_qdata (G_OBJECT (buildable), quark_buildable_constraint_blobs, NULL);
+
   for (l = constraints; l != NULL; l = l->next)
     {
       const ConstraintData *cdata = l->data;
@@ -1242,6 +2162,22 @@ emeus_constraint_layout_buildable_parser_finished (GtkBuildable *buildable,
 
   g_object_set_qdata (G_OBJECT (buildable), quark_buildable_constraints, NULL);
 
+  /* The cached basis is a basis of the Cassowary tableau, which other
+   * backends do not have
+   */
+  if (has_constraints && !solver_has_tableau (&self->solver))
+    solver_thaw (&self->solver);
+  else if (has_constraints)
+    {
+      hash = simplex_solver_hash (&self->solver);
+      has_basis = load_cached_basis (self, hash);
+
+      solver_thaw (&self->solver);
+
+      if (!has_basis)
+        save_cached_basis (self, hash);
+    }
+
   parent_buildable_iface->parser_finished (buildable, builder);
 }
 
@@ -1263,6 +2199,7 @@ emeus_constraint_layout_class_init (EmeusConstraintLayoutClass *klass)
   GtkContainerClass *container_class = GTK_CONTAINER_CLASS (klass);
 
   quark_buildable_constraints = g_quark_from_static_string ("-EmeusConstraintLayout-constraints");
+  quark_buildable_constraint_blobs = g_quark_from_static_string ("-EmeusConstraintLayout-constraint-blobs");
 
   gobject_class->finalize = emeus_constraint_layout_finalize;
 
@@ -1288,19 +2225,17 @@ emeus_constraint_layout_init (EmeusConstraintLayout *self)
 {
   gtk_widget_set_has_window (GTK_WIDGET (self), FALSE);
 
-  simplex_solver_init (&self->solver);
-
-  self->children = g_sequence_new (NULL);
-
-  self->bound_attributes = g_hash_table_new_full (NULL, NULL,
-                                                  NULL,
-                                                  (GDestroyNotify) variable_unref);
+  self->children = g_ptr_array_new ();
 
   self->constraints = g_hash_table_new_full (NULL, NULL,
                                              g_object_unref,
                                              NULL);
 
-  add_layout_stays (self);
+  self->metrics = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                         NULL,
+                                         layout_metric_free);
+
+  self->allocation_cache.max_size = DEFAULT_ALLOCATION_CACHE_SIZE;
 }
 
 /**
@@ -1318,6 +2253,26 @@ emeus_constraint_layout_new (void)
   return g_object_new (EMEUS_TYPE_CONSTRAINT_LAYOUT, NULL);
 }
 
+/* Replaces the value of the VFL metric folded into the constant of
+ * @expr with the variable the layout binds to the metric, so that the
+ * constraint follows emeus_constraint_layout_set_metric()
+ */
+static void
+bind_constraint_metric (EmeusConstraintLayout *layout,
+                        EmeusConstraint       *constraint,
+                        Expression            *expr)
+{
+  LayoutMetric *metric;
+
+  if (constraint->metric == NULL)
+    return;
+
+  metric = get_layout_metric (layout, constraint->metric, constraint->metric_value);
+
+  expression_plus (expr, constraint->metric_multiplier * constraint->metric_value * -1.0);
+  expression_add_variable (expr, metric->variable, constraint->metric_multiplier, NULL);
+}
+
 static void
 create_layout_constraint (EmeusConstraintLayout *layout,
                           EmeusConstraint       *constraint)
@@ -1328,19 +2283,20 @@ create_layout_constraint (EmeusConstraintLayout *layout,
   attr1 = get_layout_attribute (layout, constraint->target_attribute);
   if (constraint->source_attribute == EMEUS_CONSTRAINT_ATTRIBUTE_INVALID)
     {
-      attr2 = simplex_solver_create_variable (constraint->solver, "const",
-                                              emeus_constraint_get_constant (constraint));
+      attr2 = solver_create_variable (constraint->solver, "const",
+                                      emeus_constraint_get_constant (constraint));
 
-      simplex_solver_add_stay_variable (constraint->solver, attr2, STRENGTH_REQUIRED);
+      solver_add_stay_variable (constraint->solver, attr2, STRENGTH_REQUIRED);
 
       expr = expression_new_from_variable (attr2);
+      bind_constraint_metric (layout, constraint, expr);
 
       constraint->constraint =
-        simplex_solver_add_constraint (constraint->solver,
-                                       attr1,
-                                       relation_to_operator (constraint->relation),
-                                       expr,
-                                       strength_to_value (constraint->strength));
+        solver_add_constraint (constraint->solver,
+                               attr1,
+                               relation_to_operator (constraint->relation),
+                               expr,
+                               strength_to_value (constraint->strength));
       expression_unref (expr);
       variable_unref (attr2);
 
@@ -1367,13 +2323,14 @@ create_layout_constraint (EmeusConstraintLayout *layout,
     expression_plus (expression_times (expression_new_from_variable (attr2),
                                        constraint->multiplier),
                      constraint->constant);
+  bind_constraint_metric (layout, constraint, expr);
 
   constraint->constraint =
-    simplex_solver_add_constraint (constraint->solver,
-                                   attr1,
-                                   relation_to_operator (constraint->relation),
-                                   expr,
-                                   strength_to_value (constraint->strength));
+    solver_add_constraint (constraint->solver,
+                           attr1,
+                           relation_to_operator (constraint->relation),
+                           expr,
+                           strength_to_value (constraint->strength));
 
   expression_unref (expr);
 }
@@ -1385,6 +2342,8 @@ add_layout_constraint (EmeusConstraintLayout *layout,
   if (!emeus_constraint_attach (constraint, layout))
     return;
 
+  layout_defer_solving (layout);
+
   g_hash_table_add (layout->constraints, g_object_ref_sink (constraint));
 
   if (constraint->is_active)
@@ -1408,19 +2367,20 @@ create_child_constraint (EmeusConstraintLayout      *layout,
    */
   if (constraint->source_attribute == EMEUS_CONSTRAINT_ATTRIBUTE_INVALID)
     {
-      attr2 = simplex_solver_create_variable (constraint->solver, "const",
-                                              emeus_constraint_get_constant (constraint));
+      attr2 = solver_create_variable (constraint->solver, "const",
+                                      emeus_constraint_get_constant (constraint));
 
-      simplex_solver_add_stay_variable (child->solver, attr2, STRENGTH_REQUIRED);
+      solver_add_stay_variable (child->solver, attr2, STRENGTH_REQUIRED);
 
       expr = expression_new_from_variable (attr2);
+      bind_constraint_metric (layout, constraint, expr);
 
       constraint->constraint =
-        simplex_solver_add_constraint (constraint->solver,
-                                       attr1,
-                                       relation_to_operator (constraint->relation),
-                                       expr,
-                                       strength_to_value (constraint->strength));
+        solver_add_constraint (constraint->solver,
+                               attr1,
+                               relation_to_operator (constraint->relation),
+                               expr,
+                               strength_to_value (constraint->strength));
 
       expression_unref (expr);
       variable_unref (attr2);
@@ -1464,13 +2424,14 @@ create_child_constraint (EmeusConstraintLayout      *layout,
     expression_plus (expression_times (expression_new_from_variable (attr2),
                                        constraint->multiplier),
                      constraint->constant);
+  bind_constraint_metric (layout, constraint, expr);
 
   constraint->constraint =
-    simplex_solver_add_constraint (constraint->solver,
-                                   attr1,
-                                   relation_to_operator (constraint->relation),
-                                   expr,
-                                   strength_to_value (constraint->strength));
+    solver_add_constraint (constraint->solver,
+                           attr1,
+                           relation_to_operator (constraint->relation),
+                           expr,
+                           strength_to_value (constraint->strength));
 
   expression_unref (expr);
 }
@@ -1494,6 +2455,8 @@ add_child_constraint (EmeusConstraintLayout      *layout,
   if (!emeus_constraint_attach (constraint, layout))
     return;
 
+  layout_defer_solving (layout);
+
   g_hash_table_add (child->constraints, g_object_ref_sink (constraint));
 
   if (constraint->is_active)
@@ -1516,6 +2479,8 @@ remove_child_constraint (EmeusConstraintLayout      *layout,
         }
     }
 
+  layout_defer_solving (layout);
+
   emeus_constraint_detach (constraint);
 
   g_hash_table_remove (child->constraints, constraint);
@@ -1532,6 +2497,23 @@ emeus_constraint_layout_activate_constraint (EmeusConstraintLayout *layout,
   if (constraint->constraint != NULL)
     return;
 
+  layout_defer_solving (layout);
+
+  /* Re-use the expression we computed the last time the constraint
+   * was active; the variables it references are still bound to the
+   * same attributes, as detaching the constraint drops it.
+   */
+  if (constraint->prepared != NULL)
+    {
+      constraint->constraint =
+        solver_add_constraint (constraint->solver,
+                               NULL,
+                               relation_to_operator (constraint->relation),
+                               constraint->prepared,
+                               strength_to_value (constraint->strength));
+      return;
+    }
+
   if (constraint->target_object == NULL)
     create_layout_constraint (layout, constraint);
   else
@@ -1567,31 +2549,64 @@ emeus_constraint_layout_deactivate_constraint (EmeusConstraintLayout *layout,
   if (constraint->constraint == NULL)
     return;
 
-  simplex_solver_remove_constraint (constraint->solver, constraint->constraint);
+  layout_defer_solving (layout);
+
+  if (constraint->prepared == NULL)
+    constraint->prepared = expression_ref (constraint->constraint->expression);
+
+  solver_remove_constraint (constraint->solver, constraint->constraint);
   constraint->constraint = NULL;
 }
 
 SimplexSolver *
 emeus_constraint_layout_get_solver (EmeusConstraintLayout *layout)
 {
+  ensure_solver (layout);
+
   return &layout->solver;
 }
 
+/* Selects the solver backend used by @layout, instead of the default
+ * one; this has to be done before the solver is used for the first time
+ */
+gboolean
+emeus_constraint_layout_set_solver_backend (EmeusConstraintLayout *layout,
+                                            const char            *name)
+{
+  const SolverBackend *backend;
+
+  g_return_val_if_fail (EMEUS_IS_CONSTRAINT_LAYOUT (layout), FALSE);
+
+  if (layout->solver.initialized)
+    {
+      g_critical ("The solver of layout %p is already in use", layout);
+      return FALSE;
+    }
+
+  backend = solver_backend_lookup (name);
+  if (backend == NULL)
+    {
+      g_critical ("Unknown solver backend '%s'", name);
+      return FALSE;
+    }
+
+  layout->solver_backend = backend;
+
+  return TRUE;
+}
+
 gboolean
 emeus_constraint_layout_has_child_data (EmeusConstraintLayout *layout,
                                         GtkWidget             *widget)
 {
-  GSequenceIter *iter;
+  guint i;
 
   if (gtk_widget_get_parent (widget) == GTK_WIDGET (layout))
     return TRUE;
 
-  iter = g_sequence_get_begin_iter (layout->children);
-  while (!g_sequence_iter_is_end (iter))
+  for (i = 0; i < layout->children->len; i++)
     {
-      GtkWidget *child = g_sequence_get (iter);
-
-      iter = g_sequence_iter_next (iter);
+      GtkWidget *child = g_ptr_array_index (layout->children, i);
 
       if (gtk_widget_get_parent (widget) == child)
         return TRUE;
@@ -1687,17 +2702,254 @@ emeus_constraint_layout_add_constraints (EmeusConstraintLayout *layout,
 
   g_return_if_fail (EMEUS_IS_CONSTRAINT_LAYOUT (layout));
 
-  va_start (args, first_constraint);
+  va_start (args, first_constraint);
+
+  constraint = first_constraint;
+  while (constraint != NULL)
+    {
+      layout_add_constraint (layout, constraint);
+
+      constraint = va_arg (args, EmeusConstraint *);
+    }
+
+  va_end (args);
+}
+
+typedef struct {
+  /* The key of the line, see emeus_constraint_description_key() */
+  char *key;
+
+  /* Vec<EmeusConstraint>; the constraints generated by the line */
+  GPtrArray *constraints;
+} DescriptionLine;
+
+static void
+description_line_free (gpointer data)
+{
+  DescriptionLine *line = data;
+
+  g_free (line->key);
+  g_ptr_array_unref (line->constraints);
+
+  g_slice_free (DescriptionLine, line);
+}
+
+static void
+layout_remove_constraint (EmeusConstraintLayout *layout,
+                          EmeusConstraint       *constraint)
+{
+  GtkWidget *target, *parent;
+
+  /* The constraint may have been removed along with one of the
+   * widgets it references
+   */
+  if (constraint->layout != layout)
+    return;
+
+  target = emeus_constraint_get_target_object (constraint);
+  if (target == NULL)
+    {
+      layout_defer_solving (layout);
+      emeus_constraint_detach (constraint);
+      g_hash_table_remove (layout->constraints, constraint);
+      return;
+    }
+
+  if (EMEUS_IS_CONSTRAINT_LAYOUT_CHILD (target))
+    remove_child_constraint (layout, EMEUS_CONSTRAINT_LAYOUT_CHILD (target), constraint);
+  else
+    {
+      parent = gtk_widget_get_parent (target);
+      remove_child_constraint (layout, EMEUS_CONSTRAINT_LAYOUT_CHILD (parent), constraint);
+    }
+}
+
+static gboolean
+description_line_is_attached (EmeusConstraintLayout *layout,
+                              const DescriptionLine *line)
+{
+  for (guint i = 0; i < line->constraints->len; i++)
+    {
+      EmeusConstraint *constraint = g_ptr_array_index (line->constraints, i);
+
+      if (constraint->layout != layout)
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
+/**
+ * emeus_constraint_layout_update_from_description:
+ * @layout: a #EmeusConstraintLayout
+ * @lines: (array length=n_lines): an array of Visual Format Language lines
+ * @n_lines: the number of lines
+ * @hspacing: default horizontal spacing value, or -1 for the fallback value
+ * @vspacing: default vertical spacing value, or -1 for the fallback value
+ * @views: (element-type utf8 Gtk.Widget): a dictionary of [ name, widget ]
+ *   pairs; the `name` keys map to the view names in the VFL lines, while
+ *   the `widget` values map to the children of the @layout
+ * @metrics: (element-type utf8 double) (nullable): a dictionary of
+ *   [ name, value ] pairs; the `name` keys map to the metric names in the
+ *   VFL lines, while the `value` values maps to its numeric value
+ *
+ * Creates constraints from the Visual Format Language @lines, like
+ * emeus_create_constraints_from_description(), and adds them to the
+ * @layout, replacing the constraints created by the previous call to
+ * this function.
+ *
+ * Lines that did not change since the previous call keep their
+ * constraints; only the constraints of the lines that were removed
+ * or changed are removed from the @layout, and only the lines that
+ * were added or changed are parsed, in a single batch.
+ *
+ * The @views are expected to map the names in the lines that did not
+ * change to the same widgets as in the previous call.
+ *
+ * Since: 1.0
+ */
+void
+emeus_constraint_layout_update_from_description (EmeusConstraintLayout *layout,
+                                                 const char * const    *lines,
+                                                 guint                  n_lines,
+                                                 int                    hspacing,
+                                                 int                    vspacing,
+                                                 GHashTable            *views,
+                                                 GHashTable            *metrics)
+{
+  GHashTable *previous;
+  GPtrArray *description, *added;
+  SimplexSolver *solver;
+  char *prefix;
+  guint i;
+
+  g_return_if_fail (EMEUS_IS_CONSTRAINT_LAYOUT (layout));
+  g_return_if_fail (lines != NULL || n_lines == 0);
+  g_return_if_fail (views != NULL);
+
+  /* The spacing and metrics are the same for every line */
+  prefix = emeus_constraint_description_prefix (hspacing, vspacing, metrics);
+
+  /* HashTable<string, Queue<index>>; the positions of each line in
+   * the previous description, as the same line can appear more
+   * than once
+   */
+  previous = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                    NULL,
+                                    (GDestroyNotify) g_queue_free);
+
+  if (layout->description != NULL)
+    {
+      for (i = 0; i < layout->description->len; i++)
+        {
+          DescriptionLine *line = g_ptr_array_index (layout->description, i);
+          GQueue *queue = g_hash_table_lookup (previous, line->key);
+
+          if (queue == NULL)
+            {
+              queue = g_queue_new ();
+              g_hash_table_insert (previous, line->key, queue);
+            }
+
+          g_queue_push_tail (queue, GUINT_TO_POINTER (i));
+        }
+    }
+
+  description = g_ptr_array_new_full (n_lines, description_line_free);
+  added = g_ptr_array_new ();
+
+  for (i = 0; i < n_lines; i++)
+    {
+      char *key = emeus_constraint_description_key (prefix, lines[i]);
+      GQueue *queue = g_hash_table_lookup (previous, key);
+      DescriptionLine *line = NULL;
+
+      while (queue != NULL && !g_queue_is_empty (queue))
+        {
+          guint index = GPOINTER_TO_UINT (g_queue_pop_head (queue));
+          DescriptionLine *candidate = g_ptr_array_index (layout->description, index);
+
+          /* Constraints are removed along with the widgets they
+           * reference, in which case the line must be parsed again
+           */
+          if (description_line_is_attached (layout, candidate))
+            {
+              line = candidate;
+              layout->description->pdata[index] = NULL;
+              break;
+            }
+        }
+
+      if (line != NULL)
+        g_free (key);
+      else
+        {
+          line = g_slice_new (DescriptionLine);
+          line->key = key;
+          line->constraints = g_ptr_array_new_with_free_func (g_object_unref);
+
+          g_ptr_array_add (added, GUINT_TO_POINTER (i));
+        }
+
+      g_ptr_array_add (description, line);
+    }
+
+  /* The keys are owned by the previous description */
+  g_hash_table_unref (previous);
+
+  solver = emeus_constraint_layout_get_solver (layout);
+  solver_freeze (solver);
+
+  if (layout->description != NULL)
+    {
+      for (i = 0; i < layout->description->len; i++)
+        {
+          DescriptionLine *line = g_ptr_array_index (layout->description, i);
+
+          if (line == NULL)
+            continue;
+
+          for (guint j = 0; j < line->constraints->len; j++)
+            layout_remove_constraint (layout, g_ptr_array_index (line->constraints, j));
+
+          description_line_free (line);
+        }
+
+      g_ptr_array_set_free_func (layout->description, NULL);
+      g_ptr_array_unref (layout->description);
+    }
+
+  for (i = 0; i < added->len; i++)
+    {
+      guint index = GPOINTER_TO_UINT (g_ptr_array_index (added, i));
+      DescriptionLine *line = g_ptr_array_index (description, index);
+      GList *constraints, *l;
+
+      constraints = emeus_constraint_list_from_description (prefix, &lines[index], 1,
+                                                            hspacing, vspacing,
+                                                            views,
+                                                            metrics);
+
+      for (l = constraints; l != NULL; l = l->next)
+        {
+          EmeusConstraint *constraint = g_object_ref_sink (l->data);
+
+          g_ptr_array_add (line->constraints, constraint);
+          layout_add_constraint (layout, constraint);
+        }
+
+      g_list_free (constraints);
+    }
+
+  layout->description = description;
 
-  constraint = first_constraint;
-  while (constraint != NULL)
-    {
-      layout_add_constraint (layout, constraint);
+  solver_thaw (solver);
 
-      constraint = va_arg (args, EmeusConstraint *);
-    }
+  g_ptr_array_unref (added);
+  g_free (prefix);
 
-  va_end (args);
+  if (gtk_widget_get_visible (GTK_WIDGET (layout)))
+    gtk_widget_queue_resize (GTK_WIDGET (layout));
 }
 
 /**
@@ -1743,8 +2995,11 @@ emeus_constraint_layout_pack (EmeusConstraintLayout *layout,
       gtk_container_add (GTK_CONTAINER (layout_child), child);
     }
 
-  layout_child->iter = g_sequence_append (layout->children, layout_child);
-  layout_child->solver = &layout->solver;
+  layout_child->index = layout->children->len;
+  g_ptr_array_add (layout->children, layout_child);
+  layout_clear_sensitivity (layout);
+  layout_clear_allocation_cache (layout);
+  layout_child->solver = emeus_constraint_layout_get_solver (layout);
   g_object_add_weak_pointer (G_OBJECT (layout), (gpointer*) &layout_child->solver);
 
   gtk_widget_set_parent (GTK_WIDGET (layout_child), GTK_WIDGET (layout));
@@ -1780,8 +3035,8 @@ GList *
 emeus_constraint_layout_get_constraints (EmeusConstraintLayout *layout)
 {
   EmeusConstraintLayoutChild *child;
-  GSequenceIter *iter;
   GList *res;
+  guint i;
 
   g_return_val_if_fail (EMEUS_IS_CONSTRAINT_LAYOUT (layout), NULL);
 
@@ -1789,11 +3044,9 @@ emeus_constraint_layout_get_constraints (EmeusConstraintLayout *layout)
   res = g_hash_table_get_keys (layout->constraints);
 
   /* Then, iterate over each child, and add the constraints attach to it */
-  iter = g_sequence_get_begin_iter (layout->children);
-  while (!g_sequence_iter_is_end (iter))
+  for (i = 0; i < layout->children->len; i++)
     {
-      child = g_sequence_get (iter);
-      iter = g_sequence_iter_next (iter);
+      child = g_ptr_array_index (layout->children, i);
 
       res = g_list_concat (res, g_hash_table_get_keys (child->constraints));
     }
@@ -1801,6 +3054,50 @@ emeus_constraint_layout_get_constraints (EmeusConstraintLayout *layout)
   return res;
 }
 
+/**
+ * emeus_constraint_layout_get_child_rectangles:
+ * @layout: a #EmeusConstraintLayout
+ * @rects: (array length=n_rects) (out caller-allocates) (nullable): an
+ *   array of rectangles to fill
+ * @n_rects: the number of rectangles in @rects
+ *
+ * Retrieves the geometry of the children of @layout, as computed by
+ * the last size allocation, in a single pass.
+ *
+ * Each rectangle is expressed in the coordinate space of the @layout's
+ * parent, like the allocation of a widget, and the rectangles are
+ * stored in the same order used by gtk_container_forall(). At most
+ * @n_rects rectangles are written.
+ *
+ * This function is meant to be used when reading the geometry of all
+ * the children, for instance when hit-testing; it does not query the
+ * solver, so it is cheaper than calling the attribute getters of
+ * each #EmeusConstraintLayoutChild.
+ *
+ * Returns: the number of children of @layout
+ *
+ * Since: 1.0
+ */
+guint
+emeus_constraint_layout_get_child_rectangles (EmeusConstraintLayout *layout,
+                                              GdkRectangle          *rects,
+                                              guint                  n_rects)
+{
+  guint i;
+
+  g_return_val_if_fail (EMEUS_IS_CONSTRAINT_LAYOUT (layout), 0);
+  g_return_val_if_fail (rects != NULL || n_rects == 0, 0);
+
+  for (i = 0; i < layout->children->len && i < n_rects; i++)
+    {
+      EmeusConstraintLayoutChild *child = g_ptr_array_index (layout->children, i);
+
+      rects[i] = child->allocation;
+    }
+
+  return layout->children->len;
+}
+
 /**
  * emeus_constraint_layout_clear_constraints:
  * @layout: a #EmeusConstraintLayout
@@ -1827,17 +3124,482 @@ emeus_constraint_layout_clear_constraints (EmeusConstraintLayout *layout)
       g_hash_table_iter_remove (&iter);
     }
 
-  g_hash_table_remove_all (layout->bound_attributes);
+  g_clear_pointer (&layout->description, g_ptr_array_unref);
+
+  clear_bound_attributes (layout->bound_attributes);
+
+  for (guint i = 0; i < layout->children->len; i++)
+    emeus_constraint_layout_child_clear_constraints (g_ptr_array_index (layout->children, i));
+}
+
+/* Two constraints are structurally equal if they only differ by
+ * their constant, in which case one can be turned into the other
+ * without touching the rest of the layout
+ */
+static guint
+constraint_structure_hash (gconstpointer data)
+{
+  const EmeusConstraint *constraint = data;
+  guint res;
+
+  res = g_direct_hash (constraint->target_object);
+  res = res * 31 + constraint->target_attribute;
+  res = res * 31 + constraint->relation;
+  res = res * 31 + g_direct_hash (constraint->source_object);
+  res = res * 31 + constraint->source_attribute;
+  res = res * 31 + g_double_hash (&constraint->multiplier);
+  res = res * 31 + constraint->strength;
+  res = res * 31 + g_direct_hash (constraint->metric);
+
+  return res;
+}
+
+static gboolean
+constraint_structure_equal (gconstpointer a,
+                            gconstpointer b)
+{
+  const EmeusConstraint *c1 = a;
+  const EmeusConstraint *c2 = b;
+
+  return c1->target_object == c2->target_object &&
+         c1->target_attribute == c2->target_attribute &&
+         c1->relation == c2->relation &&
+         c1->source_object == c2->source_object &&
+         c1->source_attribute == c2->source_attribute &&
+         c1->multiplier == c2->multiplier &&
+         c1->strength == c2->strength &&
+         c1->metric == c2->metric &&
+         c1->metric_multiplier == c2->metric_multiplier &&
+         c1->is_active == c2->is_active;
+}
+
+static void
+collect_replaceable_constraints (GHashTable *structures,
+                                 GHashTable *constraints,
+                                 GHashTable *kept)
+{
+  GHashTableIter iter;
+  gpointer key;
+
+  g_hash_table_iter_init (&iter, constraints);
+  while (g_hash_table_iter_next (&iter, &key, NULL))
+    {
+      GQueue *queue;
+
+      if (g_hash_table_contains (kept, key))
+        continue;
+
+      queue = g_hash_table_lookup (structures, key);
+      if (queue == NULL)
+        {
+          queue = g_queue_new ();
+          g_hash_table_insert (structures, key, queue);
+        }
+
+      g_queue_push_tail (queue, key);
+    }
+}
+
+/* Gives @constraint the constant of @source; the constant is only
+ * a term of the normalized expression, so we change it and add the
+ * expression back, instead of resolving the attributes again
+ */
+static void
+update_constraint_constant (EmeusConstraintLayout *layout,
+                            EmeusConstraint       *constraint,
+                            EmeusConstraint       *source)
+{
+  double delta;
+
+  /* The constant in the expression does not include the metric */
+  delta = (source->constant - source->metric_multiplier * source->metric_value)
+        - (constraint->constant - constraint->metric_multiplier * constraint->metric_value);
+
+  constraint->constant = source->constant;
+  constraint->metric_value = source->metric_value;
+  g_clear_pointer (&constraint->description, g_free);
+
+  if (constraint->constraint != NULL)
+    {
+      emeus_constraint_layout_deactivate_constraint (layout, constraint);
+
+      g_assert (constraint->prepared != NULL);
+    }
+
+  if (constraint->prepared != NULL)
+    {
+      Expression *expr = constraint->prepared;
+
+      /* See simplex_solver_add_constraint() for the normalization */
+      if (relation_to_operator (constraint->relation) == OPERATOR_TYPE_GE)
+        delta *= -1.0;
+
+      expression_set_constant (expr, expression_get_constant (expr) + delta);
+    }
+
+  if (constraint->is_active)
+    emeus_constraint_layout_activate_constraint (layout, constraint);
+
+  g_object_notify (G_OBJECT (constraint), "constant");
+}
+
+/**
+ * emeus_constraint_layout_replace_constraints:
+ * @layout: a #EmeusConstraintLayout
+ * @constraints: (element-type EmeusConstraint): a list of
+ *   #EmeusConstraint instances
+ *
+ * Replaces all the constraints of the @layout, and of its children,
+ * with the given @constraints.
+ *
+ * Constraints in @constraints that are structurally equal to a
+ * constraint of the @layout, that is they have the same target, source,
+ * attributes, multiplier, relation, strength and state, are not added;
+ * the existing constraint is kept instead, and its constant is updated
+ * if needed. Only the remaining constraints are removed from, and added
+ * to, the @layout, in a single batch.
+ *
+ * This is useful when regenerating the constraints of a @layout from a
+ * model, e.g. using emeus_create_constraints_from_description(), as the
+ * cost of the update depends on the size of the change, instead of the
+ * size of the layout.
+ *
+ * The @layout takes ownership of the floating references of the
+ * @constraints, like emeus_constraint_layout_add_constraint(); the
+ * constraints that were matched to an existing one are not attached,
+ * and are released.
+ *
+ * Since: 1.0
+ */
+void
+emeus_constraint_layout_replace_constraints (EmeusConstraintLayout *layout,
+                                             GList                 *constraints)
+{
+  GHashTable *structures, *kept;
+  GPtrArray *added;
+  SimplexSolver *solver;
+  GHashTableIter iter;
+  gpointer value;
+  GList *l;
+  guint i;
+
+  g_return_if_fail (EMEUS_IS_CONSTRAINT_LAYOUT (layout));
+
+  /* HashSet<EmeusConstraint>; constraints already in the layout */
+  kept = g_hash_table_new (NULL, NULL);
+
+  for (l = constraints; l != NULL; l = l->next)
+    {
+      EmeusConstraint *constraint = l->data;
+
+      if (constraint->layout == layout)
+        g_hash_table_add (kept, constraint);
+    }
+
+  /* HashTable<EmeusConstraint, Queue<EmeusConstraint>>; the current
+   * constraints, grouped by structure
+   */
+  structures = g_hash_table_new_full (constraint_structure_hash,
+                                      constraint_structure_equal,
+                                      NULL,
+                                      (GDestroyNotify) g_queue_free);
+
+  collect_replaceable_constraints (structures, layout->constraints, kept);
+  for (i = 0; i < layout->children->len; i++)
+    {
+      EmeusConstraintLayoutChild *child = g_ptr_array_index (layout->children, i);
+
+      collect_replaceable_constraints (structures, child->constraints, kept);
+    }
+
+  solver = emeus_constraint_layout_get_solver (layout);
+  solver_freeze (solver);
+
+  added = g_ptr_array_new ();
+
+  for (l = constraints; l != NULL; l = l->next)
+    {
+      EmeusConstraint *constraint = l->data;
+      EmeusConstraint *match = NULL;
+      GQueue *queue;
+
+      if (g_hash_table_contains (kept, constraint))
+        continue;
+
+      if (emeus_constraint_is_attached (constraint))
+        {
+          g_critical ("Constraint '%s' is already attached.",
+                      emeus_constraint_to_string (constraint));
+          continue;
+        }
+
+      queue = g_hash_table_lookup (structures, constraint);
+      if (queue != NULL)
+        match = g_queue_pop_head (queue);
+
+      if (match == NULL)
+        {
+          g_ptr_array_add (added, constraint);
+          continue;
+        }
+
+      if (match->constant != constraint->constant ||
+          match->metric_value != constraint->metric_value)
+        update_constraint_constant (layout, match, constraint);
+
+      g_object_unref (g_object_ref_sink (constraint));
+    }
+
+  /* Whatever is left did not match any of the new constraints */
+  g_hash_table_iter_init (&iter, structures);
+  while (g_hash_table_iter_next (&iter, NULL, &value))
+    {
+      GQueue *queue = value;
+      EmeusConstraint *constraint;
+
+      while ((constraint = g_queue_pop_head (queue)) != NULL)
+        layout_remove_constraint (layout, constraint);
+    }
+
+  for (i = 0; i < added->len; i++)
+    layout_add_constraint (layout, g_ptr_array_index (added, i));
 
-  GSequenceIter *child_iter = g_sequence_get_begin_iter (layout->children);
-  while (!g_sequence_iter_is_end (child_iter))
+  solver_thaw (solver);
+
+  g_ptr_array_unref (added);
+  g_hash_table_unref (structures);
+  g_hash_table_unref (kept);
+
+  if (gtk_widget_get_visible (GTK_WIDGET (layout)))
+    gtk_widget_queue_resize (GTK_WIDGET (layout));
+}
+
+/**
+ * emeus_constraint_layout_set_metric:
+ * @layout: a #EmeusConstraintLayout
+ * @name: the name of a metric used in the visual format language
+ * @value: the new value of the metric
+ *
+ * Changes the value of the metric @name for all the constraints of
+ * the @layout created by emeus_create_constraints_from_description().
+ *
+ * Constraints referencing a metric do not store its value; the value
+ * is held by the @layout, so updating it does not require rebuilding
+ * the constraints, e.g. when the text scale or the theme changes.
+ *
+ * The value set on the @layout takes precedence over the value of the
+ * metric used when parsing the description of constraints added later.
+ *
+ * Since: 1.0
+ */
+void
+emeus_constraint_layout_set_metric (EmeusConstraintLayout *layout,
+                                    const char            *name,
+                                    double                 value)
+{
+  LayoutMetric *metric;
+
+  g_return_if_fail (EMEUS_IS_CONSTRAINT_LAYOUT (layout));
+  g_return_if_fail (name != NULL);
+
+  metric = g_hash_table_lookup (layout->metrics, name);
+  if (metric == NULL)
+    {
+      get_layout_metric (layout, name, value);
+      return;
+    }
+
+  layout_defer_solving (layout);
+
+  solver_suggest_value (&layout->solver, metric->variable, value);
+  solver_resolve (&layout->solver);
+
+  if (gtk_widget_get_visible (GTK_WIDGET (layout)))
+    gtk_widget_queue_resize (GTK_WIDGET (layout));
+}
+
+/**
+ * emeus_constraint_layout_set_metrics:
+ * @layout: a #EmeusConstraintLayout
+ * @metrics: (element-type utf8 double): a dictionary of [ name, value ]
+ *   pairs, with the same format as the metrics passed to
+ *   emeus_constraint_layout_update_from_description()
+ *
+ * Sets the values of several named metrics at once, like calling
+ * emeus_constraint_layout_set_metric() for each of them.
+ *
+ * The new values of the metrics already used by the @layout are
+ * suggested to the solver together, and the constraints are solved
+ * only once.
+ *
+ * Since: 1.0
+ */
+void
+emeus_constraint_layout_set_metrics (EmeusConstraintLayout *layout,
+                                     GHashTable            *metrics)
+{
+  GHashTableIter iter;
+  gpointer key, value;
+  Variable **variables;
+  double *values;
+  guint n_values = 0;
+
+  g_return_if_fail (EMEUS_IS_CONSTRAINT_LAYOUT (layout));
+  g_return_if_fail (metrics != NULL);
+
+  variables = g_newa (Variable *, MAX (g_hash_table_size (metrics), 1));
+  values = g_newa (double, MAX (g_hash_table_size (metrics), 1));
+
+  g_hash_table_iter_init (&iter, metrics);
+  while (g_hash_table_iter_next (&iter, &key, &value))
     {
-      EmeusConstraintLayoutChild *child = g_sequence_get (child_iter);
+      LayoutMetric *metric = g_hash_table_lookup (layout->metrics, key);
 
-      child_iter = g_sequence_iter_next (child_iter);
+      if (metric == NULL)
+        {
+          get_layout_metric (layout, key, *(double *) value);
+          continue;
+        }
 
-      emeus_constraint_layout_child_clear_constraints (child);
+      variables[n_values] = metric->variable;
+      values[n_values] = *(double *) value;
+      n_values += 1;
     }
+
+  if (n_values == 0)
+    return;
+
+  layout_defer_solving (layout);
+
+  solver_suggest_values (&layout->solver, variables, values, n_values);
+
+  if (gtk_widget_get_visible (GTK_WIDGET (layout)))
+    gtk_widget_queue_resize (GTK_WIDGET (layout));
+}
+
+/**
+ * emeus_constraint_layout_set_deferred_solving:
+ * @layout: a #EmeusConstraintLayout
+ * @deferred: whether solving the constraints should be deferred
+ *
+ * Sets whether the @layout should defer solving its constraints until
+ * the next time GTK measures or allocates it, in the layout phase of
+ * the frame clock.
+ *
+ * When solving is deferred, adding, removing, and changing constraints,
+ * metrics, and intrinsic sizes only records the changes; a burst of
+ * changes made in the same frame is solved at once.
+ *
+ * Since: 1.0
+ */
+void
+emeus_constraint_layout_set_deferred_solving (EmeusConstraintLayout *layout,
+                                              gboolean               deferred)
+{
+  g_return_if_fail (EMEUS_IS_CONSTRAINT_LAYOUT (layout));
+
+  deferred = !!deferred;
+
+  if (layout->deferred_solving == deferred)
+    return;
+
+  layout->deferred_solving = deferred;
+
+  if (!layout->deferred_solving)
+    layout_flush_solving (layout);
+}
+
+/**
+ * emeus_constraint_layout_get_deferred_solving:
+ * @layout: a #EmeusConstraintLayout
+ *
+ * Retrieves whether the @layout defers solving its constraints.
+ *
+ * See also: emeus_constraint_layout_set_deferred_solving()
+ *
+ * Returns: %TRUE if solving the constraints is deferred
+ *
+ * Since: 1.0
+ */
+gboolean
+emeus_constraint_layout_get_deferred_solving (EmeusConstraintLayout *layout)
+{
+  g_return_val_if_fail (EMEUS_IS_CONSTRAINT_LAYOUT (layout), FALSE);
+
+  return layout->deferred_solving;
+}
+
+/**
+ * emeus_constraint_layout_set_allocation_cache_size:
+ * @layout: a #EmeusConstraintLayout
+ * @size: the maximum number of allocations to cache, or 0
+ *
+ * Sets the number of allocations of the @layout whose results are
+ * kept in a cache, so that going back to a recently seen allocation,
+ * for instance when maximizing and unmaximizing a window, does not
+ * need to solve the constraints again.
+ *
+ * The cached results are discarded whenever the constraints change.
+ *
+ * Setting @size to 0 disables the cache.
+ *
+ * Since: 1.0
+ */
+void
+emeus_constraint_layout_set_allocation_cache_size (EmeusConstraintLayout *layout,
+                                                   guint                  size)
+{
+  g_return_if_fail (EMEUS_IS_CONSTRAINT_LAYOUT (layout));
+
+  layout->allocation_cache.max_size = size;
+
+  layout_trim_allocation_cache (layout);
+}
+
+/**
+ * emeus_constraint_layout_get_allocation_cache_size:
+ * @layout: a #EmeusConstraintLayout
+ *
+ * Retrieves the number of allocations of the @layout whose results
+ * are cached.
+ *
+ * See also: emeus_constraint_layout_set_allocation_cache_size()
+ *
+ * Returns: the maximum number of cached allocations
+ *
+ * Since: 1.0
+ */
+guint
+emeus_constraint_layout_get_allocation_cache_size (EmeusConstraintLayout *layout)
+{
+  g_return_val_if_fail (EMEUS_IS_CONSTRAINT_LAYOUT (layout), 0);
+
+  return layout->allocation_cache.max_size;
+}
+
+/**
+ * emeus_constraint_layout_get_allocation_cache_hit_rate:
+ * @layout: a #EmeusConstraintLayout
+ *
+ * Retrieves the fraction of the allocations of the @layout that were
+ * found in the allocation cache, since the @layout was created.
+ *
+ * Returns: the hit rate of the cache, between 0 and 1
+ *
+ * Since: 1.0
+ */
+double
+emeus_constraint_layout_get_allocation_cache_hit_rate (EmeusConstraintLayout *layout)
+{
+  guint n_lookups;
+
+  g_return_val_if_fail (EMEUS_IS_CONSTRAINT_LAYOUT (layout), 0.0);
+
+  n_lookups = layout->allocation_cache.n_hits + layout->allocation_cache.n_misses;
+  if (n_lookups == 0)
+    return 0.0;
+
+  return (double) layout->allocation_cache.n_hits / n_lookups;
 }
 
 static void
@@ -1847,27 +3609,27 @@ emeus_constraint_layout_child_finalize (GObject *gobject)
 
   if (self->solver)
     {
-      simplex_solver_freeze (self->solver);
+      solver_freeze (self->solver);
 
       if (self->width_constraint != NULL)
-        simplex_solver_remove_constraint (self->solver, self->width_constraint);
+        solver_remove_constraint (self->solver, self->width_constraint);
 
       if (self->height_constraint != NULL)
-        simplex_solver_remove_constraint (self->solver, self->height_constraint);
+        solver_remove_constraint (self->solver, self->height_constraint);
 
       if (self->right_constraint != NULL)
-        simplex_solver_remove_constraint (self->solver, self->right_constraint);
+        solver_remove_constraint (self->solver, self->right_constraint);
 
       if (self->bottom_constraint != NULL)
-        simplex_solver_remove_constraint (self->solver, self->bottom_constraint);
+        solver_remove_constraint (self->solver, self->bottom_constraint);
 
       if (self->center_x_constraint != NULL)
-        simplex_solver_remove_constraint (self->solver, self->center_x_constraint);
+        solver_remove_constraint (self->solver, self->center_x_constraint);
 
       if (self->center_y_constraint != NULL)
-        simplex_solver_remove_constraint (self->solver, self->center_y_constraint);
+        solver_remove_constraint (self->solver, self->center_y_constraint);
 
-      simplex_solver_thaw (self->solver);
+      solver_thaw (self->solver);
 
       GtkWidget *layout;
       if ((layout = gtk_widget_get_parent (GTK_WIDGET (gobject))))
@@ -1886,7 +3648,7 @@ emeus_constraint_layout_child_dispose (GObject *gobject)
   EmeusConstraintLayoutChild *self = EMEUS_CONSTRAINT_LAYOUT_CHILD (gobject);
 
   g_clear_pointer (&self->constraints, g_hash_table_unref);
-  g_clear_pointer (&self->bound_attributes, g_hash_table_unref);
+  clear_bound_attributes (self->bound_attributes);
 
   G_OBJECT_CLASS (emeus_constraint_layout_child_parent_class)->dispose (gobject);
 }
@@ -1958,14 +3720,14 @@ emeus_constraint_layout_child_get_preferred_size (EmeusConstraintLayoutChild *se
 
           /* Update the constraint because the min width can change */
           if (self->width_constraint != NULL)
-            simplex_solver_remove_constraint (self->solver, self->width_constraint);
+            solver_remove_constraint (self->solver, self->width_constraint);
 
           Expression *e = expression_new_from_constant (child_min);
 
           self->width_constraint =
-            simplex_solver_add_constraint (self->solver,
-                                           attr, OPERATOR_TYPE_GE, e,
-                                           STRENGTH_MEDIUM);
+            solver_add_constraint (self->solver,
+                                   attr, OPERATOR_TYPE_GE, e,
+                                   STRENGTH_MEDIUM);
 
           expression_unref (e);
         }
@@ -1973,7 +3735,7 @@ emeus_constraint_layout_child_get_preferred_size (EmeusConstraintLayoutChild *se
         {
           if (self->width_constraint != NULL)
             {
-              simplex_solver_remove_constraint (self->solver, self->width_constraint);
+              solver_remove_constraint (self->solver, self->width_constraint);
               self->width_constraint = NULL;
             }
         }
@@ -1990,14 +3752,14 @@ emeus_constraint_layout_child_get_preferred_size (EmeusConstraintLayoutChild *se
 
           /* Update the constraint because the min height can change */
           if (self->height_constraint != NULL)
-            simplex_solver_remove_constraint (self->solver, self->height_constraint);
+            solver_remove_constraint (self->solver, self->height_constraint);
 
           Expression *e = expression_new_from_constant (child_min);
 
           self->height_constraint =
-            simplex_solver_add_constraint (self->solver,
-                                           attr, OPERATOR_TYPE_GE, e,
-                                           STRENGTH_MEDIUM);
+            solver_add_constraint (self->solver,
+                                   attr, OPERATOR_TYPE_GE, e,
+                                   STRENGTH_MEDIUM);
 
           expression_unref (e);
         }
@@ -2005,7 +3767,7 @@ emeus_constraint_layout_child_get_preferred_size (EmeusConstraintLayoutChild *se
         {
           if (self->height_constraint != NULL)
             {
-              simplex_solver_remove_constraint (self->solver, self->height_constraint);
+              solver_remove_constraint (self->solver, self->height_constraint);
               self->height_constraint = NULL;
             }
         }
@@ -2131,10 +3893,6 @@ emeus_constraint_layout_child_init (EmeusConstraintLayoutChild *self)
   self->constraints = g_hash_table_new_full (NULL, NULL,
                                              g_object_unref,
                                              NULL);
-
-  self->bound_attributes = g_hash_table_new_full (NULL, NULL,
-                                                  NULL,
-                                                  (GDestroyNotify) variable_unref);
 }
 
 /**
@@ -2236,7 +3994,7 @@ emeus_constraint_layout_child_clear_constraints (EmeusConstraintLayoutChild *chi
   g_return_if_fail (EMEUS_IS_CONSTRAINT_LAYOUT_CHILD (child));
 
   g_hash_table_remove_all (child->constraints);
-  g_hash_table_remove_all (child->bound_attributes);
+  clear_bound_attributes (child->bound_attributes);
 
   gtk_widget_queue_resize (GTK_WIDGET (child));
 }
@@ -2258,9 +4016,11 @@ emeus_constraint_layout_child_get_top (EmeusConstraintLayoutChild *child)
 
   g_return_val_if_fail (EMEUS_IS_CONSTRAINT_LAYOUT_CHILD (child), 0);
 
+  child_flush_solving (child);
+
   res = get_child_attribute (child, EMEUS_CONSTRAINT_ATTRIBUTE_TOP);
 
-  return floor (variable_get_value (res));
+  return floor (solver_get_value (child->solver, res));
 }
 
 /**
@@ -2280,9 +4040,11 @@ emeus_constraint_layout_child_get_right (EmeusConstraintLayoutChild *child)
 
   g_return_val_if_fail (EMEUS_IS_CONSTRAINT_LAYOUT_CHILD (child), 0);
 
+  child_flush_solving (child);
+
   res = get_child_attribute (child, EMEUS_CONSTRAINT_ATTRIBUTE_RIGHT);
 
-  return ceil (variable_get_value (res));
+  return ceil (solver_get_value (child->solver, res));
 }
 
 /**
@@ -2302,9 +4064,11 @@ emeus_constraint_layout_child_get_bottom (EmeusConstraintLayoutChild *child)
 
   g_return_val_if_fail (EMEUS_IS_CONSTRAINT_LAYOUT_CHILD (child), 0);
 
+  child_flush_solving (child);
+
   res = get_child_attribute (child, EMEUS_CONSTRAINT_ATTRIBUTE_BOTTOM);
 
-  return ceil (variable_get_value (res));
+  return ceil (solver_get_value (child->solver, res));
 }
 
 /**
@@ -2324,9 +4088,11 @@ emeus_constraint_layout_child_get_left (EmeusConstraintLayoutChild *child)
 
   g_return_val_if_fail (EMEUS_IS_CONSTRAINT_LAYOUT_CHILD (child), 0);
 
+  child_flush_solving (child);
+
   res = get_child_attribute (child, EMEUS_CONSTRAINT_ATTRIBUTE_LEFT);
 
-  return floor (variable_get_value (res));
+  return floor (solver_get_value (child->solver, res));
 }
 
 /**
@@ -2346,9 +4112,11 @@ emeus_constraint_layout_child_get_width (EmeusConstraintLayoutChild *child)
 
   g_return_val_if_fail (EMEUS_IS_CONSTRAINT_LAYOUT_CHILD (child), 0);
 
+  child_flush_solving (child);
+
   res = get_child_attribute (child, EMEUS_CONSTRAINT_ATTRIBUTE_WIDTH);
 
-  return ceil (variable_get_value (res));
+  return ceil (solver_get_value (child->solver, res));
 }
 
 /**
@@ -2368,9 +4136,11 @@ emeus_constraint_layout_child_get_height (EmeusConstraintLayoutChild *child)
 
   g_return_val_if_fail (EMEUS_IS_CONSTRAINT_LAYOUT_CHILD (child), 0);
 
+  child_flush_solving (child);
+
   res = get_child_attribute (child, EMEUS_CONSTRAINT_ATTRIBUTE_HEIGHT);
 
-  return ceil (variable_get_value (res));
+  return ceil (solver_get_value (child->solver, res));
 }
 
 /**
@@ -2390,9 +4160,11 @@ emeus_constraint_layout_child_get_center_x (EmeusConstraintLayoutChild *child)
 
   g_return_val_if_fail (EMEUS_IS_CONSTRAINT_LAYOUT_CHILD (child), 0);
 
+  child_flush_solving (child);
+
   res = get_child_attribute (child, EMEUS_CONSTRAINT_ATTRIBUTE_CENTER_X);
 
-  return ceil (variable_get_value (res));
+  return ceil (solver_get_value (child->solver, res));
 }
 
 /**
@@ -2412,9 +4184,11 @@ emeus_constraint_layout_child_get_center_y (EmeusConstraintLayoutChild *child)
 
   g_return_val_if_fail (EMEUS_IS_CONSTRAINT_LAYOUT_CHILD (child), 0);
 
+  child_flush_solving (child);
+
   res = get_child_attribute (child, EMEUS_CONSTRAINT_ATTRIBUTE_CENTER_Y);
 
-  return ceil (variable_get_value (res));
+  return ceil (solver_get_value (child->solver, res));
 }
 
 /**
@@ -2444,15 +4218,17 @@ emeus_constraint_layout_child_set_intrinsic_width (EmeusConstraintLayoutChild *c
 
   attr = get_child_attribute (child, EMEUS_CONSTRAINT_ATTRIBUTE_WIDTH);
 
+  layout_defer_solving (EMEUS_CONSTRAINT_LAYOUT (gtk_widget_get_parent (GTK_WIDGET (child))));
+
   if (child->intrinsic_width < 0)
     {
       child->width_constraint =
-        simplex_solver_add_edit_variable (child->solver, attr, STRENGTH_REQUIRED);
+        solver_add_edit_variable (child->solver, attr, STRENGTH_REQUIRED);
     }
 
   if (width < 0)
     {
-      simplex_solver_remove_constraint (child->solver, child->width_constraint);
+      solver_remove_constraint (child->solver, child->width_constraint);
       child->width_constraint = NULL;
     }
 
@@ -2460,8 +4236,8 @@ emeus_constraint_layout_child_set_intrinsic_width (EmeusConstraintLayoutChild *c
 
   if (child->intrinsic_width > 0)
     {
-      simplex_solver_suggest_value (child->solver, attr, child->intrinsic_width);
-      simplex_solver_resolve (child->solver);
+      solver_suggest_value (child->solver, attr, child->intrinsic_width);
+      solver_resolve (child->solver);
     }
 
   if (gtk_widget_get_visible (GTK_WIDGET (child)))
@@ -2495,15 +4271,17 @@ emeus_constraint_layout_child_set_intrinsic_height (EmeusConstraintLayoutChild *
 
   attr = get_child_attribute (child, EMEUS_CONSTRAINT_ATTRIBUTE_HEIGHT);
 
+  layout_defer_solving (EMEUS_CONSTRAINT_LAYOUT (gtk_widget_get_parent (GTK_WIDGET (child))));
+
   if (child->intrinsic_height < 0)
     {
       child->height_constraint =
-        simplex_solver_add_edit_variable (child->solver, attr, STRENGTH_REQUIRED - 1);
+        solver_add_edit_variable (child->solver, attr, STRENGTH_REQUIRED - 1);
     }
 
   if (height < 0)
     {
-      simplex_solver_remove_constraint (child->solver, child->height_constraint);
+      solver_remove_constraint (child->solver, child->height_constraint);
       child->height_constraint = NULL;
     }
 
@@ -2511,8 +4289,8 @@ emeus_constraint_layout_child_set_intrinsic_height (EmeusConstraintLayoutChild *
 
   if (child->intrinsic_height > 0)
     {
-      simplex_solver_suggest_value (child->solver, attr, height);
-      simplex_solver_resolve (child->solver);
+      solver_suggest_value (child->solver, attr, height);
+      solver_resolve (child->solver);
     }
 
   if (gtk_widget_get_visible (GTK_WIDGET (child)))
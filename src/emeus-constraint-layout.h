@@ -55,11 +55,49 @@ void            emeus_constraint_layout_add_constraints         (EmeusConstraint
                                                                  EmeusConstraint       *first_constraint,
                                                                  ...) G_GNUC_NULL_TERMINATED;
 
+EMEUS_AVAILABLE_IN_1_0
+void            emeus_constraint_layout_update_from_description (EmeusConstraintLayout *layout,
+                                                                 const char * const    *lines,
+                                                                 guint                  n_lines,
+                                                                 int                    hspacing,
+                                                                 int                    vspacing,
+                                                                 GHashTable            *views,
+                                                                 GHashTable            *metrics);
+
 EMEUS_AVAILABLE_IN_1_0
 GList *         emeus_constraint_layout_get_constraints         (EmeusConstraintLayout *layout);
+EMEUS_AVAILABLE_IN_1_0
+guint           emeus_constraint_layout_get_child_rectangles    (EmeusConstraintLayout *layout,
+                                                                 GdkRectangle          *rects,
+                                                                 guint                  n_rects);
 
 EMEUS_AVAILABLE_IN_1_0
 void            emeus_constraint_layout_clear_constraints       (EmeusConstraintLayout *layout);
+EMEUS_AVAILABLE_IN_1_0
+void            emeus_constraint_layout_replace_constraints     (EmeusConstraintLayout *layout,
+                                                                 GList                 *constraints);
+
+EMEUS_AVAILABLE_IN_1_0
+void            emeus_constraint_layout_set_metric              (EmeusConstraintLayout *layout,
+                                                                 const char            *name,
+                                                                 double                 value);
+EMEUS_AVAILABLE_IN_1_0
+void            emeus_constraint_layout_set_metrics             (EmeusConstraintLayout *layout,
+                                                                 GHashTable            *metrics);
+
+EMEUS_AVAILABLE_IN_1_0
+void            emeus_constraint_layout_set_deferred_solving    (EmeusConstraintLayout *layout,
+                                                                 gboolean               deferred);
+EMEUS_AVAILABLE_IN_1_0
+gboolean        emeus_constraint_layout_get_deferred_solving    (EmeusConstraintLayout *layout);
+
+EMEUS_AVAILABLE_IN_1_0
+void            emeus_constraint_layout_set_allocation_cache_size       (EmeusConstraintLayout *layout,
+                                                                         guint                  size);
+EMEUS_AVAILABLE_IN_1_0
+guint           emeus_constraint_layout_get_allocation_cache_size       (EmeusConstraintLayout *layout);
+EMEUS_AVAILABLE_IN_1_0
+double          emeus_constraint_layout_get_allocation_cache_hit_rate   (EmeusConstraintLayout *layout);
 
 #define EMEUS_TYPE_CONSTRAINT_LAYOUT_CHILD (emeus_constraint_layout_child_get_type())
 
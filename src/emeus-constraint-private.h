@@ -47,6 +47,21 @@ struct _EmeusConstraint
   SimplexSolver *solver;
   Constraint *constraint;
   EmeusConstraintLayout *layout;
+
+  /* The normalized expression of the constraint, kept around after
+   * the constraint has been deactivated so that activating it again
+   * does not need to resolve the attributes and rebuild it; owned.
+   */
+  Expression *prepared;
+
+  /* The VFL metric contributing to the constant, if any, and the value
+   * it had when the constraint was created; the layout replaces it with
+   * a variable, so that the metric can be changed without rebuilding
+   * the constraint.
+   */
+  const char *metric;
+  double metric_multiplier;
+  double metric_value;
 };
 
 gboolean        emeus_constraint_attach                 (EmeusConstraint       *constraint,
@@ -57,4 +72,18 @@ Constraint *    emeus_constraint_get_real_constraint    (EmeusConstraint       *
 
 const char *    emeus_constraint_to_string              (EmeusConstraint       *constraint);
 
+char *          emeus_constraint_description_prefix     (int                    hspacing,
+                                                         int                    vspacing,
+                                                         GHashTable            *metrics);
+char *          emeus_constraint_description_key        (const char            *prefix,
+                                                         const char            *line);
+
+GList *         emeus_constraint_list_from_description  (const char            *prefix,
+                                                         const char * const     lines[],
+                                                         guint                  n_lines,
+                                                         int                    hspacing,
+                                                         int                    vspacing,
+                                                         GHashTable            *views,
+                                                         GHashTable            *metrics);
+
 G_END_DECLS
@@ -62,13 +62,14 @@
 #include "emeus-constraint-private.h"
 
 #include "emeus-expression-private.h"
-#include "emeus-simplex-solver-private.h"
+#include "emeus-solver-backend-private.h"
 #include "emeus-utils-private.h"
 #include "emeus-utils.h"
 #include "emeus-vfl-parser-private.h"
 
 #include <math.h>
 #include <float.h>
+#include <string.h>
 #include <gtk/gtk.h>
 
 enum {
@@ -95,6 +96,7 @@ emeus_constraint_finalize (GObject *gobject)
   EmeusConstraint *self = EMEUS_CONSTRAINT (gobject);
 
   g_free (self->description);
+  g_clear_pointer (&self->prepared, expression_unref);
 
   G_OBJECT_CLASS (emeus_constraint_parent_class)->finalize (gobject);
 }
@@ -685,7 +687,9 @@ void
 emeus_constraint_detach (EmeusConstraint *constraint)
 {
   if (constraint->constraint != NULL)
-    simplex_solver_remove_constraint (constraint->solver, constraint->constraint);
+    solver_remove_constraint (constraint->solver, constraint->constraint);
+
+  g_clear_pointer (&constraint->prepared, expression_unref);
 
   constraint->constraint = NULL;
   constraint->layout = NULL;
@@ -763,6 +767,149 @@ emeus_constraint_get_active (EmeusConstraint *constraint)
   return constraint->is_active;
 }
 
+/* Parsed VFL lines are shared by the whole process, as the same
+ * descriptions are typically used by every instance of a widget;
+ * the cache is bounded, and emptied when it's full.
+ */
+#define VFL_CACHE_MAX_SIZE      256
+
+typedef struct {
+  /* The strings in each VflConstraint are interned */
+  VflConstraint *constraints;
+  int n_constraints;
+} VflCacheEntry;
+
+/* HashTable<string, VflCacheEntry> */
+static GHashTable *vfl_cache;
+
+static void
+vfl_cache_entry_free (gpointer data)
+{
+  VflCacheEntry *entry = data;
+
+  g_free (entry->constraints);
+  g_slice_free (VflCacheEntry, entry);
+}
+
+/* Returns the part of the keys of the lines parsed with the given
+ * spacing and metrics that does not depend on the line, to be passed
+ * to emeus_constraint_description_key() for each line
+ */
+char *
+emeus_constraint_description_prefix (int         hspacing,
+                                     int         vspacing,
+                                     GHashTable *metrics)
+{
+  GString *res = g_string_new (NULL);
+
+  g_string_append_printf (res, "%d:%d:", hspacing, vspacing);
+
+  /* The metric values are resolved by the parser, so they are part
+   * of the key; we use the exact representation of the values
+   */
+  if (metrics != NULL)
+    {
+      GList *names = g_list_sort (g_hash_table_get_keys (metrics), (GCompareFunc) strcmp);
+
+      for (GList *l = names; l != NULL; l = l->next)
+        {
+          const double *value = g_hash_table_lookup (metrics, l->data);
+
+          g_string_append_printf (res, "%s=%a;",
+                                  (const char *) l->data,
+                                  value != NULL ? *value : 0.0);
+        }
+
+      g_list_free (names);
+    }
+
+  g_string_append_c (res, '\n');
+
+  return g_string_free (res, FALSE);
+}
+
+/* Returns a key identifying the constraints generated by parsing
+ * @line with the spacing and metrics used to build @prefix
+ */
+char *
+emeus_constraint_description_key (const char *prefix,
+                                  const char *line)
+{
+  return g_strconcat (prefix, line, NULL);
+}
+
+static bool
+vfl_cache_has_view (GHashTable *views,
+                    const char *name)
+{
+  return strcmp (name, "super") == 0 || g_hash_table_contains (views, name);
+}
+
+static const VflCacheEntry *
+vfl_cache_lookup (const char *key,
+                  GHashTable *views)
+{
+  const VflCacheEntry *entry;
+
+  if (vfl_cache == NULL)
+    return NULL;
+
+  entry = g_hash_table_lookup (vfl_cache, key);
+  if (entry == NULL)
+    return NULL;
+
+  /* The parser checks that the views exist; if they don't, we let it
+   * parse the line again, and report the error
+   */
+  for (int i = 0; i < entry->n_constraints; i++)
+    {
+      const VflConstraint *c = &entry->constraints[i];
+
+      if (!vfl_cache_has_view (views, c->view1))
+        return NULL;
+
+      if (c->view2 != NULL && !vfl_cache_has_view (views, c->view2))
+        return NULL;
+    }
+
+  return entry;
+}
+
+static const VflCacheEntry *
+vfl_cache_add (char                *key,
+               const VflConstraint *constraints,
+               int                  n_constraints)
+{
+  VflCacheEntry *entry;
+
+  if (vfl_cache == NULL)
+    vfl_cache = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                       g_free,
+                                       vfl_cache_entry_free);
+
+  if (g_hash_table_size (vfl_cache) >= VFL_CACHE_MAX_SIZE)
+    g_hash_table_remove_all (vfl_cache);
+
+  entry = g_slice_new (VflCacheEntry);
+  entry->constraints = g_new (VflConstraint, n_constraints);
+  entry->n_constraints = n_constraints;
+
+  for (int i = 0; i < n_constraints; i++)
+    {
+      VflConstraint *c = &entry->constraints[i];
+
+      *c = constraints[i];
+      c->view1 = g_intern_string (c->view1);
+      c->attr1 = g_intern_string (c->attr1);
+      c->view2 = g_intern_string (c->view2);
+      c->attr2 = g_intern_string (c->attr2);
+    }
+
+  g_hash_table_insert (vfl_cache, key, entry);
+
+  return entry;
+}
+
 /**
  * emeus_create_constraints_from_description:
  * @lines: (array length=n_lines): an array of Visual Format Language lines
@@ -815,6 +962,10 @@ emeus_constraint_get_active (EmeusConstraint *constraint)
  *                    <number> // A real number parseable by g_ascii_strtod()
  * ]|
  *
+ * The parsed lines are cached, so creating constraints repeatedly from
+ * the same description, with the same spacing and metrics, only needs
+ * to bind the view names to the widgets in @views.
+ *
  * **Note**: The VFL grammar is slightly different than the one defined by Apple,
  * as it uses symbolic values for the constraint's priority instead of numeric
  * values.
@@ -871,51 +1022,91 @@ emeus_create_constraints_from_description (const char * const  lines[],
 {
   g_return_val_if_fail (lines != NULL && n_lines != 0, NULL);
 
-  VflParser *parser = vfl_parser_new (hspacing, vspacing, metrics, views);
+  char *prefix = emeus_constraint_description_prefix (hspacing, vspacing, metrics);
+  GList *res = emeus_constraint_list_from_description (prefix, lines, n_lines,
+                                                       hspacing, vspacing,
+                                                       views,
+                                                       metrics);
+
+  g_free (prefix);
+
+  return res;
+}
+
+/* Like emeus_create_constraints_from_description(), with the @prefix
+ * of the keys of the lines already built by the caller
+ */
+GList *
+emeus_constraint_list_from_description (const char         *prefix,
+                                        const char * const  lines[],
+                                        guint               n_lines,
+                                        int                 hspacing,
+                                        int                 vspacing,
+                                        GHashTable         *views,
+                                        GHashTable         *metrics)
+{
+  /* The parser is only needed for the lines we haven't seen yet */
+  VflParser *parser = NULL;
 
   GList *res = NULL;
 
   for (guint i = 0; i < n_lines; i++)
     {
       const char *line = lines[i];
-      GError *error = NULL;
+      char *key = emeus_constraint_description_key (prefix, line);
+      const VflCacheEntry *entry = vfl_cache_lookup (key, views);
 
-      vfl_parser_parse_line (parser, line, -1, &error);
-      if (error != NULL)
+      if (entry == NULL)
         {
-          int offset = vfl_parser_get_error_offset (parser);
-          int range = vfl_parser_get_error_range (parser);
-          char *squiggly = NULL;
+          GError *error = NULL;
+
+          if (parser == NULL)
+            parser = vfl_parser_new (hspacing, vspacing, metrics, views);
 
-          if (range > 0)
+          vfl_parser_parse_line (parser, line, -1, &error);
+          if (error != NULL)
             {
-              squiggly = g_new (char, range + 1);
+              int offset = vfl_parser_get_error_offset (parser);
+              int range = vfl_parser_get_error_range (parser);
+              char *squiggly = NULL;
+
+              if (range > 0)
+                {
+                  squiggly = g_new (char, range + 1);
+
+                  for (int r = 0; r < range; r++)
+                    squiggly[r] = '~';
+
+                  squiggly[range] = '\0';
+                }
+
+              g_critical ("VFL parsing error:%d:%d: %s\n"
+                          "%s\n"
+                          "%*s^%s",
+                          i, offset + 1,
+                          error->message,
+                          line,
+                          offset, " ", squiggly != NULL ? squiggly : "");
+
+              g_free (squiggly);
+              g_error_free (error);
+              g_free (key);
+              continue;
+            }
 
-              for (int r = 0; r < range; i++)
-                squiggly[r] = '~';
+          int n_constraints = 0;
+          VflConstraint *constraints = vfl_parser_get_constraints (parser, &n_constraints);
 
-              squiggly[range] = '\0';
-            }
+          entry = vfl_cache_add (key, constraints, n_constraints);
 
-          g_critical ("VFL parsing error:%d:%d: %s\n"
-                      "%s\n"
-                      "%*s^%s",
-                      i, offset + 1,
-                      error->message,
-                      line,
-                      offset, " ", squiggly != NULL ? squiggly : "");
-
-          g_free (squiggly);
-          g_error_free (error);
-          vfl_parser_free (parser);
-          continue;
+          g_free (constraints);
         }
+      else
+        g_free (key);
 
-      int n_constraints = 0;
-      VflConstraint *constraints = vfl_parser_get_constraints (parser, &n_constraints);
-      for (int j = 0; j < n_constraints; j++)
+      for (int j = 0; j < entry->n_constraints; j++)
         {
-          const VflConstraint *c = &constraints[j];
+          const VflConstraint *c = &entry->constraints[j];
           gpointer source, target;
           EmeusConstraintAttribute source_attr, target_attr;
           EmeusConstraintRelation relation;
@@ -943,11 +1134,20 @@ emeus_create_constraints_from_description (const char * const  lines[],
                                   c->constant,
                                   c->strength);
 
+          if (c->metric != NULL)
+            {
+              const double *value = g_hash_table_lookup (metrics, c->metric);
+
+              constraint->metric = c->metric;
+              constraint->metric_multiplier = c->metric_multiplier;
+              constraint->metric_value = *value;
+            }
+
           res = g_list_prepend (res, constraint);
         }
-
-      g_free (constraints);
     }
 
+  vfl_parser_free (parser);
+
   return g_list_reverse (res);
 }
@@ -103,6 +103,12 @@ expression_is_constant (const Expression *expression)
   return expression->terms == NULL;
 }
 
+static inline guint
+expression_get_n_terms (const Expression *expression)
+{
+  return expression->terms != NULL ? g_hash_table_size (expression->terms) : 0;
+}
+
 static inline double
 expression_get_constant (const Expression *expression)
 {
@@ -117,6 +123,10 @@ Expression *expression_new_from_variable (Variable *variable);
 
 Expression *expression_clone (Expression *expression);
 
+Expression *expression_save_terms (Expression *expression);
+void expression_restore_terms (Expression *expression,
+                               Expression *saved);
+
 Expression *expression_ref (Expression *expression);
 void expression_unref (Expression *expression);
 
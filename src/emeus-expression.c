@@ -28,9 +28,28 @@
 
 /* Monotonic counter for variables; we use this when comparing
  * variables because the solver relies on ordering when pivoting
- * and optimizing the tableau
+ * and optimizing the tableau. The counter is shared by all solvers,
+ * which may live in different threads, so it is updated atomically
  */
-static unsigned long variable_id;
+static gsize variable_id;
+
+/* Notify the solver that owns an expression or a variable that its
+ * contents are about to change, so that an open transaction can
+ * record their current state
+ */
+static inline void
+expression_journal (Expression *expression)
+{
+  if (expression->solver != NULL && expression->solver->journal != NULL)
+    simplex_solver_note_expression_change (expression->solver, expression);
+}
+
+static inline void
+variable_journal (Variable *variable)
+{
+  if (variable->solver != NULL && variable->solver->journal != NULL)
+    simplex_solver_note_variable_change (variable->solver, variable);
+}
 
 static void
 dummy_variable_init (Variable *v)
@@ -71,7 +90,7 @@ variable_new (SimplexSolver *solver,
   Variable *res = g_slice_new0 (Variable);
 
   res->solver = solver;
-  res->id_ = ++variable_id;
+  res->id_ = (gsize) g_atomic_pointer_add (&variable_id, 1) + 1;
   res->type = type;
   res->ref_count = 1;
   res->name = NULL;
@@ -128,6 +147,8 @@ void
 variable_set_value (Variable *variable,
                     double value)
 {
+  variable_journal (variable);
+
   variable->value = value;
 }
 
@@ -200,6 +221,7 @@ term_new (Variable *variable,
 
   t->variable = variable_ref (variable);
   t->coefficient = coefficient;
+  t->link = NULL;
 
   return t;
 }
@@ -223,9 +245,20 @@ expression_add_term (Expression *expression,
     expression->terms = g_hash_table_new_full (NULL, NULL, NULL, (GDestroyNotify) term_free);
 
   expression->ordered_terms = g_list_prepend (expression->ordered_terms, term);
+  term->link = expression->ordered_terms;
+
   g_hash_table_insert (expression->terms, term->variable, term);
 }
 
+/* Removes @term from @expression, and frees it */
+static void
+expression_unlink_term (Expression *expression,
+                        Term *term)
+{
+  expression->ordered_terms = g_list_delete_link (expression->ordered_terms, term->link);
+  g_hash_table_remove (expression->terms, term->variable);
+}
+
 static Expression *
 expression_new_full (SimplexSolver *solver,
                      Variable *variable,
@@ -288,6 +321,49 @@ expression_clone (Expression *expression)
   return clone;
 }
 
+Expression *
+expression_save_terms (Expression *expression)
+{
+  Expression *saved = expression_new_full (NULL, NULL, 0.0, expression->constant);
+  GList *l;
+
+  /* The saved expression takes ownership of the terms, and we give a
+   * copy to the original expression; this way we can put the terms
+   * back without changing the order in which they are iterated
+   */
+  saved->terms = expression->terms;
+  saved->ordered_terms = expression->ordered_terms;
+
+  expression->terms = NULL;
+  expression->ordered_terms = NULL;
+
+  for (l = g_list_last (saved->ordered_terms); l != NULL; l = l->prev)
+    {
+      const Term *t = l->data;
+
+      expression_add_term (expression, term_new (t->variable, t->coefficient));
+    }
+
+  return saved;
+}
+
+void
+expression_restore_terms (Expression *expression,
+                          Expression *saved)
+{
+  GHashTable *terms = expression->terms;
+  GList *ordered_terms = expression->ordered_terms;
+
+  expression->constant = saved->constant;
+  expression->terms = saved->terms;
+  expression->ordered_terms = saved->ordered_terms;
+
+  saved->terms = terms;
+  saved->ordered_terms = ordered_terms;
+
+  expression_unref (saved);
+}
+
 Expression *
 expression_ref (Expression *expression)
 {
@@ -323,6 +399,8 @@ void
 expression_set_constant (Expression *expression,
                          double constant)
 {
+  expression_journal (expression);
+
   expression->constant = constant;
 }
 
@@ -332,6 +410,8 @@ expression_add_variable (Expression *expression,
                          double coefficient,
                          Variable *subject)
 {
+  expression_journal (expression);
+
   if (expression->terms != NULL)
     {
       Term *t = g_hash_table_lookup (expression->terms, variable);
@@ -377,13 +457,21 @@ expression_remove_variable (Expression *expression,
   if (term == NULL)
     return;
 
+  /* Saving the terms in the journal replaces them with copies, so we
+   * need to look the term up again, but only inside a transaction
+   */
+  if (expression->solver != NULL && expression->solver->journal != NULL)
+    {
+      expression_journal (expression);
+      term = g_hash_table_lookup (expression->terms, variable);
+    }
+
   variable_ref (variable);
 
   if (subject != NULL)
     variable_ref (subject);
 
-  expression->ordered_terms = g_list_remove (expression->ordered_terms, term);
-  g_hash_table_remove (expression->terms, variable);
+  expression_unlink_term (expression, term);
 
   if (subject != NULL)
     variable_unref (subject);
@@ -406,6 +494,8 @@ expression_set_variable (Expression *expression,
                          Variable *variable,
                          double coefficient)
 {
+  expression_journal (expression);
+
   if (expression->terms != NULL)
     {
       Term *t = g_hash_table_lookup (expression->terms, variable);
@@ -428,6 +518,8 @@ expression_add_expression (Expression *a,
 {
   GList *l;
 
+  expression_journal (a);
+
   a->constant += (n * b->constant);
 
   for (l = g_list_last (b->ordered_terms); l != NULL; l = l->prev)
@@ -553,6 +645,8 @@ expression_times (Expression *expression,
   GHashTableIter iter;
   gpointer value_p;
 
+  expression_journal (expression);
+
   expression->constant *= multiplier;
 
   if (expression->terms == NULL)
@@ -598,48 +692,59 @@ expression_new_subject (Expression *expression,
 
   g_assert (!expression_is_constant (expression));
 
+  expression_journal (expression);
+
   term = g_hash_table_lookup (expression->terms, subject);
   g_assert (term != NULL);
   g_assert (term->coefficient != 0.0);
 
   reciprocal = 1.0 / term->coefficient;
 
-  expression->ordered_terms = g_list_remove (expression->ordered_terms, term);
-  g_hash_table_remove (expression->terms, subject);
+  expression_unlink_term (expression, term);
 
   expression_times (expression, -reciprocal);
 
   return reciprocal;
 }
 
+/* Replaces @out_var with @expr, i.e. adds @expr multiplied by the
+ * coefficient of @out_var; this is the update done on every row of
+ * the tableau when pivoting, so each term of @expr costs a single
+ * lookup, and the terms are updated in place
+ */
 void
 expression_substitute_out (Expression *expression,
                            Variable *out_var,
                            Expression *expr,
                            Variable *subject)
 {
+  GList *l;
+
   if (expression->terms == NULL)
     return;
 
   double multiplier = expression_get_coefficient (expression, out_var);
 
+  expression_journal (expression);
+
   expression_remove_variable (expression, out_var, NULL);
 
   expression->constant = expression->constant + multiplier * expr->constant;
 
-  GHashTableIter iter;
-  gpointer value_p;
-  g_hash_table_iter_init (&iter, expr->terms);
-  while (g_hash_table_iter_next (&iter, NULL, &value_p))
+  for (l = g_list_last (expr->ordered_terms); l != NULL; l = l->prev)
     {
-      Variable *clv = term_get_variable (value_p);
-      double coeff = term_get_coefficient (value_p);
+      const Term *t = l->data;
+      Variable *clv = term_get_variable (t);
+      double coeff = term_get_coefficient (t);
+      Term *row_term;
 
-      double old_coefficient = expression_get_coefficient (expression, clv);
+      row_term = expression->terms != NULL
+               ? g_hash_table_lookup (expression->terms, clv)
+               : NULL;
 
-      if (expression_has_variable (expression, clv))
+      if (row_term != NULL)
         {
-          double new_coefficient = old_coefficient + multiplier * coeff;
+          double new_coefficient = row_term->coefficient + multiplier * coeff;
 
           if (approx_val (new_coefficient, 0.0))
             {
@@ -649,11 +754,11 @@ expression_substitute_out (Expression *expression,
               expression_remove_variable (expression, clv, subject);
             }
           else
-            expression_set_variable (expression, clv, new_coefficient);
+            row_term->coefficient = new_coefficient;
         }
       else
         {
-          expression_set_variable (expression, clv, multiplier * coeff);
+          expression_add_term (expression, term_new (clv, multiplier * coeff));
 
           if (expression->solver)
             simplex_solver_note_added_variable (expression->solver, clv, subject);
@@ -0,0 +1,914 @@
+/* emeus-lp-dense.c: Dense simplex engine
+ *
+ * Copyright 2016  Endless
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* The dense engine keeps the whole tableau of the program:
+ *
+ *   T = B⁻¹·A
+ *
+ * with one row for each position of the basis, and one column for each
+ * column of the program. Each row is an array of doubles aligned on 32
+ * bytes, and padded to a multiple of four columns, so that the updates
+ * of the tableau, which are all of the form
+ *
+ *   y := y + a·x
+ *
+ * on whole rows, can use the vector instructions of the CPU; the kernels
+ * are chosen when the engine is created, depending on what the CPU
+ * supports.
+ *
+ * Since the marker of each row is zero outside of it, the columns of the
+ * markers hold B⁻¹, and the values of the basic columns do not need a
+ * separate right hand side column.
+ *
+ * The size of the tableau is the number of rows times the number of
+ * columns, so the engine is only used for small programs; past
+ * DENSE_MAX_ROWS rows, the model switches to the revised engine.
+ */
+
+#include "config.h"
+
+#include "emeus-lp-solver-private.h"
+
+#include <glib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define DENSE_HAVE_X86_KERNELS 1
+#include <immintrin.h>
+#endif
+
+/* The number of rows above which the revised engine is used instead */
+#define DENSE_MAX_ROWS          256
+
+/* The alignment of the rows, and the number of columns they are padded
+ * to; enough for the 256 bits registers of AVX
+ */
+#define DENSE_ALIGNMENT         32
+#define DENSE_PADDING           (DENSE_ALIGNMENT / sizeof (double))
+
+/* The smallest pivot accepted when building the tableau, or when taking
+ * a marker into the basis before removing its row
+ */
+#define PIVOT_TOLERANCE         1e-9
+
+/* The number of pivots after which the tableau is built again from the
+ * rows of the program, to drop the rounding errors accumulated by the
+ * updates
+ */
+#define REBUILD_INTERVAL        1024
+
+/* Kernels */
+
+typedef struct {
+  const char *name;
+
+  /* y := y + a·x, on @n doubles aligned on DENSE_ALIGNMENT bytes; @n is
+   * a multiple of DENSE_PADDING
+   */
+  void (* axpy) (double *y,
+                 const double *x,
+                 double a,
+                 guint n);
+
+  /* x := a·x, with the same requirements */
+  void (* scale) (double *x,
+                  double a,
+                  guint n);
+} DenseKernels;
+
+static void
+dense_axpy_scalar (double *restrict y,
+                   const double *restrict x,
+                   double a,
+                   guint n)
+{
+  for (guint i = 0; i < n; i++)
+    y[i] += a * x[i];
+}
+
+static void
+dense_scale_scalar (double *x,
+                    double a,
+                    guint n)
+{
+  for (guint i = 0; i < n; i++)
+    x[i] *= a;
+}
+
+static const DenseKernels dense_kernels_scalar = {
+  .name = "scalar",
+  .axpy = dense_axpy_scalar,
+  .scale = dense_scale_scalar,
+};
+
+#ifdef DENSE_HAVE_X86_KERNELS
+/* The kernels multiply and add separately, instead of using FMA, so that
+ * every implementation rounds in the same way, and the solution does not
+ * depend on the CPU
+ */
+__attribute__((target ("sse2")))
+static void
+dense_axpy_sse2 (double *restrict y,
+                 const double *restrict x,
+                 double a,
+                 guint n)
+{
+  __m128d va = _mm_set1_pd (a);
+
+  for (guint i = 0; i < n; i += 2)
+    {
+      __m128d vx = _mm_load_pd (x + i);
+      __m128d vy = _mm_load_pd (y + i);
+
+      _mm_store_pd (y + i, _mm_add_pd (vy, _mm_mul_pd (va, vx)));
+    }
+}
+
+__attribute__((target ("sse2")))
+static void
+dense_scale_sse2 (double *x,
+                  double a,
+                  guint n)
+{
+  __m128d va = _mm_set1_pd (a);
+
+  for (guint i = 0; i < n; i += 2)
+    _mm_store_pd (x + i, _mm_mul_pd (va, _mm_load_pd (x + i)));
+}
+
+static const DenseKernels dense_kernels_sse2 = {
+  .name = "sse2",
+  .axpy = dense_axpy_sse2,
+  .scale = dense_scale_sse2,
+};
+
+__attribute__((target ("avx2")))
+static void
+dense_axpy_avx2 (double *restrict y,
+                 const double *restrict x,
+                 double a,
+                 guint n)
+{
+  __m256d va = _mm256_set1_pd (a);
+
+  for (guint i = 0; i < n; i += 4)
+    {
+      __m256d vx = _mm256_load_pd (x + i);
+      __m256d vy = _mm256_load_pd (y + i);
+
+      _mm256_store_pd (y + i, _mm256_add_pd (vy, _mm256_mul_pd (va, vx)));
+    }
+}
+
+__attribute__((target ("avx2")))
+static void
+dense_scale_avx2 (double *x,
+                  double a,
+                  guint n)
+{
+  __m256d va = _mm256_set1_pd (a);
+
+  for (guint i = 0; i < n; i += 4)
+    _mm256_store_pd (x + i, _mm256_mul_pd (va, _mm256_load_pd (x + i)));
+}
+
+static const DenseKernels dense_kernels_avx2 = {
+  .name = "avx2",
+  .axpy = dense_axpy_avx2,
+  .scale = dense_scale_avx2,
+};
+#endif /* DENSE_HAVE_X86_KERNELS */
+
+/* Fills @candidates with the kernels supported by the CPU, the best
+ * first, and returns their number
+ */
+static guint
+dense_kernels_get_candidates (const DenseKernels *candidates[3])
+{
+  guint n_candidates = 0;
+
+#ifdef DENSE_HAVE_X86_KERNELS
+  __builtin_cpu_init ();
+
+  if (__builtin_cpu_supports ("avx2"))
+    candidates[n_candidates++] = &dense_kernels_avx2;
+
+  if (__builtin_cpu_supports ("sse2"))
+    candidates[n_candidates++] = &dense_kernels_sse2;
+#endif
+
+  candidates[n_candidates++] = &dense_kernels_scalar;
+
+  return n_candidates;
+}
+
+/* Picks the best kernels supported by the CPU; the EMEUS_DENSE_KERNELS
+ * environment variable can ask for a less capable set, to compare them
+ */
+static const DenseKernels *
+dense_kernels_select (void)
+{
+  const char *name = g_getenv ("EMEUS_DENSE_KERNELS");
+  const DenseKernels *candidates[3];
+  guint n_candidates = dense_kernels_get_candidates (candidates);
+
+  if (name == NULL || *name == '\0')
+    return candidates[0];
+
+  for (guint i = 0; i < n_candidates; i++)
+    {
+      if (g_strcmp0 (candidates[i]->name, name) == 0)
+        return candidates[i];
+    }
+
+  g_warning ("Kernels '%s' are not available; using '%s'", name, candidates[0]->name);
+
+  return candidates[0];
+}
+
+bool
+lp_dense_kernels_available (const char *name)
+{
+  const DenseKernels *candidates[3];
+  guint n_candidates = dense_kernels_get_candidates (candidates);
+
+  for (guint i = 0; i < n_candidates; i++)
+    {
+      if (g_strcmp0 (candidates[i]->name, name) == 0)
+        return true;
+    }
+
+  return false;
+}
+
+/* Tableau */
+
+typedef struct {
+  /* The block holding the rows, and its first aligned address */
+  gpointer data;
+  double *rows;
+
+  guint n_rows;
+  guint n_columns;
+
+  /* The number of doubles between the start of two rows */
+  guint stride;
+
+  /* The number of rows that fit in the block */
+  guint capacity;
+} DenseTableau;
+
+typedef struct {
+  LpModel *model;
+
+  const DenseKernels *kernels;
+
+  DenseTableau tableau;
+
+  /* Scratch row, of the same stride as the tableau */
+  gpointer scratch_data;
+  double *scratch;
+  guint scratch_stride;
+
+  /* The pivots since the tableau was last built */
+  guint n_pivots;
+
+  /* The tableau does not match the model, and must be built again */
+  bool needs_rebuild;
+} DenseEngine;
+
+typedef struct {
+  DenseTableau tableau;
+
+  guint n_pivots;
+  bool needs_rebuild;
+} DenseSnapshot;
+
+static double *
+dense_alloc_aligned (gsize n_doubles,
+                     gpointer *data_p)
+{
+  gpointer data = g_malloc0 (n_doubles * sizeof (double) + DENSE_ALIGNMENT);
+  uintptr_t address = ((uintptr_t) data + DENSE_ALIGNMENT - 1) & ~((uintptr_t) DENSE_ALIGNMENT - 1);
+
+  *data_p = data;
+
+  return (double *) address;
+}
+
+static guint
+dense_get_stride (guint n_columns)
+{
+  return MAX ((n_columns + DENSE_PADDING - 1) / DENSE_PADDING * DENSE_PADDING, DENSE_PADDING);
+}
+
+static inline double *
+dense_tableau_get_row (const DenseTableau *tableau,
+                       guint position)
+{
+  return tableau->rows + (gsize) position * tableau->stride;
+}
+
+static void
+dense_tableau_clear (DenseTableau *tableau)
+{
+  g_free (tableau->data);
+
+  tableau->data = NULL;
+  tableau->rows = NULL;
+  tableau->n_rows = 0;
+  tableau->n_columns = 0;
+  tableau->stride = 0;
+  tableau->capacity = 0;
+}
+
+/* Resizes the tableau, keeping the existing entries; the new entries
+ * are zero
+ */
+static void
+dense_tableau_resize (DenseTableau *tableau,
+                      guint n_rows,
+                      guint n_columns)
+{
+  guint stride = dense_get_stride (n_columns);
+
+  if (stride != tableau->stride || n_rows > tableau->capacity)
+    {
+      guint capacity = MAX (n_rows, tableau->capacity);
+      gpointer data;
+      double *rows;
+
+      if (n_rows > tableau->capacity)
+        capacity = MAX (capacity, tableau->capacity * 2);
+
+      rows = dense_alloc_aligned ((gsize) capacity * stride, &data);
+
+      for (guint i = 0; i < MIN (n_rows, tableau->n_rows); i++)
+        memcpy (rows + (gsize) i * stride,
+                dense_tableau_get_row (tableau, i),
+                sizeof (double) * MIN (tableau->n_columns, n_columns));
+
+      g_free (tableau->data);
+
+      tableau->data = data;
+      tableau->rows = rows;
+      tableau->stride = stride;
+      tableau->capacity = capacity;
+    }
+  else
+    {
+      /* Shrinking the columns must leave the padding zero, and growing
+       * the rows must not reuse the entries of the removed ones
+       */
+      for (guint i = 0; i < MIN (n_rows, tableau->n_rows) && n_columns < tableau->n_columns; i++)
+        memset (dense_tableau_get_row (tableau, i) + n_columns, 0,
+                sizeof (double) * (tableau->n_columns - n_columns));
+
+      for (guint i = tableau->n_rows; i < n_rows; i++)
+        memset (dense_tableau_get_row (tableau, i), 0, sizeof (double) * stride);
+    }
+
+  tableau->n_rows = n_rows;
+  tableau->n_columns = n_columns;
+}
+
+static void
+dense_tableau_copy (DenseTableau *dest,
+                    const DenseTableau *src)
+{
+  dense_tableau_clear (dest);
+
+  dest->rows = dense_alloc_aligned ((gsize) src->n_rows * src->stride, &dest->data);
+
+  if (src->n_rows > 0)
+    memcpy (dest->rows, src->rows, sizeof (double) * src->n_rows * src->stride);
+
+  dest->n_rows = src->n_rows;
+  dest->n_columns = src->n_columns;
+  dest->stride = src->stride;
+  dest->capacity = src->n_rows;
+}
+
+/* Engine */
+
+static void
+dense_engine_ensure_scratch (DenseEngine *self)
+{
+  if (self->scratch_stride == self->tableau.stride)
+    return;
+
+  g_free (self->scratch_data);
+
+  self->scratch = dense_alloc_aligned (MAX (self->tableau.stride, DENSE_PADDING), &self->scratch_data);
+  self->scratch_stride = self->tableau.stride;
+}
+
+/* Brings the number of columns of the tableau up to date with the model;
+ * the new columns are zero
+ */
+static void
+dense_engine_ensure_columns (DenseEngine *self)
+{
+  guint n_columns = lp_model_get_n_columns (self->model);
+
+  if (n_columns != self->tableau.n_columns)
+    dense_tableau_resize (&self->tableau, self->tableau.n_rows, n_columns);
+
+  dense_engine_ensure_scratch (self);
+}
+
+static void
+dense_engine_clear_column (DenseEngine *self,
+                           guint column)
+{
+  for (guint p = 0; p < self->tableau.n_rows; p++)
+    dense_tableau_get_row (&self->tableau, p)[column] = 0.0;
+}
+
+/* Pivots the tableau on the entry of @column at @position, where @alpha
+ * is the column before the pivot
+ */
+static void
+dense_engine_pivot_tableau (DenseEngine *self,
+                            guint position,
+                            guint column,
+                            const double *alpha)
+{
+  DenseTableau *tableau = &self->tableau;
+  double *pivot_row = dense_tableau_get_row (tableau, position);
+
+  self->kernels->scale (pivot_row, 1.0 / alpha[position], tableau->stride);
+  pivot_row[column] = 1.0;
+
+  for (guint p = 0; p < tableau->n_rows; p++)
+    {
+      double *row;
+
+      if (p == position || alpha[p] == 0.0)
+        continue;
+
+      row = dense_tableau_get_row (tableau, p);
+      self->kernels->axpy (row, pivot_row, -alpha[p], tableau->stride);
+      row[column] = 0.0;
+    }
+
+  self->n_pivots += 1;
+}
+
+static void
+dense_engine_get_column (DenseEngine *self,
+                         guint column,
+                         double *alpha)
+{
+  for (guint p = 0; p < self->tableau.n_rows; p++)
+    alpha[p] = dense_tableau_get_row (&self->tableau, p)[column];
+}
+
+/* Writes the row of the program, divided by the coefficient of its
+ * marker, in @dest
+ */
+static void
+dense_engine_load_row (DenseEngine *self,
+                       const LpRow *row,
+                       double *dest)
+{
+  LpModel *model = self->model;
+  double scale = 1.0 / lp_model_get_column (model, row->marker)->coefficient;
+
+  memset (dest, 0, sizeof (double) * self->tableau.stride);
+
+  for (guint k = 0; k < row->n_terms; k++)
+    dest[row->columns[k]] = row->coefficients[k] * scale;
+
+  dest[row->marker] = 1.0;
+
+  if (row->extra != G_MAXUINT)
+    dest[row->extra] = lp_model_get_column (model, row->extra)->coefficient * scale;
+}
+
+/* Builds the tableau from the rows of the program, for the basis of the
+ * model; the basis starts with the marker of each row, and each other
+ * basic column replaces one of the markers that are not basic. Columns
+ * that became dependent are dropped, and their rows keep their marker,
+ * so the basis of the model may change; the positions follow the rows.
+ */
+static void
+dense_engine_rebuild (DenseEngine *self)
+{
+  LpModel *model = self->model;
+  DenseTableau *tableau = &self->tableau;
+  guint n_rows = lp_model_get_n_rows (model);
+  guint n_candidates = model->basis->len;
+  guint *candidates, *columns;
+  bool *is_placed;
+  double *alpha;
+
+  tableau->n_rows = 0;
+  dense_tableau_resize (tableau, n_rows, lp_model_get_n_columns (model));
+  dense_engine_ensure_scratch (self);
+
+  candidates = g_new (guint, MAX (n_candidates, 1));
+  columns = g_new (guint, MAX (n_rows, 1));
+  is_placed = g_new0 (bool, MAX (n_rows, 1));
+  alpha = g_new (double, MAX (n_rows, 1));
+
+  memcpy (candidates, model->basis->data, sizeof (guint) * n_candidates);
+
+  for (guint i = 0; i < n_rows; i++)
+    {
+      LpRow *row = lp_model_get_row (model, i);
+
+      dense_engine_load_row (self, row, dense_tableau_get_row (tableau, i));
+      columns[i] = row->marker;
+    }
+
+  /* The basic markers keep their row */
+  for (guint c = 0; c < n_candidates; c++)
+    {
+      LpColumn *column = lp_model_get_column (model, candidates[c]);
+
+      if (column->row != NULL && column->row->marker == candidates[c])
+        is_placed[column->row->index] = true;
+    }
+
+  for (guint c = 0; c < n_candidates; c++)
+    {
+      LpColumn *column = lp_model_get_column (model, candidates[c]);
+      double best = PIVOT_TOLERANCE;
+      int position = -1;
+
+      if (column->row != NULL && column->row->marker == candidates[c])
+        continue;
+
+      dense_engine_get_column (self, candidates[c], alpha);
+
+      for (guint p = 0; p < n_rows; p++)
+        {
+          if (!is_placed[p] && fabs (alpha[p]) > best)
+            {
+              best = fabs (alpha[p]);
+              position = p;
+            }
+        }
+
+      if (position < 0)
+        continue;
+
+      dense_engine_pivot_tableau (self, position, candidates[c], alpha);
+      columns[position] = candidates[c];
+      is_placed[position] = true;
+    }
+
+  lp_model_set_basis (model, columns, n_rows);
+
+  g_free (candidates);
+  g_free (columns);
+  g_free (is_placed);
+  g_free (alpha);
+
+  self->n_pivots = 0;
+  self->needs_rebuild = false;
+}
+
+static gpointer
+dense_engine_create (LpModel *model)
+{
+  DenseEngine *self = g_slice_new0 (DenseEngine);
+
+  self->model = model;
+  self->kernels = dense_kernels_select ();
+
+  /* The model may already have rows, if it is switching engine */
+  self->needs_rebuild = lp_model_get_n_rows (model) > 0;
+
+  dense_engine_ensure_columns (self);
+
+  return self;
+}
+
+static void
+dense_engine_free (gpointer engine)
+{
+  DenseEngine *self = engine;
+
+  dense_tableau_clear (&self->tableau);
+  g_free (self->scratch_data);
+
+  g_slice_free (DenseEngine, self);
+}
+
+/* The new row is expressed in terms of the nonbasic columns, by
+ * substituting out each of its basic columns with its row of the
+ * tableau; the columns of the new row are zero in the other rows.
+ */
+static void
+dense_engine_row_added (gpointer engine,
+                        LpRow *row)
+{
+  DenseEngine *self = engine;
+  LpModel *model = self->model;
+  DenseTableau *tableau = &self->tableau;
+  guint position = tableau->n_rows;
+  double scale, *new_row;
+
+  if (self->needs_rebuild)
+    return;
+
+  /* The model appends the marker to the basis before adding the row */
+  if (model->basis->len != position + 1)
+    {
+      self->needs_rebuild = true;
+      return;
+    }
+
+  dense_engine_ensure_columns (self);
+
+  dense_engine_clear_column (self, row->marker);
+  if (row->extra != G_MAXUINT)
+    dense_engine_clear_column (self, row->extra);
+
+  for (guint k = 0; k < row->n_terms; k++)
+    {
+      if (lp_model_get_column (model, row->columns[k])->n_rows == 1)
+        dense_engine_clear_column (self, row->columns[k]);
+    }
+
+  dense_tableau_resize (tableau, position + 1, tableau->n_columns);
+  new_row = dense_tableau_get_row (tableau, position);
+
+  dense_engine_load_row (self, row, new_row);
+
+  scale = 1.0 / lp_model_get_column (model, row->marker)->coefficient;
+
+  for (guint k = 0; k < row->n_terms; k++)
+    {
+      int p = lp_model_get_position (model, row->columns[k]);
+
+      if (p < 0 || (guint) p == position)
+        continue;
+
+      self->kernels->axpy (new_row, dense_tableau_get_row (tableau, p),
+                           -row->coefficients[k] * scale,
+                           tableau->stride);
+      new_row[row->columns[k]] = 0.0;
+    }
+
+  new_row[row->marker] = 1.0;
+}
+
+/* Taking the marker of the row into the basis makes the rest of the
+ * basis a basis of the other rows, whose tableau is the current one
+ * without the row of the marker; the row is then removed like the
+ * model removes the position of the marker, by moving the last row in
+ * its place.
+ */
+static void
+dense_engine_row_removed (gpointer engine,
+                          LpRow *row)
+{
+  DenseEngine *self = engine;
+  LpModel *model = self->model;
+  DenseTableau *tableau = &self->tableau;
+  int position = lp_model_get_position (model, row->marker);
+  guint last;
+
+  if (self->needs_rebuild)
+    return;
+
+  if (position < 0)
+    {
+      double *alpha = g_new (double, MAX (tableau->n_rows, 1));
+      double best = PIVOT_TOLERANCE;
+
+      dense_engine_get_column (self, row->marker, alpha);
+
+      for (guint p = 0; p < tableau->n_rows; p++)
+        {
+          if (fabs (alpha[p]) > best)
+            {
+              best = fabs (alpha[p]);
+              position = p;
+            }
+        }
+
+      if (position >= 0)
+        {
+          dense_engine_pivot_tableau (self, position, row->marker, alpha);
+          lp_model_set_basic_column (model, position, row->marker);
+        }
+
+      g_free (alpha);
+    }
+
+  /* The tableau lost too much precision; start again from the rows */
+  if (position < 0)
+    {
+      self->needs_rebuild = true;
+      return;
+    }
+
+  last = tableau->n_rows - 1;
+  if ((guint) position != last)
+    memcpy (dense_tableau_get_row (tableau, position),
+            dense_tableau_get_row (tableau, last),
+            sizeof (double) * tableau->stride);
+
+  dense_tableau_resize (tableau, last, tableau->n_columns);
+
+  /* The columns that go away with the row are zero in the other rows */
+  dense_engine_clear_column (self, row->marker);
+  if (row->extra != G_MAXUINT)
+    dense_engine_clear_column (self, row->extra);
+
+  for (guint k = 0; k < row->n_terms; k++)
+    {
+      if (lp_model_get_column (model, row->columns[k])->n_rows == 1)
+        dense_engine_clear_column (self, row->columns[k]);
+    }
+}
+
+static void
+dense_engine_refresh (gpointer engine)
+{
+  DenseEngine *self = engine;
+  LpModel *model = self->model;
+  guint n_rows = lp_model_get_n_rows (model);
+
+  /* Removing a row may take more than its marker out of the basis, if
+   * the tableau lost precision
+   */
+  if (self->tableau.n_rows != n_rows || model->basis->len != n_rows)
+    self->needs_rebuild = true;
+
+  if (self->needs_rebuild || self->n_pivots >= REBUILD_INTERVAL)
+    dense_engine_rebuild (self);
+  else
+    dense_engine_ensure_columns (self);
+}
+
+/* B⁻¹ is in the columns of the markers, divided by their coefficient */
+static void
+dense_engine_compute_values (gpointer engine,
+                             const double *rhs,
+                             double *values)
+{
+  DenseEngine *self = engine;
+  LpModel *model = self->model;
+  guint n_rows = lp_model_get_n_rows (model);
+
+  for (guint p = 0; p < self->tableau.n_rows; p++)
+    {
+      const double *row = dense_tableau_get_row (&self->tableau, p);
+      double value = 0.0;
+
+      for (guint i = 0; i < n_rows; i++)
+        {
+          const LpRow *model_row = lp_model_get_row (model, i);
+
+          if (rhs[i] != 0.0)
+            value += row[model_row->marker] * rhs[i] / lp_model_get_column (model, model_row->marker)->coefficient;
+        }
+
+      values[p] = value;
+    }
+}
+
+static void
+dense_engine_compute_column (gpointer engine,
+                             guint column,
+                             double *alpha)
+{
+  dense_engine_get_column (engine, column, alpha);
+}
+
+static void
+dense_engine_compute_row (gpointer engine,
+                          guint position,
+                          double *row)
+{
+  DenseEngine *self = engine;
+
+  memcpy (row, dense_tableau_get_row (&self->tableau, position),
+          sizeof (double) * self->tableau.n_columns);
+}
+
+static void
+dense_engine_compute_reduced_costs (gpointer engine,
+                                    const double *costs,
+                                    double *reduced_costs)
+{
+  DenseEngine *self = engine;
+  LpModel *model = self->model;
+  DenseTableau *tableau = &self->tableau;
+  double *d = self->scratch;
+
+  memset (d, 0, sizeof (double) * tableau->stride);
+  memcpy (d, costs, sizeof (double) * tableau->n_columns);
+
+  for (guint p = 0; p < tableau->n_rows; p++)
+    {
+      double cost = costs[lp_model_get_basic_column (model, p)];
+
+      if (cost != 0.0)
+        self->kernels->axpy (d, dense_tableau_get_row (tableau, p), -cost, tableau->stride);
+    }
+
+  for (guint p = 0; p < tableau->n_rows; p++)
+    d[lp_model_get_basic_column (model, p)] = 0.0;
+
+  memcpy (reduced_costs, d, sizeof (double) * tableau->n_columns);
+}
+
+static void
+dense_engine_pivot (gpointer engine,
+                    guint position,
+                    guint column,
+                    const double *alpha)
+{
+  dense_engine_pivot_tableau (engine, position, column, alpha);
+}
+
+static gpointer
+dense_engine_save (gpointer engine)
+{
+  DenseEngine *self = engine;
+  DenseSnapshot *snapshot = g_slice_new0 (DenseSnapshot);
+
+  dense_tableau_copy (&snapshot->tableau, &self->tableau);
+  snapshot->n_pivots = self->n_pivots;
+  snapshot->needs_rebuild = self->needs_rebuild;
+
+  return snapshot;
+}
+
+static void
+dense_engine_restore (gpointer engine,
+                      gpointer snapshot_p)
+{
+  DenseEngine *self = engine;
+  DenseSnapshot *snapshot = snapshot_p;
+
+  dense_tableau_copy (&self->tableau, &snapshot->tableau);
+  self->n_pivots = snapshot->n_pivots;
+  self->needs_rebuild = snapshot->needs_rebuild;
+
+  dense_engine_ensure_scratch (self);
+}
+
+static void
+dense_engine_free_snapshot (gpointer snapshot_p)
+{
+  DenseSnapshot *snapshot = snapshot_p;
+
+  dense_tableau_clear (&snapshot->tableau);
+
+  g_slice_free (DenseSnapshot, snapshot);
+}
+
+const char *
+lp_dense_engine_get_kernels (gpointer engine)
+{
+  DenseEngine *self = engine;
+
+  return self->kernels->name;
+}
+
+const LpEngineClass lp_dense_engine = {
+  .name = "dense",
+  .max_rows = DENSE_MAX_ROWS,
+
+  .create = dense_engine_create,
+  .free = dense_engine_free,
+
+  .row_added = dense_engine_row_added,
+  .row_removed = dense_engine_row_removed,
+  .refresh = dense_engine_refresh,
+
+  .compute_values = dense_engine_compute_values,
+  .compute_column = dense_engine_compute_column,
+  .compute_row = dense_engine_compute_row,
+  .compute_reduced_costs = dense_engine_compute_reduced_costs,
+
+  .pivot = dense_engine_pivot,
+
+  .save = dense_engine_save,
+  .restore = dense_engine_restore,
+  .free_snapshot = dense_engine_free_snapshot,
+};
@@ -0,0 +1,1013 @@
+/* emeus-lp-revised.c: Revised simplex engine
+ *
+ * Copyright 2016  Endless
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* The revised simplex method keeps the rows of the program in their
+ * original, sparse form, and a factorization of the basis:
+ *
+ *   B = L·U
+ *
+ * computed with the left-looking algorithm of Gilbert and Peierls, which
+ * only touches the nonzero entries of each column. Each pivot appends an
+ * eta column to the factorization, in product form; after a number of
+ * pivots the basis is factorized again, to bound the cost of the solves
+ * and the growth of the rounding errors.
+ *
+ * The memory used by the engine is proportional to the number of nonzero
+ * entries of the rows and of the factors, instead of the square of the
+ * number of rows.
+ *
+ * Adding or removing a row changes the shape of the basis, so it is
+ * factorized again before the next solve; the factorization also repairs
+ * the basis, replacing the columns that became dependent with the marker
+ * of the rows they left uncovered.
+ */
+
+#include "config.h"
+
+#include "emeus-lp-solver-private.h"
+
+#include <glib.h>
+#include <string.h>
+#include <math.h>
+
+/* The number of eta columns after which the basis is factorized again */
+#define REFACTOR_INTERVAL       64
+
+/* The smallest pivot accepted by the factorization */
+#define PIVOT_TOLERANCE         1e-9
+
+/* The pivot of each step is the sparsest row whose entry is within this
+ * ratio of the largest one
+ */
+#define PIVOT_THRESHOLD         0.1
+
+/* Entries below this magnitude are dropped from the factors */
+#define DROP_TOLERANCE          1e-14
+
+typedef struct {
+  guint index;
+  double value;
+} LpEntry;
+
+typedef struct {
+  guint n_steps;
+
+  /* The pivot row of each step, and the step of each row, or -1 */
+  guint *pivot_rows;
+  int *row_steps;
+
+  double *diagonal;
+
+  /* The columns of L, by step, indexed by row; and the columns of U,
+   * by step, indexed by the earlier steps
+   */
+  GArray *l_start;
+  GArray *l_entries;
+  GArray *u_start;
+  GArray *u_entries;
+} RevisedFactor;
+
+typedef struct {
+  LpModel *model;
+
+  /* The structural columns of the program, in compressed sparse column
+   * form, indexed by row
+   */
+  GArray *matrix_start;
+  GArray *matrix_entries;
+  bool matrix_dirty;
+
+  RevisedFactor *factor;
+  bool factor_dirty;
+
+  /* The eta columns appended by each pivot since the factorization,
+   * indexed by basis position; each column stores the reciprocal of its
+   * pivot separately
+   */
+  GArray *eta_start;
+  GArray *eta_positions;
+  GArray *eta_pivots;
+  GArray *eta_entries;
+
+  /* Scratch space, sized for the number of rows */
+  guint capacity;
+  double *work;
+  double *work_positions;
+  guint *pattern;
+  bool *in_pattern;
+  guint *visited;
+  guint *stack;
+  guint *stack_entry;
+  guint *reach;
+  guint stamp;
+} RevisedEngine;
+
+static RevisedFactor *
+revised_factor_new (guint n_rows)
+{
+  RevisedFactor *res = g_slice_new0 (RevisedFactor);
+  guint start = 0;
+
+  res->pivot_rows = g_new (guint, MAX (n_rows, 1));
+  res->row_steps = g_new (int, MAX (n_rows, 1));
+  res->diagonal = g_new (double, MAX (n_rows, 1));
+
+  for (guint i = 0; i < n_rows; i++)
+    res->row_steps[i] = -1;
+
+  res->l_start = g_array_new (FALSE, FALSE, sizeof (guint));
+  res->l_entries = g_array_new (FALSE, FALSE, sizeof (LpEntry));
+  res->u_start = g_array_new (FALSE, FALSE, sizeof (guint));
+  res->u_entries = g_array_new (FALSE, FALSE, sizeof (LpEntry));
+
+  g_array_append_val (res->l_start, start);
+  g_array_append_val (res->u_start, start);
+
+  return res;
+}
+
+static void
+revised_factor_free (RevisedFactor *factor)
+{
+  if (factor == NULL)
+    return;
+
+  g_free (factor->pivot_rows);
+  g_free (factor->row_steps);
+  g_free (factor->diagonal);
+
+  g_array_unref (factor->l_start);
+  g_array_unref (factor->l_entries);
+  g_array_unref (factor->u_start);
+  g_array_unref (factor->u_entries);
+
+  g_slice_free (RevisedFactor, factor);
+}
+
+static inline const LpEntry *
+factor_get_l (RevisedFactor *factor,
+              guint step,
+              guint *n_entries)
+{
+  guint start = g_array_index (factor->l_start, guint, step);
+
+  *n_entries = g_array_index (factor->l_start, guint, step + 1) - start;
+
+  return &g_array_index (factor->l_entries, LpEntry, start);
+}
+
+static inline const LpEntry *
+factor_get_u (RevisedFactor *factor,
+              guint step,
+              guint *n_entries)
+{
+  guint start = g_array_index (factor->u_start, guint, step);
+
+  *n_entries = g_array_index (factor->u_start, guint, step + 1) - start;
+
+  return &g_array_index (factor->u_entries, LpEntry, start);
+}
+
+static void
+revised_engine_ensure_capacity (RevisedEngine *self,
+                                guint n_rows)
+{
+  if (n_rows <= self->capacity && self->work != NULL)
+    return;
+
+  self->capacity = MAX (n_rows, 16);
+
+  g_free (self->work);
+  g_free (self->work_positions);
+  g_free (self->pattern);
+  g_free (self->in_pattern);
+  g_free (self->visited);
+  g_free (self->stack);
+  g_free (self->stack_entry);
+  g_free (self->reach);
+
+  self->work = g_new0 (double, self->capacity);
+  self->work_positions = g_new0 (double, self->capacity);
+  self->pattern = g_new (guint, self->capacity);
+  self->in_pattern = g_new0 (bool, self->capacity);
+  self->visited = g_new0 (guint, self->capacity);
+  self->stack = g_new (guint, self->capacity);
+  self->stack_entry = g_new (guint, self->capacity);
+  self->reach = g_new (guint, self->capacity);
+  self->stamp = 0;
+}
+
+static void
+revised_engine_build_matrix (RevisedEngine *self)
+{
+  LpModel *model = self->model;
+  guint n_columns = lp_model_get_n_columns (model);
+  guint *start;
+  guint total = 0;
+
+  g_array_set_size (self->matrix_start, n_columns + 1);
+  start = (guint *) (void *) self->matrix_start->data;
+  memset (start, 0, sizeof (guint) * (n_columns + 1));
+
+  for (guint i = 0; i < lp_model_get_n_rows (model); i++)
+    {
+      LpRow *row = lp_model_get_row (model, i);
+
+      for (guint t = 0; t < row->n_terms; t++)
+        start[row->columns[t] + 1] += 1;
+    }
+
+  for (guint j = 0; j < n_columns; j++)
+    {
+      total += start[j + 1];
+      start[j + 1] = total;
+    }
+
+  g_array_set_size (self->matrix_entries, total);
+
+  /* Fill the columns using the start of the next column as a cursor,
+   * then shift the starts back
+   */
+  for (guint i = 0; i < lp_model_get_n_rows (model); i++)
+    {
+      LpRow *row = lp_model_get_row (model, i);
+
+      for (guint t = 0; t < row->n_terms; t++)
+        {
+          guint j = row->columns[t];
+          LpEntry *entry = &g_array_index (self->matrix_entries, LpEntry, start[j]);
+
+          entry->index = row->index;
+          entry->value = row->coefficients[t];
+          start[j] += 1;
+        }
+    }
+
+  for (guint j = n_columns; j > 0; j--)
+    start[j] = start[j - 1];
+  start[0] = 0;
+
+  self->matrix_dirty = false;
+}
+
+static inline const LpEntry *
+matrix_get_column (RevisedEngine *self,
+                   guint column,
+                   guint *n_entries)
+{
+  guint start = g_array_index (self->matrix_start, guint, column);
+
+  *n_entries = g_array_index (self->matrix_start, guint, column + 1) - start;
+
+  return &g_array_index (self->matrix_entries, LpEntry, start);
+}
+
+/* Computes the product of @column with the row vector @y */
+static inline double
+revised_engine_dot_column (RevisedEngine *self,
+                           guint column,
+                           const double *y)
+{
+  LpColumn *c = lp_model_get_column (self->model, column);
+  const LpEntry *entries;
+  guint n_entries;
+  double res = 0.0;
+
+  if (c->row != NULL)
+    return c->coefficient * y[c->row->index];
+
+  if (c->variable == NULL)
+    return 0.0;
+
+  entries = matrix_get_column (self, column, &n_entries);
+  for (guint i = 0; i < n_entries; i++)
+    res += entries[i].value * y[entries[i].index];
+
+  return res;
+}
+
+/* Scatters @column into the work vector, and records its pattern */
+static guint
+revised_engine_load_column (RevisedEngine *self,
+                            guint column)
+{
+  LpColumn *c = lp_model_get_column (self->model, column);
+  guint n_pattern = 0;
+
+  if (c->row != NULL)
+    {
+      guint i = c->row->index;
+
+      self->work[i] = c->coefficient;
+      self->in_pattern[i] = true;
+      self->pattern[n_pattern++] = i;
+    }
+  else if (c->variable != NULL)
+    {
+      const LpEntry *entries;
+      guint n_entries;
+
+      entries = matrix_get_column (self, column, &n_entries);
+      for (guint e = 0; e < n_entries; e++)
+        {
+          guint i = entries[e].index;
+
+          self->work[i] = entries[e].value;
+          self->in_pattern[i] = true;
+          self->pattern[n_pattern++] = i;
+        }
+    }
+
+  return n_pattern;
+}
+
+/* Finds the steps of @factor that change the work vector, in
+ * topological order, with a depth-first search from the rows of its
+ * pattern; returns the number of steps, stored at the end of the
+ * reach array, in reverse
+ */
+static guint
+revised_engine_reach (RevisedEngine *self,
+                      RevisedFactor *factor,
+                      guint n_pattern)
+{
+  guint n_reach = 0;
+
+  self->stamp += 1;
+
+  for (guint p = 0; p < n_pattern; p++)
+    {
+      int root = factor->row_steps[self->pattern[p]];
+      int top = 0;
+
+      if (root < 0 || self->visited[root] == self->stamp)
+        continue;
+
+      self->visited[root] = self->stamp;
+      self->stack[0] = root;
+      self->stack_entry[0] = g_array_index (factor->l_start, guint, root);
+
+      while (top >= 0)
+        {
+          guint step = self->stack[top];
+          guint end = g_array_index (factor->l_start, guint, step + 1);
+
+          if (self->stack_entry[top] < end)
+            {
+              const LpEntry *entry;
+              int next;
+
+              entry = &g_array_index (factor->l_entries, LpEntry, self->stack_entry[top]);
+              self->stack_entry[top] += 1;
+
+              next = factor->row_steps[entry->index];
+              if (next >= 0 && self->visited[next] != self->stamp)
+                {
+                  self->visited[next] = self->stamp;
+                  top += 1;
+                  self->stack[top] = next;
+                  self->stack_entry[top] = g_array_index (factor->l_start, guint, next);
+                }
+            }
+          else
+            {
+              self->reach[n_reach++] = step;
+              top -= 1;
+            }
+        }
+    }
+
+  return n_reach;
+}
+
+static inline guint
+revised_engine_get_row_size (RevisedEngine *self,
+                             guint row)
+{
+  return lp_model_get_row (self->model, row)->n_terms;
+}
+
+/* Adds @column as the next step of @factor; returns false if the column
+ * depends on the ones already in the factorization
+ */
+static bool
+revised_engine_add_step (RevisedEngine *self,
+                         RevisedFactor *factor,
+                         guint column)
+{
+  guint n_pattern, n_reach;
+  guint step = factor->n_steps;
+  double max_value = 0.0, pivot_value = 0.0;
+  guint pivot_size = 0;
+  int pivot_row = -1;
+  guint n_entries;
+
+  n_pattern = revised_engine_load_column (self, column);
+  n_reach = revised_engine_reach (self, factor, n_pattern);
+
+  /* Solve L·x = a, in topological order */
+  for (guint r = n_reach; r > 0; r--)
+    {
+      guint s = self->reach[r - 1];
+      double v = self->work[factor->pivot_rows[s]];
+      const LpEntry *entries;
+
+      if (v == 0.0)
+        continue;
+
+      entries = factor_get_l (factor, s, &n_entries);
+      for (guint e = 0; e < n_entries; e++)
+        {
+          guint i = entries[e].index;
+
+          if (!self->in_pattern[i])
+            {
+              self->in_pattern[i] = true;
+              self->work[i] = 0.0;
+              self->pattern[n_pattern++] = i;
+            }
+
+          self->work[i] -= entries[e].value * v;
+        }
+    }
+
+  for (guint p = 0; p < n_pattern; p++)
+    {
+      guint i = self->pattern[p];
+
+      if (factor->row_steps[i] < 0)
+        max_value = MAX (max_value, fabs (self->work[i]));
+    }
+
+  if (max_value > PIVOT_TOLERANCE)
+    {
+      /* Threshold pivoting: any entry close enough to the largest one is
+       * stable, so we pick the one in the sparsest row, to limit fill-in
+       */
+      for (guint p = 0; p < n_pattern; p++)
+        {
+          guint i = self->pattern[p];
+          double v = fabs (self->work[i]);
+          guint size;
+
+          if (factor->row_steps[i] >= 0 || v < PIVOT_THRESHOLD * max_value)
+            continue;
+
+          size = revised_engine_get_row_size (self, i);
+          if (pivot_row < 0 || size < pivot_size || (size == pivot_size && v > fabs (pivot_value)))
+            {
+              pivot_row = i;
+              pivot_size = size;
+              pivot_value = self->work[i];
+            }
+        }
+    }
+
+  if (pivot_row >= 0)
+    {
+      guint end;
+
+      for (guint r = 0; r < n_reach; r++)
+        {
+          guint s = self->reach[r];
+          LpEntry entry = { s, self->work[factor->pivot_rows[s]] };
+
+          if (fabs (entry.value) > DROP_TOLERANCE)
+            g_array_append_val (factor->u_entries, entry);
+        }
+
+      for (guint p = 0; p < n_pattern; p++)
+        {
+          guint i = self->pattern[p];
+          LpEntry entry = { i, self->work[i] / pivot_value };
+
+          if (factor->row_steps[i] >= 0 || i == (guint) pivot_row)
+            continue;
+
+          if (fabs (entry.value) > DROP_TOLERANCE)
+            g_array_append_val (factor->l_entries, entry);
+        }
+
+      factor->pivot_rows[step] = pivot_row;
+      factor->row_steps[pivot_row] = step;
+      factor->diagonal[step] = pivot_value;
+      factor->n_steps += 1;
+
+      end = factor->l_entries->len;
+      g_array_append_val (factor->l_start, end);
+      end = factor->u_entries->len;
+      g_array_append_val (factor->u_start, end);
+    }
+
+  for (guint p = 0; p < n_pattern; p++)
+    {
+      self->work[self->pattern[p]] = 0.0;
+      self->in_pattern[self->pattern[p]] = false;
+    }
+
+  return pivot_row >= 0;
+}
+
+static int
+compare_candidates (gconstpointer a,
+                    gconstpointer b,
+                    gpointer data)
+{
+  RevisedEngine *self = data;
+  guint column_a = *(const guint *) a;
+  guint column_b = *(const guint *) b;
+  LpColumn *ca = lp_model_get_column (self->model, column_a);
+  LpColumn *cb = lp_model_get_column (self->model, column_b);
+  guint size_a, size_b;
+
+  /* The structural columns go first, as they are the ones we want to
+   * keep in the basis, and the sparsest first among them
+   */
+  if ((ca->variable != NULL) != (cb->variable != NULL))
+    return ca->variable != NULL ? -1 : 1;
+
+  size_a = ca->variable != NULL ? ca->n_rows : 1;
+  size_b = cb->variable != NULL ? cb->n_rows : 1;
+  if (size_a != size_b)
+    return size_a < size_b ? -1 : 1;
+
+  return column_a < column_b ? -1 : (column_a > column_b ? 1 : 0);
+}
+
+static void
+revised_engine_clear_etas (RevisedEngine *self)
+{
+  guint start = 0;
+
+  g_array_set_size (self->eta_start, 0);
+  g_array_append_val (self->eta_start, start);
+  g_array_set_size (self->eta_positions, 0);
+  g_array_set_size (self->eta_pivots, 0);
+  g_array_set_size (self->eta_entries, 0);
+}
+
+/* Factorizes the basis of the model. When repairing, the basis may have
+ * more or fewer columns than rows: the dependent columns are dropped, the
+ * rows left uncovered get their marker, and the positions of the basis
+ * follow the steps of the factorization. Otherwise, the basis must not be
+ * singular, and its positions do not change.
+ */
+static bool
+revised_engine_factorize (RevisedEngine *self,
+                          bool repair)
+{
+  LpModel *model = self->model;
+  guint n_rows = lp_model_get_n_rows (model);
+  guint n_candidates = model->basis->len;
+  RevisedFactor *factor;
+  guint *candidates, *columns;
+  bool res = false;
+
+  revised_engine_ensure_capacity (self, n_rows);
+
+  factor = revised_factor_new (n_rows);
+  candidates = g_new (guint, MAX (n_candidates, 1));
+  columns = g_new (guint, MAX (n_rows, 1));
+
+  memcpy (candidates, model->basis->data, sizeof (guint) * n_candidates);
+
+  if (repair)
+    g_qsort_with_data (candidates, n_candidates, sizeof (guint), compare_candidates, self);
+
+  for (guint c = 0; c < n_candidates; c++)
+    {
+      if (factor->n_steps == n_rows ||
+          !revised_engine_add_step (self, factor, candidates[c]))
+        {
+          if (repair)
+            continue;
+
+          goto out;
+        }
+
+      columns[factor->n_steps - 1] = candidates[c];
+    }
+
+  if (repair)
+    {
+      for (guint i = 0; i < n_rows; i++)
+        {
+          LpRow *row = lp_model_get_row (model, i);
+
+          if (factor->row_steps[i] >= 0)
+            continue;
+
+          /* The marker is zero outside of its row, so it always pivots
+           * on the row itself
+           */
+          if (revised_engine_add_step (self, factor, row->marker))
+            columns[factor->n_steps - 1] = row->marker;
+        }
+
+      lp_model_set_basis (model, columns, factor->n_steps);
+    }
+
+  if (factor->n_steps == n_rows)
+    {
+      revised_factor_free (self->factor);
+      self->factor = factor;
+      factor = NULL;
+
+      revised_engine_clear_etas (self);
+      self->factor_dirty = false;
+      res = true;
+    }
+
+out:
+  revised_factor_free (factor);
+  g_free (candidates);
+  g_free (columns);
+
+  return res;
+}
+
+/* Solves B·x = a, where @work holds a, indexed by row, and is cleared;
+ * @x is indexed by basis position
+ */
+static void
+revised_engine_ftran (RevisedEngine *self,
+                      double *work,
+                      double *x)
+{
+  RevisedFactor *factor = self->factor;
+  guint n_entries;
+
+  for (guint k = 0; k < factor->n_steps; k++)
+    {
+      double v = work[factor->pivot_rows[k]];
+      const LpEntry *entries;
+
+      if (v == 0.0)
+        continue;
+
+      entries = factor_get_l (factor, k, &n_entries);
+      for (guint e = 0; e < n_entries; e++)
+        work[entries[e].index] -= entries[e].value * v;
+    }
+
+  for (guint k = factor->n_steps; k > 0; k--)
+    {
+      guint step = k - 1;
+      double z = work[factor->pivot_rows[step]] / factor->diagonal[step];
+      const LpEntry *entries;
+
+      work[factor->pivot_rows[step]] = 0.0;
+      x[step] = z;
+
+      if (z == 0.0)
+        continue;
+
+      entries = factor_get_u (factor, step, &n_entries);
+      for (guint e = 0; e < n_entries; e++)
+        work[factor->pivot_rows[entries[e].index]] -= entries[e].value * z;
+    }
+
+  for (guint eta = 0; eta + 1 < self->eta_start->len; eta++)
+    {
+      guint position = g_array_index (self->eta_positions, guint, eta);
+      guint start = g_array_index (self->eta_start, guint, eta);
+      guint end = g_array_index (self->eta_start, guint, eta + 1);
+      double xp = x[position];
+
+      if (xp == 0.0)
+        continue;
+
+      x[position] = xp * g_array_index (self->eta_pivots, double, eta);
+
+      for (guint e = start; e < end; e++)
+        {
+          const LpEntry *entry = &g_array_index (self->eta_entries, LpEntry, e);
+
+          x[entry->index] += entry->value * xp;
+        }
+    }
+}
+
+/* Solves Bᵀ·y = c, where @c is indexed by basis position, and is
+ * overwritten; @y is indexed by row
+ */
+static void
+revised_engine_btran (RevisedEngine *self,
+                      double *c,
+                      double *y)
+{
+  RevisedFactor *factor = self->factor;
+  guint n_entries;
+
+  for (guint eta = self->eta_positions->len; eta > 0; eta--)
+    {
+      guint position = g_array_index (self->eta_positions, guint, eta - 1);
+      guint start = g_array_index (self->eta_start, guint, eta - 1);
+      guint end = g_array_index (self->eta_start, guint, eta);
+      double v = c[position] * g_array_index (self->eta_pivots, double, eta - 1);
+
+      for (guint e = start; e < end; e++)
+        {
+          const LpEntry *entry = &g_array_index (self->eta_entries, LpEntry, e);
+
+          v += entry->value * c[entry->index];
+        }
+
+      c[position] = v;
+    }
+
+  for (guint k = 0; k < factor->n_steps; k++)
+    {
+      const LpEntry *entries = factor_get_u (factor, k, &n_entries);
+      double v = c[k];
+
+      for (guint e = 0; e < n_entries; e++)
+        v -= entries[e].value * y[factor->pivot_rows[entries[e].index]];
+
+      y[factor->pivot_rows[k]] = v / factor->diagonal[k];
+    }
+
+  for (guint k = factor->n_steps; k > 0; k--)
+    {
+      const LpEntry *entries = factor_get_l (factor, k - 1, &n_entries);
+      double v = 0.0;
+
+      for (guint e = 0; e < n_entries; e++)
+        v += entries[e].value * y[entries[e].index];
+
+      y[factor->pivot_rows[k - 1]] -= v;
+    }
+}
+
+/* Factorizes the basis again once enough eta columns have accumulated;
+ * the positions of the basis do not change, so this can happen in the
+ * middle of a solve. If the basis lost too much accuracy to be factorized
+ * we keep the eta columns, and try again after the next pivot.
+ */
+static void
+revised_engine_ensure_factor (RevisedEngine *self)
+{
+  if (self->eta_positions->len < REFACTOR_INTERVAL)
+    return;
+
+  if (!revised_engine_factorize (self, false))
+    g_debug ("Unable to factorize the basis after %u pivots",
+             self->eta_positions->len);
+}
+
+static gpointer
+revised_engine_create (LpModel *model)
+{
+  RevisedEngine *self = g_slice_new0 (RevisedEngine);
+
+  self->model = model;
+
+  self->matrix_start = g_array_new (FALSE, FALSE, sizeof (guint));
+  self->matrix_entries = g_array_new (FALSE, FALSE, sizeof (LpEntry));
+  self->matrix_dirty = true;
+
+  self->factor = revised_factor_new (0);
+  self->factor_dirty = true;
+
+  self->eta_start = g_array_new (FALSE, FALSE, sizeof (guint));
+  self->eta_positions = g_array_new (FALSE, FALSE, sizeof (guint));
+  self->eta_pivots = g_array_new (FALSE, FALSE, sizeof (double));
+  self->eta_entries = g_array_new (FALSE, FALSE, sizeof (LpEntry));
+  revised_engine_clear_etas (self);
+
+  return self;
+}
+
+static void
+revised_engine_free (gpointer engine)
+{
+  RevisedEngine *self = engine;
+
+  g_array_unref (self->matrix_start);
+  g_array_unref (self->matrix_entries);
+
+  revised_factor_free (self->factor);
+
+  g_array_unref (self->eta_start);
+  g_array_unref (self->eta_positions);
+  g_array_unref (self->eta_pivots);
+  g_array_unref (self->eta_entries);
+
+  g_free (self->work);
+  g_free (self->work_positions);
+  g_free (self->pattern);
+  g_free (self->in_pattern);
+  g_free (self->visited);
+  g_free (self->stack);
+  g_free (self->stack_entry);
+  g_free (self->reach);
+
+  g_slice_free (RevisedEngine, self);
+}
+
+/* The model appends the marker of the row to the basis, and takes the
+ * columns of a removed row out of it; both change the shape of the
+ * basis, which is factorized again before the next solve
+ */
+static void
+revised_engine_row_added (gpointer engine,
+                          LpRow *row)
+{
+  RevisedEngine *self = engine;
+
+  self->matrix_dirty = true;
+  self->factor_dirty = true;
+}
+
+static void
+revised_engine_row_removed (gpointer engine,
+                            LpRow *row)
+{
+  RevisedEngine *self = engine;
+
+  self->matrix_dirty = true;
+  self->factor_dirty = true;
+}
+
+static void
+revised_engine_refresh (gpointer engine)
+{
+  RevisedEngine *self = engine;
+
+  if (self->matrix_dirty)
+    revised_engine_build_matrix (self);
+
+  if (self->factor_dirty)
+    revised_engine_factorize (self, true);
+  else
+    revised_engine_ensure_factor (self);
+}
+
+static void
+revised_engine_compute_values (gpointer engine,
+                               const double *rhs,
+                               double *values)
+{
+  RevisedEngine *self = engine;
+  guint n_rows = lp_model_get_n_rows (self->model);
+
+  revised_engine_ensure_factor (self);
+
+  memcpy (self->work, rhs, sizeof (double) * n_rows);
+  revised_engine_ftran (self, self->work, values);
+}
+
+static void
+revised_engine_compute_column (gpointer engine,
+                               guint column,
+                               double *alpha)
+{
+  RevisedEngine *self = engine;
+  guint n_pattern;
+
+  revised_engine_ensure_factor (self);
+
+  n_pattern = revised_engine_load_column (self, column);
+  for (guint p = 0; p < n_pattern; p++)
+    self->in_pattern[self->pattern[p]] = false;
+
+  revised_engine_ftran (self, self->work, alpha);
+}
+
+static void
+revised_engine_compute_row (gpointer engine,
+                            guint position,
+                            double *row)
+{
+  RevisedEngine *self = engine;
+  LpModel *model = self->model;
+  guint n_rows = lp_model_get_n_rows (model);
+
+  revised_engine_ensure_factor (self);
+
+  memset (self->work_positions, 0, sizeof (double) * n_rows);
+  self->work_positions[position] = 1.0;
+
+  revised_engine_btran (self, self->work_positions, self->work);
+
+  for (guint j = 0; j < lp_model_get_n_columns (model); j++)
+    row[j] = revised_engine_dot_column (self, j, self->work);
+
+  memset (self->work, 0, sizeof (double) * n_rows);
+}
+
+static void
+revised_engine_compute_reduced_costs (gpointer engine,
+                                      const double *costs,
+                                      double *reduced_costs)
+{
+  RevisedEngine *self = engine;
+  LpModel *model = self->model;
+  guint n_rows = lp_model_get_n_rows (model);
+
+  revised_engine_ensure_factor (self);
+
+  for (guint p = 0; p < n_rows; p++)
+    self->work_positions[p] = costs[lp_model_get_basic_column (model, p)];
+
+  revised_engine_btran (self, self->work_positions, self->work);
+
+  for (guint j = 0; j < lp_model_get_n_columns (model); j++)
+    {
+      if (lp_model_get_position (model, j) >= 0)
+        reduced_costs[j] = 0.0;
+      else
+        reduced_costs[j] = costs[j] - revised_engine_dot_column (self, j, self->work);
+    }
+
+  memset (self->work, 0, sizeof (double) * n_rows);
+}
+
+static void
+revised_engine_pivot (gpointer engine,
+                      guint position,
+                      guint column,
+                      const double *alpha)
+{
+  RevisedEngine *self = engine;
+  guint n_rows = lp_model_get_n_rows (self->model);
+  double pivot = 1.0 / alpha[position];
+  guint end;
+
+  for (guint p = 0; p < n_rows; p++)
+    {
+      LpEntry entry = { p, -alpha[p] * pivot };
+
+      if (p == position || fabs (alpha[p]) <= DROP_TOLERANCE)
+        continue;
+
+      g_array_append_val (self->eta_entries, entry);
+    }
+
+  g_array_append_val (self->eta_positions, position);
+  g_array_append_val (self->eta_pivots, pivot);
+
+  end = self->eta_entries->len;
+  g_array_append_val (self->eta_start, end);
+}
+
+/* Rolling back a transaction restores the basis of the model, which is
+ * factorized again before the next solve
+ */
+static gpointer
+revised_engine_save (gpointer engine)
+{
+  return NULL;
+}
+
+static void
+revised_engine_restore (gpointer engine,
+                        gpointer snapshot)
+{
+  RevisedEngine *self = engine;
+
+  self->matrix_dirty = true;
+  self->factor_dirty = true;
+}
+
+static void
+revised_engine_free_snapshot (gpointer snapshot)
+{
+}
+
+const LpEngineClass lp_revised_engine = {
+  .name = "revised",
+
+  .create = revised_engine_create,
+  .free = revised_engine_free,
+
+  .row_added = revised_engine_row_added,
+  .row_removed = revised_engine_row_removed,
+  .refresh = revised_engine_refresh,
+
+  .compute_values = revised_engine_compute_values,
+  .compute_column = revised_engine_compute_column,
+  .compute_row = revised_engine_compute_row,
+  .compute_reduced_costs = revised_engine_compute_reduced_costs,
+
+  .pivot = revised_engine_pivot,
+
+  .save = revised_engine_save,
+  .restore = revised_engine_restore,
+  .free_snapshot = revised_engine_free_snapshot,
+};
@@ -0,0 +1,319 @@
+/* emeus-lp-solver-private.h: Linear programming solvers
+ *
+ * Copyright 2016  Endless
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "emeus-types-private.h"
+
+G_BEGIN_DECLS
+
+/* Unlike the Cassowary solver, which rewrites its tableau every time a
+ * constraint is added, the LP solvers keep the constraints as the rows
+ * of a linear program in computational form:
+ *
+ *   minimize c·x, subject to A·x = b
+ *
+ * where x contains the variables of the layout, which are free, and the
+ * slack, error and artificial variables of each row, and c contains the
+ * strength of the error variables. The program is solved with the
+ * simplex method when a value is needed, starting from the basis of the
+ * previous solution, so that a batch of changes costs a single solve.
+ *
+ * The rows are kept in their original, sparse form; how the basis is
+ * represented, and how the simplex iterations are computed from it, is
+ * up to the LpEngine used by the solver.
+ */
+
+typedef struct _LpModel         LpModel;
+typedef struct _LpRow           LpRow;
+typedef struct _LpEngineClass   LpEngineClass;
+typedef struct _LpTransaction   LpTransaction;
+
+typedef enum {
+  /* The variables of the layout */
+  LP_BOUND_FREE,
+
+  /* Slack and error variables, which cannot be negative */
+  LP_BOUND_LOWER,
+
+  /* Artificial variables of required equalities, which must be zero */
+  LP_BOUND_FIXED,
+
+  /* Columns that are not part of the program, and can be reused */
+  LP_BOUND_UNUSED
+} LpBound;
+
+typedef struct {
+  LpBound bound;
+
+  /* The coefficient of the column in the objective */
+  double cost;
+
+  /* The variable of a structural column, with the number of rows that
+   * reference it; NULL for the columns of a row
+   */
+  Variable *variable;
+  guint n_rows;
+
+  /* The row of a slack, error, or artificial column, and the only
+   * coefficient of the column
+   */
+  LpRow *row;
+  double coefficient;
+} LpColumn;
+
+struct _LpRow {
+  Constraint *constraint;
+
+  /* The position of the row in the model */
+  guint index;
+
+  /* The terms of the row, on the structural columns */
+  guint n_terms;
+  guint *columns;
+  double *coefficients;
+
+  /* The column that makes up the starting basis of the row, and the
+   * second slack or error column of the row, or G_MAXUINT
+   */
+  guint marker;
+  guint extra;
+
+  /* The right hand side of the row: the opposite of the constant of
+   * the constraint, or of the value of a stay or edit constraint
+   */
+  double rhs;
+
+  /* The order in which the rows were added */
+  guint serial;
+
+  /* Whether the row was added by the current transaction */
+  bool is_transient;
+};
+
+/* The operations on the basis of the program; the basis itself, and
+ * the value of the basic variables, are stored in the model, and each
+ * position of the basis maps to a basic column.
+ */
+struct _LpEngineClass {
+  const char *name;
+
+  /* The number of rows above which the model switches to the revised
+   * engine, or 0
+   */
+  guint max_rows;
+
+  gpointer (* create) (LpModel *model);
+  void (* free) (gpointer engine);
+
+  /* A row was appended to the model; its marker column must enter the
+   * basis in a new position
+   */
+  void (* row_added) (gpointer engine,
+                      LpRow *row);
+
+  /* A row is about to be removed from the model, along with its columns,
+   * which must leave the basis
+   */
+  void (* row_removed) (gpointer engine,
+                        LpRow *row);
+
+  /* Brings the representation of the basis up to date with the model,
+   * repairing the basis if needed
+   */
+  void (* refresh) (gpointer engine);
+
+  /* x_B = B⁻¹·b */
+  void (* compute_values) (gpointer engine,
+                           const double *rhs,
+                           double *values);
+
+  /* α = B⁻¹·a_q, indexed by basis position */
+  void (* compute_column) (gpointer engine,
+                           guint column,
+                           double *alpha);
+
+  /* The row of B⁻¹·A for the basis @position, indexed by column */
+  void (* compute_row) (gpointer engine,
+                        guint position,
+                        double *row);
+
+  /* d = c - Aᵀ·B⁻ᵀ·c_B, indexed by column */
+  void (* compute_reduced_costs) (gpointer engine,
+                                  const double *costs,
+                                  double *reduced_costs);
+
+  /* Replaces the basic column at @position with @column, where @alpha
+   * is the result of compute_column() for it
+   */
+  void (* pivot) (gpointer engine,
+                  guint position,
+                  guint column,
+                  const double *alpha);
+
+  /* Saves the state of the engine at the beginning of a transaction,
+   * and restores it if the transaction is rolled back
+   */
+  gpointer (* save) (gpointer engine);
+  void (* restore) (gpointer engine,
+                    gpointer snapshot);
+  void (* free_snapshot) (gpointer snapshot);
+};
+
+struct _LpModel {
+  SimplexSolver *solver;
+
+  /* Vec<LpRow>; the position of each row is its index */
+  GPtrArray *rows;
+
+  /* HashTable<Constraint, LpRow> */
+  GHashTable *row_map;
+
+  /* HashTable<Variable, LpRow> of the edit constraints */
+  GHashTable *edit_map;
+
+  /* Vec<LpColumn>, and the indices of the unused columns */
+  GArray *columns;
+  GArray *free_columns;
+
+  /* HashTable<Variable, index + 1> of the structural columns */
+  GHashTable *column_map;
+
+  /* The basic column at each position of the basis, the position of
+   * each column in the basis, or -1, and the value of each basic column
+   */
+  GArray *basis;
+  GArray *positions;
+  GArray *values;
+
+  /* The engine the solver was created with, and the one in use */
+  const LpEngineClass *preferred_class;
+  const LpEngineClass *engine_class;
+  gpointer engine;
+
+  LpTransaction *transaction;
+
+  /* The serial of the next row */
+  guint row_serial;
+
+  /* Edits suggested while the solver was frozen */
+  bool has_pending_edits;
+
+  /* Statistics, for the tests */
+  guint n_solves;
+  guint n_pivots;
+};
+
+static inline LpColumn *
+lp_model_get_column (LpModel *model,
+                     guint column)
+{
+  return &g_array_index (model->columns, LpColumn, column);
+}
+
+static inline LpRow *
+lp_model_get_row (LpModel *model,
+                  guint row)
+{
+  return g_ptr_array_index (model->rows, row);
+}
+
+static inline guint
+lp_model_get_n_rows (LpModel *model)
+{
+  return model->rows->len;
+}
+
+static inline guint
+lp_model_get_n_columns (LpModel *model)
+{
+  return model->columns->len;
+}
+
+static inline guint
+lp_model_get_basic_column (LpModel *model,
+                           guint position)
+{
+  return g_array_index (model->basis, guint, position);
+}
+
+static inline int
+lp_model_get_position (LpModel *model,
+                       guint column)
+{
+  return g_array_index (model->positions, int, column);
+}
+
+void lp_model_set_basic_column (LpModel *model,
+                                guint position,
+                                guint column);
+void lp_model_append_basic_column (LpModel *model,
+                                   guint column);
+void lp_model_remove_position (LpModel *model,
+                               guint position);
+void lp_model_set_basis (LpModel *model,
+                         const guint *columns,
+                         guint n_columns);
+
+LpModel *lp_solver_get_model (SimplexSolver *solver);
+
+void lp_solver_init (SimplexSolver *solver,
+                     const LpEngineClass *engine_class);
+void lp_solver_clear (SimplexSolver *solver);
+
+double lp_solver_get_value (SimplexSolver *solver,
+                            Variable *variable);
+
+Constraint *lp_solver_add_constraint (SimplexSolver *solver,
+                                      Variable *variable,
+                                      OperatorType op,
+                                      Expression *expression,
+                                      double strength);
+void lp_solver_remove_constraint (SimplexSolver *solver,
+                                  Constraint *constraint);
+
+Constraint *lp_solver_add_stay_variable (SimplexSolver *solver,
+                                         Variable *variable,
+                                         double strength);
+Constraint *lp_solver_add_edit_variable (SimplexSolver *solver,
+                                         Variable *variable,
+                                         double strength);
+
+void lp_solver_suggest_value (SimplexSolver *solver,
+                              Variable *variable,
+                              double value);
+void lp_solver_suggest_values (SimplexSolver *solver,
+                               Variable **variables,
+                               const double *values,
+                               guint n_values);
+void lp_solver_resolve (SimplexSolver *solver);
+
+void lp_solver_freeze (SimplexSolver *solver);
+void lp_solver_thaw (SimplexSolver *solver);
+
+void lp_solver_begin_transaction (SimplexSolver *solver);
+void lp_solver_commit_transaction (SimplexSolver *solver);
+void lp_solver_rollback_transaction (SimplexSolver *solver);
+
+extern const LpEngineClass lp_revised_engine;
+extern const LpEngineClass lp_dense_engine;
+
+bool lp_dense_kernels_available (const char *name);
+const char *lp_dense_engine_get_kernels (gpointer engine);
+
+G_END_DECLS
@@ -0,0 +1,1838 @@
+/* emeus-lp-solver.c: Linear programming solvers
+ *
+ * Copyright 2016  Endless
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* The model and the driver of the LP solvers.
+ *
+ * Each constraint becomes a row of the program, built from its normalized
+ * expression; see the Constraint type. The columns of a row depend on the
+ * kind of constraint:
+ *
+ *   - a required equality gets an artificial column, which must be zero:
+ *
+ *       expr + a = 0
+ *
+ *   - a required inequality gets a slack column:
+ *
+ *       expr - s = 0
+ *
+ *   - a non-required equality gets two error columns, weighted by the
+ *     strength of the constraint in the objective:
+ *
+ *       expr + em - ep = 0
+ *
+ *   - a non-required inequality gets a slack and an error column:
+ *
+ *       expr + em - s = 0
+ *
+ * The first column of each list is the marker of the row, which makes up
+ * the starting basis; stays and edits are non-required equalities whose
+ * constant is the value of their variable.
+ *
+ * Like the tableau of the Cassowary solver, the program is solved after
+ * each change, unless the solver is frozen, in which case the changes are
+ * solved at once when thawing, or when a value is needed. If the changes
+ * since the last solve only moved the right hand side, the previous basis
+ * is still optimal for the objective, and the dual simplex repairs it;
+ * otherwise, a composite phase one finds a feasible basis, and the primal
+ * simplex optimizes it, starting from the previous basis. Like with the
+ * Cassowary solver, a required constraint that cannot be satisfied is
+ * dropped, by freeing its marker.
+ */
+
+#include "config.h"
+
+#include "emeus-lp-solver-private.h"
+
+#include "emeus-expression-private.h"
+#include "emeus-simplex-solver-private.h"
+
+#include <glib.h>
+#include <string.h>
+#include <math.h>
+
+#define PRIMAL_TOLERANCE        1e-9
+#define DUAL_TOLERANCE          1e-9
+#define PIVOT_TOLERANCE         1e-9
+
+/* The costs of the error columns go from 1 to the strength of a strong
+ * constraint, so the tolerance of the reduced costs is relative to the
+ * largest cost
+ */
+#define RELATIVE_DUAL_TOLERANCE 1e-12
+
+#define MAX_DEGENERATE_PIVOTS   32
+
+struct _LpTransaction {
+  /* The rows when the transaction began, and their right hand side */
+  GPtrArray *rows;
+  double *rhs;
+
+  /* Copies of the columns, holding a reference on their variables, and
+   * of the basis
+   */
+  GArray *columns;
+  GArray *free_columns;
+  GArray *basis;
+  GArray *positions;
+  GArray *values;
+
+  /* The rows removed by the transaction */
+  GPtrArray *removed_rows;
+
+  /* HashTable<Variable, double>; the values of the variables when the
+   * transaction began, or when the transaction first changed them
+   */
+  GHashTable *saved_values;
+
+  /* The engine when the transaction began, and its state */
+  const LpEngineClass *engine_class;
+  gpointer engine_snapshot;
+
+  guint generation;
+  bool needs_solving;
+  bool has_pending_edits;
+};
+
+static bool lp_model_solve (LpModel *model);
+
+/* Model */
+
+static void
+lp_model_set_engine (LpModel *model,
+                     const LpEngineClass *engine_class)
+{
+  if (model->engine_class == engine_class)
+    return;
+
+#ifdef EMEUS_ENABLE_DEBUG
+  g_debug ("Solver [%p]: switching from the %s engine to the %s engine (rows:%u)",
+           model->solver,
+           model->engine_class->name,
+           engine_class->name,
+           lp_model_get_n_rows (model));
+#endif
+
+  model->engine_class->free (model->engine);
+
+  model->engine_class = engine_class;
+  model->engine = engine_class->create (model);
+}
+
+/* Engines with a maximum number of rows give way to the revised engine
+ * when the program grows past it, and get back when it shrinks well
+ * below it, so that a layout oscillating around the limit does not
+ * switch back and forth.
+ *
+ * The rows added by a transaction are usually rolled back shortly
+ * after, like the stays of the layout when allocating, so a transaction
+ * gets twice the rows before switching, and never switches back.
+ */
+static void
+lp_model_select_engine (LpModel *model)
+{
+  guint n_rows = lp_model_get_n_rows (model);
+  guint max_rows = model->preferred_class->max_rows;
+
+  if (max_rows == 0)
+    return;
+
+  if (model->engine_class == model->preferred_class)
+    {
+      if (n_rows > (model->transaction != NULL ? max_rows * 2 : max_rows))
+        lp_model_set_engine (model, &lp_revised_engine);
+    }
+  else if (model->transaction == NULL && n_rows < max_rows / 4 * 3)
+    lp_model_set_engine (model, model->preferred_class);
+}
+
+void
+lp_model_set_basic_column (LpModel *model,
+                           guint position,
+                           guint column)
+{
+  guint old_column = g_array_index (model->basis, guint, position);
+
+  if (old_column != G_MAXUINT)
+    g_array_index (model->positions, int, old_column) = -1;
+
+  g_array_index (model->basis, guint, position) = column;
+  g_array_index (model->positions, int, column) = position;
+}
+
+void
+lp_model_append_basic_column (LpModel *model,
+                              guint column)
+{
+  double value = 0.0;
+
+  g_array_append_val (model->basis, column);
+  g_array_append_val (model->values, value);
+
+  g_array_index (model->positions, int, column) = model->basis->len - 1;
+}
+
+/* Removes the basic column at @position; the last position of the basis
+ * takes its place
+ */
+void
+lp_model_remove_position (LpModel *model,
+                          guint position)
+{
+  guint last = model->basis->len - 1;
+  guint column = g_array_index (model->basis, guint, position);
+
+  g_array_index (model->positions, int, column) = -1;
+
+  if (position != last)
+    {
+      guint moved = g_array_index (model->basis, guint, last);
+
+      g_array_index (model->basis, guint, position) = moved;
+      g_array_index (model->positions, int, moved) = position;
+      g_array_index (model->values, double, position) = g_array_index (model->values, double, last);
+    }
+
+  g_array_set_size (model->basis, last);
+  g_array_set_size (model->values, last);
+}
+
+/* Replaces the basis with @columns, in order */
+void
+lp_model_set_basis (LpModel *model,
+                    const guint *columns,
+                    guint n_columns)
+{
+  for (guint i = 0; i < model->basis->len; i++)
+    {
+      guint column = g_array_index (model->basis, guint, i);
+
+      g_array_index (model->positions, int, column) = -1;
+    }
+
+  g_array_set_size (model->basis, 0);
+  g_array_append_vals (model->basis, columns, n_columns);
+  g_array_set_size (model->values, n_columns);
+
+  for (guint i = 0; i < n_columns; i++)
+    g_array_index (model->positions, int, columns[i]) = i;
+}
+
+static guint
+lp_model_new_column (LpModel *model,
+                     LpBound bound,
+                     double cost)
+{
+  LpColumn *column;
+  guint res;
+
+  if (model->free_columns->len > 0)
+    {
+      res = g_array_index (model->free_columns, guint, model->free_columns->len - 1);
+      g_array_set_size (model->free_columns, model->free_columns->len - 1);
+    }
+  else
+    {
+      int position = -1;
+
+      res = model->columns->len;
+      g_array_set_size (model->columns, res + 1);
+      g_array_append_val (model->positions, position);
+    }
+
+  column = lp_model_get_column (model, res);
+  column->bound = bound;
+  column->cost = cost;
+  column->variable = NULL;
+  column->n_rows = 0;
+  column->row = NULL;
+  column->coefficient = 0.0;
+
+  return res;
+}
+
+static void
+lp_model_free_column (LpModel *model,
+                      guint index)
+{
+  LpColumn *column = lp_model_get_column (model, index);
+  int position = lp_model_get_position (model, index);
+
+  /* The engine takes the columns of a removed row out of the basis */
+  if (position >= 0)
+    lp_model_remove_position (model, position);
+
+  if (column->variable != NULL)
+    {
+      g_hash_table_remove (model->column_map, column->variable);
+      variable_unref (column->variable);
+    }
+
+  column->bound = LP_BOUND_UNUSED;
+  column->cost = 0.0;
+  column->variable = NULL;
+  column->n_rows = 0;
+  column->row = NULL;
+  column->coefficient = 0.0;
+
+  g_array_append_val (model->free_columns, index);
+}
+
+static guint
+lp_model_get_structural_column (LpModel *model,
+                                Variable *variable)
+{
+  gpointer index_p = g_hash_table_lookup (model->column_map, variable);
+  guint res;
+
+  if (index_p != NULL)
+    return GPOINTER_TO_UINT (index_p) - 1;
+
+  res = lp_model_new_column (model, LP_BOUND_FREE, 0.0);
+  lp_model_get_column (model, res)->variable = variable_ref (variable);
+
+  g_hash_table_insert (model->column_map, variable, GUINT_TO_POINTER (res + 1));
+
+  return res;
+}
+
+static guint
+lp_model_new_row_column (LpModel *model,
+                         LpRow *row,
+                         LpBound bound,
+                         double cost,
+                         double coefficient)
+{
+  guint res = lp_model_new_column (model, bound, cost);
+  LpColumn *column = lp_model_get_column (model, res);
+
+  column->row = row;
+  column->coefficient = coefficient;
+
+  return res;
+}
+
+static void
+lp_row_free (LpRow *row)
+{
+  constraint_free (row->constraint);
+
+  g_free (row->columns);
+  g_free (row->coefficients);
+
+  g_slice_free (LpRow, row);
+}
+
+static LpRow *
+lp_model_add_row (LpModel *model,
+                  Constraint *constraint)
+{
+  SimplexSolver *solver = model->solver;
+  Expression *expression = constraint->expression;
+  LpRow *row = g_slice_new0 (LpRow);
+  guint n_terms = 0;
+
+  row->constraint = constraint;
+  row->serial = model->row_serial++;
+  row->rhs = -expression_get_constant (expression);
+
+  row->columns = g_new (guint, expression_get_n_terms (expression));
+  row->coefficients = g_new (double, expression_get_n_terms (expression));
+
+  /* The terms are prepended to the ordered list */
+  for (GList *l = g_list_last (expression->ordered_terms); l != NULL; l = l->prev)
+    {
+      Term *term = l->data;
+      guint column;
+
+      column = lp_model_get_structural_column (model, term_get_variable (term));
+      lp_model_get_column (model, column)->n_rows += 1;
+
+      row->columns[n_terms] = column;
+      row->coefficients[n_terms] = term_get_coefficient (term);
+      n_terms += 1;
+    }
+
+  row->n_terms = n_terms;
+  row->extra = G_MAXUINT;
+
+  if (constraint_is_required (constraint))
+    {
+      if (constraint_is_inequality (constraint))
+        row->marker = lp_model_new_row_column (model, row, LP_BOUND_LOWER, 0.0, -1.0);
+      else
+        row->marker = lp_model_new_row_column (model, row, LP_BOUND_FIXED, 0.0, 1.0);
+    }
+  else
+    {
+      double strength = constraint->strength;
+
+      row->marker = lp_model_new_row_column (model, row, LP_BOUND_LOWER, strength, 1.0);
+
+      if (constraint_is_inequality (constraint))
+        row->extra = lp_model_new_row_column (model, row, LP_BOUND_LOWER, 0.0, -1.0);
+      else
+        row->extra = lp_model_new_row_column (model, row, LP_BOUND_LOWER, strength, -1.0);
+    }
+
+  row->index = model->rows->len;
+  g_ptr_array_add (model->rows, row);
+  g_hash_table_insert (model->row_map, constraint, row);
+
+  if (constraint_is_edit (constraint))
+    g_hash_table_insert (model->edit_map, constraint->variable, row);
+
+  row->is_transient = model->transaction != NULL;
+
+  lp_model_append_basic_column (model, row->marker);
+
+  /* Growing past the size of the engine is checked before the engine
+   * does any work for the new row; shrinking is only checked when
+   * solving, see lp_model_solve()
+   */
+  if (model->engine_class == model->preferred_class)
+    lp_model_select_engine (model);
+
+  model->engine_class->row_added (model->engine, row);
+
+  solver->generation += 1;
+  solver->needs_solving = true;
+
+  if (solver->auto_solve)
+    lp_model_solve (model);
+
+  return row;
+}
+
+static void
+lp_model_remove_row (LpModel *model,
+                     LpRow *row)
+{
+  SimplexSolver *solver = model->solver;
+
+  model->engine_class->row_removed (model->engine, row);
+
+  g_hash_table_remove (model->row_map, row->constraint);
+
+  if (constraint_is_edit (row->constraint))
+    g_hash_table_remove (model->edit_map, row->constraint->variable);
+
+  g_ptr_array_remove_index_fast (model->rows, row->index);
+  if (row->index < model->rows->len)
+    lp_model_get_row (model, row->index)->index = row->index;
+
+  lp_model_free_column (model, row->marker);
+  if (row->extra != G_MAXUINT)
+    lp_model_free_column (model, row->extra);
+
+  for (guint i = 0; i < row->n_terms; i++)
+    {
+      LpColumn *column = lp_model_get_column (model, row->columns[i]);
+
+      column->n_rows -= 1;
+      if (column->n_rows == 0)
+        lp_model_free_column (model, row->columns[i]);
+    }
+
+  if (model->transaction != NULL)
+    g_ptr_array_add (model->transaction->removed_rows, row);
+  else
+    lp_row_free (row);
+
+  solver->generation += 1;
+  solver->needs_solving = true;
+
+  if (solver->auto_solve)
+    lp_model_solve (model);
+}
+
+/* Moves the value of each stay to the current value of its variable;
+ * see simplex_solver_reset_stay_constants()
+ */
+static void
+lp_model_reset_stays (LpModel *model)
+{
+  for (guint i = 0; i < model->rows->len; i++)
+    {
+      LpRow *row = lp_model_get_row (model, i);
+
+      if (constraint_is_stay (row->constraint))
+        row->rhs = -variable_get_value (row->constraint->variable);
+    }
+}
+
+/* Driver */
+
+typedef enum {
+  LP_STATUS_OPTIMAL,
+  LP_STATUS_INFEASIBLE,
+  LP_STATUS_STOPPED
+} LpStatus;
+
+typedef struct {
+  LpModel *model;
+
+  const LpEngineClass *engine_class;
+  gpointer engine;
+
+  guint n_rows;
+  guint n_columns;
+
+  /* Indexed by row */
+  double *rhs;
+
+  /* Indexed by basis position */
+  double *values;
+  double *alpha;
+
+  /* Indexed by column */
+  double *costs;
+  double *reduced_costs;
+  double *row;
+
+  double dual_tolerance;
+
+  guint max_iterations;
+  guint max_degenerate_pivots;
+
+  guint n_iterations;
+  guint n_degenerate;
+  guint n_stalled;
+} LpSolve;
+
+static void
+lp_solve_init (LpSolve *solve,
+               LpModel *model)
+{
+  SimplexSolver *solver = model->solver;
+  double max_cost = 0.0;
+
+  solve->model = model;
+  solve->engine_class = model->engine_class;
+  solve->engine = model->engine;
+
+  solve->n_rows = lp_model_get_n_rows (model);
+  solve->n_columns = lp_model_get_n_columns (model);
+
+  g_array_set_size (model->values, solve->n_rows);
+
+  solve->rhs = g_new (double, solve->n_rows);
+  solve->values = (double *) (void *) model->values->data;
+  solve->alpha = g_new (double, solve->n_rows);
+  solve->costs = g_new (double, solve->n_columns);
+  solve->reduced_costs = g_new (double, solve->n_columns);
+  solve->row = g_new (double, solve->n_columns);
+
+  for (guint i = 0; i < solve->n_rows; i++)
+    solve->rhs[i] = lp_model_get_row (model, i)->rhs;
+
+  for (guint j = 0; j < solve->n_columns; j++)
+    {
+      LpColumn *column = lp_model_get_column (model, j);
+
+      solve->costs[j] = column->cost;
+      max_cost = MAX (max_cost, column->cost);
+    }
+
+  solve->dual_tolerance = DUAL_TOLERANCE + RELATIVE_DUAL_TOLERANCE * max_cost;
+
+  /* See simplex_solver_get_max_iterations() */
+  if (solver->max_iterations > 0)
+    solve->max_iterations = solver->max_iterations;
+  else
+    solve->max_iterations = 1000 + 10 * (solve->n_rows + solve->n_columns);
+
+  if (solver->max_degenerate_pivots > 0)
+    solve->max_degenerate_pivots = solver->max_degenerate_pivots;
+  else
+    solve->max_degenerate_pivots = MAX_DEGENERATE_PIVOTS;
+
+  solve->n_iterations = 0;
+  solve->n_degenerate = 0;
+  solve->n_stalled = 0;
+}
+
+static void
+lp_solve_clear (LpSolve *solve)
+{
+  g_free (solve->rhs);
+  g_free (solve->alpha);
+  g_free (solve->costs);
+  g_free (solve->reduced_costs);
+  g_free (solve->row);
+}
+
+static inline double
+lp_column_get_infeasibility (const LpColumn *column,
+                             double value)
+{
+  switch (column->bound)
+    {
+    case LP_BOUND_LOWER:
+      return value < -PRIMAL_TOLERANCE ? value : 0.0;
+
+    case LP_BOUND_FIXED:
+      return fabs (value) > PRIMAL_TOLERANCE ? value : 0.0;
+
+    case LP_BOUND_FREE:
+    case LP_BOUND_UNUSED:
+      break;
+    }
+
+  return 0.0;
+}
+
+static int
+lp_solve_get_n_infeasible (LpSolve *solve)
+{
+  LpModel *model = solve->model;
+  int res = 0;
+
+  for (guint p = 0; p < solve->n_rows; p++)
+    {
+      LpColumn *column = lp_model_get_column (model, lp_model_get_basic_column (model, p));
+
+      if (lp_column_get_infeasibility (column, solve->values[p]) != 0.0)
+        res += 1;
+    }
+
+  return res;
+}
+
+static bool
+lp_solve_is_dual_feasible (LpSolve *solve)
+{
+  LpModel *model = solve->model;
+
+  for (guint j = 0; j < solve->n_columns; j++)
+    {
+      LpColumn *column = lp_model_get_column (model, j);
+      double d = solve->reduced_costs[j];
+
+      if (lp_model_get_position (model, j) >= 0)
+        continue;
+
+      if (column->bound == LP_BOUND_LOWER && d < -solve->dual_tolerance)
+        return false;
+
+      if (column->bound == LP_BOUND_FREE && fabs (d) > solve->dual_tolerance)
+        return false;
+    }
+
+  return true;
+}
+
+/* Replaces the basic column at @position with @column, whose value
+ * changes by @delta; solve->alpha must contain the entering column
+ */
+static void
+lp_solve_pivot (LpSolve *solve,
+                guint position,
+                guint column,
+                double delta,
+                bool use_bland)
+{
+  LpModel *model = solve->model;
+
+  for (guint p = 0; p < solve->n_rows; p++)
+    solve->values[p] -= delta * solve->alpha[p];
+
+  solve->engine_class->pivot (solve->engine, position, column, solve->alpha);
+  lp_model_set_basic_column (model, position, column);
+
+  solve->values[position] = delta;
+
+  /* A degenerate pivot changes the basis without moving the solution;
+   * long runs of them are how the simplex method cycles
+   */
+  if (fabs (delta) <= PRIMAL_TOLERANCE)
+    {
+      solve->n_degenerate += 1;
+      solve->n_stalled += 1;
+    }
+  else
+    solve->n_stalled = 0;
+
+  if (use_bland)
+    model->solver->bland_pivot_count += 1;
+
+  solve->n_iterations += 1;
+  model->n_pivots += 1;
+}
+
+/* Picks the nonbasic column entering the basis, and the direction in
+ * which it moves: either the one with the most negative reduced cost,
+ * or, when using Bland's rule, the one with the lowest index
+ */
+static int
+lp_solve_choose_entering (LpSolve *solve,
+                          double tolerance,
+                          bool use_bland,
+                          int *direction_p)
+{
+  LpModel *model = solve->model;
+  double best_score = 0.0;
+  int res = -1;
+
+  for (guint j = 0; j < solve->n_columns; j++)
+    {
+      LpColumn *column = lp_model_get_column (model, j);
+      double d = solve->reduced_costs[j];
+      double score;
+      int direction;
+
+      if (lp_model_get_position (model, j) >= 0)
+        continue;
+
+      if (column->bound == LP_BOUND_LOWER)
+        {
+          if (d >= -tolerance)
+            continue;
+
+          score = -d;
+          direction = 1;
+        }
+      else if (column->bound == LP_BOUND_FREE)
+        {
+          if (fabs (d) <= tolerance)
+            continue;
+
+          score = fabs (d);
+          direction = d < 0.0 ? 1 : -1;
+        }
+      else
+        continue;
+
+      if (res < 0 || score > best_score)
+        {
+          res = j;
+          best_score = score;
+          *direction_p = direction;
+
+          if (use_bland)
+            break;
+        }
+    }
+
+  return res;
+}
+
+/* The ratio test: picks the basic position that blocks the entering
+ * column first, when moving in @direction; the infeasible columns of
+ * phase one block when they reach their bound. Returns -1 if nothing
+ * blocks the entering column.
+ */
+static int
+lp_solve_choose_leaving (LpSolve *solve,
+                         int direction,
+                         bool use_bland,
+                         double *step_p)
+{
+  LpModel *model = solve->model;
+  double best_step = 0.0, best_alpha = 0.0;
+  guint best_column = G_MAXUINT;
+  int res = -1;
+
+  for (guint p = 0; p < solve->n_rows; p++)
+    {
+      double alpha = solve->alpha[p];
+      double value = solve->values[p];
+      double rate, step;
+      guint j;
+      LpColumn *column;
+
+      if (fabs (alpha) < PIVOT_TOLERANCE)
+        continue;
+
+      j = lp_model_get_basic_column (model, p);
+      column = lp_model_get_column (model, j);
+
+      /* The change of the basic column for each unit of step */
+      rate = -direction * alpha;
+
+      if (column->bound == LP_BOUND_LOWER)
+        {
+          if (value < -PRIMAL_TOLERANCE)
+            {
+              if (rate <= 0.0)
+                continue;
+
+              step = -value / rate;
+            }
+          else
+            {
+              if (rate >= 0.0)
+                continue;
+
+              step = MAX (value, 0.0) / -rate;
+            }
+        }
+      else if (column->bound == LP_BOUND_FIXED)
+        {
+          if (value > PRIMAL_TOLERANCE)
+            {
+              if (rate >= 0.0)
+                continue;
+
+              step = value / -rate;
+            }
+          else if (value < -PRIMAL_TOLERANCE)
+            {
+              if (rate <= 0.0)
+                continue;
+
+              step = -value / rate;
+            }
+          else
+            step = 0.0;
+        }
+      else
+        continue;
+
+      if (res < 0 || step < best_step - PRIMAL_TOLERANCE)
+        {
+          res = p;
+          best_step = step;
+          best_alpha = fabs (alpha);
+          best_column = j;
+        }
+      else if (step <= best_step + PRIMAL_TOLERANCE)
+        {
+          /* Ties go to the largest pivot, for stability, or to the lowest
+           * index when using Bland's rule
+           */
+          if ((use_bland && j < best_column) ||
+              (!use_bland && fabs (alpha) > best_alpha))
+            {
+              res = p;
+              best_step = MIN (step, best_step);
+              best_alpha = fabs (alpha);
+              best_column = j;
+            }
+        }
+    }
+
+  *step_p = best_step;
+
+  return res;
+}
+
+/* The primal simplex, optimizing solve->costs from a feasible basis */
+static LpStatus
+lp_solve_primal (LpSolve *solve)
+{
+  const LpEngineClass *engine_class = solve->engine_class;
+
+  while (true)
+    {
+      bool use_bland = solve->n_stalled >= solve->max_degenerate_pivots;
+      double step = 0.0;
+      int entering, leaving, direction = 1;
+
+      engine_class->compute_reduced_costs (solve->engine, solve->costs, solve->reduced_costs);
+
+      entering = lp_solve_choose_entering (solve, solve->dual_tolerance, use_bland, &direction);
+      if (entering < 0)
+        return LP_STATUS_OPTIMAL;
+
+      if (solve->n_iterations == solve->max_iterations)
+        return LP_STATUS_STOPPED;
+
+      engine_class->compute_column (solve->engine, entering, solve->alpha);
+
+      leaving = lp_solve_choose_leaving (solve, direction, use_bland, &step);
+      if (leaving < 0)
+        {
+          /* The objective is bounded below by zero, so this only happens
+           * when the basis has lost accuracy
+           */
+          g_debug ("Unbounded objective variable during optimization");
+          return LP_STATUS_STOPPED;
+        }
+
+      lp_solve_pivot (solve, leaving, entering, direction * step, use_bland);
+    }
+}
+
+/* Picks the infeasible position leaving the basis: either the most
+ * infeasible one, or, when using Bland's rule, the one with the lowest
+ * column index
+ */
+static int
+lp_solve_choose_dual_leaving (LpSolve *solve,
+                              bool use_bland)
+{
+  LpModel *model = solve->model;
+  double best_infeasibility = 0.0;
+  guint best_column = G_MAXUINT;
+  int res = -1;
+
+  for (guint p = 0; p < solve->n_rows; p++)
+    {
+      guint j = lp_model_get_basic_column (model, p);
+      double infeasibility;
+
+      infeasibility = fabs (lp_column_get_infeasibility (lp_model_get_column (model, j),
+                                                         solve->values[p]));
+      if (infeasibility == 0.0)
+        continue;
+
+      if (use_bland ? j < best_column : infeasibility > best_infeasibility)
+        {
+          res = p;
+          best_infeasibility = infeasibility;
+          best_column = j;
+        }
+    }
+
+  return res;
+}
+
+/* The dual ratio test: picks the nonbasic column that can bring the
+ * basic column at @position back to its bound while keeping the reduced
+ * costs feasible; returns -1 if there is none, in which case the program
+ * is infeasible
+ */
+static int
+lp_solve_choose_dual_entering (LpSolve *solve,
+                               guint position,
+                               bool use_bland,
+                               double *ratio_p)
+{
+  LpModel *model = solve->model;
+  double best_ratio = 0.0, best_rho = 0.0;
+  int res = -1;
+
+  /* The direction in which the leaving column has to move */
+  int need = solve->values[position] < 0.0 ? 1 : -1;
+
+  for (guint j = 0; j < solve->n_columns; j++)
+    {
+      LpColumn *column = lp_model_get_column (model, j);
+      double rho = solve->row[j];
+      double ratio;
+
+      if (lp_model_get_position (model, j) >= 0)
+        continue;
+
+      if (fabs (rho) < PIVOT_TOLERANCE)
+        continue;
+
+      if (column->bound == LP_BOUND_LOWER)
+        {
+          /* A column at its lower bound can only increase */
+          if (rho * need >= 0.0)
+            continue;
+
+          ratio = MAX (solve->reduced_costs[j], 0.0) / fabs (rho);
+        }
+      else if (column->bound == LP_BOUND_FREE)
+        ratio = fabs (solve->reduced_costs[j]) / fabs (rho);
+      else
+        continue;
+
+      if (res < 0 || ratio < best_ratio - solve->dual_tolerance)
+        {
+          res = j;
+          best_ratio = ratio;
+          best_rho = fabs (rho);
+        }
+      else if (ratio <= best_ratio + solve->dual_tolerance &&
+               !use_bland &&
+               fabs (rho) > best_rho)
+        {
+          res = j;
+          best_ratio = MIN (ratio, best_ratio);
+          best_rho = fabs (rho);
+        }
+    }
+
+  *ratio_p = best_ratio;
+
+  return res;
+}
+
+/* The dual simplex, repairing the primal feasibility of a basis whose
+ * reduced costs are feasible; this is what happens after changing the
+ * value of an edit variable
+ */
+static LpStatus
+lp_solve_dual (LpSolve *solve)
+{
+  const LpEngineClass *engine_class = solve->engine_class;
+
+  while (true)
+    {
+      bool use_bland = solve->n_stalled >= solve->max_degenerate_pivots;
+      double ratio = 0.0;
+      int leaving, entering;
+
+      leaving = lp_solve_choose_dual_leaving (solve, use_bland);
+      if (leaving < 0)
+        return LP_STATUS_OPTIMAL;
+
+      if (solve->n_iterations == solve->max_iterations)
+        return LP_STATUS_STOPPED;
+
+      engine_class->compute_reduced_costs (solve->engine, solve->costs, solve->reduced_costs);
+      engine_class->compute_row (solve->engine, leaving, solve->row);
+
+      entering = lp_solve_choose_dual_entering (solve, leaving, use_bland, &ratio);
+      if (entering < 0)
+        return LP_STATUS_INFEASIBLE;
+
+      engine_class->compute_column (solve->engine, entering, solve->alpha);
+      if (fabs (solve->alpha[leaving]) < PIVOT_TOLERANCE)
+        return LP_STATUS_INFEASIBLE;
+
+      lp_solve_pivot (solve, leaving, entering,
+                      solve->values[leaving] / solve->alpha[leaving],
+                      use_bland);
+
+      /* The dual step, rather than the primal one, tells whether the
+       * pivot was degenerate
+       */
+      if (ratio > solve->dual_tolerance)
+        solve->n_stalled = 0;
+    }
+}
+
+/* Sets the costs of phase one, which minimize the sum of infeasibilities
+ * of the basic columns; returns the number of infeasible columns
+ */
+static int
+lp_solve_set_phase_one_costs (LpSolve *solve)
+{
+  LpModel *model = solve->model;
+  int res = 0;
+
+  memset (solve->costs, 0, sizeof (double) * solve->n_columns);
+
+  for (guint p = 0; p < solve->n_rows; p++)
+    {
+      guint j = lp_model_get_basic_column (model, p);
+      double infeasibility;
+
+      infeasibility = lp_column_get_infeasibility (lp_model_get_column (model, j),
+                                                   solve->values[p]);
+      if (infeasibility == 0.0)
+        continue;
+
+      solve->costs[j] = infeasibility > 0.0 ? 1.0 : -1.0;
+      res += 1;
+    }
+
+  return res;
+}
+
+/* Drops the most recent required constraint taking part in the
+ * infeasibility left by phase one, by freeing its marker; the rows that
+ * take part in it are the ones with a nonzero dual value, which we get
+ * from the reduced cost of their marker
+ */
+static bool
+lp_solve_relax (LpSolve *solve)
+{
+  LpModel *model = solve->model;
+  LpRow *relaxed = NULL;
+
+  for (guint i = 0; i < solve->n_rows; i++)
+    {
+      LpRow *row = lp_model_get_row (model, i);
+      LpColumn *marker = lp_model_get_column (model, row->marker);
+      double dual;
+
+      if (!constraint_is_required (row->constraint) || marker->bound == LP_BOUND_FREE)
+        continue;
+
+      if (lp_model_get_position (model, row->marker) >= 0)
+        dual = marker->coefficient * solve->costs[row->marker];
+      else
+        dual = marker->coefficient * (solve->costs[row->marker] - solve->reduced_costs[row->marker]);
+
+      if (fabs (dual) <= DUAL_TOLERANCE)
+        continue;
+
+      if (relaxed == NULL || row->serial > relaxed->serial)
+        relaxed = row;
+    }
+
+  if (relaxed == NULL)
+    return false;
+
+  {
+    char *str = expression_to_string (relaxed->constraint->expression);
+
+    g_debug ("Unable to satisfy a required constraint (relax): %s", str);
+
+    g_free (str);
+  }
+
+  lp_model_get_column (model, relaxed->marker)->bound = LP_BOUND_FREE;
+
+  return true;
+}
+
+/* The composite phase one: minimizes the infeasibility of the basis,
+ * changing the costs as the columns become feasible
+ */
+static LpStatus
+lp_solve_phase_one (LpSolve *solve)
+{
+  const LpEngineClass *engine_class = solve->engine_class;
+
+  while (lp_solve_set_phase_one_costs (solve) > 0)
+    {
+      bool use_bland = solve->n_stalled >= solve->max_degenerate_pivots;
+      double step = 0.0;
+      int entering, leaving, direction = 1;
+
+      engine_class->compute_reduced_costs (solve->engine, solve->costs, solve->reduced_costs);
+
+      entering = lp_solve_choose_entering (solve, DUAL_TOLERANCE, use_bland, &direction);
+      if (entering < 0)
+        {
+          if (!lp_solve_relax (solve))
+            return LP_STATUS_INFEASIBLE;
+
+          continue;
+        }
+
+      if (solve->n_iterations == solve->max_iterations)
+        return LP_STATUS_STOPPED;
+
+      engine_class->compute_column (solve->engine, entering, solve->alpha);
+
+      leaving = lp_solve_choose_leaving (solve, direction, use_bland, &step);
+      if (leaving < 0)
+        return LP_STATUS_STOPPED;
+
+      lp_solve_pivot (solve, leaving, entering, direction * step, use_bland);
+    }
+
+  return LP_STATUS_OPTIMAL;
+}
+
+static void
+lp_model_update_variables (LpModel *model)
+{
+  LpTransaction *transaction = model->transaction;
+
+  for (guint j = 0; j < lp_model_get_n_columns (model); j++)
+    {
+      LpColumn *column = lp_model_get_column (model, j);
+      int position = lp_model_get_position (model, j);
+      double value, rounded;
+
+      if (column->variable == NULL)
+        continue;
+
+      if (position >= 0)
+        value = g_array_index (model->values, double, position);
+      else
+        value = 0.0;
+
+      /* Values that are within rounding error of an integer are made
+       * exact, as the layout rounds the allocation of the children
+       */
+      rounded = nearbyint (value);
+      if (fabs (value - rounded) <= PRIMAL_TOLERANCE * MAX (1.0, fabs (value)))
+        value = rounded + 0.0;
+
+      if (transaction != NULL &&
+          !g_hash_table_contains (transaction->saved_values, column->variable))
+        {
+          double *saved = g_new (double, 1);
+
+          *saved = column->variable->value;
+          g_hash_table_insert (transaction->saved_values, variable_ref (column->variable), saved);
+        }
+
+      column->variable->value = value;
+    }
+}
+
+/* Solves the program, if anything changed since the last time; returns
+ * false if the solution may not be optimal
+ */
+static bool
+lp_model_solve (LpModel *model)
+{
+  SimplexSolver *solver = model->solver;
+  LpStatus status = LP_STATUS_OPTIMAL;
+  LpSolve solve;
+
+  if (!solver->needs_solving)
+    return true;
+
+#ifdef EMEUS_ENABLE_DEBUG
+  gint64 start_time = g_get_monotonic_time ();
+#endif
+
+  lp_model_select_engine (model);
+  model->engine_class->refresh (model->engine);
+
+  lp_solve_init (&solve, model);
+
+  model->engine_class->compute_values (model->engine, solve.rhs, solve.values);
+
+  if (lp_solve_get_n_infeasible (&solve) > 0)
+    {
+      model->engine_class->compute_reduced_costs (model->engine, solve.costs, solve.reduced_costs);
+
+      if (lp_solve_is_dual_feasible (&solve))
+        status = lp_solve_dual (&solve);
+      else
+        status = LP_STATUS_INFEASIBLE;
+
+      if (status == LP_STATUS_INFEASIBLE)
+        {
+          status = lp_solve_phase_one (&solve);
+
+          for (guint j = 0; j < solve.n_columns; j++)
+            solve.costs[j] = lp_model_get_column (model, j)->cost;
+        }
+    }
+
+  if (status == LP_STATUS_OPTIMAL)
+    status = lp_solve_primal (&solve);
+
+  if (status != LP_STATUS_OPTIMAL)
+    {
+      g_warning ("SimplexSolver %p: %s stopped after %u pivots "
+                 "(%u degenerate) without converging; the solution may "
+                 "not be optimal (rows:%u, columns:%u, infeasible:%d)",
+                 solver, model->engine_class->name,
+                 solve.n_iterations,
+                 solve.n_degenerate,
+                 solve.n_rows,
+                 solve.n_columns,
+                 lp_solve_get_n_infeasible (&solve));
+    }
+
+  /* The values are computed again from the final basis, instead of
+   * keeping the ones updated by each pivot, to drop the rounding errors
+   */
+  model->engine_class->compute_values (model->engine, solve.rhs, solve.values);
+  lp_model_update_variables (model);
+
+#ifdef EMEUS_ENABLE_DEBUG
+  g_debug ("%s.time := %.3f ms (rows:%u, columns:%u, pivots:%u, degenerate:%u)",
+           model->engine_class->name,
+           (float) (g_get_monotonic_time () - start_time) / 1000.f,
+           solve.n_rows,
+           solve.n_columns,
+           solve.n_iterations,
+           solve.n_degenerate);
+#endif
+
+  lp_solve_clear (&solve);
+
+  model->n_solves += 1;
+  solver->needs_solving = false;
+
+  return status == LP_STATUS_OPTIMAL;
+}
+
+/* Transactions */
+
+static GArray *
+copy_array (GArray *array)
+{
+  guint element_size = g_array_get_element_size (array);
+  GArray *res = g_array_sized_new (FALSE, FALSE, element_size, array->len);
+
+  g_array_append_vals (res, array->data, array->len);
+
+  return res;
+}
+
+static void
+lp_model_unref_variables (GArray *columns)
+{
+  for (guint j = 0; j < columns->len; j++)
+    {
+      LpColumn *column = &g_array_index (columns, LpColumn, j);
+
+      if (column->variable != NULL)
+        variable_unref (column->variable);
+    }
+}
+
+static void
+lp_transaction_free (LpModel *model,
+                     LpTransaction *transaction)
+{
+  GHashTableIter iter;
+  gpointer key_p;
+
+  if (transaction->columns != NULL)
+    {
+      lp_model_unref_variables (transaction->columns);
+      g_array_unref (transaction->columns);
+    }
+
+  g_clear_pointer (&transaction->free_columns, g_array_unref);
+  g_clear_pointer (&transaction->basis, g_array_unref);
+  g_clear_pointer (&transaction->positions, g_array_unref);
+  g_clear_pointer (&transaction->values, g_array_unref);
+
+  g_ptr_array_unref (transaction->rows);
+  g_ptr_array_unref (transaction->removed_rows);
+  g_free (transaction->rhs);
+
+  g_hash_table_iter_init (&iter, transaction->saved_values);
+  while (g_hash_table_iter_next (&iter, &key_p, NULL))
+    variable_unref (key_p);
+  g_hash_table_unref (transaction->saved_values);
+
+  transaction->engine_class->free_snapshot (transaction->engine_snapshot);
+
+  g_slice_free (LpTransaction, transaction);
+}
+
+static void
+lp_model_begin_transaction (LpModel *model)
+{
+  SimplexSolver *solver = model->solver;
+  LpTransaction *transaction = g_slice_new0 (LpTransaction);
+
+  transaction->rows = g_ptr_array_sized_new (model->rows->len);
+  transaction->rhs = g_new (double, model->rows->len);
+
+  for (guint i = 0; i < model->rows->len; i++)
+    {
+      LpRow *row = lp_model_get_row (model, i);
+
+      g_ptr_array_add (transaction->rows, row);
+      transaction->rhs[i] = row->rhs;
+    }
+
+  transaction->removed_rows = g_ptr_array_new ();
+  transaction->saved_values = g_hash_table_new_full (NULL, NULL, NULL, g_free);
+
+  /* The values of the variables are saved as well, as the caller may
+   * change them before adding a stay
+   */
+  transaction->columns = copy_array (model->columns);
+  for (guint j = 0; j < transaction->columns->len; j++)
+    {
+      LpColumn *column = &g_array_index (transaction->columns, LpColumn, j);
+      double *saved;
+
+      if (column->variable == NULL)
+        continue;
+
+      variable_ref (column->variable);
+
+      saved = g_new (double, 1);
+      *saved = column->variable->value;
+      g_hash_table_insert (transaction->saved_values, variable_ref (column->variable), saved);
+    }
+
+  transaction->free_columns = copy_array (model->free_columns);
+  transaction->basis = copy_array (model->basis);
+  transaction->positions = copy_array (model->positions);
+  transaction->values = copy_array (model->values);
+
+  transaction->engine_class = model->engine_class;
+  transaction->engine_snapshot = model->engine_class->save (model->engine);
+
+  transaction->generation = solver->generation;
+  transaction->needs_solving = solver->needs_solving;
+  transaction->has_pending_edits = model->has_pending_edits;
+
+  model->transaction = transaction;
+}
+
+static void
+lp_model_commit_transaction (LpModel *model)
+{
+  LpTransaction *transaction = model->transaction;
+
+  model->transaction = NULL;
+
+  for (guint i = 0; i < transaction->removed_rows->len; i++)
+    lp_row_free (g_ptr_array_index (transaction->removed_rows, i));
+
+  for (guint i = 0; i < model->rows->len; i++)
+    lp_model_get_row (model, i)->is_transient = false;
+
+  lp_transaction_free (model, transaction);
+}
+
+static void
+lp_model_rollback_transaction (LpModel *model)
+{
+  SimplexSolver *solver = model->solver;
+  LpTransaction *transaction = model->transaction;
+  GHashTableIter iter;
+  gpointer key_p, value_p;
+  GArray *tmp;
+
+  model->transaction = NULL;
+
+  /* The rows added by the transaction are gone, and the removed ones
+   * that existed before it are back
+   */
+  for (guint i = 0; i < model->rows->len; i++)
+    {
+      LpRow *row = lp_model_get_row (model, i);
+
+      if (row->is_transient)
+        lp_row_free (row);
+    }
+
+  for (guint i = 0; i < transaction->removed_rows->len; i++)
+    {
+      LpRow *row = g_ptr_array_index (transaction->removed_rows, i);
+
+      if (row->is_transient)
+        lp_row_free (row);
+    }
+
+  g_ptr_array_set_size (model->rows, 0);
+  g_hash_table_remove_all (model->row_map);
+  g_hash_table_remove_all (model->edit_map);
+
+  for (guint i = 0; i < transaction->rows->len; i++)
+    {
+      LpRow *row = g_ptr_array_index (transaction->rows, i);
+
+      row->index = i;
+      row->rhs = transaction->rhs[i];
+
+      g_ptr_array_add (model->rows, row);
+      g_hash_table_insert (model->row_map, row->constraint, row);
+
+      if (constraint_is_edit (row->constraint))
+        g_hash_table_insert (model->edit_map, row->constraint->variable, row);
+    }
+
+  /* The copies of the columns hold their own references */
+  lp_model_unref_variables (model->columns);
+  tmp = model->columns;
+  model->columns = transaction->columns;
+  transaction->columns = NULL;
+  g_array_unref (tmp);
+
+  tmp = model->free_columns;
+  model->free_columns = transaction->free_columns;
+  transaction->free_columns = tmp;
+
+  tmp = model->basis;
+  model->basis = transaction->basis;
+  transaction->basis = tmp;
+
+  tmp = model->positions;
+  model->positions = transaction->positions;
+  transaction->positions = tmp;
+
+  tmp = model->values;
+  model->values = transaction->values;
+  transaction->values = tmp;
+
+  g_hash_table_remove_all (model->column_map);
+  for (guint j = 0; j < model->columns->len; j++)
+    {
+      LpColumn *column = lp_model_get_column (model, j);
+
+      if (column->variable != NULL)
+        g_hash_table_insert (model->column_map, column->variable, GUINT_TO_POINTER (j + 1));
+    }
+
+  g_hash_table_iter_init (&iter, transaction->saved_values);
+  while (g_hash_table_iter_next (&iter, &key_p, &value_p))
+    ((Variable *) key_p)->value = *(double *) value_p;
+
+  /* The snapshot can only be restored by the engine that saved it */
+  lp_model_set_engine (model, transaction->engine_class);
+  model->engine_class->restore (model->engine, transaction->engine_snapshot);
+
+  solver->generation = transaction->generation;
+  solver->needs_solving = transaction->needs_solving;
+  model->has_pending_edits = transaction->has_pending_edits;
+
+  lp_transaction_free (model, transaction);
+}
+
+/* Backend */
+
+LpModel *
+lp_solver_get_model (SimplexSolver *solver)
+{
+  return solver->backend_data;
+}
+
+void
+lp_solver_init (SimplexSolver *solver,
+                const LpEngineClass *engine_class)
+{
+  LpModel *model;
+
+  if (solver->initialized)
+    {
+      g_critical ("The SimplexSolver %p has already been initialized", solver);
+      return;
+    }
+
+  /* The variables and expressions are still created by the simplex
+   * solver, whose tableau stays empty
+   */
+  simplex_solver_init (solver);
+
+  model = g_slice_new0 (LpModel);
+  model->solver = solver;
+
+  /* Vec<LpRow>; owns the rows */
+  model->rows = g_ptr_array_new ();
+
+  /* HashTable<Constraint, LpRow> */
+  model->row_map = g_hash_table_new (NULL, NULL);
+
+  /* HashTable<Variable, LpRow> */
+  model->edit_map = g_hash_table_new (NULL, NULL);
+
+  /* Vec<LpColumn>; owns the variables of the structural columns */
+  model->columns = g_array_new (FALSE, TRUE, sizeof (LpColumn));
+  model->free_columns = g_array_new (FALSE, FALSE, sizeof (guint));
+
+  /* HashTable<Variable, index + 1> */
+  model->column_map = g_hash_table_new (NULL, NULL);
+
+  model->basis = g_array_new (FALSE, FALSE, sizeof (guint));
+  model->positions = g_array_new (FALSE, FALSE, sizeof (int));
+  model->values = g_array_new (FALSE, TRUE, sizeof (double));
+
+  model->preferred_class = engine_class;
+  model->engine_class = engine_class;
+  model->engine = engine_class->create (model);
+
+  solver->backend_data = model;
+}
+
+void
+lp_solver_clear (SimplexSolver *solver)
+{
+  LpModel *model = lp_solver_get_model (solver);
+
+  if (model != NULL)
+    {
+      if (model->transaction != NULL)
+        lp_model_commit_transaction (model);
+
+#ifdef EMEUS_ENABLE_DEBUG
+      g_debug ("Solver [%p]:\n"
+               "- Engine: %s\n"
+               "- Rows: %u, Columns: %u\n"
+               "- Solves: %u, Pivots: %u",
+               solver,
+               model->engine_class->name,
+               lp_model_get_n_rows (model),
+               lp_model_get_n_columns (model) - model->free_columns->len,
+               model->n_solves,
+               model->n_pivots);
+#endif
+
+      model->engine_class->free (model->engine);
+
+      for (guint i = 0; i < model->rows->len; i++)
+        lp_row_free (lp_model_get_row (model, i));
+
+      lp_model_unref_variables (model->columns);
+
+      g_ptr_array_unref (model->rows);
+      g_hash_table_unref (model->row_map);
+      g_hash_table_unref (model->edit_map);
+      g_array_unref (model->columns);
+      g_array_unref (model->free_columns);
+      g_hash_table_unref (model->column_map);
+      g_array_unref (model->basis);
+      g_array_unref (model->positions);
+      g_array_unref (model->values);
+
+      g_slice_free (LpModel, model);
+
+      solver->backend_data = NULL;
+    }
+
+  simplex_solver_clear (solver);
+}
+
+double
+lp_solver_get_value (SimplexSolver *solver,
+                     Variable *variable)
+{
+  LpModel *model = lp_solver_get_model (solver);
+
+  if (model != NULL)
+    lp_model_solve (model);
+
+  return variable_get_value (variable);
+}
+
+Constraint *
+lp_solver_add_constraint (SimplexSolver *solver,
+                          Variable *variable,
+                          OperatorType op,
+                          Expression *expression,
+                          double strength)
+{
+  Constraint *res;
+
+  if (!solver->initialized)
+    {
+      g_critical ("SimplexSolver %p has not been initialized.", solver);
+      return NULL;
+    }
+
+  res = constraint_new (solver, variable, op, expression, strength);
+  lp_model_add_row (lp_solver_get_model (solver), res);
+
+  return res;
+}
+
+void
+lp_solver_remove_constraint (SimplexSolver *solver,
+                             Constraint *constraint)
+{
+  LpModel *model = lp_solver_get_model (solver);
+  LpRow *row;
+
+  if (!solver->initialized)
+    return;
+
+  row = g_hash_table_lookup (model->row_map, constraint);
+  if (row == NULL)
+    {
+      char *str = expression_to_string (constraint->expression);
+
+      g_critical ("Unknown constraint '%s', unable to remove it from solver", str);
+
+      g_free (str);
+      return;
+    }
+
+  lp_model_reset_stays (model);
+  lp_model_remove_row (model, row);
+}
+
+Constraint *
+lp_solver_add_stay_variable (SimplexSolver *solver,
+                             Variable *variable,
+                             double strength)
+{
+  Constraint *res;
+
+  if (!solver->initialized)
+    {
+      g_critical ("SimplexSolver %p has not been initialized.", solver);
+      return NULL;
+    }
+
+  res = constraint_new_stay (solver, variable, strength);
+  lp_model_add_row (lp_solver_get_model (solver), res);
+
+  return res;
+}
+
+Constraint *
+lp_solver_add_edit_variable (SimplexSolver *solver,
+                             Variable *variable,
+                             double strength)
+{
+  Constraint *res;
+
+  if (!solver->initialized)
+    return NULL;
+
+  res = constraint_new_edit (solver, variable, strength);
+  lp_model_add_row (lp_solver_get_model (solver), res);
+
+  return res;
+}
+
+static void
+lp_model_apply_suggestion (LpModel *model,
+                           Variable *variable,
+                           double value)
+{
+  SimplexSolver *solver = model->solver;
+  LpRow *row = g_hash_table_lookup (model->edit_map, variable);
+
+  if (row == NULL)
+    {
+      g_critical ("Suggesting value '%g' but variable %p is not editable",
+                  value, variable);
+      return;
+    }
+
+  solver->generation += 1;
+
+  /* Only the right hand side changes, so the basis of the last solve
+   * stays dual feasible
+   */
+  row->rhs = -value;
+  solver->needs_solving = true;
+
+  if (solver->freeze_count > 0)
+    model->has_pending_edits = true;
+}
+
+void
+lp_solver_suggest_value (SimplexSolver *solver,
+                         Variable *variable,
+                         double value)
+{
+  if (!solver->initialized)
+    {
+      g_critical ("Unable to suggest value '%g': the SimplexSolver %p "
+                  "is not initialized.",
+                  value, solver);
+      return;
+    }
+
+  lp_model_apply_suggestion (lp_solver_get_model (solver), variable, value);
+}
+
+void
+lp_solver_suggest_values (SimplexSolver *solver,
+                          Variable **variables,
+                          const double *values,
+                          guint n_values)
+{
+  if (!solver->initialized)
+    {
+      g_critical ("Unable to suggest %u values: the SimplexSolver %p "
+                  "is not initialized.",
+                  n_values, solver);
+      return;
+    }
+
+  for (guint i = 0; i < n_values; i++)
+    lp_model_apply_suggestion (lp_solver_get_model (solver), variables[i], values[i]);
+
+  lp_solver_resolve (solver);
+}
+
+void
+lp_solver_resolve (SimplexSolver *solver)
+{
+  LpModel *model = lp_solver_get_model (solver);
+
+  if (!solver->initialized)
+    {
+      g_critical ("Unable to resolve the simplex: the SimplexSolver %p "
+                  "is not initialized",
+                  solver);
+      return;
+    }
+
+  /* Deferred until the solver is thawed */
+  if (solver->freeze_count > 0)
+    {
+      model->has_pending_edits = true;
+      return;
+    }
+
+  if (lp_model_solve (model))
+    lp_model_reset_stays (model);
+
+  model->has_pending_edits = false;
+}
+
+void
+lp_solver_freeze (SimplexSolver *solver)
+{
+  solver->freeze_count += 1;
+  solver->auto_solve = false;
+}
+
+void
+lp_solver_thaw (SimplexSolver *solver)
+{
+  LpModel *model = lp_solver_get_model (solver);
+
+  if (solver->freeze_count == 0)
+    {
+      g_critical ("Unbalanced thaw; did you forget to call solver_freeze()?");
+      return;
+    }
+
+  solver->freeze_count -= 1;
+
+  if (solver->freeze_count > 0)
+    return;
+
+  solver->auto_solve = true;
+
+  /* The constraints changed while the solver was frozen are solved at
+   * once, along with the values suggested in the meantime
+   */
+  if (model->has_pending_edits)
+    lp_solver_resolve (solver);
+  else
+    lp_model_solve (model);
+}
+
+void
+lp_solver_begin_transaction (SimplexSolver *solver)
+{
+  LpModel *model = lp_solver_get_model (solver);
+
+  if (!solver->initialized)
+    {
+      g_critical ("SimplexSolver %p is not initialized.", solver);
+      return;
+    }
+
+  if (model->transaction != NULL)
+    {
+      g_critical ("SimplexSolver %p already has an open transaction.", solver);
+      return;
+    }
+
+  lp_model_begin_transaction (model);
+}
+
+void
+lp_solver_commit_transaction (SimplexSolver *solver)
+{
+  LpModel *model = lp_solver_get_model (solver);
+
+  if (model == NULL || model->transaction == NULL)
+    {
+      g_critical ("SimplexSolver %p does not have an open transaction.", solver);
+      return;
+    }
+
+  lp_model_commit_transaction (model);
+}
+
+void
+lp_solver_rollback_transaction (SimplexSolver *solver)
+{
+  LpModel *model = lp_solver_get_model (solver);
+
+  if (model == NULL || model->transaction == NULL)
+    {
+      g_critical ("SimplexSolver %p does not have an open transaction.", solver);
+      return;
+    }
+
+  lp_model_rollback_transaction (model);
+}
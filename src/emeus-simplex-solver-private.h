@@ -46,10 +46,26 @@ constraint_is_edit (const Constraint *constraint)
   return constraint->is_edit;
 }
 
+Constraint *constraint_new (SimplexSolver *solver,
+                            Variable *variable,
+                            OperatorType op,
+                            Expression *expression,
+                            double strength);
+Constraint *constraint_new_stay (SimplexSolver *solver,
+                                 Variable *variable,
+                                 double strength);
+Constraint *constraint_new_edit (SimplexSolver *solver,
+                                 Variable *variable,
+                                 double strength);
+void constraint_free (Constraint *constraint);
+
 void simplex_solver_init (SimplexSolver *solver);
 void simplex_solver_clear (SimplexSolver *solver);
 void simplex_solver_reset (SimplexSolver *solver);
 
+GHashTable *simplex_solver_copy (SimplexSolver *solver,
+                                 SimplexSolver *copy);
+
 void simplex_solver_freeze (SimplexSolver *solver);
 void simplex_solver_thaw (SimplexSolver *solver);
 
@@ -92,11 +108,45 @@ void simplex_solver_suggest_value (SimplexSolver *solver,
                                    Variable *variable,
                                    double value);
 
+void simplex_solver_suggest_values (SimplexSolver *solver,
+                                    Variable **variables,
+                                    const double *values,
+                                    guint n_values);
+
 void simplex_solver_resolve (SimplexSolver *solver);
 
 void simplex_solver_begin_edit (SimplexSolver *solver);
 void simplex_solver_end_edit (SimplexSolver *solver);
 
+guint simplex_solver_hash (SimplexSolver *solver);
+
+GArray *simplex_solver_export_basis (SimplexSolver *solver);
+bool simplex_solver_import_basis (SimplexSolver *solver,
+                                  guint hash,
+                                  const guint32 *basis,
+                                  guint n_basis);
+
+void simplex_solver_set_max_iterations (SimplexSolver *solver,
+                                        guint max_iterations);
+void simplex_solver_set_max_degenerate_pivots (SimplexSolver *solver,
+                                               guint max_pivots);
+guint simplex_solver_get_bland_pivot_count (SimplexSolver *solver);
+
+guint simplex_solver_get_generation (SimplexSolver *solver);
+
+bool simplex_solver_get_sensitivity (SimplexSolver *solver,
+                                     Constraint * const *params,
+                                     guint n_params,
+                                     Variable *variable,
+                                     double *slopes);
+GArray *simplex_solver_get_feasible_region (SimplexSolver *solver,
+                                            Constraint * const *params,
+                                            guint n_params);
+
+void simplex_solver_begin_transaction (SimplexSolver *solver);
+void simplex_solver_commit_transaction (SimplexSolver *solver);
+void simplex_solver_rollback_transaction (SimplexSolver *solver);
+
 /* Internal */
 void simplex_solver_note_added_variable (SimplexSolver *solver,
                                          Variable *variable,
@@ -104,5 +154,9 @@ void simplex_solver_note_added_variable (SimplexSolver *solver,
 void simplex_solver_note_removed_variable (SimplexSolver *solver,
                                            Variable *variable,
                                            Variable *subject);
+void simplex_solver_note_expression_change (SimplexSolver *solver,
+                                            Expression *expression);
+void simplex_solver_note_variable_change (SimplexSolver *solver,
+                                          Variable *variable);
 
 G_END_DECLS
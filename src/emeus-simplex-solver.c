@@ -29,6 +29,20 @@
 #include <math.h>
 #include <float.h>
 
+/* The tolerances used by the ratio tests; the constants of the tableau
+ * are expressed in pixels, so anything below them is rounding noise
+ * accumulated by the previous pivots
+ */
+#define FEASIBILITY_TOLERANCE   1e-9
+#define OPTIMALITY_TOLERANCE    1e-9
+#define PIVOT_TOLERANCE         1e-9
+
+/* The default number of consecutive pivots that do not move the solution
+ * after which we assume the solver may be cycling, and switch to Bland's
+ * rule until the solution moves again
+ */
+#define MAX_DEGENERATE_PIVOTS   32
+
 typedef struct {
   Constraint *constraint;
 
@@ -36,12 +50,26 @@ typedef struct {
   Variable *eminus;
 
   double prev_constant;
+
+  /* A value suggested while the solver was frozen, applied on thaw */
+  double pending_value;
+  bool has_pending;
 } EditInfo;
 
 typedef struct {
   Constraint *constraint;
 } StayInfo;
 
+typedef struct {
+  /* The required equality that defines the alias */
+  Constraint *constraint;
+
+  /* The expression replacing the aliased variable; it only references
+   * variables that are not aliased themselves
+   */
+  Expression *expression;
+} Alias;
+
 typedef struct {
   /* HashSet<Variable>, owns a reference */
   GHashTable *set;
@@ -59,12 +87,171 @@ typedef struct {
   Variable *second;
 } VariablePair;
 
-static void
-constraint_free (gpointer data)
+typedef enum {
+  /* A key was added to a table; to undo, remove it */
+  JOURNAL_TABLE_INSERT,
+
+  /* A key was removed from a table; the entry is kept in the journal
+   * and put back when undoing the change
+   */
+  JOURNAL_TABLE_REMOVE,
+
+  /* The terms of an expression, or the contents of a variable set,
+   * were saved before their first change
+   */
+  JOURNAL_EXPRESSION,
+  JOURNAL_VARIABLE_SET,
+
+  /* The value of a variable, or the previous constant of an edit
+   * variable, was saved before its first change
+   */
+  JOURNAL_VARIABLE_VALUE,
+  JOURNAL_EDIT_CONSTANT,
+
+  /* A variable was restricted to non-negative values, or released */
+  JOURNAL_VARIABLE_RESTRICT,
+
+  /* A pair was appended to the stay error variables, or the whole
+   * array was replaced
+   */
+  JOURNAL_STAY_ERROR_APPEND,
+  JOURNAL_STAY_ERROR_REPLACE,
+
+  /* A reference on a variable must be released on commit */
+  JOURNAL_VARIABLE_UNREF
+} JournalOp;
+
+typedef struct {
+  JournalOp op;
+
+  gpointer target;
+
+  gpointer key;
+  gpointer value;
+
+  double number;
+} JournalEntry;
+
+struct _SolverJournal {
+  /* Vec<JournalEntry>, in the order in which the changes were made */
+  GArray *entries;
+
+  /* HashSet<gpointer>; the expressions, variable sets, variables and
+   * edit infos whose contents have already been saved
+   */
+  GHashTable *saved;
+
+  /* Copy of the infeasible rows when the transaction began */
+  GPtrArray *infeasible_rows;
+
+  int slack_counter;
+  int artificial_counter;
+  int dummy_counter;
+
+  guint generation;
+
+  bool needs_solving;
+};
+
+static void simplex_solver_optimize (SimplexSolver *solver,
+                                     Variable *z);
+static void simplex_solver_set_external_variables (SimplexSolver *solver);
+
+/* Creates a constraint on "@variable @op @expression", normalized to
+ * a single expression compared with zero; see the Constraint type
+ */
+Constraint *
+constraint_new (SimplexSolver *solver,
+                Variable *variable,
+                OperatorType op,
+                Expression *expression,
+                double strength)
 {
-  Constraint *constraint = data;
+  Constraint *res = g_slice_new0 (Constraint);
 
-  if (data == NULL)
+  res->solver = solver;
+  res->strength = strength;
+  res->is_edit = false;
+  res->is_stay = false;
+  res->op_type = op;
+
+  if (expression == NULL)
+    res->expression = expression_new_from_variable (variable);
+  else
+    {
+      res->expression = expression_ref (expression);
+      if (res->expression->solver == NULL)
+        res->expression->solver = solver;
+
+      if (variable != NULL)
+        {
+          switch (res->op_type)
+            {
+            case OPERATOR_TYPE_EQ:
+              expression_add_variable (res->expression, variable, -1.0, NULL);
+              break;
+
+            case OPERATOR_TYPE_LE:
+              expression_add_variable (res->expression, variable, -1.0, NULL);
+              break;
+
+            case OPERATOR_TYPE_GE:
+              expression_times (res->expression, -1.0);
+              expression_add_variable (res->expression, variable, 1.0, NULL);
+              break;
+            }
+        }
+    }
+
+  return res;
+}
+
+/* Creates a stay constraint, keeping @variable at its current value */
+Constraint *
+constraint_new_stay (SimplexSolver *solver,
+                     Variable *variable,
+                     double strength)
+{
+  Constraint *res = g_slice_new0 (Constraint);
+
+  res->solver = solver;
+  res->variable = variable_ref (variable);
+  res->op_type = OPERATOR_TYPE_EQ;
+  res->strength = strength;
+  res->is_stay = true;
+  res->is_edit = false;
+
+  res->expression = expression_new (solver, variable_get_value (res->variable));
+  expression_add_variable (res->expression, res->variable, -1.0, NULL);
+
+  return res;
+}
+
+/* Creates an edit constraint, keeping @variable at the suggested value */
+Constraint *
+constraint_new_edit (SimplexSolver *solver,
+                     Variable *variable,
+                     double strength)
+{
+  Constraint *res = g_slice_new0 (Constraint);
+
+  res->solver = solver;
+  res->variable = variable_ref (variable);
+  res->op_type = OPERATOR_TYPE_EQ;
+  res->strength = strength;
+  res->is_stay = false;
+  res->is_edit = true;
+
+  res->expression = expression_new (solver, variable_get_value (variable));
+  expression_add_variable (res->expression, variable, -1.0, NULL);
+
+  return res;
+}
+
+void
+constraint_free (Constraint *constraint)
+{
+  if (constraint == NULL)
     return;
 
   expression_unref (constraint->expression);
@@ -115,6 +302,18 @@ stay_info_free (gpointer data)
   g_slice_free (StayInfo, data);
 }
 
+static void
+alias_free (gpointer data)
+{
+  Alias *alias = data;
+
+  if (data == NULL)
+    return;
+
+  expression_unref (alias->expression);
+  g_slice_free (Alias, alias);
+}
+
 static void
 variable_set_free (gpointer data)
 {
@@ -234,133 +433,493 @@ variable_pair_free (gpointer data)
   g_slice_free (VariablePair, pair);
 }
 
-void
-simplex_solver_init (SimplexSolver *solver)
+static void
+simplex_solver_journal_push (SimplexSolver *solver,
+                             JournalOp op,
+                             gpointer target,
+                             gpointer key,
+                             gpointer value,
+                             double number)
 {
-  if (solver->initialized)
-    {
-      g_critical ("The SimplexSolver %p has already been initialized", solver);
-      return;
-    }
+  JournalEntry entry = {
+    .op = op,
+    .target = target,
+    .key = key,
+    .value = value,
+    .number = number,
+  };
 
-  memset (solver, 0, sizeof (SimplexSolver));
+  g_array_append_val (solver->journal->entries, entry);
+}
 
-  /* HashTable<Variable, VariableSet>; owns keys and values */
-  solver->columns = g_hash_table_new_full (NULL, NULL,
-                                           (GDestroyNotify) variable_unref,
-                                           variable_set_free);
+static void
+simplex_solver_journal_steal (SimplexSolver *solver,
+                              GHashTable *table,
+                              gconstpointer key)
+{
+  gpointer old_key, old_value;
 
-  /* HashTable<Variable, Expression>; owns keys and values */
-  solver->rows = g_hash_table_new_full (NULL, NULL,
-                                        (GDestroyNotify) variable_unref,
-                                        (GDestroyNotify) expression_unref);
+  if (!g_hash_table_lookup_extended (table, key, &old_key, &old_value))
+    return;
 
-  /* HashSet<Variable>; owns keys */
-  solver->external_rows = g_hash_table_new_full (NULL, NULL,
-                                                 (GDestroyNotify) variable_unref,
-                                                 NULL);
+  g_hash_table_steal (table, key);
 
-  /* Vec<Variable> */
-  solver->infeasible_rows = g_ptr_array_new ();
+  simplex_solver_journal_push (solver, JOURNAL_TABLE_REMOVE, table, old_key, old_value, 0.0);
+}
 
-  /* HashSet<Variable>; owns keys */
-  solver->external_parametric_vars = g_hash_table_new_full (NULL, NULL,
-                                                            (GDestroyNotify) variable_unref,
-                                                            NULL);
+/* Wrappers around the GHashTable API for the tables in the solver;
+ * while a transaction is open, removed entries are stolen and kept
+ * inside the journal instead of being freed
+ */
+static void
+simplex_solver_table_insert (SimplexSolver *solver,
+                             GHashTable *table,
+                             gpointer key,
+                             gpointer value)
+{
+  if (solver->journal != NULL)
+    {
+      simplex_solver_journal_steal (solver, table, key);
+      simplex_solver_journal_push (solver, JOURNAL_TABLE_INSERT, table, key, NULL, 0.0);
+    }
 
-  /* Vec<VariablePair> */
-  solver->stay_error_vars = g_ptr_array_new_with_free_func (variable_pair_free);
+  g_hash_table_insert (table, key, value);
+}
 
-  /* HashTable<Constraint, VariableSet> */
-  solver->error_vars = g_hash_table_new_full (NULL, NULL,
-                                              NULL,
-                                              variable_set_free);
+static void
+simplex_solver_table_add (SimplexSolver *solver,
+                          GHashTable *table,
+                          gpointer key)
+{
+  if (solver->journal != NULL)
+    {
+      simplex_solver_journal_steal (solver, table, key);
+      simplex_solver_journal_push (solver, JOURNAL_TABLE_INSERT, table, key, NULL, 0.0);
+    }
 
-  /* HashTable<Constraint, Variable> */
-  solver->marker_vars = g_hash_table_new (NULL, NULL);
+  g_hash_table_add (table, key);
+}
 
-  /* HashTable<Variable, EditInfo>; does not own keys, but owns values */
-  solver->edit_var_map = g_hash_table_new_full (NULL, NULL,
-                                                NULL,
-                                                edit_info_free);
+static void
+simplex_solver_table_remove (SimplexSolver *solver,
+                             GHashTable *table,
+                             gconstpointer key)
+{
+  if (solver->journal != NULL)
+    simplex_solver_journal_steal (solver, table, key);
+  else
+    g_hash_table_remove (table, key);
+}
 
-  /* HashTable<Variable, StayInfo>; does not own keys, but owns values */
-  solver->stay_var_map = g_hash_table_new_full (NULL, NULL,
-                                                NULL,
-                                                stay_info_free);
+static void
+simplex_solver_journal_variable_set (SimplexSolver *solver,
+                                     VariableSet *set)
+{
+  VariableSet *saved;
+  GList *l;
 
-  /* The rows table owns the objective variable */
-  solver->objective = variable_new (solver, VARIABLE_OBJECTIVE);
-  variable_set_name (solver->objective, "Z");
-  g_hash_table_insert (solver->rows, solver->objective, expression_new (solver, 0.0));
+  if (solver->journal == NULL)
+    return;
 
-  /* HashSet<Constraint> */
-  solver->constraints = g_hash_table_new_full (NULL, NULL, constraint_free, NULL);
+  if (!g_hash_table_add (solver->journal->saved, set))
+    return;
 
-  solver->slack_counter = 0;
-  solver->dummy_counter = 0;
-  solver->artificial_counter = 0;
-  solver->freeze_count = 0;
+  /* Like expression_save_terms(), the saved copy takes ownership of
+   * the current contents, so that they can be put back unchanged
+   */
+  saved = g_slice_new (VariableSet);
+  saved->set = set->set;
+  saved->ordered_set = set->ordered_set;
 
-  solver->needs_solving = false;
-  solver->auto_solve = true;
-  solver->initialized = true;
+  set->set = g_hash_table_new_full (NULL, NULL, (GDestroyNotify) variable_unref, NULL);
+  set->ordered_set = g_list_copy (saved->ordered_set);
+
+  for (l = set->ordered_set; l != NULL; l = l->next)
+    g_hash_table_add (set->set, variable_ref (l->data));
+
+  simplex_solver_journal_push (solver, JOURNAL_VARIABLE_SET, set, saved, NULL, 0.0);
 }
 
-void
-simplex_solver_reset (SimplexSolver *solver)
+static void
+simplex_solver_variable_set_add (SimplexSolver *solver,
+                                 VariableSet *set,
+                                 Variable *variable)
 {
-  if (!solver->initialized)
-    {
-      g_critical ("SimplexSolver %p is not initialized.", solver);
-      return;
-    }
+  if (g_hash_table_contains (set->set, variable))
+    return;
 
-  solver->needs_solving = false;
-  solver->auto_solve = true;
+  simplex_solver_journal_variable_set (solver, set);
+  variable_set_add_variable (set, variable);
+}
 
-  solver->freeze_count = 0;
-  solver->slack_counter = 0;
-  solver->dummy_counter = 0;
-  solver->artificial_counter = 0;
+static bool
+simplex_solver_variable_set_remove (SimplexSolver *solver,
+                                    VariableSet *set,
+                                    Variable *variable)
+{
+  if (!g_hash_table_contains (set->set, variable))
+    return false;
 
-  g_ptr_array_set_size (solver->stay_error_vars, 0);
-  g_ptr_array_set_size (solver->infeasible_rows, 0);
+  simplex_solver_journal_variable_set (solver, set);
 
-  g_hash_table_remove_all (solver->external_rows);
-  g_hash_table_remove_all (solver->external_parametric_vars);
-  g_hash_table_remove_all (solver->error_vars);
-  g_hash_table_remove_all (solver->marker_vars);
-  g_hash_table_remove_all (solver->edit_var_map);
-  g_hash_table_remove_all (solver->stay_var_map);
-  g_hash_table_remove_all (solver->constraints);
+  return variable_set_remove_variable (set, variable);
+}
 
-  g_hash_table_remove_all (solver->rows);
-  g_hash_table_remove_all (solver->columns);
+void
+simplex_solver_note_expression_change (SimplexSolver *solver,
+                                       Expression *expression)
+{
+  if (solver->journal == NULL)
+    return;
 
-  solver->objective = variable_new (solver, VARIABLE_OBJECTIVE);
-  variable_set_name (solver->objective, "Z");
-  g_hash_table_insert (solver->rows, solver->objective, expression_new (solver, 0.0));
+  if (!g_hash_table_add (solver->journal->saved, expression))
+    return;
+
+  simplex_solver_journal_push (solver, JOURNAL_EXPRESSION,
+                               expression_ref (expression),
+                               expression_save_terms (expression),
+                               NULL,
+                               0.0);
 }
 
 void
-simplex_solver_clear (SimplexSolver *solver)
+simplex_solver_note_variable_change (SimplexSolver *solver,
+                                     Variable *variable)
 {
-  if (!solver->initialized)
+  if (solver->journal == NULL)
     return;
 
-  solver->initialized = false;
+  if (!g_hash_table_add (solver->journal->saved, variable))
+    return;
 
-#ifdef EMEUS_ENABLE_DEBUG
-  {
-    g_debug ("Solver [%p]:\n"
-             "- Rows: %d, Columns: %d\n"
-             "- Slack variables: %d\n"
-             "- Error variables: %d (pairs: %d)\n"
-             "- Marker variables: %d\n"
-             "- Infeasible rows: %d\n"
+  simplex_solver_journal_push (solver, JOURNAL_VARIABLE_VALUE,
+                               variable_ref (variable),
+                               NULL, NULL,
+                               variable->value);
+}
+
+static void
+journal_table_release (GHashTable *table,
+                       gpointer key,
+                       gpointer value)
+{
+  gpointer cur_key = NULL, cur_value = NULL;
+  bool has_key;
+
+  /* GHashTable does not give us access to its destroy functions, so
+   * we put the stolen entry back and remove it to release it
+   */
+  has_key = g_hash_table_lookup_extended (table, key, &cur_key, &cur_value);
+  if (has_key)
+    g_hash_table_steal (table, key);
+
+  g_hash_table_insert (table, key, value);
+  g_hash_table_remove (table, key);
+
+  if (has_key)
+    g_hash_table_insert (table, cur_key, cur_value);
+}
+
+static void
+simplex_solver_journal_free (SimplexSolver *solver,
+                             bool rollback)
+{
+  SolverJournal *journal = solver->journal;
+
+  if (journal == NULL)
+    return;
+
+  /* Stop journaling while we undo, or release, the changes */
+  solver->journal = NULL;
+
+  if (rollback)
+    {
+      for (int i = journal->entries->len - 1; i >= 0; i--)
+        {
+          JournalEntry *entry = &g_array_index (journal->entries, JournalEntry, i);
+
+          switch (entry->op)
+            {
+            case JOURNAL_TABLE_INSERT:
+              g_hash_table_remove (entry->target, entry->key);
+              break;
+
+            case JOURNAL_TABLE_REMOVE:
+              g_hash_table_insert (entry->target, entry->key, entry->value);
+              break;
+
+            case JOURNAL_EXPRESSION:
+              expression_restore_terms (entry->target, entry->key);
+              expression_unref (entry->target);
+              break;
+
+            case JOURNAL_VARIABLE_SET:
+              {
+                VariableSet *set = entry->target;
+                VariableSet *saved = entry->key;
+                GHashTable *tmp_set = set->set;
+                GList *tmp_ordered_set = set->ordered_set;
+
+                set->set = saved->set;
+                set->ordered_set = saved->ordered_set;
+                saved->set = tmp_set;
+                saved->ordered_set = tmp_ordered_set;
+
+                variable_set_free (saved);
+              }
+              break;
+
+            case JOURNAL_VARIABLE_VALUE:
+              ((Variable *) entry->target)->value = entry->number;
+              variable_unref (entry->target);
+              break;
+
+            case JOURNAL_EDIT_CONSTANT:
+              ((EditInfo *) entry->target)->prev_constant = entry->number;
+              break;
+
+            case JOURNAL_VARIABLE_RESTRICT:
+              ((Variable *) entry->target)->is_restricted = entry->number != 0.0;
+              ((Variable *) entry->target)->is_pivotable = entry->number != 0.0;
+              variable_unref (entry->target);
+              break;
+
+            case JOURNAL_STAY_ERROR_APPEND:
+              g_ptr_array_remove_index (solver->stay_error_vars,
+                                        solver->stay_error_vars->len - 1);
+              break;
+
+            case JOURNAL_STAY_ERROR_REPLACE:
+              g_ptr_array_unref (solver->stay_error_vars);
+              solver->stay_error_vars = entry->target;
+              break;
+
+            case JOURNAL_VARIABLE_UNREF:
+              break;
+            }
+        }
+
+      g_ptr_array_set_size (solver->infeasible_rows, 0);
+      for (int i = 0; i < journal->infeasible_rows->len; i++)
+        g_ptr_array_add (solver->infeasible_rows, g_ptr_array_index (journal->infeasible_rows, i));
+
+      solver->slack_counter = journal->slack_counter;
+      solver->artificial_counter = journal->artificial_counter;
+      solver->dummy_counter = journal->dummy_counter;
+      solver->generation = journal->generation;
+      solver->needs_solving = journal->needs_solving;
+    }
+  else
+    {
+      for (int i = 0; i < journal->entries->len; i++)
+        {
+          JournalEntry *entry = &g_array_index (journal->entries, JournalEntry, i);
+
+          switch (entry->op)
+            {
+            case JOURNAL_TABLE_INSERT:
+            case JOURNAL_EDIT_CONSTANT:
+            case JOURNAL_STAY_ERROR_APPEND:
+              break;
+
+            case JOURNAL_TABLE_REMOVE:
+              journal_table_release (entry->target, entry->key, entry->value);
+              break;
+
+            case JOURNAL_EXPRESSION:
+              expression_unref (entry->key);
+              expression_unref (entry->target);
+              break;
+
+            case JOURNAL_VARIABLE_SET:
+              variable_set_free (entry->key);
+              break;
+
+            case JOURNAL_VARIABLE_VALUE:
+            case JOURNAL_VARIABLE_RESTRICT:
+            case JOURNAL_VARIABLE_UNREF:
+              variable_unref (entry->target);
+              break;
+
+            case JOURNAL_STAY_ERROR_REPLACE:
+              g_ptr_array_unref (entry->target);
+              break;
+            }
+        }
+    }
+
+  g_array_unref (journal->entries);
+  g_hash_table_unref (journal->saved);
+  g_ptr_array_unref (journal->infeasible_rows);
+  g_slice_free (SolverJournal, journal);
+}
+
+void
+simplex_solver_init (SimplexSolver *solver)
+{
+  if (solver->initialized)
+    {
+      g_critical ("The SimplexSolver %p has already been initialized", solver);
+      return;
+    }
+
+  memset (solver, 0, sizeof (SimplexSolver));
+
+  /* HashTable<Variable, VariableSet>; owns keys and values */
+  solver->columns = g_hash_table_new_full (NULL, NULL,
+                                           (GDestroyNotify) variable_unref,
+                                           variable_set_free);
+
+  /* HashTable<Variable, Expression>; owns keys and values */
+  solver->rows = g_hash_table_new_full (NULL, NULL,
+                                        (GDestroyNotify) variable_unref,
+                                        (GDestroyNotify) expression_unref);
+
+  /* HashSet<Variable>; owns keys */
+  solver->external_rows = g_hash_table_new_full (NULL, NULL,
+                                                 (GDestroyNotify) variable_unref,
+                                                 NULL);
+
+  /* Vec<Variable> */
+  solver->infeasible_rows = g_ptr_array_new ();
+
+  /* HashSet<Variable>; owns keys */
+  solver->external_parametric_vars = g_hash_table_new_full (NULL, NULL,
+                                                            (GDestroyNotify) variable_unref,
+                                                            NULL);
+
+  /* Vec<VariablePair> */
+  solver->stay_error_vars = g_ptr_array_new_with_free_func (variable_pair_free);
+
+  /* HashTable<Constraint, VariableSet> */
+  solver->error_vars = g_hash_table_new_full (NULL, NULL,
+                                              NULL,
+                                              variable_set_free);
+
+  /* HashTable<Constraint, Variable> */
+  solver->marker_vars = g_hash_table_new (NULL, NULL);
+
+  /* HashTable<Variable, EditInfo>; does not own keys, but owns values */
+  solver->edit_var_map = g_hash_table_new_full (NULL, NULL,
+                                                NULL,
+                                                edit_info_free);
+
+  /* HashTable<Variable, StayInfo>; does not own keys, but owns values */
+  solver->stay_var_map = g_hash_table_new_full (NULL, NULL,
+                                                NULL,
+                                                stay_info_free);
+
+  /* The rows table owns the objective variable */
+  solver->objective = variable_new (solver, VARIABLE_OBJECTIVE);
+  variable_set_name (solver->objective, "Z");
+  g_hash_table_insert (solver->rows, solver->objective, expression_new (solver, 0.0));
+
+  /* HashSet<Constraint> */
+  solver->constraints = g_hash_table_new_full (NULL, NULL, (GDestroyNotify) constraint_free, NULL);
+
+  /* HashTable<Variable, Alias>; owns keys and values */
+  solver->aliases = g_hash_table_new_full (NULL, NULL,
+                                           (GDestroyNotify) variable_unref,
+                                           alias_free);
+
+  /* HashTable<Constraint, Variable> */
+  solver->alias_constraints = g_hash_table_new (NULL, NULL);
+
+  /* HashTable<Constraint, Variable> */
+  solver->bound_constraints = g_hash_table_new (NULL, NULL);
+
+  solver->slack_counter = 0;
+  solver->dummy_counter = 0;
+  solver->artificial_counter = 0;
+  solver->freeze_count = 0;
+  solver->generation = 0;
+  solver->bland_pivot_count = 0;
+
+  solver->needs_solving = false;
+  solver->auto_solve = true;
+  solver->initialized = true;
+}
+
+void
+simplex_solver_reset (SimplexSolver *solver)
+{
+  GHashTableIter iter;
+  gpointer value_p;
+
+  if (!solver->initialized)
+    {
+      g_critical ("SimplexSolver %p is not initialized.", solver);
+      return;
+    }
+
+  simplex_solver_journal_free (solver, false);
+
+  solver->needs_solving = false;
+  solver->auto_solve = true;
+
+  solver->freeze_count = 0;
+  solver->slack_counter = 0;
+  solver->dummy_counter = 0;
+  solver->artificial_counter = 0;
+
+  /* The generation is not reset, as values computed before the reset
+   * must not be confused with the ones computed after it
+   */
+  solver->generation += 1;
+
+  g_ptr_array_set_size (solver->stay_error_vars, 0);
+  g_ptr_array_set_size (solver->infeasible_rows, 0);
+
+  /* The variables outlive the reset, but not their bounds */
+  g_hash_table_iter_init (&iter, solver->bound_constraints);
+  while (g_hash_table_iter_next (&iter, NULL, &value_p))
+    {
+      Variable *variable = value_p;
+
+      variable->is_restricted = false;
+      variable->is_pivotable = false;
+    }
+
+  g_hash_table_remove_all (solver->bound_constraints);
+  g_hash_table_remove_all (solver->external_rows);
+  g_hash_table_remove_all (solver->external_parametric_vars);
+  g_hash_table_remove_all (solver->error_vars);
+  g_hash_table_remove_all (solver->marker_vars);
+  g_hash_table_remove_all (solver->edit_var_map);
+  g_hash_table_remove_all (solver->stay_var_map);
+  g_hash_table_remove_all (solver->alias_constraints);
+  g_hash_table_remove_all (solver->aliases);
+  g_hash_table_remove_all (solver->constraints);
+
+  g_hash_table_remove_all (solver->rows);
+  g_hash_table_remove_all (solver->columns);
+
+  solver->objective = variable_new (solver, VARIABLE_OBJECTIVE);
+  variable_set_name (solver->objective, "Z");
+  g_hash_table_insert (solver->rows, solver->objective, expression_new (solver, 0.0));
+}
+
+void
+simplex_solver_clear (SimplexSolver *solver)
+{
+  if (!solver->initialized)
+    return;
+
+  simplex_solver_journal_free (solver, false);
+
+  solver->initialized = false;
+
+#ifdef EMEUS_ENABLE_DEBUG
+  {
+    g_debug ("Solver [%p]:\n"
+             "- Rows: %d, Columns: %d\n"
+             "- Slack variables: %d\n"
+             "- Error variables: %d (pairs: %d)\n"
+             "- Marker variables: %d\n"
+             "- Infeasible rows: %d\n"
              "- External rows: %d\n"
-             "- Edit: %d, Stay: %d",
+             "- Edit: %d, Stay: %d\n"
+             "- Aliases: %d",
              solver,
              g_hash_table_size (solver->rows),
              g_hash_table_size (solver->columns),
@@ -371,7 +930,8 @@ simplex_solver_clear (SimplexSolver *solver)
              solver->infeasible_rows->len,
              g_hash_table_size (solver->external_rows),
              g_hash_table_size (solver->edit_var_map),
-             g_hash_table_size (solver->stay_var_map));
+             g_hash_table_size (solver->stay_var_map),
+             g_hash_table_size (solver->aliases));
   }
 #endif
 
@@ -394,6 +954,9 @@ simplex_solver_clear (SimplexSolver *solver)
   g_clear_pointer (&solver->marker_vars, g_hash_table_unref);
   g_clear_pointer (&solver->edit_var_map, g_hash_table_unref);
   g_clear_pointer (&solver->stay_var_map, g_hash_table_unref);
+  g_clear_pointer (&solver->alias_constraints, g_hash_table_unref);
+  g_clear_pointer (&solver->bound_constraints, g_hash_table_unref);
+  g_clear_pointer (&solver->aliases, g_hash_table_unref);
   g_clear_pointer (&solver->constraints, g_hash_table_unref);
 
   /* The columns need to be deleted last, for reference counting */
@@ -401,49 +964,365 @@ simplex_solver_clear (SimplexSolver *solver)
   g_clear_pointer (&solver->columns, g_hash_table_unref);
 }
 
-void
-simplex_solver_freeze (SimplexSolver *solver)
+typedef struct {
+  SimplexSolver *copy;
+
+  /* HashTable<Variable, Variable>; owns a reference on the values */
+  GHashTable *variables;
+
+  /* HashTable<Constraint, Constraint> */
+  GHashTable *constraints;
+} CopyClosure;
+
+static Variable *
+copy_variable (CopyClosure *closure,
+               Variable *variable)
 {
-  solver->freeze_count += 1;
+  Variable *res;
 
-  if (solver->freeze_count > 0)
-    solver->auto_solve = false;
+  if (variable == NULL)
+    return NULL;
+
+  res = g_hash_table_lookup (closure->variables, variable);
+  if (res != NULL)
+    return res;
+
+  res = variable_new (closure->copy, variable->type);
+
+  /* We keep the same identifier, so that the copy pivots and
+   * optimizes the tableau in the same order as the original
+   */
+  res->id_ = variable->id_;
+  res->name = variable->name;
+  res->prefix = variable->prefix;
+  res->value = variable->value;
+  res->is_external = variable->is_external;
+  res->is_pivotable = variable->is_pivotable;
+  res->is_restricted = variable->is_restricted;
+
+  g_hash_table_insert (closure->variables, variable, res);
+
+  return res;
 }
 
-void
-simplex_solver_thaw (SimplexSolver *solver)
+static Expression *
+copy_expression (CopyClosure *closure,
+                 Expression *expression)
 {
-  if (solver->freeze_count == 0)
+  Expression *res = expression_new (closure->copy, expression->constant);
+  GList *l;
+
+  /* Iterate in insertion order, to preserve the order of the terms */
+  for (l = g_list_last (expression->ordered_terms); l != NULL; l = l->prev)
     {
-      g_critical ("Unbalanced thaw; did you forger to call simplex_solver_freeze()?");
-      return;
-    }
+      Term *t = l->data;
 
-  solver->freeze_count -= 1;
+      expression_set_variable (res, copy_variable (closure, t->variable), t->coefficient);
+    }
 
-  if (solver->freeze_count == 0)
-    solver->auto_solve = true;
+  return res;
 }
 
-static char *
-simplex_solver_to_string (SimplexSolver *solver)
+static VariableSet *
+copy_variable_set (CopyClosure *closure,
+                   VariableSet *set)
 {
-  GString *buf = g_string_new (NULL);
+  VariableSet *res = variable_set_new ();
+  GList *l;
 
-  g_string_append (buf, "Tableau info:\n");
-  g_string_append_printf (buf, "Rows: %d (= %d constraints)\n",
-                          g_hash_table_size (solver->rows),
-                          g_hash_table_size (solver->rows) - 1);
-  g_string_append_printf (buf, "Columns: %d\n",
-                          g_hash_table_size (solver->columns));
-  g_string_append_printf (buf, "Infeasible rows: %d\n",
-                          solver->infeasible_rows->len);
-  g_string_append_printf (buf, "External basic variables: %d\n",
-                          g_hash_table_size (solver->external_rows));
-  g_string_append_printf (buf, "External parametric variables: %d\n",
-                          g_hash_table_size (solver->external_parametric_vars));
+  for (l = set->ordered_set; l != NULL; l = l->next)
+    variable_set_add_variable (res, copy_variable (closure, l->data));
 
-  g_string_append (buf, "Stay error vars:");
+  return res;
+}
+
+static Constraint *
+copy_constraint (CopyClosure *closure,
+                 Constraint *constraint)
+{
+  Constraint *res = g_slice_new0 (Constraint);
+
+  res->solver = closure->copy;
+  res->expression = copy_expression (closure, constraint->expression);
+  res->op_type = constraint->op_type;
+  res->strength = constraint->strength;
+  res->is_edit = constraint->is_edit;
+  res->is_stay = constraint->is_stay;
+
+  if (constraint->variable != NULL)
+    res->variable = variable_ref (copy_variable (closure, constraint->variable));
+
+  g_hash_table_insert (closure->constraints, constraint, res);
+
+  return res;
+}
+
+/* Copies the state of @solver into @copy, which must not be initialized.
+ *
+ * Every variable, expression, and constraint in the tableau of @solver
+ * is duplicated, so the two solvers do not share any data, and can be
+ * modified independently; for instance, a copy can be used to measure a
+ * layout speculatively, or from a different thread, without disturbing
+ * the solution of the original solver.
+ *
+ * An open transaction on @solver is not copied.
+ *
+ * Returns a HashTable<Variable, Variable> mapping the variables of @solver
+ * to their copies; the table owns a reference on the copies, and should
+ * be freed with g_hash_table_unref(). Variables that are not part of the
+ * tableau of @solver do not have a copy.
+ */
+GHashTable *
+simplex_solver_copy (SimplexSolver *solver,
+                     SimplexSolver *copy)
+{
+  CopyClosure closure;
+  GHashTableIter iter;
+  gpointer key_p, value_p;
+
+  if (!solver->initialized)
+    {
+      g_critical ("SimplexSolver %p is not initialized.", solver);
+      return NULL;
+    }
+
+  if (copy->initialized)
+    {
+      g_critical ("The SimplexSolver %p has already been initialized", copy);
+      return NULL;
+    }
+
+  simplex_solver_init (copy);
+
+#ifdef EMEUS_ENABLE_DEBUG
+  gint64 start_time = g_get_monotonic_time ();
+#endif
+
+  closure.copy = copy;
+  closure.variables = g_hash_table_new_full (NULL, NULL, NULL, (GDestroyNotify) variable_unref);
+  closure.constraints = g_hash_table_new (NULL, NULL);
+
+  /* Replace the objective row created by simplex_solver_init() */
+  g_hash_table_remove_all (copy->rows);
+  copy->objective = copy_variable (&closure, solver->objective);
+
+  g_hash_table_iter_init (&iter, solver->constraints);
+  while (g_hash_table_iter_next (&iter, &key_p, NULL))
+    g_hash_table_add (copy->constraints, copy_constraint (&closure, key_p));
+
+  g_hash_table_iter_init (&iter, solver->rows);
+  while (g_hash_table_iter_next (&iter, &key_p, &value_p))
+    g_hash_table_insert (copy->rows,
+                         variable_ref (copy_variable (&closure, key_p)),
+                         copy_expression (&closure, value_p));
+
+  g_hash_table_iter_init (&iter, solver->columns);
+  while (g_hash_table_iter_next (&iter, &key_p, &value_p))
+    g_hash_table_insert (copy->columns,
+                         variable_ref (copy_variable (&closure, key_p)),
+                         copy_variable_set (&closure, value_p));
+
+  g_hash_table_iter_init (&iter, solver->external_rows);
+  while (g_hash_table_iter_next (&iter, &key_p, NULL))
+    g_hash_table_add (copy->external_rows, variable_ref (copy_variable (&closure, key_p)));
+
+  g_hash_table_iter_init (&iter, solver->external_parametric_vars);
+  while (g_hash_table_iter_next (&iter, &key_p, NULL))
+    g_hash_table_add (copy->external_parametric_vars, variable_ref (copy_variable (&closure, key_p)));
+
+  for (int i = 0; i < solver->infeasible_rows->len; i++)
+    g_ptr_array_add (copy->infeasible_rows,
+                     copy_variable (&closure, g_ptr_array_index (solver->infeasible_rows, i)));
+
+  for (int i = 0; i < solver->stay_error_vars->len; i++)
+    {
+      VariablePair *pair = g_ptr_array_index (solver->stay_error_vars, i);
+
+      g_ptr_array_add (copy->stay_error_vars,
+                       variable_pair_new (copy_variable (&closure, pair->first),
+                                          copy_variable (&closure, pair->second)));
+    }
+
+  g_hash_table_iter_init (&iter, solver->error_vars);
+  while (g_hash_table_iter_next (&iter, &key_p, &value_p))
+    g_hash_table_insert (copy->error_vars,
+                         g_hash_table_lookup (closure.constraints, key_p),
+                         copy_variable_set (&closure, value_p));
+
+  g_hash_table_iter_init (&iter, solver->marker_vars);
+  while (g_hash_table_iter_next (&iter, &key_p, &value_p))
+    g_hash_table_insert (copy->marker_vars,
+                         g_hash_table_lookup (closure.constraints, key_p),
+                         copy_variable (&closure, value_p));
+
+  g_hash_table_iter_init (&iter, solver->edit_var_map);
+  while (g_hash_table_iter_next (&iter, &key_p, &value_p))
+    {
+      EditInfo *ei = value_p;
+      EditInfo *res = g_slice_new (EditInfo);
+
+      res->constraint = g_hash_table_lookup (closure.constraints, ei->constraint);
+      res->eplus = copy_variable (&closure, ei->eplus);
+      res->eminus = copy_variable (&closure, ei->eminus);
+      res->prev_constant = ei->prev_constant;
+      res->pending_value = ei->pending_value;
+      res->has_pending = ei->has_pending;
+
+      g_hash_table_insert (copy->edit_var_map, copy_variable (&closure, key_p), res);
+    }
+
+  g_hash_table_iter_init (&iter, solver->stay_var_map);
+  while (g_hash_table_iter_next (&iter, &key_p, &value_p))
+    {
+      StayInfo *si = value_p;
+      StayInfo *res = g_slice_new (StayInfo);
+
+      res->constraint = g_hash_table_lookup (closure.constraints, si->constraint);
+
+      g_hash_table_insert (copy->stay_var_map, copy_variable (&closure, key_p), res);
+    }
+
+  g_hash_table_iter_init (&iter, solver->aliases);
+  while (g_hash_table_iter_next (&iter, &key_p, &value_p))
+    {
+      Alias *alias = value_p;
+      Alias *res = g_slice_new (Alias);
+      Variable *variable = copy_variable (&closure, key_p);
+
+      res->constraint = g_hash_table_lookup (closure.constraints, alias->constraint);
+      res->expression = copy_expression (&closure, alias->expression);
+
+      g_hash_table_insert (copy->aliases, variable_ref (variable), res);
+      g_hash_table_insert (copy->alias_constraints, res->constraint, variable);
+    }
+
+  g_hash_table_iter_init (&iter, solver->bound_constraints);
+  while (g_hash_table_iter_next (&iter, &key_p, &value_p))
+    {
+      g_hash_table_insert (copy->bound_constraints,
+                           g_hash_table_lookup (closure.constraints, key_p),
+                           copy_variable (&closure, value_p));
+    }
+
+  copy->slack_counter = solver->slack_counter;
+  copy->artificial_counter = solver->artificial_counter;
+  copy->dummy_counter = solver->dummy_counter;
+  copy->optimize_count = solver->optimize_count;
+  copy->generation = solver->generation;
+  copy->max_iterations = solver->max_iterations;
+  copy->max_degenerate_pivots = solver->max_degenerate_pivots;
+  copy->bland_pivot_count = solver->bland_pivot_count;
+  copy->auto_solve = solver->auto_solve;
+  copy->needs_solving = solver->needs_solving;
+
+  g_hash_table_unref (closure.constraints);
+
+#ifdef EMEUS_ENABLE_DEBUG
+  g_debug ("copy.time := %.3f ms (rows:%d, columns:%d)",
+           (float) (g_get_monotonic_time () - start_time) / 1000.f,
+           g_hash_table_size (copy->rows),
+           g_hash_table_size (copy->columns));
+#endif
+
+  return closure.variables;
+}
+
+static void simplex_solver_delta_edit_constant (SimplexSolver *solver,
+                                                double delta,
+                                                Variable *plus_error_var,
+                                                Variable *minus_error_var);
+
+static bool
+simplex_solver_apply_pending_edits (SimplexSolver *solver)
+{
+  GHashTableIter iter;
+  gpointer value_p;
+  bool res = false;
+
+  g_hash_table_iter_init (&iter, solver->edit_var_map);
+  while (g_hash_table_iter_next (&iter, NULL, &value_p))
+    {
+      EditInfo *ei = value_p;
+      double delta;
+
+      if (!ei->has_pending)
+        continue;
+
+      delta = ei->pending_value - ei->prev_constant;
+
+      ei->prev_constant = ei->pending_value;
+      ei->has_pending = false;
+
+      simplex_solver_delta_edit_constant (solver, delta, ei->eplus, ei->eminus);
+
+      res = true;
+    }
+
+  return res;
+}
+
+void
+simplex_solver_freeze (SimplexSolver *solver)
+{
+  solver->freeze_count += 1;
+
+  if (solver->freeze_count > 0)
+    solver->auto_solve = false;
+}
+
+void
+simplex_solver_thaw (SimplexSolver *solver)
+{
+  if (solver->freeze_count == 0)
+    {
+      g_critical ("Unbalanced thaw; did you forger to call simplex_solver_freeze()?");
+      return;
+    }
+
+  solver->freeze_count -= 1;
+
+  if (solver->freeze_count > 0)
+    return;
+
+  solver->auto_solve = true;
+
+  /* Constraints added or removed while the solver was frozen have
+   * been inserted in the tableau, but the objective function has not
+   * been optimized yet; we do it once here, instead of once for each
+   * change.
+   */
+  if (solver->needs_solving)
+    {
+      simplex_solver_optimize (solver, solver->objective);
+      simplex_solver_set_external_variables (solver);
+    }
+
+  /* The values suggested while the solver was frozen are applied to
+   * the optimized tableau, and resolved at once
+   */
+  if (simplex_solver_apply_pending_edits (solver) || solver->infeasible_rows->len > 0)
+    simplex_solver_resolve (solver);
+}
+
+static char *
+simplex_solver_to_string (SimplexSolver *solver)
+{
+  GString *buf = g_string_new (NULL);
+
+  g_string_append (buf, "Tableau info:\n");
+  g_string_append_printf (buf, "Rows: %d (= %d constraints)\n",
+                          g_hash_table_size (solver->rows),
+                          g_hash_table_size (solver->rows) - 1);
+  g_string_append_printf (buf, "Columns: %d\n",
+                          g_hash_table_size (solver->columns));
+  g_string_append_printf (buf, "Infeasible rows: %d\n",
+                          solver->infeasible_rows->len);
+  g_string_append_printf (buf, "External basic variables: %d\n",
+                          g_hash_table_size (solver->external_rows));
+  g_string_append_printf (buf, "External parametric variables: %d\n",
+                          g_hash_table_size (solver->external_parametric_vars));
+
+  g_string_append (buf, "Stay error vars:");
   if (solver->stay_error_vars->len == 0)
     g_string_append (buf, " <empty>\n");
   else
@@ -471,1041 +1350,2128 @@ simplex_solver_to_string (SimplexSolver *solver)
       GHashTableIter iter;
       gpointer key_p, value_p;
 
-      g_string_append (buf, "\n");
+      g_string_append (buf, "\n");
+
+      g_hash_table_iter_init (&iter, solver->edit_var_map);
+      while (g_hash_table_iter_next (&iter, &key_p, &value_p))
+        {
+          char *var = variable_to_string (key_p);
+          const EditInfo *ei = value_p;
+          char *c = constraint_to_string (ei->constraint);
+
+          g_string_append_printf (buf, "  %s => %s\n", var, c);
+
+          g_free (var);
+          g_free (c);
+        }
+    }
+
+  return g_string_free (buf, FALSE);
+}
+
+static VariableSet *
+simplex_solver_get_column_set (SimplexSolver *solver,
+                               Variable *param_var)
+{
+  if (!solver->initialized)
+    return NULL;
+
+  return g_hash_table_lookup (solver->columns, param_var);
+}
+
+/* The number of rows in which @variable appears; pivoting on it touches
+ * every one of them
+ */
+static guint
+simplex_solver_get_column_size (SimplexSolver *solver,
+                                Variable *variable)
+{
+  VariableSet *set = simplex_solver_get_column_set (solver, variable);
+
+  return set != NULL ? variable_set_get_size (set) : 0;
+}
+
+static bool
+simplex_solver_column_has_key (SimplexSolver *solver,
+                               Variable *subject)
+{
+  if (!solver->initialized)
+    return false;
+
+  return g_hash_table_contains (solver->columns, subject);
+}
+
+static void
+simplex_solver_insert_column_variable (SimplexSolver *solver,
+                                       Variable *param_var,
+                                       Variable *row_var)
+{
+  if (!solver->initialized)
+    return;
+
+  VariableSet *cset = simplex_solver_get_column_set (solver, param_var);
+  if (cset == NULL)
+    {
+      cset = variable_set_new ();
+      simplex_solver_table_insert (solver, solver->columns, variable_ref (param_var), cset);
+    }
+
+  if (row_var != NULL)
+    simplex_solver_variable_set_add (solver, cset, row_var);
+}
+
+static void
+simplex_solver_insert_error_variable (SimplexSolver *solver,
+                                      Constraint *constraint,
+                                      Variable *variable)
+{
+  if (!solver->initialized)
+    return;
+
+  VariableSet *cset = g_hash_table_lookup (solver->error_vars, constraint);
+  if (cset == NULL)
+    {
+      cset = variable_set_new ();
+      simplex_solver_table_insert (solver, solver->error_vars, constraint, cset);
+    }
+
+  simplex_solver_variable_set_add (solver, cset, variable);
+}
+
+static void
+simplex_solver_reset_stay_constants (SimplexSolver *solver)
+{
+  for (int i = 0; i < solver->stay_error_vars->len; i++)
+    {
+      VariablePair *pair = g_ptr_array_index (solver->stay_error_vars, i);
+      Expression *expression;
+
+      expression = g_hash_table_lookup (solver->rows, pair->first);
+      if (expression == NULL)
+        expression = g_hash_table_lookup (solver->rows, pair->second);
+
+      if (expression != NULL)
+        expression_set_constant (expression, 0.0);
+    }
+}
+
+static void
+simplex_solver_set_external_variables (SimplexSolver *solver)
+{
+  GHashTableIter iter;
+  gpointer key_p, value_p;
+
+  g_hash_table_iter_init (&iter, solver->external_parametric_vars);
+  while (g_hash_table_iter_next (&iter, &key_p, NULL))
+    {
+      Variable *variable = key_p;
+
+      if (g_hash_table_contains (solver->rows, variable))
+        continue;
+
+      variable_set_value (variable, 0.0);
+    }
+
+  g_hash_table_iter_init (&iter, solver->external_rows);
+  while (g_hash_table_iter_next (&iter, &key_p, NULL))
+    {
+      Variable *variable = key_p;
+      Expression *expression;
+
+      expression = g_hash_table_lookup (solver->rows, variable);
+
+      variable_set_value (variable, expression_get_constant (expression));
+    }
+
+  /* The aliased variables are not part of the tableau, so we compute
+   * their value from the variables they are replaced with
+   */
+  g_hash_table_iter_init (&iter, solver->aliases);
+  while (g_hash_table_iter_next (&iter, &key_p, &value_p))
+    {
+      Alias *alias = value_p;
+
+      variable_set_value (key_p, expression_get_value (alias->expression));
+    }
+
+  solver->needs_solving = false;
+}
+
+typedef struct {
+  SimplexSolver *solver;
+  Variable *subject;
+} ForeachClosure;
+
+static bool
+insert_expression_columns (Term *term,
+                           gpointer data_)
+{
+  Variable *variable = term_get_variable (term);
+  ForeachClosure *data = data_;
+
+  simplex_solver_insert_column_variable (data->solver,
+                                         variable,
+                                         data->subject);
+
+  if (variable_is_external (variable))
+    simplex_solver_table_add (data->solver, data->solver->external_parametric_vars, variable_ref (variable));
+
+  return true;
+}
+
+static void
+simplex_solver_add_row (SimplexSolver *solver,
+                        Variable *variable,
+                        Expression *expression)
+{
+  if (!solver->initialized)
+    return;
+
+  simplex_solver_table_insert (solver, solver->rows, variable_ref (variable), expression_ref (expression));
+
+  ForeachClosure data = {
+    .subject = variable,
+    .solver = solver,
+  };
+
+  expression_terms_foreach (expression,
+                            insert_expression_columns,
+                            &data);
+
+  if (variable_is_external (variable))
+    simplex_solver_table_add (solver, solver->external_rows, variable_ref (variable));
+}
+
+static void
+simplex_solver_remove_column (SimplexSolver *solver,
+                              Variable *variable)
+{
+  VariableSet *set = g_hash_table_lookup (solver->columns, variable);
+
+  variable_ref (variable);
+
+  if (set == NULL)
+    goto out;
+
+  VariableSetIter iter;
+  Variable *v;
+
+  variable_set_iter_init (set, &iter);
+  while (variable_set_iter_next (&iter, &v))
+    {
+      Expression *e = g_hash_table_lookup (solver->rows, v);
+
+      expression_remove_variable (e, variable, NULL);
+    }
+
+  simplex_solver_table_remove (solver, solver->columns, variable);
+
+out:
+  if (variable_is_external (variable))
+    {
+      simplex_solver_table_remove (solver, solver->external_rows, variable);
+      simplex_solver_table_remove (solver, solver->external_parametric_vars, variable);
+    }
+
+  variable_unref (variable);
+}
+
+static bool
+remove_expression_columns (Term *term,
+                           gpointer data_)
+{
+  ForeachClosure *data = data_;
+  VariableSet *set = g_hash_table_lookup (data->solver->columns, term_get_variable (term));
+
+  if (set != NULL)
+    simplex_solver_variable_set_remove (data->solver, set, data->subject);
+
+  return true;
+}
+
+static Expression *
+simplex_solver_remove_row (SimplexSolver *solver,
+                           Variable *variable,
+                           gboolean free_res)
+{
+  if (!solver->initialized)
+    return NULL;
+
+  Expression *e = g_hash_table_lookup (solver->rows, variable);
+  g_assert (e != NULL);
+
+  expression_ref (e);
+
+  ForeachClosure data = {
+    .solver = solver,
+    .subject = variable,
+  };
+
+  expression_terms_foreach (e,
+                            remove_expression_columns,
+                            &data);
+
+  g_ptr_array_remove (solver->infeasible_rows, variable);
+
+  if (variable_is_external (variable))
+    simplex_solver_table_remove (solver, solver->external_rows, variable);
+
+  simplex_solver_table_remove (solver, solver->rows, variable);
+
+  if (free_res)
+    {
+      expression_unref (e);
+      return NULL;
+    }
+
+  return e;
+}
+
+static void
+simplex_solver_substitute_out (SimplexSolver *solver,
+                               Variable *old_variable,
+                               Expression *expression)
+{
+  if (!solver->initialized)
+    return;
+
+  VariableSet *set = g_hash_table_lookup (solver->columns, old_variable);
+  if (set != NULL)
+    {
+      VariableSetIter iter;
+      Variable *v;
+
+      variable_set_iter_init (set, &iter);
+      while (variable_set_iter_next (&iter, &v))
+        {
+          Expression *row = g_hash_table_lookup (solver->rows, v);
+
+          expression_substitute_out (row, old_variable, expression, v);
+
+          if (variable_is_restricted (v) && expression_get_constant (row) < 0)
+            {
+              /* The ratio tests allow a pivot to leave a constant slightly
+               * negative, within the feasibility tolerance; we clamp those
+               * instead of repairing them with the dual simplex
+               */
+              if (expression_get_constant (row) > -FEASIBILITY_TOLERANCE)
+                expression_set_constant (row, 0.0);
+              else
+                g_ptr_array_add (solver->infeasible_rows, v);
+            }
+        }
+    }
+
+  if (variable_is_external (old_variable))
+    {
+      simplex_solver_table_add (solver, solver->external_rows, variable_ref (old_variable));
+      simplex_solver_table_remove (solver, solver->external_parametric_vars, old_variable);
+    }
+
+  simplex_solver_table_remove (solver, solver->columns, old_variable);
+}
+
+static void
+simplex_solver_pivot (SimplexSolver *solver,
+                      Variable *entry_var,
+                      Variable *exit_var)
+{
+  if (!solver->initialized)
+    return;
+
+  if (entry_var == NULL)
+    g_critical ("INTERNAL: No entry variable for pivot");
+  else
+    variable_ref (entry_var);
+
+  if (exit_var == NULL)
+    g_critical ("INTERNAL: No exit variable for pivot");
+  else
+    variable_ref (exit_var);
+
+  Expression *expr = simplex_solver_remove_row (solver, exit_var, FALSE);
+  expression_change_subject (expr, exit_var, entry_var);
+
+  simplex_solver_substitute_out (solver, entry_var, expr);
+  simplex_solver_add_row (solver, entry_var, expr);
+
+  variable_unref (entry_var);
+  variable_unref (exit_var);
+  expression_unref (expr);
+}
+
+/* Without degeneracy, the simplex method converges in a number of pivots
+ * that is a small multiple of the size of the tableau; we use a generous
+ * bound on that, unless the solver has an explicit one
+ */
+static guint
+simplex_solver_get_max_iterations (SimplexSolver *solver)
+{
+  if (solver->max_iterations > 0)
+    return solver->max_iterations;
+
+  return 1000 + 10 * (g_hash_table_size (solver->rows) + g_hash_table_size (solver->columns));
+}
+
+static guint
+simplex_solver_get_max_degenerate_pivots (SimplexSolver *solver)
+{
+  if (solver->max_degenerate_pivots > 0)
+    return solver->max_degenerate_pivots;
+
+  return MAX_DEGENERATE_PIVOTS;
+}
+
+static void
+simplex_solver_report_max_iterations (SimplexSolver *solver,
+                                      const char *phase,
+                                      guint n_iterations,
+                                      guint n_degenerate)
+{
+  g_warning ("SimplexSolver %p: %s stopped after %u pivots "
+             "(%u degenerate) without converging; the solution may "
+             "not be optimal (rows:%u, columns:%u, infeasible:%u)",
+             solver, phase,
+             n_iterations,
+             n_degenerate,
+             g_hash_table_size (solver->rows),
+             g_hash_table_size (solver->columns),
+             solver->infeasible_rows->len);
+}
+
+/* Picks the variable entering the basis when optimizing @z_row: either
+ * the first one that improves the objective, or, when using Bland's rule,
+ * the one with the lowest index
+ */
+static Variable *
+simplex_solver_choose_entry (Expression *z_row,
+                             bool use_bland)
+{
+  Variable *res = NULL;
+  GList *l;
+
+  for (l = g_list_last (z_row->ordered_terms); l != NULL; l = l->prev)
+    {
+      const Term *t = l->data;
+
+      if (!variable_is_pivotable (t->variable) || t->coefficient >= -OPTIMALITY_TOLERANCE)
+        continue;
+
+      if (!use_bland)
+        return t->variable;
+
+      if (res == NULL || t->variable->id_ < res->id_)
+        res = t->variable;
+    }
+
+  return res;
+}
+
+/* Harris' two pass ratio test: the first pass finds the largest step
+ * that keeps every row feasible within the tolerance, and the second
+ * pass picks, among the rows that limit the step to that bound, the one
+ * with the largest pivot element, which keeps the tableau numerically
+ * stable; when using Bland's rule, ties are broken by the lowest index
+ * instead, which guarantees that the solver cannot cycle
+ *
+ * Pivoting adds the terms of the exit row to every other row in the
+ * column of @entry, so among pivot elements of the same size we pick
+ * the shortest row, which keeps the fill-in of the tableau down
+ */
+static Variable *
+simplex_solver_choose_exit (SimplexSolver *solver,
+                            Variable *entry,
+                            bool use_bland,
+                            double *ratio_p)
+{
+  VariableSet *column_vars = simplex_solver_get_column_set (solver, entry);
+  VariableSetIter iter;
+  Variable *v, *res = NULL;
+  double bound = DBL_MAX;
+  double max_coeff = 0.0;
+  guint res_n_terms = 0;
+
+  variable_set_iter_init (column_vars, &iter);
+  while (variable_set_iter_next (&iter, &v))
+    {
+      if (variable_is_pivotable (v))
+        {
+          Expression *expr = g_hash_table_lookup (solver->rows, v);
+          double coeff = expression_get_coefficient (expr, entry);
+
+          if (coeff < -PIVOT_TOLERANCE)
+            bound = MIN (bound, (expression_get_constant (expr) + FEASIBILITY_TOLERANCE) / -coeff);
+        }
+    }
+
+  if (bound == DBL_MAX)
+    return NULL;
+
+  variable_set_iter_init (column_vars, &iter);
+  while (variable_set_iter_next (&iter, &v))
+    {
+      if (variable_is_pivotable (v))
+        {
+          Expression *expr = g_hash_table_lookup (solver->rows, v);
+          double coeff = expression_get_coefficient (expr, entry);
+          double r;
+          bool better;
+
+          if (coeff >= -PIVOT_TOLERANCE)
+            continue;
+
+          r = expression_get_constant (expr) / -coeff;
+          if (r > bound)
+            continue;
+
+          if (use_bland)
+            better = res == NULL || v->id_ < res->id_;
+          else if (-coeff > max_coeff + PIVOT_TOLERANCE)
+            better = true;
+          else if (-coeff > max_coeff - PIVOT_TOLERANCE)
+            better = expression_get_n_terms (expr) < res_n_terms;
+          else
+            better = false;
+
+          if (better)
+            {
+              res = v;
+              res_n_terms = expression_get_n_terms (expr);
+              max_coeff = -coeff;
+              *ratio_p = r;
+            }
+        }
+    }
+
+  return res;
+}
+
+static void
+simplex_solver_optimize (SimplexSolver *solver,
+                         Variable *z)
+{
+  if (!solver->initialized)
+    return;
+
+  Expression *z_row = g_hash_table_lookup (solver->rows, z);
+  g_assert (z_row != NULL);
+
+  guint max_iterations = simplex_solver_get_max_iterations (solver);
+  guint max_stalled = simplex_solver_get_max_degenerate_pivots (solver);
+  guint n_iterations = 0, n_degenerate = 0, n_stalled = 0;
+  bool use_bland = false;
+
+  solver->optimize_count += 1;
+
+#ifdef EMEUS_ENABLE_DEBUG
+  gint64 start_time = g_get_monotonic_time ();
+#endif
+
+#ifdef EMEUS_ENABLE_DEBUG
+  {
+    char *str;
+
+    str = variable_to_string (z);
+    g_debug ("optimize: %s\n", str);
+    g_free (str);
+
+    str = simplex_solver_to_string (solver);
+    g_debug ("%s", str);
+    g_free (str);
+  }
+#endif
+
+  while (true)
+    {
+      Variable *entry, *exit;
+      double ratio = 0.0;
+
+      entry = simplex_solver_choose_entry (z_row, use_bland);
+      if (entry == NULL)
+        break;
+
+      if (n_iterations == max_iterations)
+        {
+          simplex_solver_report_max_iterations (solver, "optimize", n_iterations, n_degenerate);
+          break;
+        }
+
+      exit = simplex_solver_choose_exit (solver, entry, use_bland, &ratio);
+      if (exit == NULL)
+        {
+          g_debug ("Unbounded objective variable during optimization");
+          break;
+        }
+
+      /* A degenerate pivot changes the basis without moving the solution;
+       * long runs of them are how the simplex method cycles
+       */
+      if (ratio <= FEASIBILITY_TOLERANCE)
+        {
+          n_degenerate += 1;
+          n_stalled += 1;
+
+          if (n_stalled == max_stalled)
+            use_bland = true;
+        }
+      else
+        {
+          n_stalled = 0;
+          use_bland = false;
+        }
+
+      if (use_bland)
+        solver->bland_pivot_count += 1;
+
+      simplex_solver_pivot (solver, entry, exit);
+
+      n_iterations += 1;
+
+#ifdef EMEUS_ENABLE_DEBUG
+      {
+        char *str = simplex_solver_to_string (solver);
+        g_debug ("%s", str);
+        g_free (str);
+      }
+#endif
+    }
+
+#ifdef EMEUS_ENABLE_DEBUG
+  g_debug ("optimize.time := %.3f ms (pass:%d, pivots:%u, degenerate:%u)",
+           (float) (g_get_monotonic_time () - start_time) / 1000.f,
+           solver->optimize_count,
+           n_iterations,
+           n_degenerate);
+#endif
+}
+
+typedef struct {
+  SimplexSolver *solver;
+  Expression *expr;
+  double multiplier;
+  bool replace_rows;
+} ReplaceClosure;
+
+static bool
+replace_terms (Term *term,
+               gpointer data_)
+{
+  ReplaceClosure *data = data_;
+  Variable *v = term_get_variable (term);
+  double c = term_get_coefficient (term) * data->multiplier;
+  Alias *alias;
+  Expression *e;
+
+  alias = g_hash_table_lookup (data->solver->aliases, v);
+  if (alias != NULL)
+    {
+      ReplaceClosure alias_data = *data;
+
+      /* The expression of an alias does not contain other aliases,
+       * so we only recurse once
+       */
+      alias_data.multiplier = c;
+      expression_set_constant (data->expr,
+                               expression_get_constant (data->expr)
+                               + c * expression_get_constant (alias->expression));
+      expression_terms_foreach (alias->expression, replace_terms, &alias_data);
+
+      return true;
+    }
+
+  if (data->replace_rows)
+    e = g_hash_table_lookup (data->solver->rows, v);
+  else
+    e = NULL;
+
+  if (e == NULL)
+    expression_add_variable (data->expr, v, c, NULL);
+  else
+    expression_add_expression (data->expr, e, c, NULL);
+
+  return true;
+}
+
+static Expression *
+simplex_solver_new_expression (SimplexSolver *solver,
+                               Constraint *constraint,
+                               Variable **eplus_p,
+                               Variable **eminus_p,
+                               double *prev_constant_p)
+{
+  Expression *cn_expr = constraint->expression;
+  Expression *expr;
+  Variable *slack_var, *dummy_var;
+  Variable *eplus, *eminus;
+  ReplaceClosure data;
+
+  if (eplus_p != NULL)
+    *eplus_p = NULL;
+  if (eminus_p != NULL)
+    *eminus_p = NULL;
+  if (prev_constant_p != NULL)
+    *prev_constant_p = 0.0;
+
+  expr = expression_new (solver, expression_get_constant (cn_expr));
+
+  data.solver = solver;
+  data.expr = expr;
+  data.multiplier = 1.0;
+  data.replace_rows = true;
+  expression_terms_foreach (cn_expr, replace_terms, &data);
+
+  if (constraint_is_inequality (constraint))
+    {
+      /* If the constraint is an inequality, we add a slack variable to
+       * turn it into an equality, e.g. from
+       *
+       *   expr >= 0
+       *
+       * to
+       *
+       *   expr - slack = 0
+       *
+       * Additionally, if the constraint is not required we add an
+       * error variable:
+       *
+       *   expr - slack + error = 0
+       */
+      solver->slack_counter += 1;
+
+      slack_var = variable_new (solver, VARIABLE_SLACK);
+      variable_set_prefix (slack_var, "s");
+      expression_set_variable (expr, slack_var, -1.0);
+      variable_unref (slack_var);
+
+      simplex_solver_table_insert (solver, solver->marker_vars, constraint, slack_var);
+
+      if (!constraint_is_required (constraint))
+        {
+          Expression *z_row;
+
+          solver->slack_counter += 1;
+
+          eminus = variable_new (solver, VARIABLE_SLACK);
+          variable_set_name (eminus, "em");
+          expression_set_variable (expr, eminus, 1.0);
+          variable_unref (eminus);
+
+          z_row = g_hash_table_lookup (solver->rows, solver->objective);
+          expression_set_variable (z_row, eminus, constraint->strength);
+
+          simplex_solver_insert_error_variable (solver, constraint, eminus);
+          simplex_solver_note_added_variable (solver, eminus, solver->objective);
+        }
+    }
+  else 
+    {
+      if (constraint_is_required (constraint))
+        {
+          /* If the constraint is required, we use a dummy marker variable;
+           * the dummy won't be allowed to enter the basis of the tableau
+           * when pivoting.
+           */
+          solver->dummy_counter += 1;
+
+          dummy_var = variable_new (solver, VARIABLE_DUMMY);
+
+          if (eplus_p != NULL)
+            *eplus_p = dummy_var;
+          if (eminus_p != NULL)
+            *eminus_p = dummy_var;
+          if (prev_constant_p != NULL)
+            *prev_constant_p = expression_get_constant (cn_expr);
+
+          expression_set_variable (expr, dummy_var, 1.0);
+          simplex_solver_table_insert (solver, solver->marker_vars, constraint, dummy_var);
+
+          variable_unref (dummy_var);
+        }
+      else
+        {
+          Expression *z_row;
+
+          /* Since the constraint is a non-required equality, we need to
+           * add error variables around it, i.e. turn it from:
+           *
+           *   expr = 0
+           *
+           * to:
+           *
+           *   expr - eplus + eminus = 0
+           */
+          solver->slack_counter += 1;
+
+          eplus = variable_new (solver, VARIABLE_SLACK);
+          variable_set_name (eplus, "ep");
+          eminus = variable_new (solver, VARIABLE_SLACK);
+          variable_set_name (eminus, "em");
+
+          expression_set_variable (expr, eplus, -1.0);
+          expression_set_variable (expr, eminus, 1.0);
+
+          simplex_solver_table_insert (solver, solver->marker_vars, constraint, eplus);
+
+          z_row = g_hash_table_lookup (solver->rows, solver->objective);
+
+          expression_set_variable (z_row, eplus, constraint->strength);
+          expression_set_variable (z_row, eminus, constraint->strength);
+          simplex_solver_note_added_variable (solver, eplus, solver->objective);
+          simplex_solver_note_added_variable (solver, eminus, solver->objective);
+
+          simplex_solver_insert_error_variable (solver, constraint, eplus);
+          simplex_solver_insert_error_variable (solver, constraint, eminus);
+
+          if (constraint_is_stay (constraint))
+            {
+              g_ptr_array_add (solver->stay_error_vars, variable_pair_new (eplus, eminus));
+
+              if (solver->journal != NULL)
+                simplex_solver_journal_push (solver, JOURNAL_STAY_ERROR_APPEND, NULL, NULL, NULL, 0.0);
+            }
+          else if (constraint_is_edit (constraint))
+            {
+              if (eplus_p != NULL)
+                *eplus_p = eplus;
+              if (eminus_p != NULL)
+                *eminus_p = eminus;
+              if (prev_constant_p != NULL)
+                *prev_constant_p = expression_get_constant (cn_expr);
+            }
+
+          variable_unref (eplus);
+          variable_unref (eminus);
+        }
+    }
+
+  if (expression_get_constant (expr) < 0.0)
+    expression_times (expr, -1.0);
+
+  return expr;
+}
+
+/* Removes the next infeasible row to repair; when using Bland's rule,
+ * that's the one with the lowest index
+ */
+static Variable *
+simplex_solver_pop_infeasible_row (SimplexSolver *solver,
+                                   bool use_bland)
+{
+  GPtrArray *rows = solver->infeasible_rows;
+  guint index = rows->len - 1;
+  Variable *res;
+
+  if (use_bland)
+    {
+      for (guint i = 0; i < rows->len - 1; i++)
+        {
+          Variable *v = g_ptr_array_index (rows, i);
+
+          if (v->id_ < ((Variable *) g_ptr_array_index (rows, index))->id_)
+            index = i;
+        }
+    }
+
+  res = g_ptr_array_index (rows, index);
+  g_ptr_array_remove_index (rows, index);
+
+  return res;
+}
+
+/* The dual counterpart of simplex_solver_choose_exit(): the ratio test is
+ * done on the objective row, to keep the tableau optimal while the
+ * infeasible @expr is repaired
+ */
+static Variable *
+simplex_solver_choose_dual_entry (SimplexSolver *solver,
+                                  Expression *expr,
+                                  bool use_bland,
+                                  double *ratio_p)
+{
+  Expression *z_row = g_hash_table_lookup (solver->rows, solver->objective);
+  Variable *res = NULL;
+  double bound = DBL_MAX;
+  double max_coeff = 0.0;
+  GList *l;
+
+  for (l = g_list_last (expr->ordered_terms); l != NULL; l = l->prev)
+    {
+      Term *term = l->data;
+      Variable *v = term_get_variable (term);
+      double cd = term_get_coefficient (term);
+
+      if (cd > PIVOT_TOLERANCE && variable_is_pivotable (v))
+        {
+          double zc = expression_get_coefficient (z_row, v);
+
+          bound = MIN (bound, (zc + OPTIMALITY_TOLERANCE) / cd);
+        }
+    }
+
+  if (bound == DBL_MAX)
+    return NULL;
+
+  for (l = g_list_last (expr->ordered_terms); l != NULL; l = l->prev)
+    {
+      Term *term = l->data;
+      Variable *v = term_get_variable (term);
+      double cd = term_get_coefficient (term);
+      double r;
+
+      if (cd <= PIVOT_TOLERANCE || !variable_is_pivotable (v))
+        continue;
+
+      r = expression_get_coefficient (z_row, v) / cd;
+      if (r > bound)
+        continue;
+
+      if (use_bland
+          ? (res == NULL || v->id_ < res->id_)
+          : (cd > max_coeff))
+        {
+          res = v;
+          max_coeff = cd;
+          *ratio_p = r;
+        }
+    }
+
+  return res;
+}
+
+/* Repairs the infeasible rows using the dual simplex method; returns
+ * false if the pass stopped at the maximum number of pivots, in which
+ * case the rows that were not repaired are still queued
+ */
+static bool
+simplex_solver_dual_optimize (SimplexSolver *solver)
+{
+  guint max_iterations = simplex_solver_get_max_iterations (solver);
+  guint max_stalled = simplex_solver_get_max_degenerate_pivots (solver);
+  guint n_iterations = 0, n_degenerate = 0, n_stalled = 0;
+  bool use_bland = false;
+  bool converged = true;
+
+#ifdef EMEUS_ENABLE_DEBUG
+  gint64 start_time = g_get_monotonic_time ();
+#endif
+
+  /* We iterate until we don't have any more infeasible rows; the pivot()
+   * at the end of the loop iteration may add or remove infeasible rows
+   * as well
+   */
+  while (solver->infeasible_rows->len != 0)
+    {
+      Variable *entry_var, *exit_var;
+      Expression *expr;
+      double ratio = 0.0;
+
+      if (n_iterations == max_iterations)
+        {
+          simplex_solver_report_max_iterations (solver, "dual_optimize", n_iterations, n_degenerate);
+          converged = false;
+          break;
+        }
+
+      exit_var = simplex_solver_pop_infeasible_row (solver, use_bland);
+
+      expr = g_hash_table_lookup (solver->rows, exit_var);
+      if (expr == NULL)
+        continue;
+
+      if (expression_get_constant (expr) >= 0.0)
+        continue;
 
-      g_hash_table_iter_init (&iter, solver->edit_var_map);
-      while (g_hash_table_iter_next (&iter, &key_p, &value_p))
+      entry_var = simplex_solver_choose_dual_entry (solver, expr, use_bland, &ratio);
+      if (entry_var == NULL)
         {
-          char *var = variable_to_string (key_p);
-          const EditInfo *ei = value_p;
-          char *c = constraint_to_string (ei->constraint);
+          g_critical ("INTERNAL: ratio == DBL_MAX in dual_optimize");
+          continue;
+        }
 
-          g_string_append_printf (buf, "  %s => %s\n", var, c);
+      /* The dual counterpart of a degenerate pivot leaves the objective
+       * unchanged
+       */
+      if (ratio <= OPTIMALITY_TOLERANCE)
+        {
+          n_degenerate += 1;
+          n_stalled += 1;
 
-          g_free (var);
-          g_free (c);
+          if (n_stalled == max_stalled)
+            use_bland = true;
+        }
+      else
+        {
+          n_stalled = 0;
+          use_bland = false;
         }
-    }
 
-  return g_string_free (buf, FALSE);
-}
+      if (use_bland)
+        solver->bland_pivot_count += 1;
 
-static VariableSet *
-simplex_solver_get_column_set (SimplexSolver *solver,
-                               Variable *param_var)
-{
-  if (!solver->initialized)
-    return NULL;
+      simplex_solver_pivot (solver, entry_var, exit_var);
 
-  return g_hash_table_lookup (solver->columns, param_var);
-}
+      n_iterations += 1;
+    }
 
-static bool
-simplex_solver_column_has_key (SimplexSolver *solver,
-                               Variable *subject)
-{
-  if (!solver->initialized)
-    return false;
+#ifdef EMEUS_ENABLE_DEBUG
+  g_debug ("dual_optimize.time := %.3f ms (pivots:%u, degenerate:%u)",
+           (float) (g_get_monotonic_time () - start_time) / 1000.f,
+           n_iterations,
+           n_degenerate);
+#endif
 
-  return g_hash_table_contains (solver->columns, subject);
+  return converged;
 }
 
+/* Multiple edits can mark the same row as infeasible, or restore a row
+ * marked by a previous edit; we drop those before repairing the tableau
+ */
 static void
-simplex_solver_insert_column_variable (SimplexSolver *solver,
-                                       Variable *param_var,
-                                       Variable *row_var)
+simplex_solver_compact_infeasible_rows (SimplexSolver *solver)
 {
-  if (!solver->initialized)
+  GPtrArray *rows = solver->infeasible_rows;
+  GHashTable *seen;
+  guint i, n;
+
+  if (rows->len < 2)
     return;
 
-  VariableSet *cset = simplex_solver_get_column_set (solver, param_var);
-  if (cset == NULL)
+  seen = g_hash_table_new (NULL, NULL);
+
+  for (i = 0, n = 0; i < rows->len; i++)
     {
-      cset = variable_set_new ();
-      g_hash_table_insert (solver->columns, variable_ref (param_var), cset);
-    }
+      Variable *basic_var = g_ptr_array_index (rows, i);
+      Expression *expr = g_hash_table_lookup (solver->rows, basic_var);
 
-  if (row_var != NULL)
-    variable_set_add_variable (cset, row_var);
-}
+      if (expr == NULL || expression_get_constant (expr) >= 0.0)
+        continue;
 
-static void
-simplex_solver_insert_error_variable (SimplexSolver *solver,
-                                      Constraint *constraint,
-                                      Variable *variable)
-{
-  if (!solver->initialized)
-    return;
+      if (!g_hash_table_add (seen, basic_var))
+        continue;
 
-  VariableSet *cset = g_hash_table_lookup (solver->error_vars, constraint);
-  if (cset == NULL)
-    {
-      cset = variable_set_new ();
-      g_hash_table_insert (solver->error_vars, constraint, cset);
+      rows->pdata[n++] = basic_var;
     }
 
-  variable_set_add_variable (cset, variable);
-}
-
-static void
-simplex_solver_reset_stay_constants (SimplexSolver *solver)
-{
-  for (int i = 0; i < solver->stay_error_vars->len; i++)
-    {
-      VariablePair *pair = g_ptr_array_index (solver->stay_error_vars, i);
-      Expression *expression;
-
-      expression = g_hash_table_lookup (solver->rows, pair->first);
-      if (expression == NULL)
-        expression = g_hash_table_lookup (solver->rows, pair->second);
+  g_ptr_array_set_size (rows, n);
 
-      if (expression != NULL)
-        expression_set_constant (expression, 0.0);
-    }
+  g_hash_table_unref (seen);
 }
 
 static void
-simplex_solver_set_external_variables (SimplexSolver *solver)
+simplex_solver_delta_edit_constant (SimplexSolver *solver,
+                                    double delta,
+                                    Variable *plus_error_var,
+                                    Variable *minus_error_var)
 {
-  GHashTableIter iter;
-  gpointer key_p;
+  Expression *plus_expr, *minus_expr;
+  VariableSet *column_set;
+  VariableSetIter iter;
+  Variable *basic_var;
 
-  g_hash_table_iter_init (&iter, solver->external_parametric_vars);
-  while (g_hash_table_iter_next (&iter, &key_p, NULL))
+  if (!solver->initialized)
+    return;
+  
+  plus_expr = g_hash_table_lookup (solver->rows, plus_error_var);
+  if (plus_expr != NULL)
     {
-      Variable *variable = key_p;
+      double new_constant = expression_get_constant (plus_expr) + delta;
 
-      if (g_hash_table_contains (solver->rows, variable))
-        continue;
+      expression_set_constant (plus_expr, new_constant);
 
-      variable_set_value (variable, 0.0);
+      if (new_constant < 0.0)
+        g_ptr_array_add (solver->infeasible_rows, plus_error_var);
+
+      return;
     }
 
-  g_hash_table_iter_init (&iter, solver->external_rows);
-  while (g_hash_table_iter_next (&iter, &key_p, NULL))
+  minus_expr = g_hash_table_lookup (solver->rows, minus_error_var);
+  if (minus_expr != NULL)
     {
-      Variable *variable = key_p;
-      Expression *expression;
+      double new_constant = expression_get_constant (minus_expr) - delta;
 
-      expression = g_hash_table_lookup (solver->rows, variable);
+      expression_set_constant (minus_expr, new_constant);
 
-      variable_set_value (variable, expression_get_constant (expression));
-    }
+      if (new_constant < 0.0)
+        g_ptr_array_add (solver->infeasible_rows, minus_error_var);
 
-  solver->needs_solving = false;
-}
+      return;
+    }
 
-typedef struct {
-  SimplexSolver *solver;
-  Variable *subject;
-} ForeachClosure;
+  column_set = g_hash_table_lookup (solver->columns, minus_error_var);
+  if (column_set == NULL)
+    {
+      g_critical ("INTERNAL: Columns are unset during delta edit");
+      return;
+    }
 
-static bool
-insert_expression_columns (Term *term,
-                           gpointer data_)
-{
-  Variable *variable = term_get_variable (term);
-  ForeachClosure *data = data_;
+  variable_set_iter_init (column_set, &iter);
+  while (variable_set_iter_next (&iter, &basic_var))
+    {
+      Expression *expr;
+      double c, new_constant;
 
-  simplex_solver_insert_column_variable (data->solver,
-                                         variable,
-                                         data->subject);
+      expr = g_hash_table_lookup (solver->rows, basic_var);
+      c = expression_get_coefficient (expr, minus_error_var);
 
-  if (variable_is_external (variable))
-    g_hash_table_add (data->solver->external_parametric_vars, variable_ref (variable));
+      new_constant = expression_get_constant (expr) + (c * delta);
+      expression_set_constant (expr, new_constant);
 
-  return true;
+      if (variable_is_restricted (basic_var) && new_constant < 0.0)
+        g_ptr_array_add (solver->infeasible_rows, basic_var);
+    }
 }
 
-static void
-simplex_solver_add_row (SimplexSolver *solver,
-                        Variable *variable,
-                        Expression *expression)
+static Variable *
+simplex_solver_choose_subject (SimplexSolver *solver,
+                               Expression *expression)
 {
-  if (!solver->initialized)
-    return;
-
-  g_hash_table_insert (solver->rows, variable_ref (variable), expression_ref (expression));
+  Variable *subject = NULL;
+  Variable *retval = NULL;
+  bool found_unrestricted = false;
+  guint subject_column_size = 0;
+  bool found_new_restricted = false;
+  bool retval_found = false;
+  double coeff = 0.0;
+  GList *iter;
 
-  ForeachClosure data = {
-    .subject = variable,
-    .solver = solver,
-  };
+  iter = g_list_last (expression->ordered_terms);
+  while (iter != NULL)
+    {
+      Term *t = iter->data;
+      Variable *v = term_get_variable (t);
+      double c = term_get_coefficient (t);
 
-  expression_terms_foreach (expression,
-                            insert_expression_columns,
-                            &data);
+      iter = iter->prev;
 
-  if (variable_is_external (variable))
-    g_hash_table_add (solver->external_rows, variable_ref (variable));
-}
+      if (found_unrestricted)
+        {
+          if (!variable_is_restricted (v))
+            {
+              if (!g_hash_table_contains (solver->columns, v))
+                {
+                  retval_found = true;
+                  retval = v;
+                  break;
+                }
 
-static void
-simplex_solver_remove_column (SimplexSolver *solver,
-                              Variable *variable)
-{
-  VariableSet *set = g_hash_table_lookup (solver->columns, variable);
+              /* Substituting the subject out touches every row in its
+               * column, so we prefer the shortest one
+               */
+              if (simplex_solver_get_column_size (solver, v) < subject_column_size)
+                {
+                  subject = v;
+                  subject_column_size = simplex_solver_get_column_size (solver, v);
+                }
+            }
+        }
+      else
+        {
+          if (variable_is_restricted (v))
+            {
+              if (!found_new_restricted && !variable_is_dummy (v) && c < 0.0)
+                {
+                  VariableSet *cset = g_hash_table_lookup (solver->columns, v);
 
-  variable_ref (variable);
+                  if (cset == NULL ||
+                      (variable_set_get_size (cset) == 1 && g_hash_table_contains (solver->columns, solver->objective)))
+                    {
+                      subject = v;
+                      found_new_restricted = true;
+                    }
+                }
+            }
+          else
+            {
+              subject = v;
+              subject_column_size = simplex_solver_get_column_size (solver, v);
+              found_unrestricted = true;
+            }
+        }
+    }
 
-  if (set == NULL)
-    goto out;
+  if (retval_found)
+    return retval;
 
-  VariableSetIter iter;
-  Variable *v;
+  if (subject != NULL)
+    return subject;
 
-  variable_set_iter_init (set, &iter);
-  while (variable_set_iter_next (&iter, &v))
+  iter = g_list_last (expression->ordered_terms);
+  while (iter != NULL)
     {
-      Expression *e = g_hash_table_lookup (solver->rows, v);
+      Term *t = iter->data;
+      Variable *v = term_get_variable (t);
+      double c = term_get_coefficient (t);
+
+      iter = iter->prev;
+
+      if (!variable_is_dummy (v))
+        {
+          retval_found = true;
+          retval = NULL;
+          break;
+        }
 
-      expression_remove_variable (e, variable, NULL);
+      if (!g_hash_table_contains (solver->columns, v))
+        {
+          subject = v;
+          coeff = c;
+        }
     }
 
-  g_hash_table_remove (solver->columns, variable);
+  if (retval_found)
+    return retval;
 
-out:
-  if (variable_is_external (variable))
+  if (!approx_val (expression->constant, 0.0))
     {
-      g_hash_table_remove (solver->external_rows, variable);
-      g_hash_table_remove (solver->external_parametric_vars, variable);
+      g_debug ("Unable to satisfy required constraint (choose_subject)");
+      return NULL;
     }
 
-  variable_unref (variable);
+  if (coeff > 0)
+    expression_times (expression, -1.0);
+
+  return subject;
 }
 
 static bool
-remove_expression_columns (Term *term,
-                           gpointer data_)
+simplex_solver_try_adding_directly (SimplexSolver *solver,
+                                    Expression *expression)
 {
-  ForeachClosure *data = data_;
-  VariableSet *set = g_hash_table_lookup (data->solver->columns, term_get_variable (term));
+  Variable *subject;
 
-  if (set != NULL)
-    variable_set_remove_variable (set, data->subject);
+  if (!solver->initialized)
+    return false;
+
+  subject = simplex_solver_choose_subject (solver, expression);
+  if (subject == NULL)
+    return false;
+
+  variable_ref (subject);
+
+  expression_new_subject (expression, subject);
+  if (simplex_solver_column_has_key (solver, subject))
+    simplex_solver_substitute_out (solver, subject, expression);
+
+  simplex_solver_add_row (solver, subject, expression);
+
+  variable_unref (subject);
 
   return true;
 }
 
-static Expression *
-simplex_solver_remove_row (SimplexSolver *solver,
-                           Variable *variable,
-                           gboolean free_res)
+static void
+simplex_solver_add_with_artificial_variable (SimplexSolver *solver,
+                                             Expression *expression)
 {
+  Variable *av, *az;
+  Expression *az_row;
+  Expression *az_tableau_row;
+  Expression *e;
+
   if (!solver->initialized)
-    return NULL;
+    return;
+  
+  av = variable_new (solver, VARIABLE_SLACK);
+  variable_set_prefix (av, "a");
+  solver->artificial_counter += 1;
 
-  Expression *e = g_hash_table_lookup (solver->rows, variable);
-  g_assert (e != NULL);
+  az = variable_new (solver, VARIABLE_OBJECTIVE);
+  variable_set_name (az, "az");
 
-  expression_ref (e);
+  az_row = expression_clone (expression);
 
-  ForeachClosure data = {
-    .solver = solver,
-    .subject = variable,
-  };
+  simplex_solver_add_row (solver, az, az_row);
+  simplex_solver_add_row (solver, av, expression);
 
-  expression_terms_foreach (e,
-                            remove_expression_columns,
-                            &data);
+  expression_unref (az_row);
+  variable_unref (av);
+  variable_unref (az);
 
-  g_ptr_array_remove (solver->infeasible_rows, variable);
+  simplex_solver_optimize (solver, az);
 
-  if (variable_is_external (variable))
-    g_hash_table_remove (solver->external_rows, variable);
+  az_tableau_row = g_hash_table_lookup (solver->rows, az);
+  if (!approx_val (expression_get_constant (az_tableau_row), 0.0))
+    {
+      char *str = expression_to_string (expression);
 
-  g_hash_table_remove (solver->rows, variable);
+      simplex_solver_remove_column (solver, av);
+      simplex_solver_remove_row (solver, az, TRUE);
 
-  if (free_res)
-    {
-      expression_unref (e);
-      return NULL;
-    }
+      g_debug ("Unable to satisfy a required constraint (add): %s", str);
 
-  return e;
-}
+      g_free (str);
 
-static void
-simplex_solver_substitute_out (SimplexSolver *solver,
-                               Variable *old_variable,
-                               Expression *expression)
-{
-  if (!solver->initialized)
-    return;
+      return;
+    }
 
-  VariableSet *set = g_hash_table_lookup (solver->columns, old_variable);
-  if (set != NULL)
+  e = g_hash_table_lookup (solver->rows, av);
+  if (e != NULL)
     {
-      VariableSetIter iter;
-      Variable *v;
+      Variable *entry_var;
 
-      variable_set_iter_init (set, &iter);
-      while (variable_set_iter_next (&iter, &v))
+      if (expression_is_constant (e))
         {
-          Expression *row = g_hash_table_lookup (solver->rows, v);
-
-          expression_substitute_out (row, old_variable, expression, v);
+          simplex_solver_remove_row (solver, av, TRUE);
+          simplex_solver_remove_row (solver, az, TRUE);
 
-          if (variable_is_restricted (v) && expression_get_constant (row) < 0)
-            g_ptr_array_add (solver->infeasible_rows, v);
+          return;
         }
-    }
 
-  if (variable_is_external (old_variable))
-    {
-      g_hash_table_add (solver->external_rows, variable_ref (old_variable));
-      g_hash_table_remove (solver->external_parametric_vars, old_variable);
+      entry_var = expression_get_pivotable_variable (e);
+      simplex_solver_pivot (solver, entry_var, av);
     }
 
-  g_hash_table_remove (solver->columns, old_variable);
+  g_assert (!g_hash_table_contains (solver->rows, av));
+
+  simplex_solver_remove_column (solver, av);
+  simplex_solver_remove_row (solver, az, TRUE);
 }
 
-static void
-simplex_solver_pivot (SimplexSolver *solver,
-                      Variable *entry_var,
-                      Variable *exit_var)
+void
+simplex_solver_note_added_variable (SimplexSolver *solver,
+                                    Variable *variable,
+                                    Variable *subject)
 {
   if (!solver->initialized)
     return;
 
-  if (entry_var == NULL)
-    g_critical ("INTERNAL: No entry variable for pivot");
-  else
-    variable_ref (entry_var);
-
-  if (exit_var == NULL)
-    g_critical ("INTERNAL: No exit variable for pivot");
-  else
-    variable_ref (exit_var);
-
-  Expression *expr = simplex_solver_remove_row (solver, exit_var, FALSE);
-  expression_change_subject (expr, exit_var, entry_var);
-
-  simplex_solver_substitute_out (solver, entry_var, expr);
-  simplex_solver_add_row (solver, entry_var, expr);
-
-  variable_unref (entry_var);
-  variable_unref (exit_var);
-  expression_unref (expr);
+  if (subject != NULL)
+    simplex_solver_insert_column_variable (solver, variable, subject);
 }
 
-static void
-simplex_solver_optimize (SimplexSolver *solver,
-                         Variable *z)
+void
+simplex_solver_note_removed_variable (SimplexSolver *solver,
+                                      Variable *variable,
+                                      Variable *subject)
 {
+  VariableSet *set;
+
   if (!solver->initialized)
     return;
 
-  Expression *z_row = g_hash_table_lookup (solver->rows, z);
-  g_assert (z_row != NULL);
-
-  Variable *entry = NULL, *exit = NULL;
-
-  solver->optimize_count += 1;
+  set = g_hash_table_lookup (solver->columns, variable);
+  if (set != NULL && subject != NULL)
+    simplex_solver_variable_set_remove (solver, set, subject);
+}
 
-#ifdef EMEUS_ENABLE_DEBUG
-  gint64 start_time = g_get_monotonic_time ();
-#endif
+Variable *
+simplex_solver_create_variable (SimplexSolver *solver,
+                                const char *name,
+                                double value)
+{
+  Variable *res;
 
-#ifdef EMEUS_ENABLE_DEBUG
-  {
-    char *str;
+  if (!solver->initialized)
+    {
+      g_critical ("SimplexSolver %p is not initialized.", solver);
+      return NULL;
+    }
 
-    str = variable_to_string (z);
-    g_debug ("optimize: %s\n", str);
-    g_free (str);
+  res = variable_new (solver, VARIABLE_REGULAR);
+  variable_set_name (res, name);
+  variable_set_value (res, value);
 
-    str = simplex_solver_to_string (solver);
-    g_debug ("%s", str);
-    g_free (str);
-  }
-#endif
+  return res;
+}
 
-  while (true)
+Expression *
+simplex_solver_create_expression (SimplexSolver *solver,
+                                  double constant)
+{
+  if (!solver->initialized)
     {
-      GList *l;
-      VariableSet *column_vars;
-      VariableSetIter iter;
-      Variable *v;
-      double objective_coefficient = 0.0;
-      double min_ratio;
-      double r;
+      g_critical ("SimplexSolver %p is not initialized.", solver);
+      return NULL;
+    }
 
-      for (l = g_list_last (z_row->ordered_terms); l != NULL; l = l->prev)
-        {
-          const Term *t = l->data;
+  return expression_new (solver, constant);
+}
 
-          if (variable_is_pivotable (t->variable) && t->coefficient < objective_coefficient)
-            {
-              entry = t->variable;
-              objective_coefficient = t->coefficient;
-              break;
-            }
-        }
+/* A variable can be aliased if none of the rows of the tableau
+ * reference it; its column may exist, but it must be empty
+ */
+static bool
+simplex_solver_can_alias (SimplexSolver *solver,
+                          Variable *variable)
+{
+  VariableSet *set;
 
-      if (objective_coefficient >= -DBL_EPSILON)
-        break;
+  if (!variable_is_external (variable))
+    return false;
 
-      min_ratio = DBL_MAX;
-      r = 0;
+  /* Replacing a bounded variable would drop its bound */
+  if (variable_is_restricted (variable))
+    return false;
 
-      column_vars = simplex_solver_get_column_set (solver, entry);
-      variable_set_iter_init (column_vars, &iter);
-      while (variable_set_iter_next (&iter, &v))
-        {
-          if (variable_is_pivotable (v))
-            {
-              Expression *expr = g_hash_table_lookup (solver->rows, v);
-              double coeff = expression_get_coefficient (expr, entry);
+  if (g_hash_table_contains (solver->rows, variable))
+    return false;
 
-              if (coeff < 0.0)
-                {
-                  r = -1.0 * expression_get_constant (expr) / coeff;
-                  if (r < min_ratio)
-                    {
-                      min_ratio = r;
-                      exit = v;
-                    }
-                }
-            }
-        }
+  set = g_hash_table_lookup (solver->columns, variable);
 
-      if (min_ratio == DBL_MAX)
-        {
-          g_debug ("Unbounded objective variable during optimization");
-          break;
-        }
+  return set == NULL || variable_set_get_size (set) == 0;
+}
 
-      simplex_solver_pivot (solver, entry, exit);
+/* Replaces @variable inside the expression of each alias that uses it */
+static void
+simplex_solver_rewrite_aliases (SimplexSolver *solver,
+                                Variable *variable,
+                                Expression *expression)
+{
+  GPtrArray *rewrite = g_ptr_array_new ();
+  GHashTableIter iter;
+  gpointer key_p, value_p;
 
-#ifdef EMEUS_ENABLE_DEBUG
-      {
-        char *str = simplex_solver_to_string (solver);
-        g_debug ("%s", str);
-        g_free (str);
-      }
-#endif
+  g_hash_table_iter_init (&iter, solver->aliases);
+  while (g_hash_table_iter_next (&iter, &key_p, &value_p))
+    {
+      Alias *alias = value_p;
+
+      if (expression_has_variable (alias->expression, variable))
+        g_ptr_array_add (rewrite, key_p);
     }
 
-#ifdef EMEUS_ENABLE_DEBUG
-  g_debug ("optimize.time := %.3f ms (pass:%d)",
-           (float) (g_get_monotonic_time () - start_time) / 1000.f,
-           solver->optimize_count);
-#endif
-}
+  for (int i = 0; i < rewrite->len; i++)
+    {
+      Variable *aliased = g_ptr_array_index (rewrite, i);
+      Alias *alias = g_hash_table_lookup (solver->aliases, aliased);
+      Alias *res = g_slice_new (Alias);
+      GList *l;
 
-typedef struct {
-  SimplexSolver *solver;
-  Expression *expr;
-} ReplaceClosure;
+      /* We build a new expression, instead of changing the existing one,
+       * so that an open transaction can put the old alias back
+       */
+      res->constraint = alias->constraint;
+      res->expression = expression_new_from_constant (expression_get_constant (alias->expression));
 
-static bool
-replace_terms (Term *term,
-               gpointer data_)
-{
-  Variable *v = term_get_variable (term);
-  double c = term_get_coefficient (term);
-  ReplaceClosure *data = data_;
+      for (l = g_list_last (alias->expression->ordered_terms); l != NULL; l = l->prev)
+        {
+          Term *t = l->data;
 
-  Expression *e = g_hash_table_lookup (data->solver->rows, v);
+          if (t->variable == variable)
+            expression_add_expression (res->expression, expression, t->coefficient, NULL);
+          else
+            expression_add_variable (res->expression, t->variable, t->coefficient, NULL);
+        }
 
-  if (e == NULL)
-    expression_add_variable (data->expr, v, c, NULL);
-  else
-    expression_add_expression (data->expr, e, c, NULL);
+      simplex_solver_table_insert (solver, solver->aliases, variable_ref (aliased), res);
+    }
 
-  return true;
+  g_ptr_array_unref (rewrite);
 }
 
-static Expression *
-simplex_solver_new_expression (SimplexSolver *solver,
-                               Constraint *constraint,
-                               Variable **eplus_p,
-                               Variable **eminus_p,
-                               double *prev_constant_p)
+/* Checks whether a required equality can be satisfied by replacing one
+ * of its variables with an expression of the others, instead of adding
+ * a row to the tableau.
+ *
+ * Aliases are expanded, so the expression of an alias only references
+ * variables that are not aliased themselves; when we alias a variable
+ * used by other aliases, we rewrite their expressions. This way, a graph
+ * of required equalities is solved by evaluating each alias once, in
+ * any order, regardless of the order in which the constraints were
+ * added; only the variables at the roots of the graph enter the tableau.
+ */
+static bool
+simplex_solver_try_aliasing (SimplexSolver *solver,
+                             Constraint *constraint)
 {
-  Expression *cn_expr = constraint->expression;
   Expression *expr;
-  Variable *slack_var, *dummy_var;
-  Variable *eplus, *eminus;
+  Variable *subject = NULL;
   ReplaceClosure data;
+  GList *l;
 
-  if (eplus_p != NULL)
-    *eplus_p = NULL;
-  if (eminus_p != NULL)
-    *eminus_p = NULL;
-  if (prev_constant_p != NULL)
-    *prev_constant_p = 0.0;
+  if (constraint_is_inequality (constraint) ||
+      !constraint_is_required (constraint) ||
+      constraint_is_stay (constraint) ||
+      constraint_is_edit (constraint))
+    return false;
 
-  expr = expression_new (solver, expression_get_constant (cn_expr));
+  /* Expand the existing aliases, but leave the rows alone, as they
+   * change when pivoting
+   */
+  expr = expression_new_from_constant (expression_get_constant (constraint->expression));
 
   data.solver = solver;
   data.expr = expr;
-  expression_terms_foreach (cn_expr, replace_terms, &data);
+  data.multiplier = 1.0;
+  data.replace_rows = false;
+  expression_terms_foreach (constraint->expression, replace_terms, &data);
 
-  if (constraint_is_inequality (constraint))
+  /* Prefer the most recently created variable, which is usually the
+   * one being defined by the constraint
+   */
+  for (l = expr->ordered_terms; l != NULL; l = l->next)
     {
-      /* If the constraint is an inequality, we add a slack variable to
-       * turn it into an equality, e.g. from
-       *
-       *   expr >= 0
-       *
-       * to
-       *
-       *   expr - slack = 0
-       *
-       * Additionally, if the constraint is not required we add an
-       * error variable:
-       *
-       *   expr - slack + error = 0
-       */
-      solver->slack_counter += 1;
+      Term *t = l->data;
+      Variable *v = term_get_variable (t);
 
-      slack_var = variable_new (solver, VARIABLE_SLACK);
-      variable_set_prefix (slack_var, "s");
-      expression_set_variable (expr, slack_var, -1.0);
-      variable_unref (slack_var);
+      if (!simplex_solver_can_alias (solver, v))
+        continue;
 
-      g_hash_table_insert (solver->marker_vars, constraint, slack_var);
+      if (subject == NULL || v->id_ > subject->id_)
+        subject = v;
+    }
 
-      if (!constraint_is_required (constraint))
-        {
-          Expression *z_row;
+  if (subject == NULL)
+    {
+      expression_unref (expr);
+      return false;
+    }
 
-          solver->slack_counter += 1;
+  /* Turn the expression from:
+   *
+   *   a * subject + expr = 0
+   *
+   * to:
+   *
+   *   subject = expr / -a
+   */
+  expression_new_subject (expr, subject);
 
-          eminus = variable_new (solver, VARIABLE_SLACK);
-          variable_set_name (eminus, "em");
-          expression_set_variable (expr, eminus, 1.0);
-          variable_unref (eminus);
+  /* The subject may be used by other aliases, but not by the tableau */
+  if (g_hash_table_contains (solver->columns, subject))
+    simplex_solver_table_remove (solver, solver->columns, subject);
 
-          z_row = g_hash_table_lookup (solver->rows, solver->objective);
-          expression_set_variable (z_row, eminus, constraint->strength);
+  simplex_solver_rewrite_aliases (solver, subject, expr);
 
-          simplex_solver_insert_error_variable (solver, constraint, eminus);
-          simplex_solver_note_added_variable (solver, eminus, solver->objective);
-        }
-    }
-  else 
-    {
-      if (constraint_is_required (constraint))
-        {
-          /* If the constraint is required, we use a dummy marker variable;
-           * the dummy won't be allowed to enter the basis of the tableau
-           * when pivoting.
-           */
-          solver->dummy_counter += 1;
+  Alias *alias = g_slice_new (Alias);
 
-          dummy_var = variable_new (solver, VARIABLE_DUMMY);
+  alias->constraint = constraint;
+  alias->expression = expr;
 
-          if (eplus_p != NULL)
-            *eplus_p = dummy_var;
-          if (eminus_p != NULL)
-            *eminus_p = dummy_var;
-          if (prev_constant_p != NULL)
-            *prev_constant_p = expression_get_constant (cn_expr);
+  for (l = expr->ordered_terms; l != NULL; l = l->next)
+    {
+      Variable *v = term_get_variable (l->data);
 
-          expression_set_variable (expr, dummy_var, 1.0);
-          g_hash_table_insert (solver->marker_vars, constraint, dummy_var);
+      simplex_solver_insert_column_variable (solver, v, NULL);
 
-          variable_unref (dummy_var);
-        }
-      else
-        {
-          Expression *z_row;
+      if (variable_is_external (v))
+        simplex_solver_table_add (solver, solver->external_parametric_vars, variable_ref (v));
+    }
 
-          /* Since the constraint is a non-required equality, we need to
-           * add error variables around it, i.e. turn it from:
-           *
-           *   expr = 0
-           *
-           * to:
-           *
-           *   expr - eplus + eminus = 0
-           */
-          solver->slack_counter += 1;
+  simplex_solver_table_insert (solver, solver->aliases, variable_ref (subject), alias);
+  simplex_solver_table_insert (solver, solver->alias_constraints, constraint, subject);
 
-          eplus = variable_new (solver, VARIABLE_SLACK);
-          variable_set_name (eplus, "ep");
-          eminus = variable_new (solver, VARIABLE_SLACK);
-          variable_set_name (eminus, "em");
+#ifdef EMEUS_ENABLE_DEBUG
+  {
+    char *str1 = variable_to_string (subject);
+    char *str2 = expression_to_string (expr);
 
-          expression_set_variable (expr, eplus, -1.0);
-          expression_set_variable (expr, eminus, 1.0);
+    g_debug ("Aliasing variable: %s := %s", str1, str2);
 
-          g_hash_table_insert (solver->marker_vars, constraint, eplus);
+    g_free (str1);
+    g_free (str2);
+  }
+#endif
 
-          z_row = g_hash_table_lookup (solver->rows, solver->objective);
+  return true;
+}
 
-          expression_set_variable (z_row, eplus, constraint->strength);
-          expression_set_variable (z_row, eminus, constraint->strength);
-          simplex_solver_note_added_variable (solver, eplus, solver->objective);
-          simplex_solver_note_added_variable (solver, eminus, solver->objective);
+/* Picks the row to pivot a parametric @marker into the basis, so that its
+ * row can be dropped, or stop constraining the solution, without making
+ * the tableau infeasible
+ */
+static Variable *
+simplex_solver_choose_marker_exit (SimplexSolver *solver,
+                                   Variable *marker)
+{
+  VariableSet *set = g_hash_table_lookup (solver->columns, marker);
+  VariableSetIter iter;
+  Variable *exit_var = NULL;
+  Variable *v;
+  double min_ratio = 0;
 
-          simplex_solver_insert_error_variable (solver, constraint, eplus);
-          simplex_solver_insert_error_variable (solver, constraint, eminus);
+  if (set == NULL)
+    return NULL;
 
-          if (constraint_is_stay (constraint))
+  variable_set_iter_init (set, &iter);
+  while (variable_set_iter_next (&iter, &v))
+    {
+      if (variable_is_restricted (v))
+        {
+          Expression *e = g_hash_table_lookup (solver->rows, v);
+          double coeff = expression_get_coefficient (e, marker);
+
+          if (coeff < 0.0)
             {
-              g_ptr_array_add (solver->stay_error_vars, variable_pair_new (eplus, eminus));
+              double r = -expression_get_constant (e) / coeff;
+
+              if (exit_var == NULL ||
+                  r < min_ratio ||
+                  approx_val (r, min_ratio))
+                {
+                  min_ratio = r;
+                  exit_var = v;
+                }
             }
-          else if (constraint_is_edit (constraint))
+        }
+    }
+
+  if (exit_var == NULL)
+    {
+      variable_set_iter_init (set, &iter);
+      while (variable_set_iter_next (&iter, &v))
+        {
+          if (variable_is_restricted (v))
             {
-              if (eplus_p != NULL)
-                *eplus_p = eplus;
-              if (eminus_p != NULL)
-                *eminus_p = eminus;
-              if (prev_constant_p != NULL)
-                *prev_constant_p = expression_get_constant (cn_expr);
-            }
+              Expression *e = g_hash_table_lookup (solver->rows, v);
+              double coeff = expression_get_coefficient (e, marker);
+              double r = 0.0;
+              
+              if (!approx_val (coeff, 0.0))
+                r = expression_get_constant (e) / coeff;
 
-          variable_unref (eplus);
-          variable_unref (eminus);
+              if (exit_var == NULL || r < min_ratio)
+                {
+                  min_ratio = r;
+                  exit_var = v;
+                }
+            }
         }
     }
 
-  if (expression_get_constant (expr) < 0.0)
-    expression_times (expr, -1.0);
+  if (exit_var == NULL)
+    {
+      variable_set_iter_init (set, &iter);
+      while (variable_set_iter_next (&iter, &v))
+        {
+          if (v != solver->objective)
+            {
+              exit_var = v;
+              break;
+            }
+        }
+    }
 
-  return expr;
+  return exit_var;
 }
 
 static void
-simplex_solver_dual_optimize (SimplexSolver *solver)
+simplex_solver_set_variable_restricted (SimplexSolver *solver,
+                                        Variable *variable,
+                                        bool restricted)
 {
-  Expression *z_row = g_hash_table_lookup (solver->rows, solver->objective);
+  if (solver->journal != NULL)
+    simplex_solver_journal_push (solver, JOURNAL_VARIABLE_RESTRICT,
+                                 variable_ref (variable),
+                                 NULL, NULL,
+                                 variable->is_restricted ? 1.0 : 0.0);
+
+  variable->is_restricted = restricted;
+  variable->is_pivotable = restricted;
+}
 
-#ifdef EMEUS_ENABLE_DEBUG
-  gint64 start_time = g_get_monotonic_time ();
-#endif
+/* Checks whether a required inequality is a bound of zero on a single
+ * variable, like the non-negativity of a size, and can be satisfied by
+ * restricting the variable itself to non-negative values, the same way
+ * as a slack variable, instead of adding a row, and a slack variable,
+ * to the tableau.
+ *
+ * Other bounds need a row all the same, as the tableau has no way to
+ * express a variable whose value is kept away from zero.
+ */
+static bool
+simplex_solver_try_bounding (SimplexSolver *solver,
+                             Constraint *constraint)
+{
+  Expression *expr = constraint->expression;
+  Expression *row;
+  Variable *variable;
+  Term *t;
+
+  if (!constraint_is_inequality (constraint) ||
+      !constraint_is_required (constraint) ||
+      constraint_is_stay (constraint) ||
+      constraint_is_edit (constraint))
+    return false;
 
-  /* We iterate until we don't have any more infeasible rows; the pivot()
-   * at the end of the loop iteration may add or remove infeasible rows
-   * as well
+  if (expression_get_n_terms (expr) != 1 ||
+      !approx_val (expression_get_constant (expr), 0.0))
+    return false;
+
+  t = expr->ordered_terms->data;
+  variable = term_get_variable (t);
+
+  if (term_get_coefficient (t) < 0.0 ||
+      !variable_is_external (variable) ||
+      variable_is_restricted (variable) ||
+      g_hash_table_contains (solver->aliases, variable))
+    return false;
+
+  /* A basic variable must already satisfy the bound; if it does not, we
+   * add a row, and let the solver find out whether it can be satisfied
    */
-  while (solver->infeasible_rows->len != 0)
-    {
-      Variable *entry_var, *exit_var;
-      Expression *expr;
-      double ratio;
-      GList *l;
+  row = g_hash_table_lookup (solver->rows, variable);
+  if (row != NULL && expression_get_constant (row) < 0.0)
+    return false;
 
-      /* Pop the last element of the array */
-      exit_var =
-        g_ptr_array_index (solver->infeasible_rows, solver->infeasible_rows->len - 1);
-      g_ptr_array_set_size (solver->infeasible_rows, solver->infeasible_rows->len - 1);
+  simplex_solver_set_variable_restricted (solver, variable, true);
+  simplex_solver_table_insert (solver, solver->bound_constraints, constraint, variable);
 
-      expr = g_hash_table_lookup (solver->rows, exit_var);
-      if (expr == NULL)
-        continue;
+#ifdef EMEUS_ENABLE_DEBUG
+  {
+    char *str = variable_to_string (variable);
 
-      if (expression_get_constant (expr) >= 0.0)
-        continue;
+    g_debug ("Bounding variable: %s >= 0", str);
 
-      ratio = DBL_MAX;
-      entry_var = NULL;
-      for (l = g_list_last (expr->ordered_terms); l != NULL; l = l->prev)
-        {
-          Term *term = l->data;
-          Variable *v = term_get_variable (term);
-          double cd = term_get_coefficient (term);
+    g_free (str);
+  }
+#endif
 
-          if (cd > 0.0 && variable_is_pivotable (v))
-            {
-              double zc = expression_get_coefficient (z_row, v);
-              double r = zc / cd;
+  return true;
+}
+
+static void
+simplex_solver_remove_bound (SimplexSolver *solver,
+                             Constraint *constraint)
+{
+  Variable *variable = g_hash_table_lookup (solver->bound_constraints, constraint);
 
-              if (r < ratio)
-                {
-                  entry_var = v;
-                  ratio = r;
-                }
-            }
-        }
+  simplex_solver_table_remove (solver, solver->bound_constraints, constraint);
 
-      if (ratio == DBL_MAX)
-        g_critical ("INTERNAL: ratio == DBL_MAX in dual_optimize");
+  /* Like the marker of a removed constraint, a parametric variable
+   * enters the basis; once it is released, its row does not constrain
+   * the solution any more
+   */
+  if (!g_hash_table_contains (solver->rows, variable))
+    {
+      Variable *exit_var = simplex_solver_choose_marker_exit (solver, variable);
 
-      if (entry_var != NULL)
-        simplex_solver_pivot (solver, entry_var, exit_var);
+      if (exit_var != NULL)
+        simplex_solver_pivot (solver, variable, exit_var);
     }
 
-#ifdef EMEUS_ENABLE_DEBUG
-  g_debug ("dual_optimize.time := %.3f ms",
-           (float) (g_get_monotonic_time () - start_time) / 1000.f);
-#endif
+  g_ptr_array_remove (solver->infeasible_rows, variable);
+
+  simplex_solver_set_variable_restricted (solver, variable, false);
 }
 
 static void
-simplex_solver_delta_edit_constant (SimplexSolver *solver,
-                                    double delta,
-                                    Variable *plus_error_var,
-                                    Variable *minus_error_var)
+simplex_solver_add_constraint_internal (SimplexSolver *solver,
+                                        Constraint *constraint)
 {
-  Expression *plus_expr, *minus_expr;
-  VariableSet *column_set;
-  VariableSetIter iter;
-  Variable *basic_var;
+  Expression *expr;
+  Variable *eplus;
+  Variable *eminus;
+  double prev_constant;
 
-  if (!solver->initialized)
-    return;
-  
-  plus_expr = g_hash_table_lookup (solver->rows, plus_error_var);
-  if (plus_expr != NULL)
+  solver->generation += 1;
+
+  if (simplex_solver_try_aliasing (solver, constraint))
     {
-      double new_constant = expression_get_constant (plus_expr) + delta;
+      solver->needs_solving = true;
 
-      expression_set_constant (plus_expr, new_constant);
+      if (solver->auto_solve)
+        {
+          simplex_solver_optimize (solver, solver->objective);
+          simplex_solver_set_external_variables (solver);
+        }
 
-      if (new_constant < 0.0)
-        g_ptr_array_add (solver->infeasible_rows, plus_error_var);
+      if (!g_hash_table_contains (solver->constraints, constraint))
+        simplex_solver_table_add (solver, solver->constraints, constraint);
 
       return;
     }
 
-  minus_expr = g_hash_table_lookup (solver->rows, minus_error_var);
-  if (minus_expr != NULL)
+  if (simplex_solver_try_bounding (solver, constraint))
     {
-      double new_constant = expression_get_constant (minus_expr) - delta;
+      solver->needs_solving = true;
 
-      expression_set_constant (minus_expr, new_constant);
+      if (solver->auto_solve)
+        {
+          simplex_solver_optimize (solver, solver->objective);
+          simplex_solver_set_external_variables (solver);
+        }
 
-      if (new_constant < 0.0)
-        g_ptr_array_add (solver->infeasible_rows, minus_error_var);
+      if (!g_hash_table_contains (solver->constraints, constraint))
+        simplex_solver_table_add (solver, solver->constraints, constraint);
 
       return;
     }
 
-  column_set = g_hash_table_lookup (solver->columns, minus_error_var);
-  if (column_set == NULL)
+  expr = simplex_solver_new_expression (solver, constraint,
+                                        &eplus,
+                                        &eminus,
+                                        &prev_constant);
+
+#ifdef EMEUS_ENABLE_DEBUG
+  {
+    char *str1 = constraint_to_string (constraint);
+    char *str2 = expression_to_string (expr);
+
+    g_debug ("Adding constraint: %s (normalized expression: %s)", str1, str2);
+
+    g_free (str1);
+    g_free (str2);
+  }
+#endif
+
+  if (constraint_is_stay (constraint))
     {
-      g_critical ("INTERNAL: Columns are unset during delta edit");
-      return;
+      StayInfo *si = g_slice_new (StayInfo);
+
+      si->constraint = constraint;
+
+      simplex_solver_table_insert (solver, solver->stay_var_map, constraint->variable, si);
     }
 
-  variable_set_iter_init (column_set, &iter);
-  while (variable_set_iter_next (&iter, &basic_var))
+  if (constraint_is_edit (constraint))
     {
-      Expression *expr;
-      double c, new_constant;
-
-      expr = g_hash_table_lookup (solver->rows, basic_var);
-      c = expression_get_coefficient (expr, minus_error_var);
+      EditInfo *ei = g_slice_new (EditInfo);
 
-      new_constant = expression_get_constant (expr) + (c * delta);
-      expression_set_constant (expr, new_constant);
+      ei->constraint = constraint;
+      ei->eplus = eplus;
+      ei->eminus = eminus;
+      ei->prev_constant = prev_constant;
+      ei->pending_value = 0.0;
+      ei->has_pending = false;
 
-      if (variable_is_restricted (basic_var) && new_constant < 0.0)
-        g_ptr_array_add (solver->infeasible_rows, basic_var);
+      simplex_solver_table_insert (solver, solver->edit_var_map, constraint->variable, ei);
     }
-}
 
-static Variable *
-simplex_solver_choose_subject (SimplexSolver *solver,
-                               Expression *expression)
-{
-  Variable *subject = NULL;
-  Variable *retval = NULL;
-  bool found_unrestricted = false;
-  bool found_new_restricted = false;
-  bool retval_found = false;
-  double coeff = 0.0;
-  GList *iter;
+  if (!simplex_solver_try_adding_directly (solver, expr))
+    simplex_solver_add_with_artificial_variable (solver, expr);
 
-  iter = g_list_last (expression->ordered_terms);
-  while (iter != NULL)
+  solver->needs_solving = true;
+
+  if (solver->auto_solve)
     {
-      Term *t = iter->data;
-      Variable *v = term_get_variable (t);
-      double c = term_get_coefficient (t);
+      simplex_solver_optimize (solver, solver->objective);
+      simplex_solver_set_external_variables (solver);
+    }
 
-      iter = iter->prev;
+  expression_unref (expr);
 
-      if (found_unrestricted)
-        {
-          if (!variable_is_restricted (v))
-            {
-              if (!g_hash_table_contains (solver->columns, v))
-                {
-                  retval_found = true;
-                  retval = v;
-                  break;
-                }
-            }
-        }
-      else
-        {
-          if (variable_is_restricted (v))
-            {
-              if (!found_new_restricted && !variable_is_dummy (v) && c < 0.0)
-                {
-                  VariableSet *cset = g_hash_table_lookup (solver->columns, v);
+  /* Constraints depending on an alias are added again when the alias
+   * is removed, and they are already in the set
+   */
+  if (!g_hash_table_contains (solver->constraints, constraint))
+    simplex_solver_table_add (solver, solver->constraints, constraint);
+}
 
-                  if (cset == NULL ||
-                      (variable_set_get_size (cset) == 1 && g_hash_table_contains (solver->columns, solver->objective)))
-                    {
-                      subject = v;
-                      found_new_restricted = true;
-                    }
-                }
-            }
-          else
-            {
-              subject = v;
-              found_unrestricted = true;
-            }
-        }
+Constraint *
+simplex_solver_add_constraint (SimplexSolver *solver,
+                               Variable *variable,
+                               OperatorType op,
+                               Expression *expression,
+                               double strength)
+{
+  if (!solver->initialized)
+    {
+      g_critical ("SimplexSolver %p has not been initialized.", solver);
+      return NULL;
     }
 
-  if (retval_found)
-    return retval;
+  Constraint *res = constraint_new (solver, variable, op, expression, strength);
 
-  if (subject != NULL)
-    return subject;
+  simplex_solver_add_constraint_internal (solver, res);
 
-  iter = g_list_last (expression->ordered_terms);
-  while (iter != NULL)
+  return res;
+}
+
+Constraint *
+simplex_solver_add_stay_variable (SimplexSolver *solver,
+                                  Variable *variable,
+                                  double strength)
+{
+  if (!solver->initialized)
     {
-      Term *t = iter->data;
-      Variable *v = term_get_variable (t);
-      double c = term_get_coefficient (t);
+      g_critical ("SimplexSolver %p has not been initialized.", solver);
+      return NULL;
+    }
 
-      iter = iter->prev;
+  Constraint *res = constraint_new_stay (solver, variable, strength);
 
-      if (!variable_is_dummy (v))
-        {
-          retval_found = true;
-          retval = NULL;
-          break;
-        }
+  simplex_solver_add_constraint_internal (solver, res);
 
-      if (!g_hash_table_contains (solver->columns, v))
-        {
-          subject = v;
-          coeff = c;
-        }
-    }
+  return res;
+}
 
-  if (retval_found)
-    return retval;
+bool
+simplex_solver_has_stay_variable (SimplexSolver *solver,
+                                  Variable *variable)
+{
+  if (!solver->initialized)
+    return false;
 
-  if (!approx_val (expression->constant, 0.0))
+  return g_hash_table_contains (solver->stay_var_map, variable);
+}
+
+void
+simplex_solver_remove_stay_variable (SimplexSolver *solver,
+                                     Variable *variable)
+{
+  if (!solver->initialized)
     {
-      g_debug ("Unable to satisfy required constraint (choose_subject)");
-      return NULL;
+      g_critical ("Solver %p is not initialized.", solver);
+      return;
     }
 
-  if (coeff > 0)
-    expression_times (expression, -1.0);
+  StayInfo *si = g_hash_table_lookup (solver->stay_var_map, variable);
+  if (si == NULL)
+    {
+      char *str = variable_to_string (variable);
 
-  return subject;
+      g_critical ("Unknown stay variable '%s'", str);
+
+      g_free (str);
+
+      return;
+    }
+
+  simplex_solver_remove_constraint (solver, si->constraint);
 }
 
-static bool
-simplex_solver_try_adding_directly (SimplexSolver *solver,
-                                    Expression *expression)
+Constraint *
+simplex_solver_add_edit_variable (SimplexSolver *solver,
+                                  Variable *variable,
+                                  double strength)
 {
-  Variable *subject;
+  if (!solver->initialized)
+    return NULL;
+
+  Constraint *res = constraint_new_edit (solver, variable, strength);
 
+  simplex_solver_add_constraint_internal (solver, res);
+
+  return res;
+}
+
+bool
+simplex_solver_has_edit_variable (SimplexSolver *solver,
+                                  Variable *variable)
+{
   if (!solver->initialized)
     return false;
 
-  subject = simplex_solver_choose_subject (solver, expression);
-  if (subject == NULL)
-    return false;
+  return g_hash_table_contains (solver->edit_var_map, variable);
+}
 
-  variable_ref (subject);
+void
+simplex_solver_remove_edit_variable (SimplexSolver *solver,
+                                     Variable *variable)
+{
+  if (!solver->initialized)
+    {
+      g_critical ("Solver %p is not initialized.", solver);
+      return;
+    }
 
-  expression_new_subject (expression, subject);
-  if (simplex_solver_column_has_key (solver, subject))
-    simplex_solver_substitute_out (solver, subject, expression);
+  EditInfo *ei = g_hash_table_lookup (solver->edit_var_map, variable);
+  if (ei == NULL)
+    {
+      char *str = variable_to_string (variable);
 
-  simplex_solver_add_row (solver, subject, expression);
+      g_critical ("Unknown edit variable '%s'", str);
 
-  variable_unref (subject);
+      g_free (str);
 
-  return true;
+      return;
+    }
+
+  simplex_solver_remove_constraint (solver, ei->constraint);
 }
 
+static bool simplex_solver_remove_constraint_internal (SimplexSolver *solver,
+                                                       Constraint *constraint);
+
 static void
-simplex_solver_add_with_artificial_variable (SimplexSolver *solver,
-                                             Expression *expression)
+simplex_solver_remove_alias (SimplexSolver *solver,
+                             Constraint *constraint)
 {
-  Variable *av, *az;
-  Expression *az_row;
-  Expression *az_tableau_row;
-  Expression *e;
+  Variable *variable = g_hash_table_lookup (solver->alias_constraints, constraint);
+  GPtrArray *dependents;
+  GHashTableIter iter;
+  gpointer key_p;
 
-  if (!solver->initialized)
-    return;
-  
-  av = variable_new (solver, VARIABLE_SLACK);
-  variable_set_prefix (av, "a");
-  solver->artificial_counter += 1;
+  variable_ref (variable);
 
-  az = variable_new (solver, VARIABLE_OBJECTIVE);
-  variable_set_name (az, "az");
+  simplex_solver_table_remove (solver, solver->alias_constraints, constraint);
+  simplex_solver_table_remove (solver, solver->aliases, variable);
 
-  az_row = expression_clone (expression);
+  /* The constraints that referenced the aliased variable were added to
+   * the tableau using the alias expression; now that the variable is
+   * free, we need to add them again
+   */
+  dependents = g_ptr_array_new ();
 
-  simplex_solver_add_row (solver, az, az_row);
-  simplex_solver_add_row (solver, av, expression);
+  g_hash_table_iter_init (&iter, solver->constraints);
+  while (g_hash_table_iter_next (&iter, &key_p, NULL))
+    {
+      Constraint *c = key_p;
 
-  expression_unref (az_row);
-  variable_unref (av);
-  variable_unref (az);
+      if (c != constraint && expression_has_variable (c->expression, variable))
+        g_ptr_array_add (dependents, c);
+    }
 
-  simplex_solver_optimize (solver, az);
+  for (int i = 0; i < dependents->len; i++)
+    simplex_solver_remove_constraint_internal (solver, g_ptr_array_index (dependents, i));
 
-  az_tableau_row = g_hash_table_lookup (solver->rows, az);
-  if (!approx_val (expression_get_constant (az_tableau_row), 0.0))
-    {
-      char *str = expression_to_string (expression);
+  for (int i = 0; i < dependents->len; i++)
+    simplex_solver_add_constraint_internal (solver, g_ptr_array_index (dependents, i));
 
-      simplex_solver_remove_column (solver, av);
-      simplex_solver_remove_row (solver, az, TRUE);
+  g_ptr_array_unref (dependents);
 
-      g_debug ("Unable to satisfy a required constraint (add): %s", str);
+  variable_unref (variable);
+}
 
-      g_free (str);
+/* Removes the rows and columns of @constraint from the tableau, without
+ * removing @constraint from the solver
+ */
+static bool
+simplex_solver_remove_constraint_internal (SimplexSolver *solver,
+                                           Constraint *constraint)
+{
+  Expression *z_row;
+  VariableSet *error_vars;
+  VariableSetIter iter;
+  Variable *marker;
 
-      return;
+  solver->generation += 1;
+
+  if (g_hash_table_contains (solver->alias_constraints, constraint))
+    {
+      simplex_solver_remove_alias (solver, constraint);
+      return true;
     }
 
-  e = g_hash_table_lookup (solver->rows, av);
-  if (e != NULL)
+  solver->needs_solving = true;
+
+  if (g_hash_table_contains (solver->bound_constraints, constraint))
     {
-      Variable *entry_var;
+      simplex_solver_remove_bound (solver, constraint);
 
-      if (expression_is_constant (e))
+      if (solver->auto_solve)
         {
-          simplex_solver_remove_row (solver, av, TRUE);
-          simplex_solver_remove_row (solver, az, TRUE);
-
-          return;
+          simplex_solver_optimize (solver, solver->objective);
+          simplex_solver_set_external_variables (solver);
         }
 
-      entry_var = expression_get_pivotable_variable (e);
-      simplex_solver_pivot (solver, entry_var, av);
+      return true;
     }
 
-  g_assert (!g_hash_table_contains (solver->rows, av));
+  simplex_solver_reset_stay_constants (solver);
 
-  simplex_solver_remove_column (solver, av);
-  simplex_solver_remove_row (solver, az, TRUE);
-}
+  z_row = g_hash_table_lookup (solver->rows, solver->objective);
+  error_vars = g_hash_table_lookup (solver->error_vars, constraint);
 
-void
-simplex_solver_note_added_variable (SimplexSolver *solver,
-                                    Variable *variable,
-                                    Variable *subject)
-{
-  if (!solver->initialized)
-    return;
+  if (error_vars != NULL)
+    {
+      Variable *v;
 
-  if (subject != NULL)
-    simplex_solver_insert_column_variable (solver, variable, subject);
-}
+      variable_set_iter_init (error_vars, &iter);
+      while (variable_set_iter_next (&iter, &v))
+        {
+          Expression *e;
 
-void
-simplex_solver_note_removed_variable (SimplexSolver *solver,
-                                      Variable *variable,
-                                      Variable *subject)
-{
-  VariableSet *set;
+          e = g_hash_table_lookup (solver->rows, v);
 
-  if (!solver->initialized)
-    return;
+          if (e == NULL)
+            {
+              expression_add_variable (z_row,
+                                       v,
+                                       constraint->strength,
+                                       solver->objective);
+            }
+          else
+            {
+              expression_add_expression (z_row,
+                                         e,
+                                         constraint->strength,
+                                         solver->objective);
+            }
+        }
+    }
 
-  set = g_hash_table_lookup (solver->columns, variable);
-  if (set != NULL && subject != NULL)
-    variable_set_remove_variable (set, subject);
-}
+  marker = g_hash_table_lookup (solver->marker_vars, constraint);
+  if (marker == NULL)
+    {
+      g_critical ("Constraint %p not found", constraint);
+      return false;
+    }
 
-Variable *
-simplex_solver_create_variable (SimplexSolver *solver,
-                                const char *name,
-                                double value)
-{
-  Variable *res;
+  simplex_solver_table_remove (solver, solver->marker_vars, constraint);
 
-  if (!solver->initialized)
+  if (g_hash_table_lookup (solver->rows, marker) == NULL)
     {
-      g_critical ("SimplexSolver %p is not initialized.", solver);
-      return NULL;
-    }
+      VariableSet *set = g_hash_table_lookup (solver->columns, marker);
+      Variable *exit_var;
 
-  res = variable_new (solver, VARIABLE_REGULAR);
-  variable_set_name (res, name);
-  variable_set_value (res, value);
+      if (set == NULL)
+        goto no_columns;
 
-  return res;
-}
+      exit_var = simplex_solver_choose_marker_exit (solver, marker);
+      if (exit_var != NULL)
+        simplex_solver_pivot (solver, marker, exit_var);
+      else if (variable_set_get_size (set) == 0)
+        simplex_solver_remove_column (solver, marker);
+    }
 
-Expression *
-simplex_solver_create_expression (SimplexSolver *solver,
-                                  double constant)
-{
-  if (!solver->initialized)
+no_columns:
+  if (g_hash_table_lookup (solver->rows, marker) != NULL)
+    simplex_solver_remove_row (solver, marker, TRUE);
+  else if (solver->journal != NULL)
+    simplex_solver_journal_push (solver, JOURNAL_VARIABLE_UNREF, marker, NULL, NULL, 0.0);
+  else
+    variable_unref (marker);
+
+  if (error_vars != NULL)
     {
-      g_critical ("SimplexSolver %p is not initialized.", solver);
-      return NULL;
-    }
+      Variable *v;
 
-  return expression_new (solver, constant);
-}
+      variable_set_iter_init (error_vars, &iter);
+      while (variable_set_iter_next (&iter, &v))
+        {
+          if (v != marker)
+            simplex_solver_remove_column (solver, v);
+        }
+    }
 
-static void
-simplex_solver_add_constraint_internal (SimplexSolver *solver,
-                                        Constraint *constraint)
-{
-  Expression *expr;
-  Variable *eplus;
-  Variable *eminus;
-  double prev_constant;
+  if (constraint_is_stay (constraint))
+    {
+      if (error_vars != NULL)
+        {
+          GPtrArray *remaining = g_ptr_array_new_with_free_func (variable_pair_free);
+          int i = 0;
 
-  expr = simplex_solver_new_expression (solver, constraint,
-                                        &eplus,
-                                        &eminus,
-                                        &prev_constant);
+          for (i = 0; i < solver->stay_error_vars->len; i++)
+            {
+              VariablePair *pair = g_ptr_array_index (solver->stay_error_vars, i);
+              bool found = false;
 
-#ifdef EMEUS_ENABLE_DEBUG
-  {
-    char *str1 = constraint_to_string (constraint);
-    char *str2 = expression_to_string (expr);
+              if (simplex_solver_variable_set_remove (solver, error_vars, pair->first))
+                found = true;
 
-    g_debug ("Adding constraint: %s (normalized expression: %s)", str1, str2);
+              if (simplex_solver_variable_set_remove (solver, error_vars, pair->second))
+                found = true;
 
-    g_free (str1);
-    g_free (str2);
-  }
-#endif
+              if (!found)
+                g_ptr_array_add (remaining, variable_pair_new (pair->first, pair->second));
+            }
 
-  if (constraint_is_stay (constraint))
-    {
-      StayInfo *si = g_slice_new (StayInfo);
+          if (solver->journal != NULL)
+            simplex_solver_journal_push (solver, JOURNAL_STAY_ERROR_REPLACE,
+                                         solver->stay_error_vars,
+                                         NULL, NULL,
+                                         0.0);
+          else
+            g_ptr_array_unref (solver->stay_error_vars);
 
-      si->constraint = constraint;
+          solver->stay_error_vars = remaining;
+        }
 
-      g_hash_table_insert (solver->stay_var_map, constraint->variable, si);
+      simplex_solver_table_remove (solver, solver->stay_var_map, constraint->variable);
     }
-
-  if (constraint_is_edit (constraint))
+  else if (constraint_is_edit (constraint))
     {
-      EditInfo *ei = g_slice_new (EditInfo);
+      EditInfo *ei = g_hash_table_lookup (solver->edit_var_map, constraint->variable);
 
-      ei->constraint = constraint;
-      ei->eplus = eplus;
-      ei->eminus = eminus;
-      ei->prev_constant = prev_constant;
+      simplex_solver_remove_column (solver, ei->eminus);
 
-      g_hash_table_insert (solver->edit_var_map, constraint->variable, ei);
+      simplex_solver_table_remove (solver, solver->edit_var_map, constraint->variable);
     }
 
-  if (!simplex_solver_try_adding_directly (solver, expr))
-    simplex_solver_add_with_artificial_variable (solver, expr);
-
-  solver->needs_solving = true;
+  if (error_vars != NULL)
+    simplex_solver_table_remove (solver, solver->error_vars, constraint);
 
   if (solver->auto_solve)
     {
@@ -1513,385 +3479,450 @@ simplex_solver_add_constraint_internal (SimplexSolver *solver,
       simplex_solver_set_external_variables (solver);
     }
 
-  expression_unref (expr);
-
-  g_hash_table_add (solver->constraints, constraint);
+  return true;
 }
 
-Constraint *
-simplex_solver_add_constraint (SimplexSolver *solver,
-                               Variable *variable,
-                               OperatorType op,
-                               Expression *expression,
-                               double strength)
+void
+simplex_solver_remove_constraint (SimplexSolver *solver,
+                                  Constraint *constraint)
 {
   if (!solver->initialized)
+    return;
+
+  if (!g_hash_table_contains (solver->constraints, constraint))
     {
-      g_critical ("SimplexSolver %p has not been initialized.", solver);
-      return NULL;
+      char *str = constraint_to_string (constraint);
+
+      g_critical ("Unknown constraint '%s', unable to remove it from solver", str);
+
+      g_free (str);
     }
 
-  Constraint *res = g_slice_new0 (Constraint);
-  res->solver = solver;
-  res->strength = strength;
-  res->is_edit = false;
-  res->is_stay = false;
-  res->op_type = op;
+  if (simplex_solver_remove_constraint_internal (solver, constraint))
+    simplex_solver_table_remove (solver, solver->constraints, constraint);
+}
 
-  if (expression == NULL)
-    res->expression = expression_new_from_variable (variable);
-  else
+static void
+simplex_solver_apply_suggestion (SimplexSolver *solver,
+                                 Variable *variable,
+                                 double value)
+{
+  EditInfo *ei = g_hash_table_lookup (solver->edit_var_map, variable);
+  if (ei == NULL)
     {
-      res->expression = expression_ref (expression);
-      if (res->expression->solver == NULL)
-        res->expression->solver = solver;
-
-      if (variable != NULL)
-        {
-          switch (res->op_type)
-            {
-            case OPERATOR_TYPE_EQ:
-              expression_add_variable (res->expression, variable, -1.0, NULL);
-              break;
+      g_critical ("Suggesting value '%g' but variable %p is not editable",
+                  value, variable);
+      return;
+    }
 
-            case OPERATOR_TYPE_LE:
-              expression_add_variable (res->expression, variable, -1.0, NULL);
-              break;
+  solver->generation += 1;
 
-            case OPERATOR_TYPE_GE:
-              expression_times (res->expression, -1.0);
-              expression_add_variable (res->expression, variable, 1.0, NULL);
-              break;
-            }
-        }
+  /* While frozen, the tableau may not be optimal, so we cannot repair
+   * it with the dual simplex yet; we keep the last suggested value, and
+   * apply it when thawing. Transactions need the change in the journal,
+   * so they always apply it directly.
+   */
+  if (solver->freeze_count > 0 && solver->journal == NULL)
+    {
+      ei->pending_value = value;
+      ei->has_pending = true;
+      solver->needs_solving = true;
+      return;
     }
 
-  simplex_solver_add_constraint_internal (solver, res);
+  if (solver->journal != NULL && g_hash_table_add (solver->journal->saved, ei))
+    simplex_solver_journal_push (solver, JOURNAL_EDIT_CONSTANT, ei, NULL, NULL, ei->prev_constant);
 
-  return res;
+  ei->has_pending = false;
+
+  double delta = value - ei->prev_constant;
+
+  ei->prev_constant = value;
+
+  simplex_solver_delta_edit_constant (solver, delta, ei->eplus, ei->eminus);
 }
 
-Constraint *
-simplex_solver_add_stay_variable (SimplexSolver *solver,
-                                  Variable *variable,
-                                  double strength)
+void
+simplex_solver_suggest_value (SimplexSolver *solver,
+                              Variable *variable,
+                              double value)
 {
   if (!solver->initialized)
     {
-      g_critical ("SimplexSolver %p has not been initialized.", solver);
-      return NULL;
-    }
-
-  Constraint *res = g_slice_new0 (Constraint);
-  res->solver = solver;
-  res->variable = variable_ref (variable);
-  res->op_type = OPERATOR_TYPE_EQ;
-  res->strength = strength;
-  res->is_stay = true;
-  res->is_edit = false;
+      char *str = variable_to_string (variable);
 
-  res->expression = expression_new (solver, variable_get_value (res->variable));
-  expression_add_variable (res->expression, res->variable, -1.0, NULL);
+      g_critical ("Unable to suggest value '%g' for variable '%s': the "
+                  "SimplexSolver %p is not initialized.",
+                  value, str, solver);
 
-  simplex_solver_add_constraint_internal (solver, res);
+      g_free (str);
+      return;
+    }
 
-  return res;
+  simplex_solver_apply_suggestion (solver, variable, value);
 }
 
-bool
-simplex_solver_has_stay_variable (SimplexSolver *solver,
-                                  Variable *variable)
+/* Suggests a value for each of the edit @variables, and resolves the
+ * tableau once; the rows made infeasible by more than one suggestion
+ * are only repaired once.
+ */
+void
+simplex_solver_suggest_values (SimplexSolver *solver,
+                               Variable **variables,
+                               const double *values,
+                               guint n_values)
 {
   if (!solver->initialized)
-    return false;
+    {
+      g_critical ("Unable to suggest %u values: the SimplexSolver %p "
+                  "is not initialized.",
+                  n_values, solver);
+      return;
+    }
 
-  return g_hash_table_contains (solver->stay_var_map, variable);
+  for (guint i = 0; i < n_values; i++)
+    simplex_solver_apply_suggestion (solver, variables[i], values[i]);
+
+  simplex_solver_resolve (solver);
 }
 
 void
-simplex_solver_remove_stay_variable (SimplexSolver *solver,
-                                     Variable *variable)
+simplex_solver_resolve (SimplexSolver *solver)
 {
   if (!solver->initialized)
     {
-      g_critical ("Solver %p is not initialized.", solver);
+      g_critical ("Unable to resolve the simplex: the SimplexSolver %p "
+                  "is not initialized",
+                  solver);
       return;
     }
 
-  StayInfo *si = g_hash_table_lookup (solver->stay_var_map, variable);
-  if (si == NULL)
+  /* Deferred until the solver is thawed */
+  if (solver->freeze_count > 0 && solver->journal == NULL)
     {
-      char *str = variable_to_string (variable);
-
-      g_critical ("Unknown stay variable '%s'", str);
-
-      g_free (str);
-
+      solver->needs_solving = true;
       return;
     }
 
-  simplex_solver_remove_constraint (solver, si->constraint);
-}
+  bool converged;
 
-Constraint *
-simplex_solver_add_edit_variable (SimplexSolver *solver,
-                                  Variable *variable,
-                                  double strength)
-{
-  if (!solver->initialized)
-    return NULL;
+#ifdef EMEUS_ENABLE_DEBUG
+  gint64 start_time = g_get_monotonic_time ();
+#endif
 
-  Constraint *res = g_slice_new (Constraint);
-  res->solver = solver;
-  res->variable = variable_ref (variable);
-  res->op_type = OPERATOR_TYPE_EQ;
-  res->strength = strength;
-  res->is_stay = false;
-  res->is_edit = true;
+  simplex_solver_compact_infeasible_rows (solver);
+  converged = simplex_solver_dual_optimize (solver);
+  simplex_solver_set_external_variables (solver);
 
-  res->expression = expression_new (solver, variable_get_value (variable));
-  expression_add_variable (res->expression, variable, -1.0, NULL);
+  /* If the dual simplex gave up, the rows it did not repair are still
+   * queued, and the next call picks up from there
+   */
+  if (converged)
+    simplex_solver_reset_stay_constants (solver);
 
-  simplex_solver_add_constraint_internal (solver, res);
+#ifdef EMEUS_ENABLE_DEBUG
+  g_debug ("resolve.time := %.3f ms",
+           (float) (g_get_monotonic_time () - start_time) / 1000.f);
+#endif
 
-  return res;
+  solver->needs_solving = !converged;
 }
 
-bool
-simplex_solver_has_edit_variable (SimplexSolver *solver,
-                                  Variable *variable)
+void
+simplex_solver_begin_edit (SimplexSolver *solver)
 {
-  if (!solver->initialized)
-    return false;
+  if (g_hash_table_size (solver->edit_var_map) == 0)
+    {
+      g_critical ("Solver %p does not have editable variables.", solver);
+      return;
+    }
 
-  return g_hash_table_contains (solver->edit_var_map, variable);
+  g_ptr_array_set_size (solver->infeasible_rows, 0);
+  simplex_solver_reset_stay_constants (solver);
 }
 
+
 void
-simplex_solver_remove_edit_variable (SimplexSolver *solver,
-                                     Variable *variable)
+simplex_solver_end_edit (SimplexSolver *solver)
 {
-  if (!solver->initialized)
+  simplex_solver_resolve (solver);
+}
+
+static int
+compare_variable_ids (gconstpointer a,
+                      gconstpointer b)
+{
+  return sort_by_variable_id (*(Variable * const *) a, *(Variable * const *) b);
+}
+
+/* Returns all the variables in the tableau, except the objective,
+ * sorted by their creation order; the position of a variable in the
+ * returned array is stable across solvers built in the same way.
+ */
+static GPtrArray *
+simplex_solver_get_tableau_variables (SimplexSolver *solver)
+{
+  GHashTable *seen = g_hash_table_new (NULL, NULL);
+  GPtrArray *res = g_ptr_array_new ();
+  GHashTableIter iter;
+  gpointer key;
+
+  g_hash_table_iter_init (&iter, solver->rows);
+  while (g_hash_table_iter_next (&iter, &key, NULL))
     {
-      g_critical ("Solver %p is not initialized.", solver);
-      return;
+      if (key != solver->objective && g_hash_table_add (seen, key))
+        g_ptr_array_add (res, key);
     }
 
-  EditInfo *ei = g_hash_table_lookup (solver->edit_var_map, variable);
-  if (ei == NULL)
+  g_hash_table_iter_init (&iter, solver->columns);
+  while (g_hash_table_iter_next (&iter, &key, NULL))
     {
-      char *str = variable_to_string (variable);
-
-      g_critical ("Unknown edit variable '%s'", str);
+      if (key != solver->objective && g_hash_table_add (seen, key))
+        g_ptr_array_add (res, key);
+    }
 
-      g_free (str);
+  g_ptr_array_sort (res, compare_variable_ids);
 
-      return;
-    }
+  g_hash_table_unref (seen);
 
-  simplex_solver_remove_constraint (solver, ei->constraint);
+  return res;
 }
 
-void
-simplex_solver_remove_constraint (SimplexSolver *solver,
-                                  Constraint *constraint)
+static guint
+constraint_hash (const Constraint *constraint)
 {
-  Expression *z_row;
-  VariableSet *error_vars;
-  VariableSetIter iter;
-  Variable *marker;
+  const Expression *expression = constraint->expression;
+  guint res = constraint->op_type + 1;
+  GList *l;
 
-  if (!solver->initialized)
-    return;
+  res = res * 31 + g_double_hash (&constraint->strength);
+  res = res * 31 + (constraint->is_stay ? 1 : 0) + (constraint->is_edit ? 2 : 0);
 
-  if (!g_hash_table_contains (solver->constraints, constraint))
-    {
-      char *str = constraint_to_string (constraint);
+  /* The constant of stay and edit constraints depends on the value
+   * the variable had when the constraint was added
+   */
+  if (!constraint->is_stay && !constraint->is_edit)
+    res = res * 31 + g_double_hash (&expression->constant);
 
-      g_critical ("Unknown constraint '%s', unable to remove it from solver", str);
+  for (l = expression->ordered_terms; l != NULL; l = l->next)
+    {
+      const Term *t = l->data;
+      const Variable *v = t->variable;
 
-      g_free (str);
+      res = res * 31 + g_double_hash (&t->coefficient);
+      res = res * 31 + g_str_hash (v->prefix != NULL ? v->prefix : "");
+      res = res * 31 + g_str_hash (v->name != NULL ? v->name : "");
     }
 
-  solver->needs_solving = true;
+  return res;
+}
 
-  simplex_solver_reset_stay_constants (solver);
+/* Computes a hash of the set of constraints in the solver, and of the
+ * variables of the tableau in creation order, which is how the basis
+ * exported by simplex_solver_export_basis() identifies them; it does
+ * not depend on the current state of the tableau, and it is used to
+ * check that an exported basis can be imported.
+ */
+guint
+simplex_solver_hash (SimplexSolver *solver)
+{
+  GPtrArray *variables;
+  GHashTableIter iter;
+  gpointer key;
+  guint res = 0;
 
-  z_row = g_hash_table_lookup (solver->rows, solver->objective);
-  error_vars = g_hash_table_lookup (solver->error_vars, constraint);
+  if (!solver->initialized)
+    return 0;
 
-  if (error_vars != NULL)
+  g_hash_table_iter_init (&iter, solver->constraints);
+  while (g_hash_table_iter_next (&iter, &key, NULL))
+    res += constraint_hash (key);
+
+  /* The same constraints added in a different order create their
+   * variables in a different order as well
+   */
+  variables = simplex_solver_get_tableau_variables (solver);
+  for (guint i = 0; i < variables->len; i++)
     {
-      Variable *v;
+      const Variable *v = g_ptr_array_index (variables, i);
 
-      variable_set_iter_init (error_vars, &iter);
-      while (variable_set_iter_next (&iter, &v))
-        {
-          Expression *e;
+      res = res * 31 + v->type;
+      res = res * 31 + g_str_hash (v->prefix != NULL ? v->prefix : "");
+      res = res * 31 + g_str_hash (v->name != NULL ? v->name : "");
+    }
+  g_ptr_array_unref (variables);
 
-          e = g_hash_table_lookup (solver->rows, v);
+  return res;
+}
 
-          if (e == NULL)
-            {
-              expression_add_variable (z_row,
-                                       v,
-                                       constraint->strength,
-                                       solver->objective);
-            }
-          else
-            {
-              expression_add_expression (z_row,
-                                         e,
-                                         constraint->strength,
-                                         solver->objective);
-            }
-        }
-    }
+/* Exports the current basis of the solver, that is the set of
+ * pivotable variables that are basic in the tableau.
+ *
+ * Each variable is identified by its position among the variables
+ * of the tableau, in creation order, so the basis can be imported
+ * into a solver containing the same constraints, added in the same
+ * order, with simplex_solver_import_basis().
+ *
+ * Returns an array of guint32, to be freed by the caller.
+ */
+GArray *
+simplex_solver_export_basis (SimplexSolver *solver)
+{
+  GArray *res = g_array_new (FALSE, FALSE, sizeof (guint32));
+  GPtrArray *variables;
 
-  marker = g_hash_table_lookup (solver->marker_vars, constraint);
-  if (marker == NULL)
+  if (!solver->initialized)
+    return res;
+
+  variables = simplex_solver_get_tableau_variables (solver);
+
+  for (guint32 i = 0; i < variables->len; i++)
     {
-      g_critical ("Constraint %p not found", constraint);
-      return;
+      Variable *v = g_ptr_array_index (variables, i);
+
+      if (variable_is_pivotable (v) && g_hash_table_contains (solver->rows, v))
+        g_array_append_val (res, i);
     }
 
-  g_hash_table_remove (solver->marker_vars, constraint);
+  g_ptr_array_unref (variables);
 
-  if (g_hash_table_lookup (solver->rows, marker) == NULL)
-    {
-      VariableSet *set = g_hash_table_lookup (solver->columns, marker);
-      Variable *exit_var = NULL;
-      Variable *v;
-      double min_ratio = 0;
+  return res;
+}
 
-      if (set == NULL)
-        goto no_columns;
+static Variable *
+simplex_solver_find_basis_exit (SimplexSolver *solver,
+                                Variable *entry,
+                                GHashTable *basis)
+{
+  VariableSet *column_vars = simplex_solver_get_column_set (solver, entry);
+  VariableSetIter iter;
+  Variable *v, *res = NULL;
+  double max_coeff = 0.0;
 
-      variable_set_iter_init (set, &iter);
-      while (variable_set_iter_next (&iter, &v))
-        {
-          if (variable_is_restricted (v))
-            {
-              Expression *e = g_hash_table_lookup (solver->rows, v);
-              double coeff = expression_get_coefficient (e, marker);
+  if (column_vars == NULL)
+    return NULL;
 
-              if (coeff < 0.0)
-                {
-                  double r = -expression_get_constant (e) / coeff;
+  /* Pick the row with the largest coefficient for the entry variable,
+   * among the ones whose basic variable should become parametric
+   */
+  variable_set_iter_init (column_vars, &iter);
+  while (variable_set_iter_next (&iter, &v))
+    {
+      Expression *expr;
+      double coeff;
 
-                  if (exit_var == NULL ||
-                      r < min_ratio ||
-                      approx_val (r, min_ratio))
-                    {
-                      min_ratio = r;
-                      exit_var = v;
-                    }
-                }
-            }
-        }
+      if (!variable_is_pivotable (v) || g_hash_table_contains (basis, v))
+        continue;
 
-      if (exit_var == NULL)
+      expr = g_hash_table_lookup (solver->rows, v);
+      coeff = fabs (expression_get_coefficient (expr, entry));
+      if (coeff > max_coeff)
         {
-          variable_set_iter_init (set, &iter);
-          while (variable_set_iter_next (&iter, &v))
-            {
-              if (variable_is_restricted (v))
-                {
-                  Expression *e = g_hash_table_lookup (solver->rows, v);
-                  double coeff = expression_get_coefficient (e, marker);
-                  double r = 0.0;
-                  
-                  if (!approx_val (coeff, 0.0))
-                    r = expression_get_constant (e) / coeff;
-
-                  if (exit_var == NULL || r < min_ratio)
-                    {
-                      min_ratio = r;
-                      exit_var = v;
-                    }
-                }
-            }
+          max_coeff = coeff;
+          res = v;
         }
+    }
 
-      if (exit_var == NULL)
-        {
-          if (variable_set_get_size (set) == 0)
-            simplex_solver_remove_column (solver, marker);
-          else
-            {
-              variable_set_iter_init (set, &iter);
-              while (variable_set_iter_next (&iter, &v))
-                {
-                  if (v != solver->objective)
-                    {
-                      exit_var = v;
-                      break;
-                    }
-                }
-            }
-        }
+  if (max_coeff < DBL_EPSILON)
+    return NULL;
 
-      if (exit_var != NULL)
-        simplex_solver_pivot (solver, marker, exit_var);
-    }
+  return res;
+}
 
-no_columns:
-  if (g_hash_table_lookup (solver->rows, marker) != NULL)
-    simplex_solver_remove_row (solver, marker, TRUE);
-  else
-    variable_unref (marker);
+/* Pivots the tableau to the basis exported by a previous call to
+ * simplex_solver_export_basis(), and then optimizes from there; this
+ * allows skipping most of the pivots needed to solve a set of
+ * constraints from scratch.
+ *
+ * The basis is only used if the hash matches simplex_solver_hash(), and
+ * if it results in a feasible tableau; otherwise, the tableau is left
+ * untouched.
+ *
+ * Returns true if the basis was imported.
+ */
+bool
+simplex_solver_import_basis (SimplexSolver *solver,
+                             guint hash,
+                             const guint32 *basis,
+                             guint n_basis)
+{
+  GHashTable *basic_vars;
+  GPtrArray *variables;
+  GHashTableIter iter;
+  gpointer key, value;
+  bool res = true;
 
-  if (error_vars != NULL)
+  if (!solver->initialized || solver->journal != NULL)
+    return false;
+
+  if (hash != simplex_solver_hash (solver))
+    return false;
+
+  variables = simplex_solver_get_tableau_variables (solver);
+  basic_vars = g_hash_table_new (NULL, NULL);
+
+  for (guint i = 0; i < n_basis; i++)
     {
       Variable *v;
 
-      variable_set_iter_init (error_vars, &iter);
-      while (variable_set_iter_next (&iter, &v))
+      if (basis[i] >= variables->len)
         {
-          if (v != marker)
-            simplex_solver_remove_column (solver, v);
+          res = false;
+          break;
         }
-    }
 
-  if (constraint_is_stay (constraint))
-    {
-      if (error_vars != NULL)
+      v = g_ptr_array_index (variables, basis[i]);
+      if (!variable_is_pivotable (v))
         {
-          GPtrArray *remaining = g_ptr_array_new_with_free_func (variable_pair_free);
-          int i = 0;
+          res = false;
+          break;
+        }
 
-          for (i = 0; i < solver->stay_error_vars->len; i++)
-            {
-              VariablePair *pair = g_ptr_array_index (solver->stay_error_vars, i);
-              bool found = false;
+      g_hash_table_add (basic_vars, v);
+    }
 
-              if (variable_set_remove_variable (error_vars, pair->first))
-                found = true;
+  if (!res)
+    goto out;
 
-              if (variable_set_remove_variable (error_vars, pair->second))
-                found = true;
+  /* Pivoting to an arbitrary basis may lead to an infeasible tableau,
+   * so we use a transaction to be able to go back if that's the case
+   */
+  simplex_solver_begin_transaction (solver);
 
-              if (!found)
-                g_ptr_array_add (remaining, variable_pair_new (pair->first, pair->second));
-            }
+  for (guint i = 0; i < variables->len && res; i++)
+    {
+      Variable *entry = g_ptr_array_index (variables, i);
+      Variable *exit;
 
-          g_clear_pointer (&solver->stay_error_vars, g_ptr_array_unref);
-          solver->stay_error_vars = remaining;
-        }
+      if (!g_hash_table_contains (basic_vars, entry) ||
+          g_hash_table_contains (solver->rows, entry))
+        continue;
 
-      g_hash_table_remove (solver->stay_var_map, constraint->variable);
+      exit = simplex_solver_find_basis_exit (solver, entry, basic_vars);
+      if (exit == NULL)
+        res = false;
+      else
+        simplex_solver_pivot (solver, entry, exit);
     }
-  else if (constraint_is_edit (constraint))
-    {
-      EditInfo *ei = g_hash_table_lookup (solver->edit_var_map, constraint->variable);
 
-      simplex_solver_remove_column (solver, ei->eminus);
+  g_hash_table_iter_init (&iter, solver->rows);
+  while (res && g_hash_table_iter_next (&iter, &key, &value))
+    {
+      if (variable_is_restricted (key) &&
+          expression_get_constant (value) < -DBL_EPSILON)
+        res = false;
+    }
 
-      g_hash_table_remove (solver->edit_var_map, constraint->variable);
+  if (!res)
+    {
+      g_debug ("Unable to import basis in solver %p", solver);
+      simplex_solver_rollback_transaction (solver);
+      goto out;
     }
 
-  if (error_vars != NULL)
-    g_hash_table_remove (solver->error_vars, constraint);
+  simplex_solver_commit_transaction (solver);
+
+  solver->needs_solving = true;
 
   if (solver->auto_solve)
     {
@@ -1899,85 +3930,301 @@ no_columns:
       simplex_solver_set_external_variables (solver);
     }
 
-  g_hash_table_remove (solver->constraints, constraint);
+out:
+  g_hash_table_unref (basic_vars);
+  g_ptr_array_unref (variables);
+
+  return res;
 }
 
+/* Begins a transaction on the solver.
+ *
+ * Until the transaction is committed or rolled back, every change
+ * to the tableau is recorded in a journal. Rolling back the
+ * transaction undoes the changes in reverse order, restoring the
+ * rows, columns, and variable values that the solver had when the
+ * transaction began, without pivoting.
+ *
+ * Transactions cannot be nested.
+ */
 void
-simplex_solver_suggest_value (SimplexSolver *solver,
-                              Variable *variable,
-                              double value)
+simplex_solver_begin_transaction (SimplexSolver *solver)
 {
+  SolverJournal *journal;
+
   if (!solver->initialized)
     {
-      char *str = variable_to_string (variable);
-
-      g_critical ("Unable to suggest value '%g' for variable '%s': the "
-                  "SimplexSolver %p is not initialized.",
-                  value, str, solver);
-
-      g_free (str);
+      g_critical ("SimplexSolver %p is not initialized.", solver);
       return;
     }
 
-  EditInfo *ei = g_hash_table_lookup (solver->edit_var_map, variable);
-  if (ei == NULL)
+  if (solver->journal != NULL)
     {
-      g_critical ("Suggesting value '%g' but variable %p is not editable",
-                  value, variable);
+      g_critical ("SimplexSolver %p already has an open transaction.", solver);
       return;
     }
 
-  ei->prev_constant = value - ei->prev_constant;
+  journal = g_slice_new (SolverJournal);
+  journal->entries = g_array_new (FALSE, FALSE, sizeof (JournalEntry));
+  journal->saved = g_hash_table_new (NULL, NULL);
+  journal->infeasible_rows = g_ptr_array_sized_new (solver->infeasible_rows->len);
 
-  simplex_solver_delta_edit_constant (solver, ei->prev_constant, ei->eplus, ei->eminus);
+  for (int i = 0; i < solver->infeasible_rows->len; i++)
+    g_ptr_array_add (journal->infeasible_rows, g_ptr_array_index (solver->infeasible_rows, i));
+
+  journal->slack_counter = solver->slack_counter;
+  journal->artificial_counter = solver->artificial_counter;
+  journal->dummy_counter = solver->dummy_counter;
+  journal->generation = solver->generation;
+  journal->needs_solving = solver->needs_solving;
+
+  solver->journal = journal;
 }
 
+/* Keeps all the changes made since simplex_solver_begin_transaction(),
+ * and releases the journal.
+ */
 void
-simplex_solver_resolve (SimplexSolver *solver)
+simplex_solver_commit_transaction (SimplexSolver *solver)
 {
-  if (!solver->initialized)
+  if (solver->journal == NULL)
     {
-      g_critical ("Unable to resolve the simplex: the SimplexSolver %p "
-                  "is not initialized",
-                  solver);
+      g_critical ("SimplexSolver %p does not have an open transaction.", solver);
+      return;
+    }
+
+  simplex_solver_journal_free (solver, false);
+}
+
+/* Undoes all the changes made since simplex_solver_begin_transaction().
+ *
+ * Constraints added to the solver during the transaction are freed,
+ * and must not be used after this function returns.
+ */
+void
+simplex_solver_rollback_transaction (SimplexSolver *solver)
+{
+  if (solver->journal == NULL)
+    {
+      g_critical ("SimplexSolver %p does not have an open transaction.", solver);
       return;
     }
 
 #ifdef EMEUS_ENABLE_DEBUG
   gint64 start_time = g_get_monotonic_time ();
+  guint n_entries = solver->journal->entries->len;
 #endif
 
-  simplex_solver_dual_optimize (solver);
-  simplex_solver_set_external_variables (solver);
-
-  g_ptr_array_set_size (solver->infeasible_rows, 0);
-
-  simplex_solver_reset_stay_constants (solver);
+  simplex_solver_journal_free (solver, true);
 
 #ifdef EMEUS_ENABLE_DEBUG
-  g_debug ("resolve.time := %.3f ms",
-           (float) (g_get_monotonic_time () - start_time) / 1000.f);
+  g_debug ("rollback.time := %.3f ms (entries:%u)",
+           (float) (g_get_monotonic_time () - start_time) / 1000.f,
+           n_entries);
 #endif
+}
 
-  solver->needs_solving = false;
+
+/* Sets the maximum number of pivots that a single optimization pass can
+ * do before giving up, to bound the time spent on a degenerate tableau;
+ * 0 uses a bound computed from the size of the tableau.
+ */
+void
+simplex_solver_set_max_iterations (SimplexSolver *solver,
+                                   guint max_iterations)
+{
+  solver->max_iterations = max_iterations;
 }
 
+/* Sets the number of consecutive degenerate pivots after which a single
+ * optimization pass switches to Bland's rule, which cannot cycle but is
+ * slower to converge; 0 uses the default value.
+ */
 void
-simplex_solver_begin_edit (SimplexSolver *solver)
+simplex_solver_set_max_degenerate_pivots (SimplexSolver *solver,
+                                          guint max_pivots)
 {
-  if (g_hash_table_size (solver->edit_var_map) == 0)
+  solver->max_degenerate_pivots = max_pivots;
+}
+
+/* Retrieves the number of pivots chosen using Bland's rule since the
+ * solver was initialized
+ */
+guint
+simplex_solver_get_bland_pivot_count (SimplexSolver *solver)
+{
+  return solver->bland_pivot_count;
+}
+
+guint
+simplex_solver_get_generation (SimplexSolver *solver)
+{
+  return solver->generation;
+}
+
+/* Retrieves the marker variables of @params, which must be required
+ * stays; changing the value of a stay by a delta is equivalent to
+ * moving its marker by the same delta, so as long as the
+ * marker is not in the basis, the rows of the tableau tell us how the
+ * solution changes with the value of the stay
+ */
+static bool
+simplex_solver_get_param_markers (SimplexSolver *solver,
+                                  Constraint * const *params,
+                                  guint n_params,
+                                  Variable **markers)
+{
+  if (!solver->initialized)
     {
-      g_critical ("Solver %p does not have editable variables.", solver);
-      return;
+      g_critical ("SimplexSolver %p is not initialized.", solver);
+      return false;
     }
 
-  g_ptr_array_set_size (solver->infeasible_rows, 0);
-  simplex_solver_reset_stay_constants (solver);
+  if (solver->needs_solving || solver->infeasible_rows->len > 0)
+    return false;
+
+  for (guint i = 0; i < n_params; i++)
+    {
+      Constraint *param = params[i];
+
+      if (param == NULL ||
+          !constraint_is_stay (param) ||
+          !constraint_is_required (param))
+        return false;
+
+      markers[i] = g_hash_table_lookup (solver->marker_vars, param);
+      if (markers[i] == NULL || g_hash_table_contains (solver->rows, markers[i]))
+        return false;
+    }
+
+  return true;
 }
 
+static void
+simplex_solver_add_slopes (SimplexSolver *solver,
+                           Variable *variable,
+                           double coefficient,
+                           Variable **markers,
+                           guint n_params,
+                           double *slopes)
+{
+  Expression *row = g_hash_table_lookup (solver->rows, variable);
+
+  /* Parametric variables are not in the basis, and do not move */
+  if (row == NULL)
+    return;
 
-void
-simplex_solver_end_edit (SimplexSolver *solver)
+  for (guint i = 0; i < n_params; i++)
+    slopes[i] += coefficient * expression_get_coefficient (row, markers[i]);
+}
+
+/* Computes the rate of change of the value of @variable with respect
+ * to the value of each of the required stays in @params, as long as
+ * the basis of the tableau does not change.
+ *
+ * Returns false if the stays cannot be used as parameters, e.g. the
+ * solver has not been solved yet.
+ */
+bool
+simplex_solver_get_sensitivity (SimplexSolver *solver,
+                                Constraint * const *params,
+                                guint n_params,
+                                Variable *variable,
+                                double *slopes)
 {
-  simplex_solver_resolve (solver);
+  Variable **markers = g_newa (Variable *, MAX (n_params, 1));
+  Alias *alias;
+
+  if (!simplex_solver_get_param_markers (solver, params, n_params, markers))
+    return false;
+
+  for (guint i = 0; i < n_params; i++)
+    slopes[i] = 0.0;
+
+  alias = g_hash_table_lookup (solver->aliases, variable);
+  if (alias != NULL)
+    {
+      GList *terms = expression_get_terms (alias->expression);
+
+      for (GList *l = terms; l != NULL; l = l->next)
+        {
+          Term *t = l->data;
+
+          simplex_solver_add_slopes (solver, term_get_variable (t),
+                                     term_get_coefficient (t),
+                                     markers, n_params,
+                                     slopes);
+        }
+
+      g_list_free (terms);
+    }
+  else
+    simplex_solver_add_slopes (solver, variable, 1.0, markers, n_params, slopes);
+
+  return true;
+}
+
+/* Computes the region of values of the stays in @params for which the
+ * basis of the tableau stays feasible, and thus optimal, as changing the
+ * value of a stay only changes the constants of the rows.
+ *
+ * The region is returned as a set of half-spaces, each made of a constant
+ * followed by @n_params coefficients; moving the stays by a delta keeps
+ * the basis if, for every half-space:
+ *
+ *   constant + Σ coefficient[i] * delta[i] >= 0
+ *
+ * Returns NULL if the stays cannot be used as parameters.
+ */
+GArray *
+simplex_solver_get_feasible_region (SimplexSolver *solver,
+                                    Constraint * const *params,
+                                    guint n_params)
+{
+  Variable **markers = g_newa (Variable *, MAX (n_params, 1));
+  double *half_space = g_newa (double, n_params + 1);
+  GHashTableIter iter;
+  gpointer key_p, value_p;
+  GArray *res;
+
+  if (!simplex_solver_get_param_markers (solver, params, n_params, markers))
+    return NULL;
+
+  res = g_array_new (FALSE, FALSE, sizeof (double));
+
+  g_hash_table_iter_init (&iter, solver->rows);
+  while (g_hash_table_iter_next (&iter, &key_p, &value_p))
+    {
+      Variable *basic_var = key_p;
+      Expression *row = value_p;
+      bool is_constant = true;
+
+      /* Unrestricted variables can take any value */
+      if (!variable_is_restricted (basic_var) || basic_var == solver->objective)
+        continue;
+
+      half_space[0] = expression_get_constant (row);
+      for (guint i = 0; i < n_params; i++)
+        {
+          half_space[i + 1] = expression_get_coefficient (row, markers[i]);
+          if (!approx_val (half_space[i + 1], 0.0))
+            is_constant = false;
+        }
+
+      if (is_constant)
+        continue;
+
+      /* A dummy in the basis must stay at zero, so any movement of the
+       * stays would require pivoting
+       */
+      if (variable_is_dummy (basic_var))
+        {
+          g_array_unref (res);
+          return NULL;
+        }
+
+      g_array_append_vals (res, half_space, n_params + 1);
+    }
+
+  return res;
 }
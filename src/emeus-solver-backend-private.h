@@ -0,0 +1,204 @@
+/* emeus-solver-backend-private.h: Solver backends
+ *
+ * Copyright 2016  Endless
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "emeus-types-private.h"
+
+G_BEGIN_DECLS
+
+/* The operations used by the layout to drive its solver.
+ *
+ * The variables, expressions and constraints are shared by all backends,
+ * and the state of the solver is always kept in a SimplexSolver, so that
+ * the layout does not need to know which backend it is using; a backend
+ * can keep additional state in the backend_data field of the solver.
+ *
+ * The default backend is the Cassowary implementation of the simplex
+ * solver; a different backend can be selected by name through the
+ * EMEUS_SOLVER_BACKEND environment variable, or for a single layout.
+ */
+struct _SolverBackend {
+  const char *name;
+
+  /* Whether the backend keeps a Cassowary tableau, which the layout can
+   * query for the sensitivity of the solution, and export as a basis
+   */
+  bool has_tableau;
+
+  void (* init) (SimplexSolver *solver);
+  void (* clear) (SimplexSolver *solver);
+
+  Variable *(* create_variable) (SimplexSolver *solver,
+                                 const char *name,
+                                 double value);
+  double (* get_value) (SimplexSolver *solver,
+                        Variable *variable);
+
+  Constraint *(* add_constraint) (SimplexSolver *solver,
+                                  Variable *variable,
+                                  OperatorType op,
+                                  Expression *expression,
+                                  double strength);
+  void (* remove_constraint) (SimplexSolver *solver,
+                              Constraint *constraint);
+
+  Constraint *(* add_stay_variable) (SimplexSolver *solver,
+                                     Variable *variable,
+                                     double strength);
+  Constraint *(* add_edit_variable) (SimplexSolver *solver,
+                                     Variable *variable,
+                                     double strength);
+
+  void (* suggest_value) (SimplexSolver *solver,
+                          Variable *variable,
+                          double value);
+  void (* suggest_values) (SimplexSolver *solver,
+                           Variable **variables,
+                           const double *values,
+                           guint n_values);
+  void (* resolve) (SimplexSolver *solver);
+
+  void (* freeze) (SimplexSolver *solver);
+  void (* thaw) (SimplexSolver *solver);
+
+  void (* begin_transaction) (SimplexSolver *solver);
+  void (* commit_transaction) (SimplexSolver *solver);
+  void (* rollback_transaction) (SimplexSolver *solver);
+};
+
+const SolverBackend *solver_backend_get_default (void);
+const SolverBackend *solver_backend_lookup (const char *name);
+
+void solver_init (SimplexSolver *solver,
+                  const SolverBackend *backend);
+
+static inline void
+solver_clear (SimplexSolver *solver)
+{
+  solver->backend->clear (solver);
+}
+
+static inline Variable *
+solver_create_variable (SimplexSolver *solver,
+                        const char *name,
+                        double value)
+{
+  return solver->backend->create_variable (solver, name, value);
+}
+
+static inline double
+solver_get_value (SimplexSolver *solver,
+                  Variable *variable)
+{
+  return solver->backend->get_value (solver, variable);
+}
+
+static inline Constraint *
+solver_add_constraint (SimplexSolver *solver,
+                       Variable *variable,
+                       OperatorType op,
+                       Expression *expression,
+                       double strength)
+{
+  return solver->backend->add_constraint (solver, variable, op, expression, strength);
+}
+
+static inline void
+solver_remove_constraint (SimplexSolver *solver,
+                          Constraint *constraint)
+{
+  solver->backend->remove_constraint (solver, constraint);
+}
+
+static inline Constraint *
+solver_add_stay_variable (SimplexSolver *solver,
+                          Variable *variable,
+                          double strength)
+{
+  return solver->backend->add_stay_variable (solver, variable, strength);
+}
+
+static inline Constraint *
+solver_add_edit_variable (SimplexSolver *solver,
+                          Variable *variable,
+                          double strength)
+{
+  return solver->backend->add_edit_variable (solver, variable, strength);
+}
+
+static inline void
+solver_suggest_value (SimplexSolver *solver,
+                      Variable *variable,
+                      double value)
+{
+  solver->backend->suggest_value (solver, variable, value);
+}
+
+static inline void
+solver_suggest_values (SimplexSolver *solver,
+                       Variable **variables,
+                       const double *values,
+                       guint n_values)
+{
+  solver->backend->suggest_values (solver, variables, values, n_values);
+}
+
+static inline void
+solver_resolve (SimplexSolver *solver)
+{
+  solver->backend->resolve (solver);
+}
+
+static inline void
+solver_freeze (SimplexSolver *solver)
+{
+  solver->backend->freeze (solver);
+}
+
+static inline void
+solver_thaw (SimplexSolver *solver)
+{
+  solver->backend->thaw (solver);
+}
+
+static inline void
+solver_begin_transaction (SimplexSolver *solver)
+{
+  solver->backend->begin_transaction (solver);
+}
+
+static inline void
+solver_commit_transaction (SimplexSolver *solver)
+{
+  solver->backend->commit_transaction (solver);
+}
+
+static inline void
+solver_rollback_transaction (SimplexSolver *solver)
+{
+  solver->backend->rollback_transaction (solver);
+}
+
+static inline bool
+solver_has_tableau (SimplexSolver *solver)
+{
+  return solver->backend->has_tableau;
+}
+
+G_END_DECLS
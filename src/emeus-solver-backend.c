@@ -0,0 +1,409 @@
+/* emeus-solver-backend.c: Solver backends
+ *
+ * Copyright 2016  Endless
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include "emeus-solver-backend-private.h"
+
+#include "emeus-expression-private.h"
+#include "emeus-lp-solver-private.h"
+#include "emeus-simplex-solver-private.h"
+
+#include <glib.h>
+
+/* Cassowary: the incremental simplex solver */
+
+static double
+cassowary_get_value (SimplexSolver *solver,
+                     Variable *variable)
+{
+  return variable_get_value (variable);
+}
+
+static const SolverBackend cassowary_backend = {
+  .name = "cassowary",
+  .has_tableau = true,
+
+  .init = simplex_solver_init,
+  .clear = simplex_solver_clear,
+
+  .create_variable = simplex_solver_create_variable,
+  .get_value = cassowary_get_value,
+
+  .add_constraint = simplex_solver_add_constraint,
+  .remove_constraint = simplex_solver_remove_constraint,
+
+  .add_stay_variable = simplex_solver_add_stay_variable,
+  .add_edit_variable = simplex_solver_add_edit_variable,
+
+  .suggest_value = simplex_solver_suggest_value,
+  .suggest_values = simplex_solver_suggest_values,
+  .resolve = simplex_solver_resolve,
+
+  .freeze = simplex_solver_freeze,
+  .thaw = simplex_solver_thaw,
+
+  .begin_transaction = simplex_solver_begin_transaction,
+  .commit_transaction = simplex_solver_commit_transaction,
+  .rollback_transaction = simplex_solver_rollback_transaction,
+};
+
+/* Profile: the Cassowary solver, counting and timing the operations
+ * that change the tableau; the totals are printed when the solver is
+ * cleared, to compare the cost of a workload across changes
+ */
+
+typedef enum {
+  PROFILE_ADD_CONSTRAINT,
+  PROFILE_REMOVE_CONSTRAINT,
+  PROFILE_ADD_STAY,
+  PROFILE_ADD_EDIT,
+  PROFILE_SUGGEST_VALUE,
+  PROFILE_SUGGEST_VALUES,
+  PROFILE_RESOLVE,
+  PROFILE_THAW,
+
+  N_PROFILE_OPS
+} ProfileOp;
+
+static const char *profile_op_names[N_PROFILE_OPS] = {
+  [PROFILE_ADD_CONSTRAINT]      = "add-constraint",
+  [PROFILE_REMOVE_CONSTRAINT]   = "remove-constraint",
+  [PROFILE_ADD_STAY]            = "add-stay",
+  [PROFILE_ADD_EDIT]            = "add-edit",
+  [PROFILE_SUGGEST_VALUE]       = "suggest-value",
+  [PROFILE_SUGGEST_VALUES]      = "suggest-values",
+  [PROFILE_RESOLVE]             = "resolve",
+  [PROFILE_THAW]                = "thaw",
+};
+
+typedef struct {
+  guint n_calls[N_PROFILE_OPS];
+  gint64 total_time[N_PROFILE_OPS];
+} ProfileData;
+
+static inline void
+profile_record (SimplexSolver *solver,
+                ProfileOp op,
+                gint64 start_time)
+{
+  ProfileData *data = solver->backend_data;
+
+  data->n_calls[op] += 1;
+  data->total_time[op] += g_get_monotonic_time () - start_time;
+}
+
+static void
+profile_init (SimplexSolver *solver)
+{
+  simplex_solver_init (solver);
+
+  solver->backend_data = g_new0 (ProfileData, 1);
+}
+
+static void
+profile_clear (SimplexSolver *solver)
+{
+  ProfileData *data = solver->backend_data;
+
+  if (data != NULL)
+    {
+      for (int i = 0; i < N_PROFILE_OPS; i++)
+        {
+          if (data->n_calls[i] == 0)
+            continue;
+
+          g_message ("solver %p: %s: %u calls, %.3f ms",
+                     solver,
+                     profile_op_names[i],
+                     data->n_calls[i],
+                     (float) data->total_time[i] / 1000.f);
+        }
+
+      g_free (data);
+      solver->backend_data = NULL;
+    }
+
+  simplex_solver_clear (solver);
+}
+
+static Constraint *
+profile_add_constraint (SimplexSolver *solver,
+                        Variable *variable,
+                        OperatorType op,
+                        Expression *expression,
+                        double strength)
+{
+  gint64 start_time = g_get_monotonic_time ();
+  Constraint *res;
+
+  res = simplex_solver_add_constraint (solver, variable, op, expression, strength);
+  profile_record (solver, PROFILE_ADD_CONSTRAINT, start_time);
+
+  return res;
+}
+
+static void
+profile_remove_constraint (SimplexSolver *solver,
+                           Constraint *constraint)
+{
+  gint64 start_time = g_get_monotonic_time ();
+
+  simplex_solver_remove_constraint (solver, constraint);
+  profile_record (solver, PROFILE_REMOVE_CONSTRAINT, start_time);
+}
+
+static Constraint *
+profile_add_stay_variable (SimplexSolver *solver,
+                           Variable *variable,
+                           double strength)
+{
+  gint64 start_time = g_get_monotonic_time ();
+  Constraint *res;
+
+  res = simplex_solver_add_stay_variable (solver, variable, strength);
+  profile_record (solver, PROFILE_ADD_STAY, start_time);
+
+  return res;
+}
+
+static Constraint *
+profile_add_edit_variable (SimplexSolver *solver,
+                           Variable *variable,
+                           double strength)
+{
+  gint64 start_time = g_get_monotonic_time ();
+  Constraint *res;
+
+  res = simplex_solver_add_edit_variable (solver, variable, strength);
+  profile_record (solver, PROFILE_ADD_EDIT, start_time);
+
+  return res;
+}
+
+static void
+profile_suggest_value (SimplexSolver *solver,
+                       Variable *variable,
+                       double value)
+{
+  gint64 start_time = g_get_monotonic_time ();
+
+  simplex_solver_suggest_value (solver, variable, value);
+  profile_record (solver, PROFILE_SUGGEST_VALUE, start_time);
+}
+
+static void
+profile_suggest_values (SimplexSolver *solver,
+                        Variable **variables,
+                        const double *values,
+                        guint n_values)
+{
+  gint64 start_time = g_get_monotonic_time ();
+
+  simplex_solver_suggest_values (solver, variables, values, n_values);
+  profile_record (solver, PROFILE_SUGGEST_VALUES, start_time);
+}
+
+static void
+profile_resolve (SimplexSolver *solver)
+{
+  gint64 start_time = g_get_monotonic_time ();
+
+  simplex_solver_resolve (solver);
+  profile_record (solver, PROFILE_RESOLVE, start_time);
+}
+
+static void
+profile_thaw (SimplexSolver *solver)
+{
+  gint64 start_time = g_get_monotonic_time ();
+
+  simplex_solver_thaw (solver);
+  profile_record (solver, PROFILE_THAW, start_time);
+}
+
+static const SolverBackend profile_backend = {
+  .name = "profile",
+  .has_tableau = true,
+
+  .init = profile_init,
+  .clear = profile_clear,
+
+  .create_variable = simplex_solver_create_variable,
+  .get_value = cassowary_get_value,
+
+  .add_constraint = profile_add_constraint,
+  .remove_constraint = profile_remove_constraint,
+
+  .add_stay_variable = profile_add_stay_variable,
+  .add_edit_variable = profile_add_edit_variable,
+
+  .suggest_value = profile_suggest_value,
+  .suggest_values = profile_suggest_values,
+  .resolve = profile_resolve,
+
+  .freeze = simplex_solver_freeze,
+  .thaw = profile_thaw,
+
+  .begin_transaction = simplex_solver_begin_transaction,
+  .commit_transaction = simplex_solver_commit_transaction,
+  .rollback_transaction = simplex_solver_rollback_transaction,
+};
+
+/* Revised: the revised simplex method, on the sparse rows of a linear
+ * program, with a factorized basis; see emeus-lp-solver.c. It does not
+ * rewrite the constraints into a tableau, so its memory scales with the
+ * number of nonzero coefficients, which makes it a better fit for very
+ * large layouts.
+ */
+
+static void
+revised_init (SimplexSolver *solver)
+{
+  lp_solver_init (solver, &lp_revised_engine);
+}
+
+static const SolverBackend revised_backend = {
+  .name = "revised",
+  .has_tableau = false,
+
+  .init = revised_init,
+  .clear = lp_solver_clear,
+
+  .create_variable = simplex_solver_create_variable,
+  .get_value = lp_solver_get_value,
+
+  .add_constraint = lp_solver_add_constraint,
+  .remove_constraint = lp_solver_remove_constraint,
+
+  .add_stay_variable = lp_solver_add_stay_variable,
+  .add_edit_variable = lp_solver_add_edit_variable,
+
+  .suggest_value = lp_solver_suggest_value,
+  .suggest_values = lp_solver_suggest_values,
+  .resolve = lp_solver_resolve,
+
+  .freeze = lp_solver_freeze,
+  .thaw = lp_solver_thaw,
+
+  .begin_transaction = lp_solver_begin_transaction,
+  .commit_transaction = lp_solver_commit_transaction,
+  .rollback_transaction = lp_solver_rollback_transaction,
+};
+
+/* Dense: the solver of the revised backend, but keeping the whole
+ * tableau of the program, whose rows are updated with the vector
+ * instructions of the CPU; see emeus-lp-dense.c. Programs with more than a few hundred rows switch to
+ * the revised simplex engine automatically.
+ */
+
+static void
+dense_init (SimplexSolver *solver)
+{
+  lp_solver_init (solver, &lp_dense_engine);
+}
+
+static const SolverBackend dense_backend = {
+  .name = "dense",
+  .has_tableau = false,
+
+  .init = dense_init,
+  .clear = lp_solver_clear,
+
+  .create_variable = simplex_solver_create_variable,
+  .get_value = lp_solver_get_value,
+
+  .add_constraint = lp_solver_add_constraint,
+  .remove_constraint = lp_solver_remove_constraint,
+
+  .add_stay_variable = lp_solver_add_stay_variable,
+  .add_edit_variable = lp_solver_add_edit_variable,
+
+  .suggest_value = lp_solver_suggest_value,
+  .suggest_values = lp_solver_suggest_values,
+  .resolve = lp_solver_resolve,
+
+  .freeze = lp_solver_freeze,
+  .thaw = lp_solver_thaw,
+
+  .begin_transaction = lp_solver_begin_transaction,
+  .commit_transaction = lp_solver_commit_transaction,
+  .rollback_transaction = lp_solver_rollback_transaction,
+};
+
+static const SolverBackend *solver_backends[] = {
+  &cassowary_backend,
+  &profile_backend,
+  &revised_backend,
+  &dense_backend,
+};
+
+/* Returns the backend called @name, or NULL if there is none */
+const SolverBackend *
+solver_backend_lookup (const char *name)
+{
+  for (int i = 0; i < G_N_ELEMENTS (solver_backends); i++)
+    {
+      if (g_strcmp0 (solver_backends[i]->name, name) == 0)
+        return solver_backends[i];
+    }
+
+  return NULL;
+}
+
+/* Returns the backend named by the EMEUS_SOLVER_BACKEND environment
+ * variable, if set, or the Cassowary solver
+ */
+const SolverBackend *
+solver_backend_get_default (void)
+{
+  static const SolverBackend *default_backend;
+
+  if (default_backend == NULL)
+    {
+      const char *name = g_getenv ("EMEUS_SOLVER_BACKEND");
+
+      if (name != NULL)
+        {
+          default_backend = solver_backend_lookup (name);
+
+          if (default_backend == NULL)
+            g_warning ("Unknown solver backend '%s', using '%s' instead",
+                       name,
+                       cassowary_backend.name);
+        }
+
+      if (default_backend == NULL)
+        default_backend = &cassowary_backend;
+    }
+
+  return default_backend;
+}
+
+/* Initializes @solver using @backend, or the default backend if NULL */
+void
+solver_init (SimplexSolver *solver,
+             const SolverBackend *backend)
+{
+  if (backend == NULL)
+    backend = solver_backend_get_default ();
+
+  backend->init (solver);
+
+  solver->backend = backend;
+}
@@ -24,6 +24,8 @@
 G_BEGIN_DECLS
 
 typedef struct _SimplexSolver   SimplexSolver;
+typedef struct _SolverJournal   SolverJournal;
+typedef struct _SolverBackend   SolverBackend;
 
 typedef enum {
   VARIABLE_DUMMY     = 'd',
@@ -55,6 +57,9 @@ typedef struct {
   double coefficient;
 
   Variable *variable;
+
+  /* The node of the term in the ordered terms of its expression */
+  GList *link;
 } Term;
 
 typedef struct {
@@ -132,8 +137,13 @@ typedef struct {
     NULL, NULL, \
     NULL, \
     NULL, \
+    NULL, NULL, \
+    NULL, \
     0, 0, 0, 0, 0, \
+    0, 0, \
     false, false, \
+    NULL, \
+    NULL, NULL, \
   }
 
 struct _SimplexSolver {
@@ -162,14 +172,51 @@ struct _SimplexSolver {
 
   GHashTable *constraints;
 
+  /* Variables replaced by an expression through a required equality,
+   * instead of entering the tableau
+   */
+  GHashTable *aliases;
+  GHashTable *alias_constraints;
+
+  /* Required bounds of zero, satisfied by restricting their variable
+   * instead of adding a row to the tableau
+   */
+  GHashTable *bound_constraints;
+
   int slack_counter;
   int artificial_counter;
   int dummy_counter;
   int optimize_count;
   int freeze_count;
 
+  /* Incremented every time the set of constraints, or the value of an
+   * edit variable, changes; values computed by the solver for a given
+   * generation stay valid until it changes
+   */
+  guint generation;
+
+  /* The maximum number of pivots in an optimization pass, or 0 */
+  guint max_iterations;
+
+  /* The number of consecutive degenerate pivots after which an
+   * optimization pass switches to Bland's rule, or 0
+   */
+  guint max_degenerate_pivots;
+
+  /* The number of pivots chosen using Bland's rule */
+  guint bland_pivot_count;
+
   bool auto_solve;
   bool needs_solving;
+
+  /* The undo log of the current transaction, if any */
+  SolverJournal *journal;
+
+  /* The backend driving the solver, and its private data; see
+   * emeus-solver-backend-private.h
+   */
+  const SolverBackend *backend;
+  gpointer backend_data;
 };
 
 G_END_DECLS
@@ -39,4 +39,19 @@ const char *strength_to_string (double strength);
 
 bool approx_val (double v1, double v2);
 
+/* The serialized form of a set of constraints, as generated by the
+ * emeus-gen-constraints tool: a version, followed by an array of
+ *
+ *   (target name, target attribute, relation,
+ *    source name, source attribute,
+ *    multiplier, constant, strength)
+ *
+ * The attributes, relation, and strength are stored using the values
+ * of the public enumerations; an empty source name is used for constant
+ * constraints. The data is stored in little endian byte order.
+ */
+#define CONSTRAINTS_BLOB_VERSION        1
+#define CONSTRAINTS_BLOB_TYPE           "(ua(syysyddi))"
+#define CONSTRAINTS_BLOB_ITEM           "(&syy&syddi)"
+
 G_END_DECLS
@@ -27,6 +27,12 @@ typedef struct {
   double constant;
   double multiplier;
   double strength;
+
+  /* The named metric contributing to the constant, if any; the
+   * constant already includes metric_multiplier times its value
+   */
+  const char *metric;
+  double metric_multiplier;
 } VflConstraint;
 
 GQuark vfl_error_quark (void);
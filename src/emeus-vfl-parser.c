@@ -18,6 +18,12 @@ typedef struct {
   char *object;
   const char *attr;
 
+  /* The metric the constant was resolved from, if any, and the
+   * factor applied to it by the operators
+   */
+  const char *metric;
+  double metric_multiplier;
+
   double priority;
 } VflPredicate;
 
@@ -259,6 +265,8 @@ parse_predicate (VflParser *parser,
 
   predicate->object = NULL;
   predicate->multiplier = 1.0;
+  predicate->metric = NULL;
+  predicate->metric_multiplier = 0.0;
 
   /*         <predicate> = (<relation>)? (<objectOfPredicate>) ('.'<attribute>)? (<operator>)? ('@'<priority>)?
    *          <relation> = '==' | '<=' | '>='
@@ -332,6 +340,8 @@ parse_predicate (VflParser *parser,
           predicate->object = NULL;
           predicate->attr = default_attribute[orientation];
           predicate->constant = *val;
+          predicate->metric = g_intern_string (name);
+          predicate->metric_multiplier = 1.0;
 
           g_free (name);
 
@@ -345,6 +355,8 @@ parse_predicate (VflParser *parser,
           predicate->object = NULL;
           predicate->attr = default_attribute[orientation];
           predicate->constant = *val;
+          predicate->metric = g_intern_string (name);
+          predicate->metric_multiplier = 1.0;
 
           g_free (name);
 
@@ -456,10 +468,11 @@ parse_operators:
       else
         {
           /* If the subject is a constant then apply multiplier directly */
-          if (*operator == '*')
-            predicate->constant *= multiplier;
-          else
-            predicate->constant *= 1.0 / multiplier;
+          if (*operator == '/')
+            multiplier = 1.0 / multiplier;
+
+          predicate->constant *= multiplier;
+          predicate->metric_multiplier *= multiplier;
         }
     }
 
@@ -1068,6 +1081,8 @@ vfl_parser_get_constraints (VflParser *parser,
               c.constant = p->constant;
               c.multiplier = p->multiplier;
               c.strength = p->priority;
+              c.metric = p->metric;
+              c.metric_multiplier = p->metric_multiplier;
 
               g_array_append_val (constraints, c);
             }
@@ -1097,18 +1112,24 @@ vfl_parser_get_constraints (VflParser *parser,
               c.constant = p->constant * -1.0;
               c.relation = p->relation;
               c.strength = p->priority;
+              c.metric = p->metric;
+              c.metric_multiplier = p->metric_multiplier * -1.0;
             }
           else if (iter->spacing.is_default)
             {
               c.constant = get_default_spacing (parser) * -1.0;
               c.relation = OPERATOR_TYPE_EQ;
               c.strength = STRENGTH_REQUIRED;
+              c.metric = NULL;
+              c.metric_multiplier = 0.0;
             }
           else
             {
               c.constant = iter->spacing.size * -1.0;
               c.relation = OPERATOR_TYPE_EQ;
               c.strength = STRENGTH_REQUIRED;
+              c.metric = NULL;
+              c.metric_multiplier = 0.0;
             }
 
           c.multiplier = 1.0;
@@ -1137,6 +1158,8 @@ vfl_parser_get_constraints (VflParser *parser,
           c.constant = 0.0;
           c.multiplier = 1.0;
           c.strength = STRENGTH_REQUIRED;
+          c.metric = NULL;
+          c.metric_multiplier = 0.0;
 
           g_array_append_val (constraints, c);
         }
@@ -26,6 +26,7 @@
 #include "emeus-version-macros.h"
 
 #include "emeus-constraint.h"
+#include "emeus-constraint-group.h"
 #include "emeus-constraint-layout.h"
 #include "emeus-utils.h"
 
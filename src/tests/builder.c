@@ -0,0 +1,215 @@
+#include "emeus.h"
+
+#include "emeus-constraint-layout-private.h"
+
+#include "emeus-test-utils.h"
+
+#include <gtk/gtk.h>
+#include <glib/gstdio.h>
+
+/* The temporary directory used as the user cache directory */
+static char *cache_dir;
+
+static GtkBuilder *
+builder_new (const char *ui)
+{
+  g_type_ensure (EMEUS_TYPE_CONSTRAINT_LAYOUT);
+
+  return gtk_builder_new_from_string (ui, -1);
+}
+
+/* Returns the number of bases in the cache directory */
+static guint
+count_cached_bases (void)
+{
+  char *dir = g_build_filename (cache_dir, "emeus", NULL);
+  GDir *d = g_dir_open (dir, 0, NULL);
+  const char *name;
+  guint res = 0;
+
+  if (d != NULL)
+    {
+      while ((name = g_dir_read_name (d)) != NULL)
+        {
+          if (g_str_has_suffix (name, ".basis"))
+            res += 1;
+        }
+
+      g_dir_close (d);
+    }
+
+  g_free (dir);
+
+  return res;
+}
+
+static void
+remove_cache_dir (void)
+{
+  char *dir = g_build_filename (cache_dir, "emeus", NULL);
+  GDir *d = g_dir_open (dir, 0, NULL);
+  const char *name;
+
+  if (d != NULL)
+    {
+      while ((name = g_dir_read_name (d)) != NULL)
+        {
+          char *path = g_build_filename (dir, name, NULL);
+
+          g_unlink (path);
+          g_free (path);
+        }
+
+      g_dir_close (d);
+    }
+
+  g_rmdir (dir);
+  g_rmdir (cache_dir);
+
+  g_free (dir);
+}
+
+/* Layouts built from UI files without any constraint do not need a solver */
+static void
+emeus_builder_empty (void)
+{
+  const char *ui =
+    "<interface>"
+    "  <object class='EmeusConstraintLayout' id='empty'/>"
+    "  <object class='EmeusConstraintLayout' id='no-constraints'>"
+    "    <constraints/>"
+    "  </object>"
+    "</interface>";
+  GtkBuilder *builder = builder_new (ui);
+  EmeusConstraintLayout *layout;
+
+  layout = EMEUS_CONSTRAINT_LAYOUT (gtk_builder_get_object (builder, "empty"));
+  g_assert_nonnull (layout);
+  g_assert_false (layout->solver.initialized);
+
+  layout = EMEUS_CONSTRAINT_LAYOUT (gtk_builder_get_object (builder, "no-constraints"));
+  g_assert_nonnull (layout);
+  g_assert_false (layout->solver.initialized);
+
+  g_object_unref (builder);
+}
+
+static GtkBuilder *
+builder_new_with_width (int width)
+{
+  char *ui =
+    g_strdup_printf ("<interface>"
+                     "  <object class='EmeusConstraintLayout' id='layout'>"
+                     "    <child>"
+                     "      <object class='GtkLabel' id='label'/>"
+                     "    </child>"
+                     "    <constraints>"
+                     "      <constraint target-object='label'"
+                     "                  target-attr='width'"
+                     "                  relation='EMEUS_CONSTRAINT_RELATION_GE'"
+                     "                  constant='%d'/>"
+                     "    </constraints>"
+                     "  </object>"
+                     "</interface>",
+                     width);
+  GtkBuilder *builder = builder_new (ui);
+
+  g_free (ui);
+
+  return builder;
+}
+
+/* The bases of the layouts are only stored on disk if the application
+ * asks for it, and they are written outside of the thread building the
+ * layout
+ */
+static void
+emeus_builder_basis_cache (void)
+{
+  GtkBuilder *builder;
+  int i;
+
+  builder = builder_new_with_width (100);
+  g_object_unref (builder);
+
+  g_assert_cmpuint (count_cached_bases (), ==, 0);
+
+  g_setenv ("EMEUS_BASIS_CACHE", "1", TRUE);
+
+  builder = builder_new_with_width (200);
+  g_object_unref (builder);
+
+  for (i = 0; i < 100 && count_cached_bases () == 0; i++)
+    g_usleep (G_USEC_PER_SEC / 100);
+
+  g_assert_cmpuint (count_cached_bases (), ==, 1);
+
+  g_unsetenv ("EMEUS_BASIS_CACHE");
+}
+
+/* Constraints compiled by emeus-gen-constraints --binary, see meson.build */
+static void
+emeus_builder_resource (void)
+{
+  const char *ui =
+    "<interface>"
+    "  <object class='EmeusConstraintLayout' id='layout'>"
+    "    <child>"
+    "      <object class='GtkButton' id='button'/>"
+    "    </child>"
+    "    <child>"
+    "      <object class='GtkLabel' id='label'/>"
+    "    </child>"
+    "    <constraints>"
+    "      <resource path='/com/endlessm/Emeus/tests/builder.constraints'/>"
+    "    </constraints>"
+    "  </object>"
+    "</interface>";
+  GtkBuilder *builder = builder_new (ui);
+  EmeusConstraintLayout *layout;
+  EmeusConstraintLayoutChild *button, *label;
+  GList *constraints;
+
+  layout = EMEUS_CONSTRAINT_LAYOUT (gtk_builder_get_object (builder, "layout"));
+  g_assert_nonnull (layout);
+  g_assert_true (layout->solver.initialized);
+
+  /* |-10-[button], [button(100)], [button]-20-[label], [label]-10-| */
+  constraints = emeus_constraint_layout_get_constraints (layout);
+  g_assert_cmpuint (g_list_length (constraints), ==, 4);
+  g_list_free (constraints);
+
+  button = EMEUS_CONSTRAINT_LAYOUT_CHILD (gtk_widget_get_parent (GTK_WIDGET (gtk_builder_get_object (builder, "button"))));
+  label = EMEUS_CONSTRAINT_LAYOUT_CHILD (gtk_widget_get_parent (GTK_WIDGET (gtk_builder_get_object (builder, "label"))));
+
+  g_assert_cmpint (emeus_constraint_layout_child_get_left (button), ==, 10);
+  g_assert_cmpint (emeus_constraint_layout_child_get_width (button), ==, 100);
+  g_assert_cmpint (emeus_constraint_layout_child_get_left (label), ==, 10 + 100 + 20);
+
+  g_object_unref (builder);
+}
+
+int
+main (int argc, char *argv[])
+{
+  int res;
+
+  /* Do not touch the user's cache directory */
+  cache_dir = g_dir_make_tmp ("emeus-test-XXXXXX", NULL);
+  g_assert_nonnull (cache_dir);
+  g_setenv ("XDG_CACHE_HOME", cache_dir, TRUE);
+  g_unsetenv ("EMEUS_BASIS_CACHE");
+
+  gtk_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/emeus/builder/empty", emeus_builder_empty);
+  g_test_add_func ("/emeus/builder/basis-cache", emeus_builder_basis_cache);
+  g_test_add_func ("/emeus/builder/resource", emeus_builder_resource);
+
+  res = g_test_run ();
+
+  remove_cache_dir ();
+  g_free (cache_dir);
+
+  return res;
+}
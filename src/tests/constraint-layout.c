@@ -0,0 +1,1222 @@
+#include "emeus.h"
+
+#include "emeus-constraint-private.h"
+#include "emeus-constraint-layout-private.h"
+#include "emeus-expression-private.h"
+#include "emeus-solver-backend-private.h"
+#include "emeus-types-private.h"
+
+#include "emeus-test-utils.h"
+
+#include <gtk/gtk.h>
+
+static EmeusConstraintLayout *
+layout_new (void)
+{
+  EmeusConstraintLayout *layout = EMEUS_CONSTRAINT_LAYOUT (emeus_constraint_layout_new ());
+
+  return g_object_ref_sink (layout);
+}
+
+static GtkWidget *
+layout_pack_child (EmeusConstraintLayout *layout,
+                   const char            *name)
+{
+  GtkWidget *widget = gtk_label_new (name);
+
+  emeus_constraint_layout_pack (layout, widget, name, NULL);
+
+  return widget;
+}
+
+/* A constraint between an attribute of @widget and a constant */
+static EmeusConstraint *
+constant_constraint_new (GtkWidget                *widget,
+                         EmeusConstraintAttribute  attribute,
+                         EmeusConstraintRelation   relation,
+                         double                    constant,
+                         EmeusConstraintStrength   strength)
+{
+  return emeus_constraint_new (widget, attribute,
+                               relation,
+                               NULL, EMEUS_CONSTRAINT_ATTRIBUTE_INVALID,
+                               1.0, constant,
+                               strength);
+}
+
+static EmeusConstraintLayoutChild *
+layout_child (GtkWidget *widget)
+{
+  return EMEUS_CONSTRAINT_LAYOUT_CHILD (gtk_widget_get_parent (widget));
+}
+
+static double
+child_get_value (GtkWidget                *widget,
+                 EmeusConstraintAttribute  attribute)
+{
+  EmeusConstraintLayoutChild *child = layout_child (widget);
+
+  g_assert_nonnull (child->bound_attributes[attribute]);
+
+  return variable_get_value (child->bound_attributes[attribute]);
+}
+
+/* Adds the constraints of the VFL @lines to the @layout; the views are
+ * the children of the @layout, by name
+ */
+static void
+layout_add_description (EmeusConstraintLayout *layout,
+                        const char * const     lines[],
+                        guint                  n_lines,
+                        GHashTable            *views,
+                        GHashTable            *metrics)
+{
+  GList *constraints, *l;
+
+  constraints = emeus_create_constraints_from_description (lines, n_lines, -1, -1,
+                                                           views,
+                                                           metrics);
+
+  for (l = constraints; l != NULL; l = l->next)
+    emeus_constraint_layout_add_constraint (layout, l->data);
+
+  g_list_free (constraints);
+}
+
+/* A snapshot of the constraints of @layout, with a reference on each */
+static GPtrArray *
+layout_get_constraints (EmeusConstraintLayout *layout)
+{
+  GPtrArray *res = g_ptr_array_new_with_free_func (g_object_unref);
+  GList *constraints, *l;
+
+  constraints = emeus_constraint_layout_get_constraints (layout);
+  for (l = constraints; l != NULL; l = l->next)
+    g_ptr_array_add (res, g_object_ref (l->data));
+
+  g_list_free (constraints);
+
+  return res;
+}
+
+static gboolean
+constraints_contain (GPtrArray       *constraints,
+                     EmeusConstraint *constraint)
+{
+  for (guint i = 0; i < constraints->len; i++)
+    {
+      if (g_ptr_array_index (constraints, i) == constraint)
+        return TRUE;
+    }
+
+  return FALSE;
+}
+
+/* Counts the @constraints that are attached to @layout */
+static guint
+count_attached (GPtrArray             *constraints,
+                EmeusConstraintLayout *layout)
+{
+  guint res = 0;
+
+  for (guint i = 0; i < constraints->len; i++)
+    {
+      EmeusConstraint *constraint = g_ptr_array_index (constraints, i);
+
+      if (constraint->layout == layout)
+        res += 1;
+    }
+
+  return res;
+}
+
+/* Checks that the solver of the constraint is frozen while the group
+ * changes it, so that all the changes are solved at once
+ */
+static void
+on_active_notify (GObject    *gobject,
+                  GParamSpec *pspec,
+                  gpointer    data)
+{
+  EmeusConstraint *constraint = EMEUS_CONSTRAINT (gobject);
+  guint *n_changes = data;
+
+  g_assert_nonnull (constraint->solver);
+  g_assert_cmpint (constraint->solver->freeze_count, >, 0);
+
+  *n_changes += 1;
+}
+
+static void
+emeus_group_set_active (void)
+{
+  EmeusConstraintLayout *layout = layout_new ();
+  GtkWidget *child = layout_pack_child (layout, "child");
+  EmeusConstraintGroup *narrow = emeus_constraint_group_new ();
+  EmeusConstraintGroup *wide = emeus_constraint_group_new ();
+  EmeusConstraint *constraints[4];
+  guint n_changes = 0;
+  int i;
+
+  emeus_constraint_group_set_active (wide, FALSE);
+
+  constraints[0] = constant_constraint_new (child, EMEUS_CONSTRAINT_ATTRIBUTE_WIDTH,
+                                            EMEUS_CONSTRAINT_RELATION_EQ, 100.0,
+                                            EMEUS_CONSTRAINT_STRENGTH_REQUIRED);
+  constraints[1] = constant_constraint_new (child, EMEUS_CONSTRAINT_ATTRIBUTE_HEIGHT,
+                                            EMEUS_CONSTRAINT_RELATION_EQ, 50.0,
+                                            EMEUS_CONSTRAINT_STRENGTH_REQUIRED);
+  emeus_constraint_group_add_constraint (narrow, constraints[0]);
+  emeus_constraint_group_add_constraint (narrow, constraints[1]);
+
+  constraints[2] = constant_constraint_new (child, EMEUS_CONSTRAINT_ATTRIBUTE_WIDTH,
+                                            EMEUS_CONSTRAINT_RELATION_EQ, 200.0,
+                                            EMEUS_CONSTRAINT_STRENGTH_REQUIRED);
+  constraints[3] = constant_constraint_new (child, EMEUS_CONSTRAINT_ATTRIBUTE_HEIGHT,
+                                            EMEUS_CONSTRAINT_RELATION_EQ, 20.0,
+                                            EMEUS_CONSTRAINT_STRENGTH_REQUIRED);
+  emeus_constraint_group_add_constraint (wide, constraints[2]);
+  emeus_constraint_group_add_constraint (wide, constraints[3]);
+
+  g_assert_true (emeus_constraint_get_active (constraints[0]));
+  g_assert_false (emeus_constraint_get_active (constraints[2]));
+
+  for (i = 0; i < G_N_ELEMENTS (constraints); i++)
+    emeus_constraint_layout_add_constraint (layout, constraints[i]);
+
+  emeus_assert_almost_equals (child_get_value (child, EMEUS_CONSTRAINT_ATTRIBUTE_WIDTH), 100.0);
+  emeus_assert_almost_equals (child_get_value (child, EMEUS_CONSTRAINT_ATTRIBUTE_HEIGHT), 50.0);
+
+  for (i = 0; i < G_N_ELEMENTS (constraints); i++)
+    g_signal_connect (constraints[i], "notify::active", G_CALLBACK (on_active_notify), &n_changes);
+
+  emeus_constraint_group_set_active (narrow, FALSE);
+  emeus_constraint_group_set_active (wide, TRUE);
+
+  g_assert_cmpuint (n_changes, ==, 4);
+  g_assert_cmpint (layout->solver.freeze_count, ==, 0);
+
+  g_assert_false (emeus_constraint_get_active (constraints[0]));
+  g_assert_true (emeus_constraint_get_active (constraints[2]));
+
+  emeus_assert_almost_equals (child_get_value (child, EMEUS_CONSTRAINT_ATTRIBUTE_WIDTH), 200.0);
+  emeus_assert_almost_equals (child_get_value (child, EMEUS_CONSTRAINT_ATTRIBUTE_HEIGHT), 20.0);
+
+  /* Setting the same state again does not touch the constraints */
+  emeus_constraint_group_set_active (wide, TRUE);
+  g_assert_cmpuint (n_changes, ==, 4);
+
+  g_object_unref (narrow);
+  g_object_unref (wide);
+  gtk_widget_destroy (GTK_WIDGET (layout));
+  g_object_unref (layout);
+}
+
+static void
+emeus_group_two_layouts (void)
+{
+  EmeusConstraintLayout *layout_a = layout_new ();
+  EmeusConstraintLayout *layout_b = layout_new ();
+  GtkWidget *child_a = layout_pack_child (layout_a, "a");
+  GtkWidget *child_b = layout_pack_child (layout_b, "b");
+  EmeusConstraintGroup *group = emeus_constraint_group_new ();
+  EmeusConstraint *fallback_a, *fallback_b, *constraint_a, *constraint_b;
+  guint n_changes = 0;
+
+  fallback_a = constant_constraint_new (child_a, EMEUS_CONSTRAINT_ATTRIBUTE_WIDTH,
+                                        EMEUS_CONSTRAINT_RELATION_EQ, 10.0,
+                                        EMEUS_CONSTRAINT_STRENGTH_WEAK);
+  fallback_b = constant_constraint_new (child_b, EMEUS_CONSTRAINT_ATTRIBUTE_WIDTH,
+                                        EMEUS_CONSTRAINT_RELATION_EQ, 10.0,
+                                        EMEUS_CONSTRAINT_STRENGTH_WEAK);
+  emeus_constraint_layout_add_constraint (layout_a, fallback_a);
+  emeus_constraint_layout_add_constraint (layout_b, fallback_b);
+
+  constraint_a = constant_constraint_new (child_a, EMEUS_CONSTRAINT_ATTRIBUTE_WIDTH,
+                                          EMEUS_CONSTRAINT_RELATION_EQ, 30.0,
+                                          EMEUS_CONSTRAINT_STRENGTH_REQUIRED);
+  constraint_b = constant_constraint_new (child_b, EMEUS_CONSTRAINT_ATTRIBUTE_WIDTH,
+                                          EMEUS_CONSTRAINT_RELATION_EQ, 40.0,
+                                          EMEUS_CONSTRAINT_STRENGTH_REQUIRED);
+  emeus_constraint_group_add_constraint (group, constraint_a);
+  emeus_constraint_group_add_constraint (group, constraint_b);
+  emeus_constraint_layout_add_constraint (layout_a, constraint_a);
+  emeus_constraint_layout_add_constraint (layout_b, constraint_b);
+
+  emeus_assert_almost_equals (child_get_value (child_a, EMEUS_CONSTRAINT_ATTRIBUTE_WIDTH), 30.0);
+  emeus_assert_almost_equals (child_get_value (child_b, EMEUS_CONSTRAINT_ATTRIBUTE_WIDTH), 40.0);
+
+  g_signal_connect (constraint_a, "notify::active", G_CALLBACK (on_active_notify), &n_changes);
+  g_signal_connect (constraint_b, "notify::active", G_CALLBACK (on_active_notify), &n_changes);
+
+  /* Each layout is frozen while the group changes, and solved once */
+  emeus_constraint_group_set_active (group, FALSE);
+
+  g_assert_cmpuint (n_changes, ==, 2);
+  g_assert_cmpint (layout_a->solver.freeze_count, ==, 0);
+  g_assert_cmpint (layout_b->solver.freeze_count, ==, 0);
+
+  emeus_assert_almost_equals (child_get_value (child_a, EMEUS_CONSTRAINT_ATTRIBUTE_WIDTH), 10.0);
+  emeus_assert_almost_equals (child_get_value (child_b, EMEUS_CONSTRAINT_ATTRIBUTE_WIDTH), 10.0);
+
+  emeus_constraint_group_set_active (group, TRUE);
+
+  g_assert_cmpuint (n_changes, ==, 4);
+  g_assert_cmpint (layout_a->solver.freeze_count, ==, 0);
+  g_assert_cmpint (layout_b->solver.freeze_count, ==, 0);
+
+  emeus_assert_almost_equals (child_get_value (child_a, EMEUS_CONSTRAINT_ATTRIBUTE_WIDTH), 30.0);
+  emeus_assert_almost_equals (child_get_value (child_b, EMEUS_CONSTRAINT_ATTRIBUTE_WIDTH), 40.0);
+
+  g_object_unref (group);
+  gtk_widget_destroy (GTK_WIDGET (layout_a));
+  gtk_widget_destroy (GTK_WIDGET (layout_b));
+  g_object_unref (layout_a);
+  g_object_unref (layout_b);
+}
+
+/* Inequalities are normalized in place by the solver when they are first
+ * added; activating them again re-uses the normalized expression, which
+ * must keep the same direction
+ */
+static void
+emeus_group_reactivate (gconstpointer data)
+{
+  EmeusConstraintRelation relation = GPOINTER_TO_INT (data);
+  EmeusConstraintLayout *layout = layout_new ();
+  GtkWidget *child = layout_pack_child (layout, "child");
+  EmeusConstraintGroup *group = emeus_constraint_group_new ();
+  EmeusConstraint *constraint;
+  double bound;
+  int i;
+
+  /* The width would be 100, unless the constraint in the group is active */
+  emeus_constraint_layout_add_constraint (layout,
+                                          constant_constraint_new (child, EMEUS_CONSTRAINT_ATTRIBUTE_WIDTH,
+                                                                   EMEUS_CONSTRAINT_RELATION_EQ, 100.0,
+                                                                   EMEUS_CONSTRAINT_STRENGTH_WEAK));
+
+  bound = relation == EMEUS_CONSTRAINT_RELATION_GE ? 150.0 : 60.0;
+  constraint = constant_constraint_new (child, EMEUS_CONSTRAINT_ATTRIBUTE_WIDTH,
+                                        relation, bound,
+                                        EMEUS_CONSTRAINT_STRENGTH_REQUIRED);
+  emeus_constraint_group_add_constraint (group, constraint);
+  emeus_constraint_layout_add_constraint (layout, constraint);
+
+  emeus_assert_almost_equals (child_get_value (child, EMEUS_CONSTRAINT_ATTRIBUTE_WIDTH), bound);
+
+  for (i = 0; i < 2; i++)
+    {
+      emeus_constraint_group_set_active (group, FALSE);
+
+      g_assert_nonnull (constraint->prepared);
+      emeus_assert_almost_equals (child_get_value (child, EMEUS_CONSTRAINT_ATTRIBUTE_WIDTH), 100.0);
+
+      emeus_constraint_group_set_active (group, TRUE);
+
+      emeus_assert_almost_equals (child_get_value (child, EMEUS_CONSTRAINT_ATTRIBUTE_WIDTH), bound);
+    }
+
+  g_object_unref (group);
+  gtk_widget_destroy (GTK_WIDGET (layout));
+  g_object_unref (layout);
+}
+
+/* The allocation re-uses the minimum size of the children measured while
+ * GTK asks for the size of the layout; a child that changes between two
+ * size requests, without an allocation in between, must not be allocated
+ * using its old minimum size
+ */
+static void
+emeus_layout_measure_children (void)
+{
+  EmeusConstraintLayout *layout = layout_new ();
+  GtkWidget *widget = layout_pack_child (layout, "child");
+  GtkAllocation allocation = { 0, 0, 10, 10 };
+  GtkAllocation child_allocation;
+  int minimum, natural;
+  int child_minimum;
+
+  gtk_widget_show_all (GTK_WIDGET (layout));
+
+  gtk_widget_get_preferred_width (GTK_WIDGET (layout), &minimum, &natural);
+  gtk_widget_get_preferred_height (GTK_WIDGET (layout), &minimum, &natural);
+
+  /* The layout is measured again, but not allocated, after the child
+   * changed, like a page of a GtkStack that is not visible
+   */
+  gtk_label_set_text (GTK_LABEL (widget), "A much longer label for the child");
+  gtk_widget_get_preferred_width (GTK_WIDGET (layout), &minimum, &natural);
+  gtk_widget_get_preferred_height (GTK_WIDGET (layout), &minimum, &natural);
+
+  gtk_widget_get_preferred_width (widget, &child_minimum, NULL);
+
+  gtk_widget_size_allocate (GTK_WIDGET (layout), &allocation);
+  gtk_widget_get_allocation (gtk_widget_get_parent (widget), &child_allocation);
+  g_assert_cmpint (child_allocation.width, >=, child_minimum);
+
+  gtk_widget_destroy (GTK_WIDGET (layout));
+  g_object_unref (layout);
+}
+
+/* The solver is only created when a child or a constraint needs it */
+static void
+emeus_layout_lazy_solver (void)
+{
+  EmeusConstraintLayout *layout = layout_new ();
+  GtkAllocation allocation = { 0, 0, 200, 100 };
+  int minimum, natural;
+
+  gtk_widget_show_all (GTK_WIDGET (layout));
+
+  gtk_widget_get_preferred_width (GTK_WIDGET (layout), &minimum, &natural);
+  g_assert_cmpint (minimum, ==, 0);
+  gtk_widget_get_preferred_height (GTK_WIDGET (layout), &minimum, &natural);
+  g_assert_cmpint (minimum, ==, 0);
+  gtk_widget_size_allocate (GTK_WIDGET (layout), &allocation);
+
+  emeus_constraint_layout_set_deferred_solving (layout, TRUE);
+  emeus_constraint_layout_set_deferred_solving (layout, FALSE);
+  emeus_constraint_layout_set_allocation_cache_size (layout, 8);
+  emeus_constraint_layout_clear_constraints (layout);
+
+  g_assert_null (emeus_constraint_layout_get_constraints (layout));
+  g_assert_cmpuint (emeus_constraint_layout_get_child_rectangles (layout, NULL, 0), ==, 0);
+
+  g_assert_false (layout->solver.initialized);
+
+  layout_pack_child (layout, "child");
+  g_assert_true (layout->solver.initialized);
+
+  gtk_widget_destroy (GTK_WIDGET (layout));
+  g_object_unref (layout);
+}
+
+/* The layout holds the value of the metrics used by its constraints */
+static void
+emeus_layout_set_metric (void)
+{
+  const char * const lines[] = {
+    "|-margin-[a(50)]-gap-[b(50)]",
+  };
+  EmeusConstraintLayout *layout = layout_new ();
+  GtkWidget *a = layout_pack_child (layout, "a");
+  GtkWidget *b = layout_pack_child (layout, "b");
+  GHashTable *views = g_hash_table_new (g_str_hash, g_str_equal);
+  GHashTable *metrics = g_hash_table_new (g_str_hash, g_str_equal);
+  double gap = 20.0, margin = 4.0;
+
+  g_hash_table_insert (views, "a", a);
+  g_hash_table_insert (views, "b", b);
+  g_hash_table_insert (metrics, "gap", &gap);
+  g_hash_table_insert (metrics, "margin", &margin);
+
+  /* A value set before the constraints are added takes precedence */
+  emeus_constraint_layout_set_metric (layout, "margin", 10.0);
+
+  layout_add_description (layout, lines, G_N_ELEMENTS (lines), views, metrics);
+
+  g_assert_cmpint (emeus_constraint_layout_child_get_left (layout_child (a)), ==, 10);
+  g_assert_cmpint (emeus_constraint_layout_child_get_left (layout_child (b)), ==, 10 + 50 + 20);
+
+  emeus_constraint_layout_set_metric (layout, "gap", 35.0);
+
+  g_assert_cmpint (emeus_constraint_layout_child_get_left (layout_child (a)), ==, 10);
+  g_assert_cmpint (emeus_constraint_layout_child_get_left (layout_child (b)), ==, 10 + 50 + 35);
+
+  emeus_constraint_layout_set_metric (layout, "margin", 0.0);
+  emeus_constraint_layout_set_metric (layout, "gap", 35.0);
+
+  g_assert_cmpint (emeus_constraint_layout_child_get_left (layout_child (a)), ==, 0);
+  g_assert_cmpint (emeus_constraint_layout_child_get_left (layout_child (b)), ==, 50 + 35);
+
+  g_hash_table_unref (metrics);
+  g_hash_table_unref (views);
+  gtk_widget_destroy (GTK_WIDGET (layout));
+  g_object_unref (layout);
+}
+
+/* Several metrics can be changed at once */
+static void
+emeus_layout_set_metrics (void)
+{
+  const char * const lines[] = {
+    "|-margin-[a(50)]-gap-[b(50)]",
+  };
+  EmeusConstraintLayout *layout = layout_new ();
+  GtkWidget *a = layout_pack_child (layout, "a");
+  GtkWidget *b = layout_pack_child (layout, "b");
+  GHashTable *views = g_hash_table_new (g_str_hash, g_str_equal);
+  GHashTable *metrics = g_hash_table_new (g_str_hash, g_str_equal);
+  double gap = 20.0, margin = 4.0;
+  int minimum, natural;
+
+  g_hash_table_insert (views, "a", a);
+  g_hash_table_insert (views, "b", b);
+  g_hash_table_insert (metrics, "gap", &gap);
+  g_hash_table_insert (metrics, "margin", &margin);
+
+  layout_add_description (layout, lines, G_N_ELEMENTS (lines), views, metrics);
+
+  g_assert_cmpint (emeus_constraint_layout_child_get_left (layout_child (a)), ==, 4);
+  g_assert_cmpint (emeus_constraint_layout_child_get_left (layout_child (b)), ==, 4 + 50 + 20);
+
+  gap = 35.0;
+  margin = 12.0;
+  emeus_constraint_layout_set_metrics (layout, metrics);
+
+  g_assert_cmpint (emeus_constraint_layout_child_get_left (layout_child (a)), ==, 12);
+  g_assert_cmpint (emeus_constraint_layout_child_get_left (layout_child (b)), ==, 12 + 50 + 35);
+
+  /* Deferred changes are solved together when the layout is measured */
+  emeus_constraint_layout_set_deferred_solving (layout, TRUE);
+
+  gap = 5.0;
+  margin = 0.0;
+  emeus_constraint_layout_set_metrics (layout, metrics);
+  g_assert_true (layout->solve_pending);
+
+  gtk_widget_get_preferred_width (GTK_WIDGET (layout), &minimum, &natural);
+
+  g_assert_false (layout->solve_pending);
+  emeus_assert_almost_equals (child_get_value (a, EMEUS_CONSTRAINT_ATTRIBUTE_LEFT), 0.0);
+  emeus_assert_almost_equals (child_get_value (b, EMEUS_CONSTRAINT_ATTRIBUTE_LEFT), 50.0 + 5.0);
+
+  g_hash_table_unref (metrics);
+  g_hash_table_unref (views);
+  gtk_widget_destroy (GTK_WIDGET (layout));
+  g_object_unref (layout);
+}
+
+static void
+update_description (EmeusConstraintLayout *layout,
+                    const char * const     lines[],
+                    guint                  n_lines,
+                    GHashTable            *views)
+{
+  emeus_constraint_layout_update_from_description (layout, lines, n_lines, -1, -1, views, NULL);
+}
+
+/* Lines that did not change keep their constraints, while the
+ * constraints of the lines that changed or were removed are detached
+ */
+static void
+emeus_layout_update_description (void)
+{
+  const char * const first[] = { "H:|[a]|" };
+  const char * const second[] = { "H:|[a]|", "H:|[b]|" };
+  const char * const third[] = { "H:|[a]|", "H:|[b(100)]|" };
+  EmeusConstraintLayout *layout = layout_new ();
+  GHashTable *views = g_hash_table_new (g_str_hash, g_str_equal);
+  GPtrArray *line_a, *line_b, *line_b2, *current;
+  guint i;
+
+  g_hash_table_insert (views, "a", layout_pack_child (layout, "a"));
+  g_hash_table_insert (views, "b", layout_pack_child (layout, "b"));
+
+  update_description (layout, first, G_N_ELEMENTS (first), views);
+  line_a = layout_get_constraints (layout);
+  g_assert_cmpint (line_a->len, >, 0);
+
+  /* Adding a line keeps the constraints of the existing one */
+  update_description (layout, second, G_N_ELEMENTS (second), views);
+  current = layout_get_constraints (layout);
+  g_assert_cmpint (count_attached (line_a, layout), ==, line_a->len);
+
+  line_b = g_ptr_array_new_with_free_func (g_object_unref);
+  for (i = 0; i < current->len; i++)
+    {
+      EmeusConstraint *constraint = g_ptr_array_index (current, i);
+
+      if (!constraints_contain (line_a, constraint))
+        g_ptr_array_add (line_b, g_object_ref (constraint));
+    }
+
+  g_assert_cmpint (line_b->len, >, 0);
+  g_ptr_array_unref (current);
+
+  /* Changing a line detaches its constraints, and only those */
+  update_description (layout, third, G_N_ELEMENTS (third), views);
+  g_assert_cmpint (count_attached (line_a, layout), ==, line_a->len);
+  g_assert_cmpint (count_attached (line_b, layout), ==, 0);
+
+  current = layout_get_constraints (layout);
+  line_b2 = g_ptr_array_new_with_free_func (g_object_unref);
+  for (i = 0; i < current->len; i++)
+    {
+      EmeusConstraint *constraint = g_ptr_array_index (current, i);
+
+      g_assert_false (constraints_contain (line_b, constraint));
+
+      if (!constraints_contain (line_a, constraint))
+        g_ptr_array_add (line_b2, g_object_ref (constraint));
+    }
+
+  g_assert_cmpint (line_b2->len, >, 0);
+  g_ptr_array_unref (current);
+
+  /* Removing a line detaches its constraints */
+  update_description (layout, first, G_N_ELEMENTS (first), views);
+  g_assert_cmpint (count_attached (line_a, layout), ==, line_a->len);
+  g_assert_cmpint (count_attached (line_b2, layout), ==, 0);
+
+  current = layout_get_constraints (layout);
+  g_assert_cmpint (current->len, ==, line_a->len);
+  g_ptr_array_unref (current);
+
+  g_ptr_array_unref (line_b2);
+  g_ptr_array_unref (line_b);
+  g_ptr_array_unref (line_a);
+  g_hash_table_unref (views);
+  gtk_widget_destroy (GTK_WIDGET (layout));
+  g_object_unref (layout);
+}
+
+/* Each occurrence of a line has its own constraints */
+static void
+emeus_layout_update_description_duplicates (void)
+{
+  const char * const once[] = { "H:|[a]|" };
+  const char * const twice[] = { "H:|[a]|", "H:|[a]|" };
+  EmeusConstraintLayout *layout = layout_new ();
+  GHashTable *views = g_hash_table_new (g_str_hash, g_str_equal);
+  GPtrArray *first, *both;
+
+  g_hash_table_insert (views, "a", layout_pack_child (layout, "a"));
+
+  update_description (layout, once, G_N_ELEMENTS (once), views);
+  first = layout_get_constraints (layout);
+
+  update_description (layout, twice, G_N_ELEMENTS (twice), views);
+  both = layout_get_constraints (layout);
+  g_assert_cmpint (both->len, ==, first->len * 2);
+  g_assert_cmpint (count_attached (first, layout), ==, first->len);
+
+  /* Dropping the copy keeps the constraints of the first occurrence */
+  update_description (layout, once, G_N_ELEMENTS (once), views);
+  g_assert_cmpint (count_attached (first, layout), ==, first->len);
+  g_assert_cmpint (count_attached (both, layout), ==, first->len);
+
+  g_ptr_array_unref (both);
+  g_ptr_array_unref (first);
+  g_hash_table_unref (views);
+  gtk_widget_destroy (GTK_WIDGET (layout));
+  g_object_unref (layout);
+}
+
+/* A line is parsed again if one of the children it references was
+ * removed, even if the line did not change
+ */
+static void
+emeus_layout_update_description_removed_child (void)
+{
+  const char * const lines[] = { "H:|[a]-[b]|" };
+  EmeusConstraintLayout *layout = layout_new ();
+  GHashTable *views = g_hash_table_new (g_str_hash, g_str_equal);
+  GtkWidget *b = layout_pack_child (layout, "b");
+  GPtrArray *before, *after;
+  guint i;
+
+  g_hash_table_insert (views, "a", layout_pack_child (layout, "a"));
+  g_hash_table_insert (views, "b", b);
+
+  update_description (layout, lines, G_N_ELEMENTS (lines), views);
+  before = layout_get_constraints (layout);
+
+  /* Removing b only removes the constraints referencing it */
+  gtk_container_remove (GTK_CONTAINER (layout), b);
+  g_assert_cmpint (count_attached (before, layout), >, 0);
+  g_assert_cmpint (count_attached (before, layout), <, before->len);
+
+  g_hash_table_insert (views, "b", layout_pack_child (layout, "b"));
+
+  update_description (layout, lines, G_N_ELEMENTS (lines), views);
+  g_assert_cmpint (count_attached (before, layout), ==, 0);
+
+  after = layout_get_constraints (layout);
+  g_assert_cmpint (after->len, ==, before->len);
+  for (i = 0; i < after->len; i++)
+    g_assert_false (constraints_contain (before, g_ptr_array_index (after, i)));
+
+  g_ptr_array_unref (after);
+  g_ptr_array_unref (before);
+  g_hash_table_unref (views);
+  gtk_widget_destroy (GTK_WIDGET (layout));
+  g_object_unref (layout);
+}
+
+/* Replacing the constraints keeps the ones that only differ by their
+ * constant, and moves the solution to the new constant; the sign of
+ * the constant of an inequality is flipped by the normalization
+ */
+static void
+emeus_layout_replace_constraints (gconstpointer data)
+{
+  EmeusConstraintRelation relation = GPOINTER_TO_INT (data);
+  EmeusConstraintLayout *layout = layout_new ();
+  GtkWidget *child = layout_pack_child (layout, "child");
+  EmeusConstraint *width, *height, *pull, *replacement, *left;
+  const double constants[] = { 150.0, 80.0 };
+  GList *constraints;
+  guint i;
+
+  /* Keeps the inequalities on their bound */
+  pull = constant_constraint_new (child, EMEUS_CONSTRAINT_ATTRIBUTE_WIDTH,
+                                  EMEUS_CONSTRAINT_RELATION_EQ,
+                                  relation == EMEUS_CONSTRAINT_RELATION_LE ? 1000.0 : 0.0,
+                                  EMEUS_CONSTRAINT_STRENGTH_WEAK);
+  width = constant_constraint_new (child, EMEUS_CONSTRAINT_ATTRIBUTE_WIDTH,
+                                   relation, 100.0,
+                                   EMEUS_CONSTRAINT_STRENGTH_REQUIRED);
+  height = constant_constraint_new (child, EMEUS_CONSTRAINT_ATTRIBUTE_HEIGHT,
+                                    EMEUS_CONSTRAINT_RELATION_EQ, 50.0,
+                                    EMEUS_CONSTRAINT_STRENGTH_REQUIRED);
+  g_object_ref (height);
+
+  emeus_constraint_layout_add_constraint (layout, pull);
+  emeus_constraint_layout_add_constraint (layout, width);
+  emeus_constraint_layout_add_constraint (layout, height);
+
+  emeus_assert_almost_equals (child_get_value (child, EMEUS_CONSTRAINT_ATTRIBUTE_WIDTH), 100.0);
+  emeus_assert_almost_equals (child_get_value (child, EMEUS_CONSTRAINT_ATTRIBUTE_HEIGHT), 50.0);
+
+  for (i = 0; i < G_N_ELEMENTS (constants); i++)
+    {
+      replacement = constant_constraint_new (child, EMEUS_CONSTRAINT_ATTRIBUTE_WIDTH,
+                                             relation, constants[i],
+                                             EMEUS_CONSTRAINT_STRENGTH_REQUIRED);
+      g_object_ref (replacement);
+
+      constraints = NULL;
+      constraints = g_list_prepend (constraints, replacement);
+      constraints = g_list_prepend (constraints, pull);
+
+      emeus_constraint_layout_replace_constraints (layout, constraints);
+      g_list_free (constraints);
+
+      /* The existing constraint is kept, with the new constant */
+      g_assert_true (emeus_constraint_is_attached (width));
+      g_assert_true (emeus_constraint_is_attached (pull));
+      g_assert_false (emeus_constraint_is_attached (replacement));
+      emeus_assert_almost_equals (emeus_constraint_get_constant (width), constants[i]);
+      emeus_assert_almost_equals (child_get_value (child, EMEUS_CONSTRAINT_ATTRIBUTE_WIDTH),
+                                  constants[i]);
+
+      g_object_unref (replacement);
+    }
+
+  /* The height constraint did not match anything in the first pass */
+  g_assert_false (emeus_constraint_is_attached (height));
+
+  left = constant_constraint_new (child, EMEUS_CONSTRAINT_ATTRIBUTE_LEFT,
+                                  EMEUS_CONSTRAINT_RELATION_EQ, 10.0,
+                                  EMEUS_CONSTRAINT_STRENGTH_REQUIRED);
+
+  constraints = NULL;
+  constraints = g_list_prepend (constraints, left);
+  constraints = g_list_prepend (constraints, width);
+  constraints = g_list_prepend (constraints, pull);
+
+  emeus_constraint_layout_replace_constraints (layout, constraints);
+  g_list_free (constraints);
+
+  /* Unmatched constraints are added */
+  g_assert_true (emeus_constraint_is_attached (left));
+  g_assert_true (emeus_constraint_is_attached (width));
+  emeus_assert_almost_equals (child_get_value (child, EMEUS_CONSTRAINT_ATTRIBUTE_LEFT), 10.0);
+  emeus_assert_almost_equals (child_get_value (child, EMEUS_CONSTRAINT_ATTRIBUTE_WIDTH), 80.0);
+
+  g_object_unref (height);
+  gtk_widget_destroy (GTK_WIDGET (layout));
+  g_object_unref (layout);
+}
+
+/* In deferred mode a burst of changes is only solved when the layout
+ * is measured, or when a value is read through the child getters
+ */
+static void
+emeus_layout_deferred_solving (void)
+{
+  EmeusConstraintLayout *layout = layout_new ();
+  GtkWidget *widget = layout_pack_child (layout, "child");
+  EmeusConstraintLayoutChild *child = layout_child (widget);
+  int minimum, natural;
+
+  emeus_constraint_layout_set_deferred_solving (layout, TRUE);
+  g_assert_true (emeus_constraint_layout_get_deferred_solving (layout));
+
+  emeus_constraint_layout_add_constraint (layout,
+                                          constant_constraint_new (widget,
+                                                                   EMEUS_CONSTRAINT_ATTRIBUTE_LEFT,
+                                                                   EMEUS_CONSTRAINT_RELATION_EQ, 10.0,
+                                                                   EMEUS_CONSTRAINT_STRENGTH_REQUIRED));
+  emeus_constraint_layout_child_set_intrinsic_width (child, 100);
+  emeus_constraint_layout_child_set_intrinsic_height (child, 60);
+
+  g_assert_true (layout->solve_pending);
+  g_assert_cmpint (layout->solver.freeze_count, ==, 1);
+  emeus_assert_almost_equals (child_get_value (widget, EMEUS_CONSTRAINT_ATTRIBUTE_LEFT), 0.0);
+  emeus_assert_almost_equals (child_get_value (widget, EMEUS_CONSTRAINT_ATTRIBUTE_WIDTH), 0.0);
+
+  /* Measuring solves the whole burst at once */
+  gtk_widget_get_preferred_width (GTK_WIDGET (layout), &minimum, &natural);
+
+  g_assert_false (layout->solve_pending);
+  g_assert_cmpint (layout->solver.freeze_count, ==, 0);
+  emeus_assert_almost_equals (child_get_value (widget, EMEUS_CONSTRAINT_ATTRIBUTE_LEFT), 10.0);
+  emeus_assert_almost_equals (child_get_value (widget, EMEUS_CONSTRAINT_ATTRIBUTE_WIDTH), 100.0);
+  emeus_assert_almost_equals (child_get_value (widget, EMEUS_CONSTRAINT_ATTRIBUTE_HEIGHT), 60.0);
+
+  /* The getters see the pending changes */
+  emeus_constraint_layout_child_set_intrinsic_width (child, 120);
+  g_assert_true (layout->solve_pending);
+
+  g_assert_cmpint (emeus_constraint_layout_child_get_width (child), ==, 120);
+  g_assert_false (layout->solve_pending);
+  g_assert_cmpint (layout->solver.freeze_count, ==, 0);
+
+  /* Turning the mode off solves the pending changes */
+  emeus_constraint_layout_add_constraint (layout,
+                                          constant_constraint_new (widget,
+                                                                   EMEUS_CONSTRAINT_ATTRIBUTE_TOP,
+                                                                   EMEUS_CONSTRAINT_RELATION_EQ, 5.0,
+                                                                   EMEUS_CONSTRAINT_STRENGTH_REQUIRED));
+  g_assert_true (layout->solve_pending);
+
+  emeus_constraint_layout_set_deferred_solving (layout, FALSE);
+
+  g_assert_false (layout->solve_pending);
+  g_assert_cmpint (layout->solver.freeze_count, ==, 0);
+  emeus_assert_almost_equals (child_get_value (widget, EMEUS_CONSTRAINT_ATTRIBUTE_TOP), 5.0);
+
+  /* Changes are solved immediately again */
+  emeus_constraint_layout_child_set_intrinsic_height (child, 80);
+  g_assert_false (layout->solve_pending);
+  emeus_assert_almost_equals (child_get_value (widget, EMEUS_CONSTRAINT_ATTRIBUTE_HEIGHT), 80.0);
+
+  gtk_widget_destroy (GTK_WIDGET (layout));
+  g_object_unref (layout);
+}
+
+static guint
+allocation_cache_length (EmeusConstraintLayout *layout)
+{
+  if (layout->allocation_cache.entries == NULL)
+    return 0;
+
+  return g_queue_get_length (layout->allocation_cache.entries);
+}
+
+/* Measures and allocates @layout, like GTK does after a resize */
+static void
+layout_allocate (EmeusConstraintLayout *layout,
+                 int                    width,
+                 int                    height)
+{
+  GtkAllocation allocation = { 0, 0, width, height };
+  int minimum, natural;
+
+  gtk_widget_queue_resize (GTK_WIDGET (layout));
+  gtk_widget_get_preferred_width (GTK_WIDGET (layout), &minimum, &natural);
+  gtk_widget_get_preferred_height (GTK_WIDGET (layout), &minimum, &natural);
+  gtk_widget_size_allocate (GTK_WIDGET (layout), &allocation);
+}
+
+static void
+assert_child_allocation (GtkWidget *widget,
+                         int        x,
+                         int        y,
+                         int        width,
+                         int        height)
+{
+  GtkAllocation allocation;
+
+  gtk_widget_get_allocation (gtk_widget_get_parent (widget), &allocation);
+  g_assert_cmpint (allocation.x, ==, x);
+  g_assert_cmpint (allocation.y, ==, y);
+  g_assert_cmpint (allocation.width, ==, width);
+  g_assert_cmpint (allocation.height, ==, height);
+}
+
+/* The allocation cache keeps the most recently used allocations, and
+ * discards them when the constraints change
+ */
+static void
+emeus_layout_allocation_cache (void)
+{
+  EmeusConstraintLayout *layout = layout_new ();
+  GtkWidget *widget = layout_pack_child (layout, "child");
+
+  emeus_constraint_layout_add_constraint (layout,
+                                          constant_constraint_new (widget,
+                                                                   EMEUS_CONSTRAINT_ATTRIBUTE_LEFT,
+                                                                   EMEUS_CONSTRAINT_RELATION_EQ, 0.0,
+                                                                   EMEUS_CONSTRAINT_STRENGTH_REQUIRED));
+  emeus_constraint_layout_add_constraint (layout,
+                                          constant_constraint_new (widget,
+                                                                   EMEUS_CONSTRAINT_ATTRIBUTE_TOP,
+                                                                   EMEUS_CONSTRAINT_RELATION_EQ, 0.0,
+                                                                   EMEUS_CONSTRAINT_STRENGTH_REQUIRED));
+  emeus_constraint_layout_add_constraint (layout,
+                                          emeus_constraint_new (widget, EMEUS_CONSTRAINT_ATTRIBUTE_WIDTH,
+                                                                EMEUS_CONSTRAINT_RELATION_EQ,
+                                                                NULL, EMEUS_CONSTRAINT_ATTRIBUTE_WIDTH,
+                                                                0.5, 0.0,
+                                                                EMEUS_CONSTRAINT_STRENGTH_REQUIRED));
+  emeus_constraint_layout_add_constraint (layout,
+                                          emeus_constraint_new (widget, EMEUS_CONSTRAINT_ATTRIBUTE_HEIGHT,
+                                                                EMEUS_CONSTRAINT_RELATION_EQ,
+                                                                NULL, EMEUS_CONSTRAINT_ATTRIBUTE_HEIGHT,
+                                                                0.5, 0.0,
+                                                                EMEUS_CONSTRAINT_STRENGTH_REQUIRED));
+
+  emeus_constraint_layout_set_allocation_cache_size (layout, 2);
+  g_assert_cmpuint (emeus_constraint_layout_get_allocation_cache_size (layout), ==, 2);
+  emeus_assert_almost_equals (emeus_constraint_layout_get_allocation_cache_hit_rate (layout), 0.0);
+
+  gtk_widget_show_all (GTK_WIDGET (layout));
+
+  /* A new allocation misses the cache, and is stored */
+  layout_allocate (layout, 400, 300);
+  g_assert_cmpuint (layout->allocation_cache.n_hits, ==, 0);
+  g_assert_cmpuint (layout->allocation_cache.n_misses, ==, 1);
+  g_assert_cmpuint (allocation_cache_length (layout), ==, 1);
+  assert_child_allocation (widget, 0, 0, 200, 150);
+
+  /* Going back to it hits the cache */
+  layout_allocate (layout, 400, 300);
+  g_assert_cmpuint (layout->allocation_cache.n_hits, ==, 1);
+  g_assert_cmpuint (layout->allocation_cache.n_misses, ==, 1);
+  g_assert_cmpuint (allocation_cache_length (layout), ==, 1);
+  assert_child_allocation (widget, 0, 0, 200, 150);
+  emeus_assert_almost_equals (emeus_constraint_layout_get_allocation_cache_hit_rate (layout), 0.5);
+
+  /* The least recently used allocation is dropped */
+  layout_allocate (layout, 600, 300);
+  assert_child_allocation (widget, 0, 0, 300, 150);
+  layout_allocate (layout, 800, 300);
+  assert_child_allocation (widget, 0, 0, 400, 150);
+  g_assert_cmpuint (layout->allocation_cache.n_misses, ==, 3);
+  g_assert_cmpuint (allocation_cache_length (layout), ==, 2);
+
+  layout_allocate (layout, 600, 300);
+  g_assert_cmpuint (layout->allocation_cache.n_hits, ==, 2);
+  assert_child_allocation (widget, 0, 0, 300, 150);
+
+  layout_allocate (layout, 400, 300);
+  g_assert_cmpuint (layout->allocation_cache.n_hits, ==, 2);
+  g_assert_cmpuint (layout->allocation_cache.n_misses, ==, 4);
+  g_assert_cmpuint (allocation_cache_length (layout), ==, 2);
+  assert_child_allocation (widget, 0, 0, 200, 150);
+  emeus_assert_almost_equals (emeus_constraint_layout_get_allocation_cache_hit_rate (layout), 2.0 / 6.0);
+
+  /* Changing the constraints invalidates every entry */
+  emeus_constraint_layout_add_constraint (layout,
+                                          constant_constraint_new (widget,
+                                                                   EMEUS_CONSTRAINT_ATTRIBUTE_LEFT,
+                                                                   EMEUS_CONSTRAINT_RELATION_GE, 10.0,
+                                                                   EMEUS_CONSTRAINT_STRENGTH_WEAK));
+  layout_allocate (layout, 600, 300);
+  g_assert_cmpuint (layout->allocation_cache.n_hits, ==, 2);
+  g_assert_cmpuint (layout->allocation_cache.n_misses, ==, 5);
+  g_assert_cmpuint (allocation_cache_length (layout), ==, 1);
+  assert_child_allocation (widget, 0, 0, 300, 150);
+
+  /* Disabling the cache drops the entries, and stops the lookups */
+  emeus_constraint_layout_set_allocation_cache_size (layout, 0);
+  g_assert_cmpuint (allocation_cache_length (layout), ==, 0);
+
+  layout_allocate (layout, 600, 300);
+  g_assert_cmpuint (layout->allocation_cache.n_hits, ==, 2);
+  g_assert_cmpuint (layout->allocation_cache.n_misses, ==, 5);
+  g_assert_cmpuint (allocation_cache_length (layout), ==, 0);
+  assert_child_allocation (widget, 0, 0, 300, 150);
+
+  gtk_widget_destroy (GTK_WIDGET (layout));
+  g_object_unref (layout);
+}
+
+/* The rectangles of the children match their allocation */
+static void
+emeus_layout_child_rectangles (void)
+{
+  const char * const lines[] = {
+    "H:|-10-[a(100)]-20-[b(50)]",
+    "V:|-5-[a(30)]",
+    "V:|[b(40)]",
+  };
+  EmeusConstraintLayout *layout = layout_new ();
+  GtkWidget *a = layout_pack_child (layout, "a");
+  GtkWidget *b = layout_pack_child (layout, "b");
+  GHashTable *views = g_hash_table_new (g_str_hash, g_str_equal);
+  GdkRectangle rects[3] = { { 0, }, };
+
+  g_hash_table_insert (views, "a", a);
+  g_hash_table_insert (views, "b", b);
+
+  layout_add_description (layout, lines, G_N_ELEMENTS (lines), views, NULL);
+
+  gtk_widget_show_all (GTK_WIDGET (layout));
+  layout_allocate (layout, 400, 300);
+
+  assert_child_allocation (a, 10, 5, 100, 30);
+  assert_child_allocation (b, 130, 0, 50, 40);
+
+  /* The rectangles are in the same order as the children */
+  g_assert_cmpuint (emeus_constraint_layout_get_child_rectangles (layout, rects, G_N_ELEMENTS (rects)), ==, 2);
+  g_assert_cmpint (rects[0].x, ==, 10);
+  g_assert_cmpint (rects[0].y, ==, 5);
+  g_assert_cmpint (rects[0].width, ==, 100);
+  g_assert_cmpint (rects[0].height, ==, 30);
+  g_assert_cmpint (rects[1].x, ==, 130);
+  g_assert_cmpint (rects[1].y, ==, 0);
+  g_assert_cmpint (rects[1].width, ==, 50);
+  g_assert_cmpint (rects[1].height, ==, 40);
+
+  /* The rectangles past the children are left untouched */
+  g_assert_cmpint (rects[2].width, ==, 0);
+  g_assert_cmpint (rects[2].height, ==, 0);
+
+  /* At most n_rects rectangles are written */
+  memset (rects, 0, sizeof (rects));
+  g_assert_cmpuint (emeus_constraint_layout_get_child_rectangles (layout, rects, 1), ==, 2);
+  g_assert_cmpint (rects[0].x, ==, 10);
+  g_assert_cmpint (rects[1].width, ==, 0);
+
+  /* The number of children can be queried without an array */
+  g_assert_cmpuint (emeus_constraint_layout_get_child_rectangles (layout, NULL, 0), ==, 2);
+
+  g_hash_table_unref (views);
+  gtk_widget_destroy (GTK_WIDGET (layout));
+  g_object_unref (layout);
+}
+
+/* The child is 100 pixels narrower than the layout, between a width
+ * of 50 and 300 pixels; reaching the maximum width changes the basis
+ * of the solver
+ */
+static EmeusConstraintLayout *
+sensitivity_layout_new (GtkWidget **child_p)
+{
+  EmeusConstraintLayout *layout = layout_new ();
+  GtkWidget *widget = layout_pack_child (layout, "child");
+
+  emeus_constraint_layout_add_constraint (layout,
+                                          constant_constraint_new (widget,
+                                                                   EMEUS_CONSTRAINT_ATTRIBUTE_LEFT,
+                                                                   EMEUS_CONSTRAINT_RELATION_EQ, 0.0,
+                                                                   EMEUS_CONSTRAINT_STRENGTH_REQUIRED));
+  emeus_constraint_layout_add_constraint (layout,
+                                          constant_constraint_new (widget,
+                                                                   EMEUS_CONSTRAINT_ATTRIBUTE_TOP,
+                                                                   EMEUS_CONSTRAINT_RELATION_EQ, 0.0,
+                                                                   EMEUS_CONSTRAINT_STRENGTH_REQUIRED));
+  emeus_constraint_layout_add_constraint (layout,
+                                          emeus_constraint_new (widget, EMEUS_CONSTRAINT_ATTRIBUTE_HEIGHT,
+                                                                EMEUS_CONSTRAINT_RELATION_EQ,
+                                                                NULL, EMEUS_CONSTRAINT_ATTRIBUTE_HEIGHT,
+                                                                1.0, 0.0,
+                                                                EMEUS_CONSTRAINT_STRENGTH_REQUIRED));
+  emeus_constraint_layout_add_constraint (layout,
+                                          emeus_constraint_new (widget, EMEUS_CONSTRAINT_ATTRIBUTE_WIDTH,
+                                                                EMEUS_CONSTRAINT_RELATION_EQ,
+                                                                NULL, EMEUS_CONSTRAINT_ATTRIBUTE_WIDTH,
+                                                                1.0, -100.0,
+                                                                EMEUS_CONSTRAINT_STRENGTH_MEDIUM));
+  emeus_constraint_layout_add_constraint (layout,
+                                          constant_constraint_new (widget,
+                                                                   EMEUS_CONSTRAINT_ATTRIBUTE_WIDTH,
+                                                                   EMEUS_CONSTRAINT_RELATION_GE, 50.0,
+                                                                   EMEUS_CONSTRAINT_STRENGTH_REQUIRED));
+  emeus_constraint_layout_add_constraint (layout,
+                                          constant_constraint_new (widget,
+                                                                   EMEUS_CONSTRAINT_ATTRIBUTE_WIDTH,
+                                                                   EMEUS_CONSTRAINT_RELATION_LE, 300.0,
+                                                                   EMEUS_CONSTRAINT_STRENGTH_REQUIRED));
+
+  /* Every allocation goes through the sensitivity model or the solver */
+  emeus_constraint_layout_set_allocation_cache_size (layout, 0);
+
+  gtk_widget_show_all (GTK_WIDGET (layout));
+
+  *child_p = widget;
+
+  return layout;
+}
+
+/* Allocations inside the region in which the basis stays the same are
+ * computed from the sensitivity of the solution, and must match the
+ * allocation computed by the solver; leaving the region solves again
+ */
+static void
+emeus_layout_allocate_from_sensitivity (void)
+{
+  const struct {
+    int width;
+    int child_width;
+    gboolean solved;
+  } steps[] = {
+    { 250, 150, TRUE },
+    { 300, 200, FALSE },
+    { 350, 250, FALSE },
+    /* The maximum width of the child changes the basis */
+    { 450, 300, TRUE },
+    { 500, 300, FALSE },
+    { 200, 100, TRUE },
+    { 380, 280, FALSE },
+  };
+  GtkWidget *widget;
+  EmeusConstraintLayout *layout = sensitivity_layout_new (&widget);
+  guint i;
+
+  for (i = 0; i < G_N_ELEMENTS (steps); i++)
+    {
+      EmeusConstraintLayout *reference;
+      GtkWidget *reference_widget;
+      GtkAllocation expected;
+
+      layout_allocate (layout, steps[i].width, 300);
+
+      if (steps[i].solved)
+        g_assert_cmpint (layout->sensitivity.allocation.width, ==, steps[i].width);
+      else
+        g_assert_cmpint (layout->sensitivity.allocation.width, !=, steps[i].width);
+
+      /* A new layout always goes through the solver */
+      reference = sensitivity_layout_new (&reference_widget);
+      layout_allocate (reference, steps[i].width, 300);
+      g_assert_cmpint (reference->sensitivity.allocation.width, ==, steps[i].width);
+
+      gtk_widget_get_allocation (gtk_widget_get_parent (reference_widget), &expected);
+      g_assert_cmpint (expected.width, ==, steps[i].child_width);
+      assert_child_allocation (widget, expected.x, expected.y, expected.width, expected.height);
+
+      gtk_widget_destroy (GTK_WIDGET (reference));
+      g_object_unref (reference);
+    }
+
+  gtk_widget_destroy (GTK_WIDGET (layout));
+  g_object_unref (layout);
+}
+
+/* The solver backend can be chosen for each layout, until the solver
+ * is used for the first time
+ */
+static void
+emeus_layout_solver_backend (void)
+{
+  EmeusConstraintLayout *layout = layout_new ();
+  GtkWidget *widget;
+
+  g_test_expect_message ("Emeus", G_LOG_LEVEL_CRITICAL, "*Unknown solver backend*");
+  g_assert_false (emeus_constraint_layout_set_solver_backend (layout, "invalid"));
+  g_test_assert_expected_messages ();
+
+  g_assert_true (emeus_constraint_layout_set_solver_backend (layout, "profile"));
+  g_assert_false (layout->solver.initialized);
+
+  widget = layout_pack_child (layout, "child");
+  emeus_constraint_layout_add_constraint (layout,
+                                          constant_constraint_new (widget,
+                                                                   EMEUS_CONSTRAINT_ATTRIBUTE_WIDTH,
+                                                                   EMEUS_CONSTRAINT_RELATION_EQ, 100.0,
+                                                                   EMEUS_CONSTRAINT_STRENGTH_REQUIRED));
+
+  g_assert_true (layout->solver.backend == solver_backend_lookup ("profile"));
+  emeus_assert_almost_equals (child_get_value (widget, EMEUS_CONSTRAINT_ATTRIBUTE_WIDTH), 100.0);
+
+  g_test_expect_message ("Emeus", G_LOG_LEVEL_CRITICAL, "*already in use*");
+  g_assert_false (emeus_constraint_layout_set_solver_backend (layout, "cassowary"));
+  g_test_assert_expected_messages ();
+
+  g_assert_true (layout->solver.backend == solver_backend_lookup ("profile"));
+
+  gtk_widget_destroy (GTK_WIDGET (layout));
+  g_object_unref (layout);
+}
+
+/* The LP backends allocate the children like the Cassowary solver,
+ * without a sensitivity model
+ */
+static void
+emeus_layout_lp_backend (gconstpointer data)
+{
+  const char * const lines[] = {
+    "H:|-10-[a(100)]-20-[b(50)]",
+    "V:|-5-[a(30)]",
+    "V:|[b(40)]",
+  };
+  EmeusConstraintLayout *layout = layout_new ();
+  GHashTable *views = g_hash_table_new (g_str_hash, g_str_equal);
+  GtkWidget *a, *b;
+
+  g_assert_true (emeus_constraint_layout_set_solver_backend (layout, data));
+
+  a = layout_pack_child (layout, "a");
+  b = layout_pack_child (layout, "b");
+
+  g_hash_table_insert (views, "a", a);
+  g_hash_table_insert (views, "b", b);
+
+  layout_add_description (layout, lines, G_N_ELEMENTS (lines), views, NULL);
+
+  g_assert_true (layout->solver.backend == solver_backend_lookup (data));
+
+  gtk_widget_show_all (GTK_WIDGET (layout));
+
+  layout_allocate (layout, 400, 300);
+  assert_child_allocation (a, 10, 5, 100, 30);
+  assert_child_allocation (b, 130, 0, 50, 40);
+  g_assert_null (layout->sensitivity.region);
+
+  layout_allocate (layout, 600, 200);
+  assert_child_allocation (a, 10, 5, 100, 30);
+  assert_child_allocation (b, 130, 0, 50, 40);
+
+  g_hash_table_unref (views);
+  gtk_widget_destroy (GTK_WIDGET (layout));
+  g_object_unref (layout);
+}
+
+int
+main (int argc, char *argv[])
+{
+  gtk_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/emeus/constraint-group/set-active", emeus_group_set_active);
+  g_test_add_func ("/emeus/constraint-group/two-layouts", emeus_group_two_layouts);
+  g_test_add_data_func ("/emeus/constraint-group/reactivate-ge",
+                        GINT_TO_POINTER (EMEUS_CONSTRAINT_RELATION_GE),
+                        emeus_group_reactivate);
+  g_test_add_data_func ("/emeus/constraint-group/reactivate-le",
+                        GINT_TO_POINTER (EMEUS_CONSTRAINT_RELATION_LE),
+                        emeus_group_reactivate);
+  g_test_add_func ("/emeus/constraint-layout/measure-children", emeus_layout_measure_children);
+  g_test_add_func ("/emeus/constraint-layout/lazy-solver", emeus_layout_lazy_solver);
+  g_test_add_func ("/emeus/constraint-layout/set-metric", emeus_layout_set_metric);
+  g_test_add_func ("/emeus/constraint-layout/set-metrics", emeus_layout_set_metrics);
+  g_test_add_func ("/emeus/constraint-layout/update-description", emeus_layout_update_description);
+  g_test_add_func ("/emeus/constraint-layout/update-description-duplicates",
+                   emeus_layout_update_description_duplicates);
+  g_test_add_func ("/emeus/constraint-layout/update-description-removed-child",
+                   emeus_layout_update_description_removed_child);
+  g_test_add_data_func ("/emeus/constraint-layout/replace-constraints-eq",
+                        GINT_TO_POINTER (EMEUS_CONSTRAINT_RELATION_EQ),
+                        emeus_layout_replace_constraints);
+  g_test_add_data_func ("/emeus/constraint-layout/replace-constraints-ge",
+                        GINT_TO_POINTER (EMEUS_CONSTRAINT_RELATION_GE),
+                        emeus_layout_replace_constraints);
+  g_test_add_data_func ("/emeus/constraint-layout/replace-constraints-le",
+                        GINT_TO_POINTER (EMEUS_CONSTRAINT_RELATION_LE),
+                        emeus_layout_replace_constraints);
+  g_test_add_func ("/emeus/constraint-layout/deferred-solving", emeus_layout_deferred_solving);
+  g_test_add_func ("/emeus/constraint-layout/allocation-cache", emeus_layout_allocation_cache);
+  g_test_add_func ("/emeus/constraint-layout/child-rectangles", emeus_layout_child_rectangles);
+  g_test_add_func ("/emeus/constraint-layout/allocate-from-sensitivity",
+                   emeus_layout_allocate_from_sensitivity);
+  g_test_add_func ("/emeus/constraint-layout/solver-backend", emeus_layout_solver_backend);
+  g_test_add_data_func ("/emeus/constraint-layout/revised-backend", "revised", emeus_layout_lp_backend);
+  g_test_add_data_func ("/emeus/constraint-layout/dense-backend", "dense", emeus_layout_lp_backend);
+
+  return g_test_run ();
+}
@@ -0,0 +1,916 @@
+#include "emeus-expression-private.h"
+#include "emeus-lp-solver-private.h"
+#include "emeus-simplex-solver-private.h"
+#include "emeus-solver-backend-private.h"
+#include "emeus-types-private.h"
+
+#include "emeus-test-utils.h"
+
+#define N_RANDOM_PROBLEMS       50
+
+static void
+lp_solver_init_backend (SimplexSolver *solver,
+                        const char    *name)
+{
+  const SolverBackend *backend = solver_backend_lookup (name);
+
+  g_assert_nonnull (backend);
+
+  solver_init (solver, backend);
+}
+
+static void
+emeus_lp_solver_simple (gconstpointer data)
+{
+  SimplexSolver solver = SIMPLEX_SOLVER_INIT;
+
+  lp_solver_init_backend (&solver, data);
+
+  Variable *x = solver_create_variable (&solver, "x", 167.0);
+  Variable *y = solver_create_variable (&solver, "y", 2.0);
+
+  /* x + 10 <= y, with x staying weakly at 167 and y at 2 */
+  solver_add_stay_variable (&solver, x, STRENGTH_WEAK);
+  solver_add_stay_variable (&solver, y, STRENGTH_MEDIUM);
+
+  Expression *e = expression_minus (expression_new_from_variable (y), 10.0);
+  solver_add_constraint (&solver, x, OPERATOR_TYPE_LE, e, STRENGTH_REQUIRED);
+  expression_unref (e);
+
+  emeus_assert_almost_equals (solver_get_value (&solver, x), -8.0);
+  emeus_assert_almost_equals (solver_get_value (&solver, y), 2.0);
+
+  variable_unref (x);
+  variable_unref (y);
+
+  solver_clear (&solver);
+}
+
+static void
+emeus_lp_solver_edit (gconstpointer data)
+{
+  SimplexSolver solver = SIMPLEX_SOLVER_INIT;
+
+  lp_solver_init_backend (&solver, data);
+
+  Variable *x = solver_create_variable (&solver, "x", 0.0);
+  Variable *y = solver_create_variable (&solver, "y", 0.0);
+  Variable *z = solver_create_variable (&solver, "z", 0.0);
+
+  solver_add_stay_variable (&solver, x, STRENGTH_WEAK);
+  solver_add_stay_variable (&solver, y, STRENGTH_WEAK);
+  solver_add_stay_variable (&solver, z, STRENGTH_WEAK);
+
+  /* y = x + 10, z >= y */
+  Expression *e = expression_plus (expression_new_from_variable (x), 10.0);
+  solver_add_constraint (&solver, y, OPERATOR_TYPE_EQ, e, STRENGTH_REQUIRED);
+  expression_unref (e);
+
+  e = expression_new_from_variable (y);
+  solver_add_constraint (&solver, z, OPERATOR_TYPE_GE, e, STRENGTH_REQUIRED);
+  expression_unref (e);
+
+  solver_add_edit_variable (&solver, x, STRENGTH_STRONG);
+
+  for (int i = 0; i < 10; i++)
+    {
+      double value = i * 7.5 - 20.0;
+
+      solver_suggest_value (&solver, x, value);
+      solver_resolve (&solver);
+
+      emeus_assert_almost_equals (solver_get_value (&solver, x), value);
+      emeus_assert_almost_equals (solver_get_value (&solver, y), value + 10.0);
+      g_assert_cmpfloat (solver_get_value (&solver, z), >=, value + 10.0 - 1e-9);
+    }
+
+  /* A batch of suggestions is resolved at once */
+  Variable *vars[] = { x, z };
+  double values[] = { 100.0, 50.0 };
+
+  solver_add_edit_variable (&solver, z, STRENGTH_MEDIUM);
+  solver_suggest_values (&solver, vars, values, G_N_ELEMENTS (vars));
+  solver_resolve (&solver);
+
+  /* The strong edit of x wins over the medium edit of z */
+  emeus_assert_almost_equals (solver_get_value (&solver, x), 100.0);
+  emeus_assert_almost_equals (solver_get_value (&solver, y), 110.0);
+  emeus_assert_almost_equals (solver_get_value (&solver, z), 110.0);
+
+  variable_unref (x);
+  variable_unref (y);
+  variable_unref (z);
+
+  solver_clear (&solver);
+}
+
+static void
+emeus_lp_solver_stay (gconstpointer data)
+{
+  SimplexSolver solver = SIMPLEX_SOLVER_INIT;
+
+  lp_solver_init_backend (&solver, data);
+
+  Variable *x = solver_create_variable (&solver, "x", 5.0);
+  Variable *y = solver_create_variable (&solver, "y", 10.0);
+
+  solver_add_stay_variable (&solver, x, STRENGTH_STRONG);
+  solver_add_stay_variable (&solver, y, STRENGTH_WEAK);
+
+  emeus_assert_almost_equals (solver_get_value (&solver, x), 5.0);
+  emeus_assert_almost_equals (solver_get_value (&solver, y), 10.0);
+
+  /* x + y = 30; the weaker stay gives way */
+  Expression *e = expression_minus_variable (expression_new_from_constant (30.0), y);
+  Constraint *c = solver_add_constraint (&solver, x, OPERATOR_TYPE_EQ, e, STRENGTH_REQUIRED);
+  expression_unref (e);
+
+  emeus_assert_almost_equals (solver_get_value (&solver, x), 5.0);
+  emeus_assert_almost_equals (solver_get_value (&solver, y), 25.0);
+
+  /* Removing the constraint leaves the variables where they were */
+  solver_remove_constraint (&solver, c);
+
+  emeus_assert_almost_equals (solver_get_value (&solver, x), 5.0);
+  emeus_assert_almost_equals (solver_get_value (&solver, y), 25.0);
+
+  variable_unref (x);
+  variable_unref (y);
+
+  solver_clear (&solver);
+}
+
+static void
+emeus_lp_solver_freeze_thaw (gconstpointer data)
+{
+  SimplexSolver solver = SIMPLEX_SOLVER_INIT;
+
+  lp_solver_init_backend (&solver, data);
+
+  LpModel *model = lp_solver_get_model (&solver);
+
+  Variable *x = solver_create_variable (&solver, "x", 0.0);
+  Variable *y = solver_create_variable (&solver, "y", 0.0);
+
+  solver_freeze (&solver);
+
+  solver_add_stay_variable (&solver, x, STRENGTH_WEAK);
+  solver_add_stay_variable (&solver, y, STRENGTH_WEAK);
+
+  Expression *e = expression_times (expression_new_from_variable (x), 2.0);
+  solver_add_constraint (&solver, y, OPERATOR_TYPE_EQ, e, STRENGTH_REQUIRED);
+  expression_unref (e);
+
+  solver_add_edit_variable (&solver, x, STRENGTH_STRONG);
+  solver_suggest_value (&solver, x, 21.0);
+  solver_suggest_value (&solver, x, 42.0);
+
+  /* Nothing is solved until the solver is thawed */
+  g_assert_cmpuint (model->n_solves, ==, 0);
+
+  solver_thaw (&solver);
+
+  g_assert_cmpuint (model->n_solves, ==, 1);
+
+  emeus_assert_almost_equals (solver_get_value (&solver, x), 42.0);
+  emeus_assert_almost_equals (solver_get_value (&solver, y), 84.0);
+
+  g_test_expect_message ("Emeus", G_LOG_LEVEL_CRITICAL, "*Unbalanced thaw*");
+  solver_thaw (&solver);
+  g_test_assert_expected_messages ();
+
+  variable_unref (x);
+  variable_unref (y);
+
+  solver_clear (&solver);
+}
+
+static void
+emeus_lp_solver_transaction (gconstpointer data)
+{
+  SimplexSolver solver = SIMPLEX_SOLVER_INIT;
+
+  lp_solver_init_backend (&solver, data);
+
+  Variable *left = solver_create_variable (&solver, "left", 0.0);
+  Variable *width = solver_create_variable (&solver, "width", 0.0);
+  Variable *right = solver_create_variable (&solver, "right", 0.0);
+
+  solver_add_stay_variable (&solver, left, STRENGTH_WEAK);
+  solver_add_stay_variable (&solver, width, STRENGTH_WEAK);
+
+  /* right = left + width, width >= 100 */
+  Expression *e = expression_plus_variable (expression_new_from_variable (left), width);
+  solver_add_constraint (&solver, right, OPERATOR_TYPE_EQ, e, STRENGTH_REQUIRED);
+  expression_unref (e);
+
+  e = expression_new_from_constant (100.0);
+  Constraint *min_width = solver_add_constraint (&solver, width, OPERATOR_TYPE_GE, e, STRENGTH_REQUIRED);
+  expression_unref (e);
+
+  emeus_assert_almost_equals (solver_get_value (&solver, width), 100.0);
+  emeus_assert_almost_equals (solver_get_value (&solver, right), 100.0);
+
+  guint generation = simplex_solver_get_generation (&solver);
+
+  solver_begin_transaction (&solver);
+
+  /* Impose the position of the right edge, and drop the minimum width */
+  variable_set_value (right, 250.0);
+  solver_add_stay_variable (&solver, right, STRENGTH_REQUIRED);
+  solver_remove_constraint (&solver, min_width);
+
+  e = expression_new_from_constant (50.0);
+  solver_add_constraint (&solver, left, OPERATOR_TYPE_EQ, e, STRENGTH_REQUIRED);
+  expression_unref (e);
+
+  emeus_assert_almost_equals (solver_get_value (&solver, left), 50.0);
+  emeus_assert_almost_equals (solver_get_value (&solver, width), 200.0);
+  emeus_assert_almost_equals (solver_get_value (&solver, right), 250.0);
+
+  solver_rollback_transaction (&solver);
+
+  /* Everything is back where it was, including the removed constraint */
+  g_assert_cmpuint (simplex_solver_get_generation (&solver), ==, generation);
+  emeus_assert_almost_equals (solver_get_value (&solver, left), 0.0);
+  emeus_assert_almost_equals (solver_get_value (&solver, width), 100.0);
+  emeus_assert_almost_equals (solver_get_value (&solver, right), 100.0);
+
+  solver_remove_constraint (&solver, min_width);
+
+  e = expression_new_from_constant (30.0);
+  solver_add_constraint (&solver, width, OPERATOR_TYPE_EQ, e, STRENGTH_REQUIRED);
+  expression_unref (e);
+
+  emeus_assert_almost_equals (solver_get_value (&solver, width), 30.0);
+  emeus_assert_almost_equals (solver_get_value (&solver, right), 30.0);
+
+  /* A committed transaction keeps its changes */
+  solver_begin_transaction (&solver);
+
+  e = expression_new_from_constant (10.0);
+  solver_add_constraint (&solver, left, OPERATOR_TYPE_EQ, e, STRENGTH_REQUIRED);
+  expression_unref (e);
+
+  solver_commit_transaction (&solver);
+
+  emeus_assert_almost_equals (solver_get_value (&solver, left), 10.0);
+  emeus_assert_almost_equals (solver_get_value (&solver, right), 40.0);
+
+  variable_unref (left);
+  variable_unref (width);
+  variable_unref (right);
+
+  solver_clear (&solver);
+}
+
+static void
+emeus_lp_solver_infeasible (gconstpointer data)
+{
+  SimplexSolver solver = SIMPLEX_SOLVER_INIT;
+
+  lp_solver_init_backend (&solver, data);
+
+  Variable *x = solver_create_variable (&solver, "x", 0.0);
+  Variable *y = solver_create_variable (&solver, "y", 0.0);
+
+  solver_add_stay_variable (&solver, y, STRENGTH_WEAK);
+
+  Expression *e = expression_new_from_constant (10.0);
+  solver_add_constraint (&solver, x, OPERATOR_TYPE_GE, e, STRENGTH_REQUIRED);
+  expression_unref (e);
+
+  e = expression_plus (expression_new_from_variable (x), 5.0);
+  solver_add_constraint (&solver, y, OPERATOR_TYPE_EQ, e, STRENGTH_REQUIRED);
+  expression_unref (e);
+
+  emeus_assert_almost_equals (solver_get_value (&solver, x), 10.0);
+  emeus_assert_almost_equals (solver_get_value (&solver, y), 15.0);
+
+  /* x <= 5 cannot be satisfied along with x >= 10; the newer required
+   * constraint is the one that gives way
+   */
+  e = expression_new_from_constant (5.0);
+  solver_add_constraint (&solver, x, OPERATOR_TYPE_LE, e, STRENGTH_REQUIRED);
+  expression_unref (e);
+
+  emeus_assert_almost_equals (solver_get_value (&solver, x), 10.0);
+  emeus_assert_almost_equals (solver_get_value (&solver, y), 15.0);
+
+  variable_unref (x);
+  variable_unref (y);
+
+  solver_clear (&solver);
+}
+
+/* A chain of required constraints long enough to go through several
+ * refactorizations of the basis while editing its head
+ */
+static void
+emeus_lp_solver_chain (gconstpointer data)
+{
+  SimplexSolver solver = SIMPLEX_SOLVER_INIT;
+  const guint n_vars = 300;
+
+  lp_solver_init_backend (&solver, data);
+
+  LpModel *model = lp_solver_get_model (&solver);
+  Variable **vars = g_new (Variable *, n_vars);
+
+  solver_freeze (&solver);
+
+  for (guint i = 0; i < n_vars; i++)
+    {
+      vars[i] = solver_create_variable (&solver, "chain", 0.0);
+      solver_add_stay_variable (&solver, vars[i], STRENGTH_WEAK);
+
+      if (i == 0)
+        continue;
+
+      /* vars[i] >= vars[i - 1] + 1 */
+      Expression *e = expression_plus (expression_new_from_variable (vars[i - 1]), 1.0);
+      solver_add_constraint (&solver, vars[i], OPERATOR_TYPE_GE, e, STRENGTH_REQUIRED);
+      expression_unref (e);
+    }
+
+  solver_add_edit_variable (&solver, vars[0], STRENGTH_STRONG);
+
+  solver_thaw (&solver);
+
+  for (guint i = 0; i < n_vars; i++)
+    emeus_assert_almost_equals (solver_get_value (&solver, vars[i]), i);
+
+  for (int value = 0; value <= 100; value += 25)
+    {
+      solver_suggest_value (&solver, vars[0], value);
+      solver_resolve (&solver);
+
+      for (guint i = 0; i < n_vars; i++)
+        emeus_assert_almost_equals (solver_get_value (&solver, vars[i]), value + (double) i);
+    }
+
+  g_assert_cmpuint (model->n_pivots, >, 64);
+
+  for (guint i = 0; i < n_vars; i++)
+    variable_unref (vars[i]);
+
+  g_free (vars);
+
+  solver_clear (&solver);
+}
+
+typedef struct {
+  guint lhs;
+  guint rhs;
+  double multiplier;
+  double constant;
+  OperatorType op;
+  double strength;
+
+  Constraint *constraint;
+  bool removed;
+} RandomConstraint;
+
+static double
+random_strength (int first)
+{
+  switch (g_test_rand_int_range (first, 4))
+    {
+    case 0:
+      return STRENGTH_WEAK;
+
+    case 1:
+      return STRENGTH_MEDIUM;
+
+    case 2:
+      return STRENGTH_STRONG;
+
+    default:
+      return STRENGTH_REQUIRED;
+    }
+}
+
+/* The unit multipliers come first */
+static const double random_multipliers[] = { 1.0, -1.0, 2.0, 0.5 };
+
+/* A random constraint between two variables, which is satisfied by
+ * @solution if it is required; @n_multipliers is the number of the
+ * random_multipliers to choose from
+ */
+static void
+random_constraint_init (RandomConstraint *c,
+                        const double     *solution,
+                        guint             n_vars,
+                        guint             n_multipliers)
+{
+  c->lhs = g_test_rand_int_range (0, n_vars);
+  c->rhs = (c->lhs + g_test_rand_int_range (1, n_vars)) % n_vars;
+  c->multiplier = random_multipliers[g_test_rand_int_range (0, n_multipliers)];
+  c->op = g_test_rand_int_range (OPERATOR_TYPE_LE, OPERATOR_TYPE_GE + 1);
+  c->strength = random_strength (0);
+  c->constant = solution[c->lhs] - c->multiplier * solution[c->rhs];
+  c->constraint = NULL;
+  c->removed = false;
+
+  if (c->strength < STRENGTH_REQUIRED)
+    c->constant += g_test_rand_int_range (-50, 50);
+  else if (c->op == OPERATOR_TYPE_GE)
+    c->constant -= g_test_rand_int_range (0, 20);
+  else if (c->op == OPERATOR_TYPE_LE)
+    c->constant += g_test_rand_int_range (0, 20);
+}
+
+static Constraint *
+random_constraint_add (RandomConstraint *c,
+                       SimplexSolver    *solver,
+                       Variable        **vars)
+{
+  Expression *e;
+  Constraint *res;
+
+  e = expression_times (expression_new_from_variable (vars[c->rhs]), c->multiplier);
+  e = expression_plus (e, c->constant);
+  res = solver_add_constraint (solver, vars[c->lhs], c->op, e, c->strength);
+  expression_unref (e);
+
+  return res;
+}
+
+/* The sum of the errors of the non-required constraints, and of the weak
+ * stays at @anchors, if any, weighted by their strength, which is what
+ * the solvers minimize
+ */
+static double
+random_problem_get_objective (Variable        **vars,
+                              const double     *anchors,
+                              guint             n_vars,
+                              RandomConstraint *constraints,
+                              guint             n_constraints)
+{
+  double res = 0.0;
+
+  for (guint i = 0; anchors != NULL && i < n_vars; i++)
+    res += STRENGTH_WEAK * fabs (variable_get_value (vars[i]) - anchors[i]);
+
+  for (guint i = 0; i < n_constraints; i++)
+    {
+      RandomConstraint *c = &constraints[i];
+      double error;
+
+      if (c->removed)
+        continue;
+
+      error = variable_get_value (vars[c->lhs])
+            - c->multiplier * variable_get_value (vars[c->rhs])
+            - c->constant;
+
+      if (c->strength >= STRENGTH_REQUIRED)
+        {
+          if (c->op == OPERATOR_TYPE_EQ)
+            g_assert_cmpfloat (fabs (error), <, 1e-6);
+          else if (c->op == OPERATOR_TYPE_GE)
+            g_assert_cmpfloat (error, >, -1e-6);
+          else
+            g_assert_cmpfloat (error, <, 1e-6);
+
+          continue;
+        }
+
+      if (c->op == OPERATOR_TYPE_EQ)
+        res += c->strength * fabs (error);
+      else if (c->op == OPERATOR_TYPE_GE)
+        res += c->strength * MAX (-error, 0.0);
+      else
+        res += c->strength * MAX (error, 0.0);
+    }
+
+  return res;
+}
+
+/* Solves the constraints that were not removed at once, with a new solver
+ * using the @name backend, and returns the objective of the solution
+ */
+static double
+random_problem_solve (const char       *name,
+                      const double     *anchors,
+                      guint             n_vars,
+                      RandomConstraint *constraints,
+                      guint             n_constraints)
+{
+  SimplexSolver solver = SIMPLEX_SOLVER_INIT;
+  Variable **vars = g_new (Variable *, n_vars);
+  double res;
+
+  lp_solver_init_backend (&solver, name);
+
+  solver_freeze (&solver);
+
+  for (guint i = 0; i < n_vars; i++)
+    {
+      vars[i] = solver_create_variable (&solver, "v", anchors != NULL ? anchors[i] : 0.0);
+
+      if (anchors != NULL)
+        solver_add_stay_variable (&solver, vars[i], STRENGTH_WEAK);
+    }
+
+  for (guint i = 0; i < n_constraints; i++)
+    {
+      if (!constraints[i].removed)
+        random_constraint_add (&constraints[i], &solver, vars);
+    }
+
+  solver_thaw (&solver);
+
+  res = random_problem_get_objective (vars, anchors, n_vars, constraints, n_constraints);
+
+  for (guint i = 0; i < n_vars; i++)
+    variable_unref (vars[i]);
+
+  g_free (vars);
+
+  solver_clear (&solver);
+
+  return res;
+}
+
+/* Solves random feasible problems with the revised backend and with the
+ * Cassowary solver; solutions may differ, but not the objective
+ */
+static void
+emeus_lp_solver_random (gconstpointer data)
+{
+  for (int n = 0; n < N_RANDOM_PROBLEMS; n++)
+    {
+      guint n_vars = g_test_rand_int_range (4, 12);
+      guint n_constraints = g_test_rand_int_range (n_vars, n_vars * 3);
+      RandomConstraint *constraints = g_new0 (RandomConstraint, n_constraints);
+      double *solution = g_new (double, n_vars);
+      double *anchors = g_new (double, n_vars);
+      double expected, objective;
+
+      for (guint i = 0; i < n_vars; i++)
+        {
+          solution[i] = g_test_rand_int_range (0, 100);
+          anchors[i] = g_test_rand_int_range (0, 100);
+        }
+
+      /* The Cassowary solver does not always find a solution for random
+       * required constraints with other multipliers, so the comparison
+       * sticks to the unit ones
+       */
+      for (guint i = 0; i < n_constraints; i++)
+        random_constraint_init (&constraints[i], solution, n_vars, 2);
+
+      expected = random_problem_solve ("cassowary", anchors, n_vars, constraints, n_constraints);
+      objective = random_problem_solve (data, anchors, n_vars, constraints, n_constraints);
+
+      if (g_test_verbose ())
+        g_test_message ("problem %d: %u variables, %u constraints, objective: %g, expected: %g",
+                        n, n_vars, n_constraints,
+                        objective, expected);
+
+      g_assert_true (emeus_fuzzy_equals (objective, expected, 1e-6 * MAX (expected, 1.0)));
+
+      g_free (constraints);
+      g_free (solution);
+      g_free (anchors);
+    }
+}
+
+/* Adds and removes random constraints one at a time, so that every
+ * change goes through an incremental solve, and compares the objective
+ * with the one of a new revised solver after each change; there are no
+ * stays, as their value depends on the previous solution
+ */
+static void
+emeus_lp_solver_random_incremental (gconstpointer data)
+{
+  for (int n = 0; n < N_RANDOM_PROBLEMS / 5; n++)
+    {
+      SimplexSolver solver = SIMPLEX_SOLVER_INIT;
+      guint n_vars = g_test_rand_int_range (4, 10);
+      guint n_constraints = g_test_rand_int_range (n_vars * 2, n_vars * 4);
+      RandomConstraint *constraints = g_new0 (RandomConstraint, n_constraints);
+      double *solution = g_new (double, n_vars);
+      Variable **vars = g_new (Variable *, n_vars);
+
+      lp_solver_init_backend (&solver, data);
+
+      for (guint i = 0; i < n_vars; i++)
+        {
+          solution[i] = g_test_rand_int_range (0, 100);
+          vars[i] = solver_create_variable (&solver, "v", 0.0);
+        }
+
+      for (guint i = 0; i < n_constraints; i++)
+        {
+          RandomConstraint *c = &constraints[i];
+          double expected, objective;
+
+          random_constraint_init (c, solution, n_vars, G_N_ELEMENTS (random_multipliers));
+          c->constraint = random_constraint_add (c, &solver, vars);
+
+          /* Every third step, remove one of the previous constraints */
+          if (i % 3 == 2)
+            {
+              RandomConstraint *r = &constraints[g_test_rand_int_range (0, i)];
+
+              if (!r->removed)
+                {
+                  solver_remove_constraint (&solver, r->constraint);
+                  r->removed = true;
+                }
+            }
+
+          for (guint v = 0; v < n_vars; v++)
+            solver_get_value (&solver, vars[v]);
+
+          objective = random_problem_get_objective (vars, NULL, n_vars, constraints, i + 1);
+          expected = random_problem_solve ("revised", NULL, n_vars, constraints, i + 1);
+
+          g_assert_true (emeus_fuzzy_equals (objective, expected, 1e-6 * MAX (expected, 1.0)));
+        }
+
+      for (guint i = 0; i < n_vars; i++)
+        variable_unref (vars[i]);
+
+      g_free (vars);
+      g_free (constraints);
+      g_free (solution);
+
+      solver_clear (&solver);
+    }
+}
+
+/* A chain of @n_vars variables, each at least one more than the previous
+ * one, with the first one editable
+ */
+static Variable **
+chain_new (SimplexSolver *solver,
+           guint          n_vars,
+           Constraint   **constraints)
+{
+  Variable **res = g_new (Variable *, n_vars);
+
+  solver_freeze (solver);
+
+  for (guint i = 0; i < n_vars; i++)
+    {
+      res[i] = solver_create_variable (solver, "chain", 0.0);
+      solver_add_stay_variable (solver, res[i], STRENGTH_WEAK);
+
+      if (i == 0)
+        continue;
+
+      Expression *e = expression_plus (expression_new_from_variable (res[i - 1]), 1.0);
+      constraints[i] = solver_add_constraint (solver, res[i], OPERATOR_TYPE_GE, e, STRENGTH_REQUIRED);
+      expression_unref (e);
+    }
+
+  solver_add_edit_variable (solver, res[0], STRENGTH_STRONG);
+
+  solver_thaw (solver);
+
+  return res;
+}
+
+static void
+chain_free (Variable **vars,
+            guint      n_vars)
+{
+  for (guint i = 0; i < n_vars; i++)
+    variable_unref (vars[i]);
+
+  g_free (vars);
+}
+
+/* The dense engine gives way to the revised engine for large programs,
+ * and gets back when the program shrinks
+ */
+static void
+emeus_lp_solver_dense_switch (void)
+{
+  SimplexSolver solver = SIMPLEX_SOLVER_INIT;
+  const guint n_vars = 150;
+  Constraint *constraints[150] = { NULL, };
+
+  lp_solver_init_backend (&solver, "dense");
+
+  LpModel *model = lp_solver_get_model (&solver);
+
+  g_assert_true (model->engine_class == &lp_dense_engine);
+
+  /* A stay and a constraint for each variable */
+  Variable **vars = chain_new (&solver, n_vars, constraints);
+
+  g_assert_true (model->engine_class == &lp_revised_engine);
+
+  solver_suggest_value (&solver, vars[0], 10.0);
+  solver_resolve (&solver);
+
+  for (guint i = 0; i < n_vars; i++)
+    emeus_assert_almost_equals (solver_get_value (&solver, vars[i]), 10.0 + i);
+
+  /* Dropping the second half of the chain leaves fewer rows than the
+   * limit of the dense engine, but not enough below it to switch back
+   */
+  for (guint i = n_vars - 1; i >= n_vars / 2; i--)
+    solver_remove_constraint (&solver, constraints[i]);
+
+  g_assert_cmpuint (lp_model_get_n_rows (model), <, lp_dense_engine.max_rows);
+
+  solver_suggest_value (&solver, vars[0], 20.0);
+  solver_resolve (&solver);
+
+  g_assert_true (model->engine_class == &lp_revised_engine);
+
+  for (guint i = 0; i < n_vars / 2; i++)
+    emeus_assert_almost_equals (solver_get_value (&solver, vars[i]), 20.0 + i);
+
+  for (guint i = n_vars / 2 - 1; i >= n_vars / 4; i--)
+    solver_remove_constraint (&solver, constraints[i]);
+
+  solver_suggest_value (&solver, vars[0], 30.0);
+  solver_resolve (&solver);
+
+  g_assert_true (model->engine_class == &lp_dense_engine);
+
+  for (guint i = 0; i < n_vars / 4; i++)
+    emeus_assert_almost_equals (solver_get_value (&solver, vars[i]), 30.0 + i);
+
+  chain_free (vars, n_vars);
+
+  solver_clear (&solver);
+}
+
+/* Rolling back a transaction restores the engine it started with */
+static void
+emeus_lp_solver_dense_transaction (void)
+{
+  SimplexSolver solver = SIMPLEX_SOLVER_INIT;
+  const guint n_vars = 50;
+  Constraint *constraints[50] = { NULL, };
+
+  lp_solver_init_backend (&solver, "dense");
+
+  LpModel *model = lp_solver_get_model (&solver);
+  Variable **vars = chain_new (&solver, n_vars, constraints);
+
+  g_assert_true (model->engine_class == &lp_dense_engine);
+
+  solver_begin_transaction (&solver);
+
+  /* Enough rows to go past the limit, even inside a transaction */
+  for (guint i = 0; i < lp_dense_engine.max_rows * 2; i++)
+    {
+      Expression *e = expression_new_from_constant (i);
+
+      solver_add_constraint (&solver, vars[i % n_vars], OPERATOR_TYPE_GE, e, STRENGTH_WEAK);
+      expression_unref (e);
+    }
+
+  g_assert_true (model->engine_class == &lp_revised_engine);
+
+  solver_rollback_transaction (&solver);
+
+  g_assert_true (model->engine_class == &lp_dense_engine);
+
+  solver_suggest_value (&solver, vars[0], 5.0);
+  solver_resolve (&solver);
+
+  for (guint i = 0; i < n_vars; i++)
+    emeus_assert_almost_equals (solver_get_value (&solver, vars[i]), 5.0 + i);
+
+  chain_free (vars, n_vars);
+
+  solver_clear (&solver);
+}
+
+/* Solves the constraints with the dense engine, using the @kernels, and
+ * returns the values of the variables
+ */
+static double *
+dense_solve (const char       *kernels,
+             const double     *anchors,
+             guint             n_vars,
+             RandomConstraint *constraints,
+             guint             n_constraints)
+{
+  SimplexSolver solver = SIMPLEX_SOLVER_INIT;
+  Variable **vars = g_new (Variable *, n_vars);
+  double *res = g_new (double, n_vars);
+
+  g_setenv ("EMEUS_DENSE_KERNELS", kernels, TRUE);
+  lp_solver_init_backend (&solver, "dense");
+  g_unsetenv ("EMEUS_DENSE_KERNELS");
+
+  LpModel *model = lp_solver_get_model (&solver);
+
+  g_assert_cmpstr (lp_dense_engine_get_kernels (model->engine), ==, kernels);
+
+  for (guint i = 0; i < n_vars; i++)
+    {
+      vars[i] = solver_create_variable (&solver, "v", anchors[i]);
+      solver_add_stay_variable (&solver, vars[i], STRENGTH_WEAK);
+    }
+
+  for (guint i = 0; i < n_constraints; i++)
+    random_constraint_add (&constraints[i], &solver, vars);
+
+  for (guint i = 0; i < n_vars; i++)
+    {
+      res[i] = solver_get_value (&solver, vars[i]);
+      variable_unref (vars[i]);
+    }
+
+  g_free (vars);
+
+  solver_clear (&solver);
+
+  return res;
+}
+
+/* The vector kernels round like the scalar ones, so the solution does not
+ * depend on the CPU
+ */
+static void
+emeus_lp_solver_dense_kernels (void)
+{
+  const char *kernels[] = { "sse2", "avx2" };
+  const guint n_vars = 40, n_constraints = 120;
+  RandomConstraint *constraints = g_new0 (RandomConstraint, n_constraints);
+  double *solution = g_new (double, n_vars);
+  double *anchors = g_new (double, n_vars);
+  double *expected;
+
+  for (guint i = 0; i < n_vars; i++)
+    {
+      solution[i] = g_test_rand_int_range (0, 100);
+      anchors[i] = g_test_rand_int_range (0, 100);
+    }
+
+  for (guint i = 0; i < n_constraints; i++)
+    random_constraint_init (&constraints[i], solution, n_vars, G_N_ELEMENTS (random_multipliers));
+
+  expected = dense_solve ("scalar", anchors, n_vars, constraints, n_constraints);
+
+  for (int k = 0; k < G_N_ELEMENTS (kernels); k++)
+    {
+      double *values;
+
+      if (!lp_dense_kernels_available (kernels[k]))
+        continue;
+
+      values = dense_solve (kernels[k], anchors, n_vars, constraints, n_constraints);
+
+      for (guint i = 0; i < n_vars; i++)
+        g_assert_cmpfloat (values[i], ==, expected[i]);
+
+      g_free (values);
+    }
+
+  g_free (expected);
+  g_free (anchors);
+  g_free (solution);
+  g_free (constraints);
+}
+
+static const char *backends[] = { "revised", "dense" };
+
+static const struct {
+  const char *name;
+  GTestDataFunc func;
+} backend_tests[] = {
+  { "simple", emeus_lp_solver_simple },
+  { "edit", emeus_lp_solver_edit },
+  { "stay", emeus_lp_solver_stay },
+  { "freeze-thaw", emeus_lp_solver_freeze_thaw },
+  { "transaction", emeus_lp_solver_transaction },
+  { "infeasible", emeus_lp_solver_infeasible },
+  { "chain", emeus_lp_solver_chain },
+  { "random", emeus_lp_solver_random },
+  { "random-incremental", emeus_lp_solver_random_incremental },
+};
+
+int
+main (int argc, char *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+
+  for (int i = 0; i < G_N_ELEMENTS (backends); i++)
+    {
+      for (int j = 0; j < G_N_ELEMENTS (backend_tests); j++)
+        {
+          char *path = g_strdup_printf ("/emeus/lp-solver/%s/%s", backends[i], backend_tests[j].name);
+
+          g_test_add_data_func (path, backends[i], backend_tests[j].func);
+          g_free (path);
+        }
+    }
+
+  g_test_add_func ("/emeus/lp-solver/dense/switch", emeus_lp_solver_dense_switch);
+  g_test_add_func ("/emeus/lp-solver/dense/transaction-switch", emeus_lp_solver_dense_transaction);
+  g_test_add_func ("/emeus/lp-solver/dense/kernels", emeus_lp_solver_dense_kernels);
+
+  return g_test_run ();
+}
@@ -1,5 +1,6 @@
 #include "emeus-expression-private.h"
 #include "emeus-simplex-solver-private.h"
+#include "emeus-solver-backend-private.h"
 #include "emeus-types-private.h"
 
 #include "emeus-test-utils.h"
@@ -271,6 +272,138 @@ emeus_solver_edit_var_suggest (void)
   simplex_solver_clear (&solver);
 }
 
+/* Each suggestion replaces the previous one; repeating the same value
+ * must not move the variable
+ */
+static void
+emeus_solver_edit_var_repeat (void)
+{
+  SimplexSolver solver = SIMPLEX_SOLVER_INIT;
+
+  simplex_solver_init (&solver);
+
+  Variable *a = simplex_solver_create_variable (&solver, "a", 0.0);
+  Variable *b = simplex_solver_create_variable (&solver, "b", 0.0);
+
+  simplex_solver_add_stay_variable (&solver, a, STRENGTH_WEAK);
+
+  /* b = a + 10 */
+  Expression *e = expression_plus (expression_new_from_variable (a), 10.0);
+  simplex_solver_add_constraint (&solver, b, OPERATOR_TYPE_EQ, e, STRENGTH_REQUIRED);
+  expression_unref (e);
+
+  simplex_solver_add_edit_variable (&solver, a, STRENGTH_STRONG);
+  simplex_solver_begin_edit (&solver);
+
+  const double values[] = { 4.0, 4.0, 4.0, -3.0, -3.0, 0.0 };
+
+  for (int i = 0; i < G_N_ELEMENTS (values); i++)
+    {
+      simplex_solver_suggest_value (&solver, a, values[i]);
+      simplex_solver_resolve (&solver);
+
+      emeus_assert_almost_equals (variable_get_value (a), values[i]);
+      emeus_assert_almost_equals (variable_get_value (b), values[i] + 10.0);
+    }
+
+  simplex_solver_end_edit (&solver);
+
+  variable_unref (a);
+  variable_unref (b);
+
+  simplex_solver_clear (&solver);
+}
+
+static void
+emeus_solver_edit_var_metric (void)
+{
+  SimplexSolver solver = SIMPLEX_SOLVER_INIT;
+
+  simplex_solver_init (&solver);
+
+  Variable *x = simplex_solver_create_variable (&solver, "x", 0.0);
+  Variable *spacing = simplex_solver_create_variable (&solver, "spacing", 8.0);
+
+  simplex_solver_add_edit_variable (&solver, spacing, STRENGTH_REQUIRED);
+
+  /* x = spacing * 2 + 4 */
+  Expression *e = expression_new_from_variable (spacing);
+  expression_times (e, 2.0);
+  expression_plus (e, 4.0);
+  simplex_solver_add_constraint (&solver, x, OPERATOR_TYPE_EQ, e, STRENGTH_REQUIRED);
+  expression_unref (e);
+
+  emeus_assert_almost_equals (variable_get_value (x), 20.0);
+
+  /* Every suggestion is relative to the current value of the variable,
+   * not to the previous suggestion
+   */
+  const double values[] = { 12.0, 6.0, 6.0, 0.0, 10.0 };
+
+  for (int i = 0; i < G_N_ELEMENTS (values); i++)
+    {
+      simplex_solver_suggest_value (&solver, spacing, values[i]);
+      simplex_solver_resolve (&solver);
+
+      emeus_assert_almost_equals (variable_get_value (spacing), values[i]);
+      emeus_assert_almost_equals (variable_get_value (x), values[i] * 2.0 + 4.0);
+    }
+
+  variable_unref (x);
+  variable_unref (spacing);
+
+  simplex_solver_clear (&solver);
+}
+
+static void
+emeus_solver_edit_var_suggest_values (void)
+{
+  SimplexSolver solver = SIMPLEX_SOLVER_INIT;
+
+  simplex_solver_init (&solver);
+
+  Variable *left = simplex_solver_create_variable (&solver, "left", 0.0);
+  Variable *right = simplex_solver_create_variable (&solver, "right", 100.0);
+  Variable *mid = simplex_solver_create_variable (&solver, "mid", 0.0);
+
+  simplex_solver_add_stay_variable (&solver, mid, STRENGTH_WEAK);
+
+  /* mid = (left + right) / 2 */
+  Expression *e = expression_plus_variable (expression_new_from_variable (left), right);
+  expression_times (e, 0.5);
+  simplex_solver_add_constraint (&solver, mid, OPERATOR_TYPE_EQ, e, STRENGTH_REQUIRED);
+  expression_unref (e);
+
+  simplex_solver_add_edit_variable (&solver, left, STRENGTH_STRONG);
+  simplex_solver_add_edit_variable (&solver, right, STRENGTH_STRONG);
+
+  /* Moving both edges at once must be the same as moving them one
+   * at a time
+   */
+  Variable *vars[] = { left, right, left };
+  const double values[] = { 10.0, 50.0, 20.0 };
+
+  simplex_solver_suggest_values (&solver, vars, values, G_N_ELEMENTS (values));
+
+  emeus_assert_almost_equals (variable_get_value (left), 20.0);
+  emeus_assert_almost_equals (variable_get_value (right), 50.0);
+  emeus_assert_almost_equals (variable_get_value (mid), 35.0);
+
+  simplex_solver_suggest_value (&solver, left, 0.0);
+  simplex_solver_suggest_value (&solver, right, 10.0);
+  simplex_solver_resolve (&solver);
+
+  emeus_assert_almost_equals (variable_get_value (left), 0.0);
+  emeus_assert_almost_equals (variable_get_value (right), 10.0);
+  emeus_assert_almost_equals (variable_get_value (mid), 5.0);
+
+  variable_unref (left);
+  variable_unref (right);
+  variable_unref (mid);
+
+  simplex_solver_clear (&solver);
+}
+
 static void
 emeus_solver_paper (void)
 {
@@ -574,6 +707,975 @@ emeus_solver_buttons (void)
   simplex_solver_clear (&solver);
 }
 
+static void
+emeus_solver_freeze_thaw (void)
+{
+  SimplexSolver solver = SIMPLEX_SOLVER_INIT;
+
+  simplex_solver_init (&solver);
+
+  Variable *x = simplex_solver_create_variable (&solver, "x", 0.0);
+  Variable *y = simplex_solver_create_variable (&solver, "y", 0.0);
+
+  simplex_solver_add_stay_variable (&solver, x, STRENGTH_WEAK);
+  simplex_solver_add_stay_variable (&solver, y, STRENGTH_WEAK);
+
+  simplex_solver_freeze (&solver);
+
+  Expression *e = expression_plus (expression_new_from_variable (y), 10.0);
+  Constraint *c1 = simplex_solver_add_constraint (&solver,
+                                                  x, OPERATOR_TYPE_EQ, e,
+                                                  STRENGTH_REQUIRED);
+  expression_unref (e);
+
+  e = expression_new_from_constant (50.0);
+  simplex_solver_add_constraint (&solver,
+                                 y, OPERATOR_TYPE_GE, e,
+                                 STRENGTH_REQUIRED);
+  expression_unref (e);
+
+  simplex_solver_thaw (&solver);
+
+  emeus_assert_almost_equals (variable_get_value (x), 60.0);
+  emeus_assert_almost_equals (variable_get_value (y), 50.0);
+
+  /* Re-adding a constraint from its normalized expression must yield
+   * the same solution
+   */
+  Expression *prepared = expression_ref (c1->expression);
+
+  simplex_solver_freeze (&solver);
+  simplex_solver_remove_constraint (&solver, c1);
+  simplex_solver_add_constraint (&solver,
+                                 NULL, OPERATOR_TYPE_EQ, prepared,
+                                 STRENGTH_REQUIRED);
+  simplex_solver_thaw (&solver);
+
+  emeus_assert_almost_equals (variable_get_value (x), 60.0);
+  emeus_assert_almost_equals (variable_get_value (y), 50.0);
+
+  expression_unref (prepared);
+  variable_unref (y);
+  variable_unref (x);
+
+  simplex_solver_clear (&solver);
+}
+
+static void
+emeus_solver_freeze_edit (void)
+{
+  SimplexSolver solver = SIMPLEX_SOLVER_INIT;
+
+  simplex_solver_init (&solver);
+
+  Variable *x = simplex_solver_create_variable (&solver, "x", 0.0);
+  Variable *w = simplex_solver_create_variable (&solver, "w", 10.0);
+
+  simplex_solver_add_stay_variable (&solver, x, STRENGTH_WEAK);
+  simplex_solver_add_edit_variable (&solver, w, STRENGTH_REQUIRED);
+
+  /* Suggestions made while frozen are applied once, on thaw, after
+   * the constraints added in the meantime; the last one wins
+   */
+  simplex_solver_freeze (&solver);
+
+  Expression *e = expression_times (expression_new_from_variable (w), 2.0);
+  simplex_solver_add_constraint (&solver, x, OPERATOR_TYPE_EQ, e, STRENGTH_REQUIRED);
+  expression_unref (e);
+
+  simplex_solver_suggest_value (&solver, w, 20.0);
+  simplex_solver_resolve (&solver);
+  simplex_solver_suggest_value (&solver, w, 30.0);
+  simplex_solver_resolve (&solver);
+
+  simplex_solver_thaw (&solver);
+
+  emeus_assert_almost_equals (variable_get_value (w), 30.0);
+  emeus_assert_almost_equals (variable_get_value (x), 60.0);
+
+  simplex_solver_suggest_value (&solver, w, 5.0);
+  simplex_solver_resolve (&solver);
+
+  emeus_assert_almost_equals (variable_get_value (w), 5.0);
+  emeus_assert_almost_equals (variable_get_value (x), 10.0);
+
+  variable_unref (w);
+  variable_unref (x);
+
+  simplex_solver_clear (&solver);
+}
+
+static void
+emeus_solver_transaction (void)
+{
+  SimplexSolver solver = SIMPLEX_SOLVER_INIT;
+
+  simplex_solver_init (&solver);
+
+  Variable *x = simplex_solver_create_variable (&solver, "x", 0.0);
+  Variable *y = simplex_solver_create_variable (&solver, "y", 0.0);
+
+  simplex_solver_add_stay_variable (&solver, x, STRENGTH_WEAK);
+  simplex_solver_add_stay_variable (&solver, y, STRENGTH_WEAK);
+
+  Expression *e = expression_plus (expression_new_from_variable (y), 10.0);
+  simplex_solver_add_constraint (&solver, x, OPERATOR_TYPE_EQ, e, STRENGTH_REQUIRED);
+  expression_unref (e);
+
+  double x_value = variable_get_value (x);
+  double y_value = variable_get_value (y);
+
+  /* Changes inside a rolled back transaction are discarded */
+  simplex_solver_begin_transaction (&solver);
+
+  e = expression_new_from_constant (100.0);
+  simplex_solver_add_constraint (&solver, y, OPERATOR_TYPE_GE, e, STRENGTH_REQUIRED);
+  expression_unref (e);
+
+  variable_set_value (x, 50.0);
+  simplex_solver_add_stay_variable (&solver, x, STRENGTH_STRONG);
+
+  emeus_assert_almost_equals (variable_get_value (x), 110.0);
+  emeus_assert_almost_equals (variable_get_value (y), 100.0);
+
+  simplex_solver_rollback_transaction (&solver);
+
+  emeus_assert_almost_equals (variable_get_value (x), x_value);
+  emeus_assert_almost_equals (variable_get_value (y), y_value);
+
+  /* The restored tableau can still be modified */
+  e = expression_new_from_constant (20.0);
+  Constraint *c = simplex_solver_add_constraint (&solver, y, OPERATOR_TYPE_GE, e, STRENGTH_REQUIRED);
+  expression_unref (e);
+
+  emeus_assert_almost_equals (variable_get_value (x), 30.0);
+  emeus_assert_almost_equals (variable_get_value (y), 20.0);
+
+  /* Changes inside a committed transaction are kept */
+  simplex_solver_begin_transaction (&solver);
+  simplex_solver_remove_constraint (&solver, c);
+
+  e = expression_new_from_constant (40.0);
+  simplex_solver_add_constraint (&solver, y, OPERATOR_TYPE_GE, e, STRENGTH_REQUIRED);
+  expression_unref (e);
+
+  simplex_solver_commit_transaction (&solver);
+
+  emeus_assert_almost_equals (variable_get_value (x), 50.0);
+  emeus_assert_almost_equals (variable_get_value (y), 40.0);
+
+  variable_unref (y);
+  variable_unref (x);
+
+  simplex_solver_clear (&solver);
+}
+
+static void
+emeus_solver_copy (void)
+{
+  SimplexSolver solver = SIMPLEX_SOLVER_INIT;
+  SimplexSolver copy = SIMPLEX_SOLVER_INIT;
+  GHashTable *variables;
+
+  simplex_solver_init (&solver);
+
+  Variable *a = simplex_solver_create_variable (&solver, "a", 0.0);
+  Variable *b = simplex_solver_create_variable (&solver, "b", 0.0);
+
+  simplex_solver_add_stay_variable (&solver, a, STRENGTH_STRONG);
+
+  Expression *e = expression_plus (expression_new_from_variable (b), 10.0);
+  simplex_solver_add_constraint (&solver, a, OPERATOR_TYPE_EQ, e, STRENGTH_REQUIRED);
+  expression_unref (e);
+
+  simplex_solver_add_edit_variable (&solver, a, STRENGTH_REQUIRED);
+  simplex_solver_begin_edit (&solver);
+  simplex_solver_suggest_value (&solver, a, 20.0);
+  simplex_solver_resolve (&solver);
+
+  emeus_assert_almost_equals (variable_get_value (a), 20.0);
+  emeus_assert_almost_equals (variable_get_value (b), 10.0);
+
+  variables = simplex_solver_copy (&solver, &copy);
+  g_assert_nonnull (variables);
+
+  Variable *copy_a = g_hash_table_lookup (variables, a);
+  Variable *copy_b = g_hash_table_lookup (variables, b);
+
+  g_assert_nonnull (copy_a);
+  g_assert_nonnull (copy_b);
+  g_assert (copy_a != a);
+  g_assert (copy_b != b);
+
+  emeus_assert_almost_equals (variable_get_value (copy_a), 20.0);
+  emeus_assert_almost_equals (variable_get_value (copy_b), 10.0);
+
+  /* Editing the copy does not affect the original */
+  simplex_solver_suggest_value (&copy, copy_a, 50.0);
+  simplex_solver_resolve (&copy);
+
+  emeus_assert_almost_equals (variable_get_value (copy_a), 50.0);
+  emeus_assert_almost_equals (variable_get_value (copy_b), 40.0);
+  emeus_assert_almost_equals (variable_get_value (a), 20.0);
+  emeus_assert_almost_equals (variable_get_value (b), 10.0);
+
+  /* Editing the original does not affect the copy */
+  simplex_solver_suggest_value (&solver, a, 30.0);
+  simplex_solver_resolve (&solver);
+
+  emeus_assert_almost_equals (variable_get_value (a), 30.0);
+  emeus_assert_almost_equals (variable_get_value (b), 20.0);
+  emeus_assert_almost_equals (variable_get_value (copy_a), 50.0);
+  emeus_assert_almost_equals (variable_get_value (copy_b), 40.0);
+
+  /* The copy can be cleared independently */
+  simplex_solver_end_edit (&copy);
+  g_hash_table_unref (variables);
+  simplex_solver_clear (&copy);
+
+  simplex_solver_end_edit (&solver);
+
+  emeus_assert_almost_equals (variable_get_value (a), 30.0);
+  emeus_assert_almost_equals (variable_get_value (b), 20.0);
+
+  variable_unref (a);
+  variable_unref (b);
+
+  simplex_solver_clear (&solver);
+}
+
+static void
+emeus_solver_alias (void)
+{
+  SimplexSolver solver = SIMPLEX_SOLVER_INIT;
+
+  simplex_solver_init (&solver);
+
+  Variable *a = simplex_solver_create_variable (&solver, "a", 0.0);
+  Variable *b = simplex_solver_create_variable (&solver, "b", 0.0);
+
+  /* b = a + 10 does not enter the tableau */
+  Expression *e = expression_plus (expression_new_from_variable (a), 10.0);
+  Constraint *alias = simplex_solver_add_constraint (&solver, b, OPERATOR_TYPE_EQ, e, STRENGTH_REQUIRED);
+  expression_unref (e);
+
+  g_assert_cmpint (g_hash_table_size (solver.aliases), ==, 1);
+  g_assert_false (g_hash_table_contains (solver.columns, b));
+
+  e = expression_new_from_constant (5.0);
+  simplex_solver_add_constraint (&solver, a, OPERATOR_TYPE_GE, e, STRENGTH_REQUIRED);
+  expression_unref (e);
+
+  emeus_assert_almost_equals (variable_get_value (a), 5.0);
+  emeus_assert_almost_equals (variable_get_value (b), 15.0);
+
+  /* Constraints on b are expressed in terms of a */
+  e = expression_new_from_constant (30.0);
+  simplex_solver_add_constraint (&solver, b, OPERATOR_TYPE_GE, e, STRENGTH_REQUIRED);
+  expression_unref (e);
+
+  g_assert_false (g_hash_table_contains (solver.columns, b));
+
+  emeus_assert_almost_equals (variable_get_value (a), 20.0);
+  emeus_assert_almost_equals (variable_get_value (b), 30.0);
+
+  /* Aliases created inside a transaction are undone */
+  Variable *c = simplex_solver_create_variable (&solver, "c", 0.0);
+
+  simplex_solver_begin_transaction (&solver);
+
+  e = expression_times (expression_new_from_variable (b), 2.0);
+  simplex_solver_add_constraint (&solver, c, OPERATOR_TYPE_EQ, e, STRENGTH_REQUIRED);
+  expression_unref (e);
+
+  g_assert_cmpint (g_hash_table_size (solver.aliases), ==, 2);
+  emeus_assert_almost_equals (variable_get_value (c), 60.0);
+
+  simplex_solver_rollback_transaction (&solver);
+
+  g_assert_cmpint (g_hash_table_size (solver.aliases), ==, 1);
+
+  /* Removing the alias adds b to the tableau */
+  simplex_solver_remove_constraint (&solver, alias);
+
+  g_assert_cmpint (g_hash_table_size (solver.aliases), ==, 0);
+  g_assert_true (g_hash_table_contains (solver.columns, b) ||
+                 g_hash_table_contains (solver.rows, b));
+
+  emeus_assert_almost_equals (variable_get_value (a), 5.0);
+  emeus_assert_almost_equals (variable_get_value (b), 30.0);
+
+  variable_unref (a);
+  variable_unref (b);
+  variable_unref (c);
+
+  simplex_solver_clear (&solver);
+}
+
+static void
+emeus_solver_alias_chain (void)
+{
+  SimplexSolver solver = SIMPLEX_SOLVER_INIT;
+
+  simplex_solver_init (&solver);
+
+  Variable *a = simplex_solver_create_variable (&solver, "a", 0.0);
+  Variable *b = simplex_solver_create_variable (&solver, "b", 0.0);
+  Variable *c = simplex_solver_create_variable (&solver, "c", 0.0);
+
+  Expression *e = expression_new_from_constant (10.0);
+  simplex_solver_add_constraint (&solver, a, OPERATOR_TYPE_GE, e, STRENGTH_REQUIRED);
+  expression_unref (e);
+
+  /* c = b + 8, then b = a + 8; the second constraint is added after
+   * b has been used by an alias, but the whole chain stays out of the
+   * tableau
+   */
+  e = expression_plus (expression_new_from_variable (b), 8.0);
+  Constraint *cn_c = simplex_solver_add_constraint (&solver, c, OPERATOR_TYPE_EQ, e, STRENGTH_REQUIRED);
+  expression_unref (e);
+
+  e = expression_plus (expression_new_from_variable (a), 8.0);
+  Constraint *cn_b = simplex_solver_add_constraint (&solver, b, OPERATOR_TYPE_EQ, e, STRENGTH_REQUIRED);
+  expression_unref (e);
+
+  g_assert_cmpint (g_hash_table_size (solver.aliases), ==, 2);
+  g_assert_false (g_hash_table_contains (solver.columns, b));
+  g_assert_false (g_hash_table_contains (solver.columns, c));
+
+  emeus_assert_almost_equals (variable_get_value (a), 10.0);
+  emeus_assert_almost_equals (variable_get_value (b), 18.0);
+  emeus_assert_almost_equals (variable_get_value (c), 26.0);
+
+  /* Removing the middle of the chain keeps c bound to b */
+  simplex_solver_remove_constraint (&solver, cn_b);
+
+  e = expression_new_from_constant (50.0);
+  simplex_solver_add_constraint (&solver, b, OPERATOR_TYPE_GE, e, STRENGTH_REQUIRED);
+  expression_unref (e);
+
+  emeus_assert_almost_equals (variable_get_value (a), 10.0);
+  emeus_assert_almost_equals (variable_get_value (b), 50.0);
+  emeus_assert_almost_equals (variable_get_value (c), 58.0);
+
+  simplex_solver_remove_constraint (&solver, cn_c);
+
+  g_assert_cmpint (g_hash_table_size (solver.aliases), ==, 0);
+
+  variable_unref (a);
+  variable_unref (b);
+  variable_unref (c);
+
+  simplex_solver_clear (&solver);
+}
+
+static void
+add_basis_constraints (SimplexSolver *solver,
+                       Variable *x,
+                       Variable *y,
+                       Variable *w)
+{
+  Expression *e;
+
+  simplex_solver_add_stay_variable (solver, x, STRENGTH_WEAK);
+  simplex_solver_add_stay_variable (solver, y, STRENGTH_WEAK);
+  simplex_solver_add_stay_variable (solver, w, STRENGTH_WEAK);
+
+  e = expression_new_from_constant (10.0);
+  simplex_solver_add_constraint (solver, x, OPERATOR_TYPE_GE, e, STRENGTH_REQUIRED);
+  expression_unref (e);
+
+  e = expression_new_from_constant (100.0);
+  simplex_solver_add_constraint (solver, w, OPERATOR_TYPE_EQ, e, STRENGTH_MEDIUM);
+  expression_unref (e);
+
+  e = expression_plus (expression_plus_variable (expression_new_from_variable (x), w), 5.0);
+  simplex_solver_add_constraint (solver, y, OPERATOR_TYPE_EQ, e, STRENGTH_STRONG);
+  expression_unref (e);
+
+  e = expression_new_from_constant (80.0);
+  simplex_solver_add_constraint (solver, y, OPERATOR_TYPE_LE, e, STRENGTH_REQUIRED);
+  expression_unref (e);
+}
+
+static void
+emeus_solver_basis (void)
+{
+  SimplexSolver solver = SIMPLEX_SOLVER_INIT;
+  SimplexSolver warm = SIMPLEX_SOLVER_INIT;
+
+  simplex_solver_init (&solver);
+
+  Variable *x = simplex_solver_create_variable (&solver, "x", 0.0);
+  Variable *y = simplex_solver_create_variable (&solver, "y", 0.0);
+  Variable *w = simplex_solver_create_variable (&solver, "w", 0.0);
+
+  add_basis_constraints (&solver, x, y, w);
+
+  emeus_assert_almost_equals (variable_get_value (x), 10.0);
+  emeus_assert_almost_equals (variable_get_value (w), 65.0);
+  emeus_assert_almost_equals (variable_get_value (y), 80.0);
+
+  guint hash = simplex_solver_hash (&solver);
+  GArray *basis = simplex_solver_export_basis (&solver);
+
+  g_assert_cmpint (basis->len, >, 0);
+
+  /* Build the same set of constraints without solving it, and
+   * import the basis before thawing the solver
+   */
+  simplex_solver_init (&warm);
+
+  Variable *wx = simplex_solver_create_variable (&warm, "x", 0.0);
+  Variable *wy = simplex_solver_create_variable (&warm, "y", 0.0);
+  Variable *ww = simplex_solver_create_variable (&warm, "w", 0.0);
+
+  simplex_solver_freeze (&warm);
+  add_basis_constraints (&warm, wx, wy, ww);
+
+  g_assert_cmpuint (simplex_solver_hash (&warm), ==, hash);
+  g_assert_true (simplex_solver_import_basis (&warm, hash,
+                                              (const guint32 *) basis->data,
+                                              basis->len));
+
+  simplex_solver_thaw (&warm);
+
+  emeus_assert_almost_equals (variable_get_value (wx), 10.0);
+  emeus_assert_almost_equals (variable_get_value (ww), 65.0);
+  emeus_assert_almost_equals (variable_get_value (wy), 80.0);
+
+  /* The basis refers to the variables in creation order, so the same
+   * constraints on variables created in another order must not match
+   */
+  SimplexSolver reordered = SIMPLEX_SOLVER_INIT;
+
+  simplex_solver_init (&reordered);
+
+  Variable *rw = simplex_solver_create_variable (&reordered, "w", 0.0);
+  Variable *ry = simplex_solver_create_variable (&reordered, "y", 0.0);
+  Variable *rx = simplex_solver_create_variable (&reordered, "x", 0.0);
+
+  simplex_solver_freeze (&reordered);
+  add_basis_constraints (&reordered, rx, ry, rw);
+
+  g_assert_cmpuint (simplex_solver_hash (&reordered), !=, hash);
+
+  simplex_solver_thaw (&reordered);
+
+  variable_unref (rx);
+  variable_unref (ry);
+  variable_unref (rw);
+
+  simplex_solver_clear (&reordered);
+
+  /* A different set of constraints must reject the basis */
+  Expression *e = expression_new_from_constant (20.0);
+  simplex_solver_add_constraint (&warm, wx, OPERATOR_TYPE_GE, e, STRENGTH_REQUIRED);
+  expression_unref (e);
+
+  g_assert_false (simplex_solver_import_basis (&warm, hash,
+                                               (const guint32 *) basis->data,
+                                               basis->len));
+
+  emeus_assert_almost_equals (variable_get_value (wx), 20.0);
+
+  g_array_unref (basis);
+
+  variable_unref (ww);
+  variable_unref (wy);
+  variable_unref (wx);
+  variable_unref (w);
+  variable_unref (y);
+  variable_unref (x);
+
+  simplex_solver_clear (&warm);
+  simplex_solver_clear (&solver);
+}
+
+static void
+emeus_solver_sensitivity (void)
+{
+  SimplexSolver solver = SIMPLEX_SOLVER_INIT;
+
+  simplex_solver_init (&solver);
+
+  Variable *left = simplex_solver_create_variable (&solver, "left", 0.0);
+  Variable *width = simplex_solver_create_variable (&solver, "width", 0.0);
+  Variable *child_left = simplex_solver_create_variable (&solver, "child_left", 0.0);
+  Variable *child_width = simplex_solver_create_variable (&solver, "child_width", 0.0);
+
+  Expression *e;
+
+  /* child_left = left + 10 */
+  e = expression_plus (expression_new_from_variable (left), 10.0);
+  simplex_solver_add_constraint (&solver, child_left, OPERATOR_TYPE_EQ, e, STRENGTH_REQUIRED);
+  expression_unref (e);
+
+  /* child_width = width - 20 */
+  e = expression_plus (expression_new_from_variable (width), -20.0);
+  simplex_solver_add_constraint (&solver, child_width, OPERATOR_TYPE_EQ, e, STRENGTH_REQUIRED);
+  expression_unref (e);
+
+  /* child_width >= 50 */
+  e = expression_new_from_constant (50.0);
+  simplex_solver_add_constraint (&solver, child_width, OPERATOR_TYPE_GE, e, STRENGTH_REQUIRED);
+  expression_unref (e);
+
+  guint generation = simplex_solver_get_generation (&solver);
+
+  simplex_solver_begin_transaction (&solver);
+
+  Constraint *params[2];
+
+  variable_set_value (left, 0.0);
+  params[0] = simplex_solver_add_stay_variable (&solver, left, STRENGTH_REQUIRED);
+  variable_set_value (width, 200.0);
+  params[1] = simplex_solver_add_stay_variable (&solver, width, STRENGTH_REQUIRED);
+
+  emeus_assert_almost_equals (variable_get_value (child_left), 10.0);
+  emeus_assert_almost_equals (variable_get_value (child_width), 180.0);
+
+  double slopes[2];
+
+  g_assert_true (simplex_solver_get_sensitivity (&solver, params, 2, child_left, slopes));
+  emeus_assert_almost_equals (slopes[0], 1.0);
+  emeus_assert_almost_equals (slopes[1], 0.0);
+
+  g_assert_true (simplex_solver_get_sensitivity (&solver, params, 2, child_width, slopes));
+  emeus_assert_almost_equals (slopes[0], 0.0);
+  emeus_assert_almost_equals (slopes[1], 1.0);
+
+  /* The basis holds as long as child_width >= 50, i.e. width >= 70 */
+  GArray *region = simplex_solver_get_feasible_region (&solver, params, 2);
+  g_assert_nonnull (region);
+  g_assert_cmpint (region->len, ==, 3);
+  emeus_assert_almost_equals (g_array_index (region, double, 0), 130.0);
+  emeus_assert_almost_equals (g_array_index (region, double, 1), 0.0);
+  emeus_assert_almost_equals (g_array_index (region, double, 2), 1.0);
+  g_array_unref (region);
+
+  simplex_solver_rollback_transaction (&solver);
+
+  g_assert_cmpuint (simplex_solver_get_generation (&solver), ==, generation);
+
+  /* Re-solving inside the region gives the same result as the linear
+   * evaluation, i.e. child_width = 180 + (100 - 200)
+   */
+  simplex_solver_begin_transaction (&solver);
+
+  variable_set_value (left, 5.0);
+  simplex_solver_add_stay_variable (&solver, left, STRENGTH_REQUIRED);
+  variable_set_value (width, 100.0);
+  simplex_solver_add_stay_variable (&solver, width, STRENGTH_REQUIRED);
+
+  emeus_assert_almost_equals (variable_get_value (child_left), 15.0);
+  emeus_assert_almost_equals (variable_get_value (child_width), 80.0);
+
+  simplex_solver_rollback_transaction (&solver);
+
+  variable_unref (child_width);
+  variable_unref (child_left);
+  variable_unref (width);
+  variable_unref (left);
+
+  simplex_solver_clear (&solver);
+}
+
+#define N_TIED_BOXES    16
+
+/* A row of boxes packed in a fixed width, all asking for the same width
+ * with the same strength; most of the pivots are degenerate
+ */
+static void
+add_tied_boxes (SimplexSolver *solver,
+                Variable **lefts,
+                Variable **widths)
+{
+  Expression *e;
+  int i;
+
+  for (i = 0; i < N_TIED_BOXES; i++)
+    {
+      lefts[i] = simplex_solver_create_variable (solver, "left", 0.0);
+      widths[i] = simplex_solver_create_variable (solver, "width", 0.0);
+
+      e = expression_new_from_constant (10.0);
+      simplex_solver_add_constraint (solver, widths[i], OPERATOR_TYPE_GE, e, STRENGTH_REQUIRED);
+      expression_unref (e);
+
+      e = expression_new_from_constant (100.0);
+      simplex_solver_add_constraint (solver, widths[i], OPERATOR_TYPE_EQ, e, STRENGTH_MEDIUM);
+      expression_unref (e);
+
+      if (i == 0)
+        e = expression_new_from_constant (0.0);
+      else
+        e = expression_plus_variable (expression_new_from_variable (lefts[i - 1]), widths[i - 1]);
+      simplex_solver_add_constraint (solver, lefts[i], OPERATOR_TYPE_EQ, e, STRENGTH_REQUIRED);
+      expression_unref (e);
+    }
+
+  /* The last box ends at 400 */
+  e = expression_new_from_constant (400.0);
+  expression_add_variable (e, widths[N_TIED_BOXES - 1], -1.0, NULL);
+  simplex_solver_add_constraint (solver, lefts[N_TIED_BOXES - 1], OPERATOR_TYPE_EQ, e, STRENGTH_REQUIRED);
+  expression_unref (e);
+}
+
+static void
+emeus_solver_degenerate (void)
+{
+  SimplexSolver solver = SIMPLEX_SOLVER_INIT;
+  Variable *lefts[N_TIED_BOXES], *widths[N_TIED_BOXES];
+  double total = 0.0;
+  int i;
+
+  simplex_solver_init (&solver);
+
+  add_tied_boxes (&solver, lefts, widths);
+
+  for (i = 0; i < N_TIED_BOXES; i++)
+    {
+      double left = variable_get_value (lefts[i]);
+      double width = variable_get_value (widths[i]);
+
+      g_assert_true (emeus_fuzzy_equals (left, total, 1e-6));
+      g_assert_cmpfloat (width, >=, 10.0 - 1e-6);
+
+      total += width;
+    }
+
+  g_assert_true (emeus_fuzzy_equals (total, 400.0, 1e-6));
+
+  for (i = 0; i < N_TIED_BOXES; i++)
+    {
+      variable_unref (lefts[i]);
+      variable_unref (widths[i]);
+    }
+
+  simplex_solver_clear (&solver);
+}
+
+#define N_CHAINED_VALUES        16
+
+/* A chain of values that must all be the same, each asking for the
+ * same value with the same strength; all the constraints meet at the
+ * solution, so the solver runs into long sequences of pivots that do
+ * not move it
+ *
+ * The data is the number of consecutive degenerate pivots after which
+ * the solver switches to Bland's rule, or 0 for the default
+ */
+static void
+emeus_solver_degenerate_chain (gconstpointer data)
+{
+  SimplexSolver solver = SIMPLEX_SOLVER_INIT;
+  Variable *values[N_CHAINED_VALUES];
+  guint max_degenerate_pivots = GPOINTER_TO_UINT (data);
+  Expression *e;
+  int i;
+
+  simplex_solver_init (&solver);
+  simplex_solver_set_max_degenerate_pivots (&solver, max_degenerate_pivots);
+
+  for (i = 0; i < N_CHAINED_VALUES; i++)
+    {
+      values[i] = simplex_solver_create_variable (&solver, "value", 0.0);
+
+      if (i > 0)
+        {
+          e = expression_new_from_variable (values[i - 1]);
+          simplex_solver_add_constraint (&solver, values[i], OPERATOR_TYPE_GE, e, STRENGTH_REQUIRED);
+          expression_unref (e);
+        }
+
+      e = expression_new_from_constant (50.0);
+      simplex_solver_add_constraint (&solver, values[i], OPERATOR_TYPE_EQ, e, STRENGTH_MEDIUM);
+      expression_unref (e);
+    }
+
+  /* Closes the chain */
+  e = expression_new_from_variable (values[0]);
+  simplex_solver_add_constraint (&solver, values[N_CHAINED_VALUES - 1], OPERATOR_TYPE_LE, e, STRENGTH_REQUIRED);
+  expression_unref (e);
+
+  if (max_degenerate_pivots == 1)
+    g_assert_cmpuint (simplex_solver_get_bland_pivot_count (&solver), >, 0);
+
+  for (i = 0; i < N_CHAINED_VALUES; i++)
+    {
+      g_assert_true (emeus_fuzzy_equals (variable_get_value (values[i]), 50.0, 1e-6));
+      variable_unref (values[i]);
+    }
+
+  simplex_solver_clear (&solver);
+}
+
+static void
+emeus_solver_max_iterations (void)
+{
+  if (g_test_subprocess ())
+    {
+      SimplexSolver solver = SIMPLEX_SOLVER_INIT;
+      Variable *lefts[N_TIED_BOXES], *widths[N_TIED_BOXES];
+
+      simplex_solver_init (&solver);
+
+      /* Some of the constraints take more than one pivot to solve, so
+       * the optimization stops at the cap and reports it
+       */
+      simplex_solver_set_max_iterations (&solver, 1);
+
+      add_tied_boxes (&solver, lefts, widths);
+
+      return;
+    }
+
+  g_test_trap_subprocess (NULL, 0, 0);
+  g_test_trap_assert_failed ();
+  g_test_trap_assert_stderr ("*optimize stopped after 1 pivots*");
+}
+
+/* A resolve that stops at the maximum number of pivots keeps the rows
+ * it did not repair, and the next resolve finishes the job
+ */
+static void
+emeus_solver_dual_max_iterations (void)
+{
+  SimplexSolver solver = SIMPLEX_SOLVER_INIT;
+  Variable *x, *ys[4];
+  Expression *e;
+  int i;
+
+  simplex_solver_init (&solver);
+
+  x = simplex_solver_create_variable (&solver, "x", 0.0);
+  simplex_solver_add_edit_variable (&solver, x, STRENGTH_STRONG);
+
+  for (i = 0; i < G_N_ELEMENTS (ys); i++)
+    {
+      ys[i] = simplex_solver_create_variable (&solver, "y", 0.0);
+      simplex_solver_add_stay_variable (&solver, ys[i], STRENGTH_WEAK);
+
+      /* Each value is at most its predecessor plus i, so moving x down
+       * pushes the whole chain down, one row at a time
+       */
+      e = expression_plus (expression_new_from_variable (i > 0 ? ys[i - 1] : x), i);
+      simplex_solver_add_constraint (&solver, ys[i], OPERATOR_TYPE_LE, e, STRENGTH_REQUIRED);
+      expression_unref (e);
+    }
+
+  simplex_solver_set_max_iterations (&solver, 1);
+
+  g_test_expect_message ("Emeus", G_LOG_LEVEL_WARNING, "*dual_optimize stopped after 1 pivots*");
+  simplex_solver_suggest_value (&solver, x, -100.0);
+  simplex_solver_resolve (&solver);
+  g_test_assert_expected_messages ();
+
+  g_assert_true (solver.needs_solving);
+  g_assert_cmpuint (solver.infeasible_rows->len, >, 0);
+
+  simplex_solver_set_max_iterations (&solver, 0);
+  simplex_solver_resolve (&solver);
+
+  g_assert_false (solver.needs_solving);
+  g_assert_cmpuint (solver.infeasible_rows->len, ==, 0);
+
+  g_assert_cmpfloat (variable_get_value (x), ==, -100.0);
+  for (i = 0; i < G_N_ELEMENTS (ys); i++)
+    {
+      g_assert_cmpfloat (variable_get_value (ys[i]), ==, -100.0 + i * (i + 1) / 2);
+      variable_unref (ys[i]);
+    }
+
+  variable_unref (x);
+
+  simplex_solver_clear (&solver);
+}
+
+#define N_SPACED_BOXES  64
+
+static void
+emeus_solver_fill_in (void)
+{
+  SimplexSolver solver = SIMPLEX_SOLVER_INIT;
+  Variable *lefts[N_SPACED_BOXES], *widths[N_SPACED_BOXES];
+  GHashTableIter iter;
+  gpointer key, value;
+  guint max_terms = 0;
+  Expression *e;
+  int i;
+
+  simplex_solver_init (&solver);
+
+  /* Boxes of 50 that are at least 8 apart, which only constrain their
+   * neighbours; pivoting on them should not make the rows any longer
+   */
+  for (i = 0; i < N_SPACED_BOXES; i++)
+    {
+      lefts[i] = simplex_solver_create_variable (&solver, "left", 0.0);
+      widths[i] = simplex_solver_create_variable (&solver, "width", 0.0);
+
+      e = expression_new_from_constant (10.0);
+      simplex_solver_add_constraint (&solver, widths[i], OPERATOR_TYPE_GE, e, STRENGTH_REQUIRED);
+      expression_unref (e);
+
+      e = expression_new_from_constant (50.0);
+      simplex_solver_add_constraint (&solver, widths[i], OPERATOR_TYPE_EQ, e, STRENGTH_MEDIUM);
+      expression_unref (e);
+
+      if (i == 0)
+        e = expression_new_from_constant (0.0);
+      else
+        e = expression_plus (expression_plus_variable (expression_new_from_variable (lefts[i - 1]), widths[i - 1]), 8.0);
+      simplex_solver_add_constraint (&solver, lefts[i], OPERATOR_TYPE_GE, e, STRENGTH_REQUIRED);
+      expression_unref (e);
+
+      simplex_solver_add_stay_variable (&solver, lefts[i], STRENGTH_WEAK);
+    }
+
+  for (i = 0; i < N_SPACED_BOXES; i++)
+    {
+      emeus_assert_almost_equals (variable_get_value (lefts[i]), i * 58.0);
+      emeus_assert_almost_equals (variable_get_value (widths[i]), 50.0);
+    }
+
+  g_hash_table_iter_init (&iter, solver.rows);
+  while (g_hash_table_iter_next (&iter, &key, &value))
+    {
+      if (key != solver.objective)
+        max_terms = MAX (max_terms, expression_get_n_terms (value));
+    }
+
+  g_test_message ("Longest row: %u terms", max_terms);
+  g_assert_cmpuint (max_terms, <=, 8);
+
+  for (i = 0; i < N_SPACED_BOXES; i++)
+    {
+      variable_unref (lefts[i]);
+      variable_unref (widths[i]);
+    }
+
+  simplex_solver_clear (&solver);
+}
+
+static void
+emeus_solver_bounds (void)
+{
+  SimplexSolver solver = SIMPLEX_SOLVER_INIT;
+  guint n_rows;
+
+  simplex_solver_init (&solver);
+
+  Variable *x = simplex_solver_create_variable (&solver, "x", 0.0);
+  Variable *y = simplex_solver_create_variable (&solver, "y", 0.0);
+
+  /* y = x + 10 */
+  Expression *e = expression_plus (expression_new_from_variable (x), 10.0);
+  simplex_solver_add_constraint (&solver, y, OPERATOR_TYPE_EQ, e, STRENGTH_MEDIUM);
+  expression_unref (e);
+
+  simplex_solver_add_edit_variable (&solver, x, STRENGTH_STRONG);
+
+  /* A required bound of zero does not add rows to the tableau */
+  n_rows = g_hash_table_size (solver.rows);
+
+  e = expression_new_from_constant (0.0);
+  Constraint *bound = simplex_solver_add_constraint (&solver, x, OPERATOR_TYPE_GE, e, STRENGTH_REQUIRED);
+  expression_unref (e);
+
+  g_assert_cmpuint (g_hash_table_size (solver.rows), ==, n_rows);
+  g_assert_true (variable_is_restricted (x));
+
+  simplex_solver_suggest_value (&solver, x, -20.0);
+  simplex_solver_resolve (&solver);
+
+  emeus_assert_almost_equals (variable_get_value (x), 0.0);
+  emeus_assert_almost_equals (variable_get_value (y), 10.0);
+
+  simplex_solver_suggest_value (&solver, x, 30.0);
+  simplex_solver_resolve (&solver);
+
+  emeus_assert_almost_equals (variable_get_value (x), 30.0);
+  emeus_assert_almost_equals (variable_get_value (y), 40.0);
+
+  /* Rolling back the removal of the bound restricts the variable again */
+  simplex_solver_begin_transaction (&solver);
+  simplex_solver_remove_constraint (&solver, bound);
+  g_assert_false (variable_is_restricted (x));
+  simplex_solver_rollback_transaction (&solver);
+
+  g_assert_true (variable_is_restricted (x));
+
+  simplex_solver_suggest_value (&solver, x, -20.0);
+  simplex_solver_resolve (&solver);
+
+  emeus_assert_almost_equals (variable_get_value (x), 0.0);
+
+  /* Without the bound, the variable can be negative */
+  simplex_solver_remove_constraint (&solver, bound);
+  g_assert_false (variable_is_restricted (x));
+
+  simplex_solver_suggest_value (&solver, x, -20.0);
+  simplex_solver_resolve (&solver);
+
+  emeus_assert_almost_equals (variable_get_value (x), -20.0);
+  emeus_assert_almost_equals (variable_get_value (y), -10.0);
+
+  variable_unref (y);
+  variable_unref (x);
+
+  simplex_solver_clear (&solver);
+}
+
+static void
+emeus_solver_backend (void)
+{
+  const char *names[] = { "cassowary", "profile", "revised", "dense" };
+
+  g_assert_null (solver_backend_lookup ("invalid"));
+  g_assert_nonnull (solver_backend_get_default ());
+
+  for (int i = 0; i < G_N_ELEMENTS (names); i++)
+    {
+      const SolverBackend *backend = solver_backend_lookup (names[i]);
+      SimplexSolver solver = SIMPLEX_SOLVER_INIT;
+
+      g_assert_nonnull (backend);
+      g_assert_cmpstr (backend->name, ==, names[i]);
+
+      solver_init (&solver, backend);
+      g_assert_true (solver.backend == backend);
+
+      Variable *x = solver_create_variable (&solver, "x", 0.0);
+      Variable *y = solver_create_variable (&solver, "y", 0.0);
+
+      /* y = x + 10 */
+      Expression *e = expression_plus (expression_new_from_variable (x), 10.0);
+      solver_add_constraint (&solver, y, OPERATOR_TYPE_EQ, e, STRENGTH_REQUIRED);
+      expression_unref (e);
+
+      solver_add_edit_variable (&solver, x, STRENGTH_STRONG);
+
+      solver_freeze (&solver);
+      solver_suggest_value (&solver, x, 20.0);
+      solver_thaw (&solver);
+
+      emeus_assert_almost_equals (solver_get_value (&solver, x), 20.0);
+      emeus_assert_almost_equals (solver_get_value (&solver, y), 30.0);
+
+      solver_suggest_value (&solver, x, 5.0);
+      solver_resolve (&solver);
+
+      emeus_assert_almost_equals (solver_get_value (&solver, y), 15.0);
+
+      variable_unref (x);
+      variable_unref (y);
+
+      solver_clear (&solver);
+    }
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -583,6 +1685,9 @@ main (int argc, char *argv[])
   g_test_add_func ("/emeus/solver/stay", emeus_solver_stay);
   g_test_add_func ("/emeus/solver/edit-var-required", emeus_solver_edit_var_required);
   g_test_add_func ("/emeus/solver/edit-var-suggest", emeus_solver_edit_var_suggest);
+  g_test_add_func ("/emeus/solver/edit-var-repeat", emeus_solver_edit_var_repeat);
+  g_test_add_func ("/emeus/solver/edit-var-metric", emeus_solver_edit_var_metric);
+  g_test_add_func ("/emeus/solver/edit-var-suggest-values", emeus_solver_edit_var_suggest_values);
   g_test_add_func ("/emeus/solver/variable-geq-constant", emeus_solver_variable_geq_constant);
   g_test_add_func ("/emeus/solver/variable-leq-constant", emeus_solver_variable_leq_constant);
   g_test_add_func ("/emeus/solver/variable-eq-constant", emeus_solver_variable_eq_constant);
@@ -590,6 +1695,24 @@ main (int argc, char *argv[])
   g_test_add_func ("/emeus/solver/cassowary", emeus_solver_cassowary);
   g_test_add_func ("/emeus/solver/paper", emeus_solver_paper);
   g_test_add_func ("/emeus/solver/buttons", emeus_solver_buttons);
+  g_test_add_func ("/emeus/solver/freeze-thaw", emeus_solver_freeze_thaw);
+  g_test_add_func ("/emeus/solver/freeze-edit", emeus_solver_freeze_edit);
+  g_test_add_func ("/emeus/solver/transaction", emeus_solver_transaction);
+  g_test_add_func ("/emeus/solver/copy", emeus_solver_copy);
+  g_test_add_func ("/emeus/solver/alias", emeus_solver_alias);
+  g_test_add_func ("/emeus/solver/alias-chain", emeus_solver_alias_chain);
+  g_test_add_func ("/emeus/solver/basis", emeus_solver_basis);
+  g_test_add_func ("/emeus/solver/sensitivity", emeus_solver_sensitivity);
+  g_test_add_func ("/emeus/solver/degenerate", emeus_solver_degenerate);
+  g_test_add_data_func ("/emeus/solver/degenerate-chain", GUINT_TO_POINTER (0),
+                        emeus_solver_degenerate_chain);
+  g_test_add_data_func ("/emeus/solver/degenerate-chain-bland", GUINT_TO_POINTER (1),
+                        emeus_solver_degenerate_chain);
+  g_test_add_func ("/emeus/solver/max-iterations", emeus_solver_max_iterations);
+  g_test_add_func ("/emeus/solver/dual-max-iterations", emeus_solver_dual_max_iterations);
+  g_test_add_func ("/emeus/solver/fill-in", emeus_solver_fill_in);
+  g_test_add_func ("/emeus/solver/bounds", emeus_solver_bounds);
+  g_test_add_func ("/emeus/solver/backend", emeus_solver_backend);
 
   return g_test_run ();
 }
@@ -89,6 +89,12 @@ vfl_parser_valid (gconstpointer data)
   g_assert_nonnull (constraints);
   g_assert_cmpint (n_constraints, !=, 0);
 
+  for (int i = 0; i < n_constraints; i++)
+    {
+      if (constraints[i].metric != NULL)
+        g_assert_true (g_hash_table_contains (metrics, constraints[i].metric));
+    }
+
   g_free (constraints);
 
   vfl_parser_free (parser);
@@ -189,6 +189,12 @@ struct _EditorApplicationWindow
   GHashTable *views;
   GHashTable *metrics;
 
+  /* Set<string>; the VFL lines of the previous change that were parsed
+   * successfully with the current views, and do not need to be validated
+   * again
+   */
+  GHashTable *valid_lines;
+
   gboolean in_selection : 1;
 };
 
@@ -221,6 +227,7 @@ add_view_button__clicked (EditorApplicationWindow *self)
 
       const char *view_name = gtk_entry_get_text (GTK_ENTRY (row->name_entry));
       g_hash_table_insert (self->views, g_strdup (view_name), row->view_widget);
+      g_hash_table_remove_all (self->valid_lines);
 
       emeus_constraint_layout_pack (EMEUS_CONSTRAINT_LAYOUT (self->layout_box),
                                     row->view_widget,
@@ -361,6 +368,8 @@ vfl_text_area__changed (EditorApplicationWindow *self,
 
   gboolean had_error = FALSE;
 
+  GHashTable *valid_lines = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
   vfl_parser_set_views (self->vfl_parser, self->views);
 
   for (int i = 0; lines[i] != 0; i += 1)
@@ -368,6 +377,13 @@ vfl_text_area__changed (EditorApplicationWindow *self,
       const char *line = lines[i];
       GError *error = NULL;
 
+      /* Only the lines that changed need to be validated */
+      if (g_hash_table_contains (self->valid_lines, line))
+        {
+          g_hash_table_add (valid_lines, g_strdup (line));
+          continue;
+        }
+
       vfl_parser_parse_line (self->vfl_parser, line, -1, &error);
       if (error != NULL)
         {
@@ -402,8 +418,13 @@ vfl_text_area__changed (EditorApplicationWindow *self,
 
           break;
         }
+
+      g_hash_table_add (valid_lines, g_strdup (line));
     }
 
+  g_hash_table_unref (self->valid_lines);
+  self->valid_lines = valid_lines;
+
   if (had_error)
     {
       g_strfreev (lines);
@@ -412,24 +433,15 @@ vfl_text_area__changed (EditorApplicationWindow *self,
 
   log_text_area_add_message (self, _("Visual format parsed successfully\n"), FALSE);
 
-  emeus_constraint_layout_clear_constraints (EMEUS_CONSTRAINT_LAYOUT (self->layout_box));
-
-  GList *constraints = emeus_create_constraints_from_description ((const char * const *) lines,
-                                                                  g_strv_length (lines),
-                                                                  -1, -1,
-                                                                  self->views,
-                                                                  NULL);
-
-  g_debug ("*** Generated %d constraints from %d lines", g_list_length (constraints), g_strv_length (lines));
-
-  for (GList *l = constraints; l != NULL; l = l->next)
-    emeus_constraint_layout_add_constraint (EMEUS_CONSTRAINT_LAYOUT (self->layout_box), l->data);
-
-  g_list_free (constraints);
+  /* Only the constraints of the lines that changed are replaced */
+  emeus_constraint_layout_update_from_description (EMEUS_CONSTRAINT_LAYOUT (self->layout_box),
+                                                   (const char * const *) lines,
+                                                   g_strv_length (lines),
+                                                   -1, -1,
+                                                   self->views,
+                                                   NULL);
 
   g_strfreev (lines);
-
-  gtk_widget_queue_resize (GTK_WIDGET (self->layout_box));
 }
 
 static void
@@ -440,6 +452,7 @@ editor_application_window_finalize (GObject *gobject)
   vfl_parser_free (self->vfl_parser);
 
   g_clear_pointer (&self->views, g_hash_table_unref);
+  g_clear_pointer (&self->valid_lines, g_hash_table_unref);
 
   G_OBJECT_CLASS (editor_application_window_parent_class)->finalize (gobject);
 }
@@ -479,6 +492,7 @@ editor_application_window_init (EditorApplicationWindow *self)
 
   self->views = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
   self->vfl_parser = vfl_parser_new (-1, -1, NULL, self->views);
+  self->valid_lines = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
 
   g_signal_connect_swapped (gtk_text_view_get_buffer (GTK_TEXT_VIEW (self->vfl_text_area)),
                             "changed", G_CALLBACK (vfl_text_area__changed),
@@ -3,6 +3,7 @@
 #include <glib.h>
 
 #include "emeus-vfl-parser-private.h"
+#include "emeus-utils-private.h"
 
 #include <string.h>
 #include <stdlib.h>
@@ -35,23 +36,9 @@ relation_to_string (OperatorType rel)
   return "eq";
 }
 
-static const char *
-strength_to_string (double strength)
-{
-  if (strength >= STRENGTH_REQUIRED)
-    return "required";
-
-  if (strength >= STRENGTH_STRONG)
-    return "strong";
-
-  if (strength >= STRENGTH_MEDIUM)
-    return "medium";
-
-  return "weak";
-}
-
 static int opt_hspacing = -1;
 static int opt_vspacing = -1;
+static gboolean opt_binary;
 static char **opt_views;
 static char **opt_vfl;
 
@@ -59,6 +46,7 @@ static GOptionEntry options[] = {
   { "hspacing", 'H', 0, G_OPTION_ARG_INT, &opt_hspacing, "Default horizontal spacing", "SPACING" },
   { "vspacing", 'V', 0, G_OPTION_ARG_INT, &opt_vspacing, "Default vertical spacing", "SPACING" },
   { "view", 0, 0, G_OPTION_ARG_STRING_ARRAY, &opt_views, "Views", "NAME" },
+  { "binary", 'b', 0, G_OPTION_ARG_NONE, &opt_binary, "Generate compiled constraints, for use in a GResource", NULL },
 
   { G_OPTION_REMAINING, 0, 0, G_OPTION_ARG_STRING_ARRAY, &opt_vfl, "Visual Format Language strings", "FORMAT" },
 
@@ -99,6 +87,11 @@ main (int argc, char *argv[])
 
   GString *buffer = g_string_new ("<constraints>\n");
 
+  GVariantBuilder blob;
+  g_variant_builder_init (&blob, G_VARIANT_TYPE (CONSTRAINTS_BLOB_TYPE));
+  g_variant_builder_add (&blob, "u", CONSTRAINTS_BLOB_VERSION);
+  g_variant_builder_open (&blob, G_VARIANT_TYPE ("a(syysyddi)"));
+
   for (int i = 0; opt_vfl[i] != NULL; i++)
     {
       GError *error = NULL;
@@ -135,6 +128,16 @@ main (int argc, char *argv[])
         {
           VflConstraint *c = &constraints[j];
 
+          g_variant_builder_add (&blob, "(syysyddi)",
+                                 c->view1,
+                                 (guchar) attribute_from_name (c->attr1),
+                                 (guchar) operator_to_relation (c->relation),
+                                 c->view2 != NULL ? c->view2 : "",
+                                 (guchar) attribute_from_name (c->attr2),
+                                 c->multiplier,
+                                 c->constant,
+                                 (gint32) value_to_strength (c->strength));
+
           g_string_append_printf (buffer, "  <constraint target-object=\"%s\" target-attr=\"%s\"\n", c->view1, c->attr1);
           g_string_append_printf (buffer, "              relation=\"%s\"\n", relation_to_string (c->relation));
 
@@ -150,8 +153,27 @@ main (int argc, char *argv[])
 
   g_string_append (buffer, "</constraints>\n");
 
-  fprintf (stdout, "%s", buffer->str);
+  g_variant_builder_close (&blob);
+
+  GVariant *res = g_variant_ref_sink (g_variant_builder_end (&blob));
+
+  if (opt_binary)
+    {
+      /* Compiled constraints are always stored in little endian order */
+      if (G_BYTE_ORDER == G_BIG_ENDIAN)
+        {
+          GVariant *tmp = g_variant_byteswap (res);
+
+          g_variant_unref (res);
+          res = tmp;
+        }
+
+      fwrite (g_variant_get_data (res), 1, g_variant_get_size (res), stdout);
+    }
+  else
+    fprintf (stdout, "%s", buffer->str);
 
+  g_variant_unref (res);
   g_string_free (buffer, TRUE);
 
   vfl_parser_free (parser);